@@ -0,0 +1,398 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/circuit/BasicQuantumRegister.h"
+#include "../src/circuit/VectorizedQuantumRegister.h"
+#include "../src/circuit/SplitQuantumRegister.h"
+#include "../src/circuit/HalfPrecisionQuantumRegister.h"
+#include "../src/circuit/CLQuantumRegister.h"
+#include "../src/algebra/Constants.h"
+#include "CL/opencl.hpp"
+
+using namespace KQS;
+
+using real_t = float;
+using complex_t = std::complex<real_t>;
+using Gate = Circuit::QuantumLogicGate<real_t>;
+
+/**
+ * Runs standard circuits end to end on every register: QFT, GHZ, Grover search with multi-controlled oracles, QAOA
+ * for MaxCut and Sycamore-style random circuits. Reports the wall time split into register setup, gates,
+ * measurement (marginals and sampled shots) and I/O (writing the state to a file), and the peak resident memory.
+ *
+ * Usage: CircuitBenchmark [numQubits = 20] [depth = 10] [backends = basic,vectorized,split,half,cl]
+ *
+ * The depth is the number of Grover iterations (at most the optimal number), QAOA layers and random circuit cycles;
+ * QFT and GHZ have a fixed depth. CLQuantumRegister runs on the first GPU, or CPU if there is no GPU.
+ */
+
+using Operation = std::function<void(Circuit::QuantumRegister<real_t> &)>;
+
+struct Workload {
+	std::string name;
+	std::vector<Operation> operations;
+};
+
+/** Number of controls of the multi-controlled gates the Grover oracle is decomposed into. */
+constexpr size_t MaxControls = 4;
+
+/** Number of shots sampled after every circuit. */
+constexpr size_t Shots = 1024;
+
+/////////////// Memory ///////////////
+
+/** Resets the peak resident set size of the process, supported on Linux only. */
+void resetPeakMemory() {
+#ifdef __linux__
+	std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+/** Peak resident set size of the process since the last reset in MB, 0 if unknown. */
+double peakMemory() {
+#ifdef __linux__
+	std::ifstream status("/proc/self/status");
+	for (std::string line; std::getline(status, line);)
+		if (line.starts_with("VmHWM:"))
+			return std::stod(line.substr(6)) / 1024;
+#endif
+	return 0;
+}
+
+/////////////// Circuits ///////////////
+
+Workload qft(size_t n) {
+	Workload workload{"QFT", {}};
+	for (size_t i = n; i-- > 0;) {
+		workload.operations.emplace_back([=](auto &r) { r.hadamard(i); });
+		for (size_t j = i; j-- > 0;)
+			workload.operations.emplace_back([=](auto &r) {
+				r.controlledPhase(j, i, Algebra::PI<real_t> / static_cast<real_t>(1ULL << (i - j)));
+			});
+	}
+	for (size_t i = 0; i < n / 2; ++i)
+		workload.operations.emplace_back([=](auto &r) { r.swap(i, n - 1 - i); });
+	return workload;
+}
+
+Workload ghz(size_t n) {
+	Workload workload{"GHZ", {}};
+	workload.operations.emplace_back([](auto &r) { r.hadamard(0); });
+	for (size_t i = 1; i < n; ++i)
+		workload.operations.emplace_back([=](auto &r) { r.controlledX(i - 1, i); });
+	return workload;
+}
+
+/**
+ * Appends a Z controlled by all but the last qubit (a phase of -1 on the state with all qubits one). Gates with more
+ * than MaxControls controls are split into a chain of multi-controlled X gates computing the AND of the controls into
+ * clean ancillas, which are uncomputed afterwards.
+ */
+void multiControlledZ(std::vector<Operation> &operations, const std::vector<size_t> &qubits,
+					  const std::vector<size_t> &ancillas) {
+	size_t target = qubits.back();
+	std::vector<size_t> controls(qubits.begin(), qubits.end() - 1);
+
+	// every gate of the chain replaces MaxControls controls with an ancilla holding their AND
+	std::vector<std::vector<size_t>> chain;
+	for (size_t ancilla = 0; controls.size() > MaxControls; ++ancilla) {
+		std::vector<size_t> gateQubits = {ancillas.at(ancilla)};
+		gateQubits.insert(gateQubits.end(), controls.begin(), controls.begin() + MaxControls);
+		chain.push_back(gateQubits);
+
+		controls.erase(controls.begin(), controls.begin() + MaxControls);
+		controls.insert(controls.begin(), ancillas[ancilla]);
+	}
+
+	auto apply = [&](const std::vector<size_t> &gateQubits, const Gate &base) {
+		Gate gate = Gate::makeControlled(base, gateQubits.size() - 1);
+		operations.emplace_back([=](auto &r) { r.gate(gate, gateQubits); });
+	};
+
+	for (const auto &gateQubits: chain)
+		apply(gateQubits, Gate::pauliX());
+
+	std::vector<size_t> finalQubits = {target};
+	finalQubits.insert(finalQubits.end(), controls.begin(), controls.end());
+	apply(finalQubits, Gate::pauliZ());
+
+	for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+		apply(*it, Gate::pauliX());
+}
+
+/** Number of ancillas multiControlledZ needs for the given number of qubits. */
+size_t ancillasFor(size_t qubits) {
+	size_t controls = qubits - 1;
+	if (controls <= MaxControls)
+		return 0;
+	// every ancilla reduces the number of controls by MaxControls - 1
+	size_t step = MaxControls - 1;
+	return (controls - MaxControls + step - 1) / step;
+}
+
+Workload grover(size_t n, size_t depth) {
+	Workload workload{"Grover", {}};
+
+	// the most search qubits that fit with their ancillas
+	size_t searchQubits = n;
+	while (searchQubits + ancillasFor(searchQubits) > n)
+		--searchQubits;
+
+	std::vector<size_t> search(searchQubits);
+	std::vector<size_t> ancillas(ancillasFor(searchQubits));
+	std::iota(search.begin(), search.end(), 0);
+	std::iota(ancillas.begin(), ancillas.end(), searchQubits);
+
+	auto layer = [&](auto &&apply) {
+		for (size_t q: search)
+			workload.operations.emplace_back([=](auto &r) { apply(r, q); });
+	};
+	auto hadamards = [&] { layer([](auto &r, size_t q) { r.hadamard(q); }); };
+
+	size_t optimal = static_cast<size_t>(Algebra::PI<double> / 4 * std::sqrt(static_cast<double>(1ULL << searchQubits)));
+	size_t marked = 0x5A5A5A5A5A5A5A5AULL & ((1ULL << searchQubits) - 1);
+
+	hadamards();
+	for (size_t iteration = 0; iteration < std::min(depth, std::max<size_t>(optimal, 1)); ++iteration) {
+		// oracle: phase -1 on the marked state
+		auto flipZeros = [&] {
+			for (size_t q: search)
+				if (!((marked >> q) & 1))
+					workload.operations.emplace_back([=](auto &r) { r.pauliX(q); });
+		};
+		flipZeros();
+		multiControlledZ(workload.operations, search, ancillas);
+		flipZeros();
+
+		// diffusion: reflection about the uniform superposition
+		hadamards();
+		layer([](auto &r, size_t q) { r.pauliX(q); });
+		multiControlledZ(workload.operations, search, ancillas);
+		layer([](auto &r, size_t q) { r.pauliX(q); });
+		hadamards();
+	}
+
+	return workload;
+}
+
+Workload qaoa(size_t n, size_t depth, std::mt19937 &rng) {
+	Workload workload{"QAOA", {}};
+
+	// ring with random chords, about three edges per vertex
+	std::vector<std::pair<size_t, size_t>> edges;
+	for (size_t i = 0; i < n; ++i)
+		edges.emplace_back(i, (i + 1) % n);
+	std::uniform_int_distribution<size_t> vertex(0, n - 1);
+	for (size_t i = 0; i < n / 2; ++i) {
+		size_t a = vertex(rng), b = vertex(rng);
+		if (a != b)
+			edges.emplace_back(a, b);
+	}
+
+	std::uniform_real_distribution<real_t> angle(0, Algebra::PI<real_t>);
+	for (size_t q = 0; q < n; ++q)
+		workload.operations.emplace_back([=](auto &r) { r.hadamard(q); });
+
+	for (size_t layer = 0; layer < depth; ++layer) {
+		// cost: exp(-i gamma Z Z) on every edge, a diagonal gate
+		real_t gamma = angle(rng);
+		complex_t same = std::polar<real_t>(1, -gamma), different = std::polar<real_t>(1, gamma);
+		Gate zz(SmallMatrix<real_t, 4>{{same, 0, 0, 0}, {0, different, 0, 0}, {0, 0, different, 0}, {0, 0, 0, same}});
+		for (auto [a, b]: edges)
+			workload.operations.emplace_back([=](auto &r) { r.gate(zz, {a, b}); });
+
+		// mixer: exp(-i beta X) on every qubit, a dense gate
+		real_t beta = angle(rng);
+		complex_t c = std::cos(beta), s = complex_t(0, -std::sin(beta));
+		Gate rx(SmallMatrix<real_t, 2>{{c, s}, {s, c}});
+		for (size_t q = 0; q < n; ++q)
+			workload.operations.emplace_back([=](auto &r) { r.gate(rx, {q}); });
+	}
+
+	return workload;
+}
+
+/**
+ * Random circuit in the style of the Sycamore supremacy experiment: qubits on a grid, every cycle a random choice of
+ * sqrt(X), sqrt(Y) and sqrt(W) on every qubit (never the same twice in a row) followed by fSim gates on one of four
+ * patterns of couplers, in the order ABCDCDAB.
+ */
+Workload randomCircuit(size_t n, size_t depth, std::mt19937 &rng) {
+	Workload workload{"Random", {}};
+
+	auto sqrtGate = [](complex_t x, complex_t y) {
+		// sqrt of the Pauli x X + y Y (with |x|^2 + |y|^2 = 1): (1 + i) / 2 * I + (1 - i) / 2 * (x X + y Y)
+		complex_t a(0.5, 0.5), b(0.5, -0.5);
+		complex_t offDiagonal = b * (x - complex_t(0, 1) * y);
+		complex_t offDiagonalConj = b * (x + complex_t(0, 1) * y);
+		return Gate(SmallMatrix<real_t, 2>{{a, offDiagonal}, {offDiagonalConj, a}});
+	};
+	real_t w = Algebra::RecSqrt2<real_t>;
+	std::array<Gate, 3> oneQubitGates = {sqrtGate(1, 0), sqrtGate(0, 1), sqrtGate(w, w)};
+
+	real_t theta = Algebra::PI<real_t> / 2, phi = Algebra::PI<real_t> / 6;
+	complex_t c = std::cos(theta), s = complex_t(0, -std::sin(theta));
+	Gate fSim(SmallMatrix<real_t, 4>{{1, 0, 0, 0}, {0, c, s, 0}, {0, s, c, 0}, {0, 0, 0, std::polar<real_t>(1, -phi)}});
+
+	size_t columns = std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(n))));
+	std::array<std::vector<std::pair<size_t, size_t>>, 4> patterns;
+	for (size_t q = 0; q < n; ++q) {
+		size_t row = q / columns, column = q % columns;
+		if (column + 1 < columns && q + 1 < n)
+			patterns[column % 2].emplace_back(q, q + 1);
+		if (q + columns < n)
+			patterns[2 + row % 2].emplace_back(q, q + columns);
+	}
+	constexpr std::array<size_t, 8> sequence = {0, 1, 2, 3, 2, 3, 0, 1};
+
+	std::vector<size_t> previous(n, oneQubitGates.size());
+	std::uniform_int_distribution<size_t> choice(0, oneQubitGates.size() - 1);
+	for (size_t cycle = 0; cycle < depth; ++cycle) {
+		for (size_t q = 0; q < n; ++q) {
+			size_t g;
+			do g = choice(rng); while (g == previous[q]);
+			previous[q] = g;
+			workload.operations.emplace_back([gate = oneQubitGates[g], q](auto &r) { r.gate(gate, {q}); });
+		}
+		for (auto [a, b]: patterns[sequence[cycle % sequence.size()]])
+			workload.operations.emplace_back([=](auto &r) { r.gate(fSim, {a, b}); });
+	}
+
+	return workload;
+}
+
+/////////////// Benchmark ///////////////
+
+/** Waits for the gates enqueued on OpenCL registers, whose gate kernels are not waited for. */
+void finish(const Circuit::QuantumRegister<real_t> &qRegister) {
+	if (const auto *clRegister = dynamic_cast<const Circuit::CLQuantumRegister<real_t> *>(&qRegister))
+		clRegister->finish();
+}
+
+std::optional<cl::Device> findDevice() {
+	std::vector<cl::Platform> platforms;
+	cl::Platform::get(&platforms);
+
+	for (cl_device_type type: {CL_DEVICE_TYPE_GPU, CL_DEVICE_TYPE_CPU}) {
+		for (const auto &platform: platforms) {
+			std::vector<cl::Device> devices;
+			platform.getDevices(type, &devices);
+
+			if (!devices.empty())
+				return devices[0];
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::unique_ptr<Circuit::QuantumRegister<real_t>> createRegister(const std::string &backend, size_t numQubits,
+																 const std::optional<cl::Device> &device) {
+	if (backend == "basic")
+		return std::make_unique<Circuit::BasicQuantumRegister<real_t>>(numQubits);
+	if (backend == "vectorized")
+		return std::make_unique<Circuit::VectorizedQuantumRegister<real_t>>(numQubits);
+	if (backend == "split")
+		return std::make_unique<Circuit::SplitQuantumRegister<real_t>>(numQubits);
+	if (backend == "half")
+		return std::make_unique<Circuit::HalfPrecisionQuantumRegister>(numQubits);
+	if (backend == "cl") {
+		if (!device)
+			throw std::runtime_error("No OpenCL device");
+		return std::make_unique<Circuit::CLQuantumRegister<real_t>>(numQubits, cl::Context(*device), *device);
+	}
+	throw std::runtime_error("Unknown backend " + backend);
+}
+
+int main(int argc, char **argv) {
+	size_t numQubits = argc > 1 ? std::stoul(argv[1]) : 20;
+	size_t depth = argc > 2 ? std::stoul(argv[2]) : 10;
+	std::string backendList = argc > 3 ? argv[3] : "basic,vectorized,split,half,cl";
+
+	std::vector<std::string> backends;
+	std::stringstream stream(backendList);
+	for (std::string backend; std::getline(stream, backend, ',');)
+		backends.push_back(backend);
+
+	std::optional<cl::Device> device;
+	if (std::ranges::find(backends, "cl") != backends.end()) {
+		device = findDevice();
+		if (device)
+			std::cout << "OpenCL device: " << device->getInfo<CL_DEVICE_NAME>() << std::endl;
+	}
+
+	std::mt19937 rng(42);
+	std::vector<Workload> workloads;
+	workloads.push_back(qft(numQubits));
+	workloads.push_back(ghz(numQubits));
+	workloads.push_back(grover(numQubits, depth));
+	workloads.push_back(qaoa(numQubits, depth, rng));
+	workloads.push_back(randomCircuit(numQubits, depth, rng));
+
+	std::vector<real_t> randomNumbers(Shots);
+	std::uniform_real_distribution<real_t> uniform01(0, 1);
+	for (auto &number: randomNumbers)
+		number = uniform01(rng);
+
+	std::string fileName = (std::filesystem::temp_directory_path() / "CircuitBenchmark.bin").string();
+
+	std::cout << "Qubits: " << numQubits << ", depth: " << depth << ", shots: " << Shots << std::endl;
+	std::cout << std::left << std::setw(10) << "Circuit" << std::setw(12) << "Register" << std::right
+			  << std::setw(8) << "Gates" << std::setw(12) << "Wall ms" << std::setw(12) << "Setup ms"
+			  << std::setw(12) << "Gates ms" << std::setw(12) << "Measure ms" << std::setw(10) << "I/O ms"
+			  << std::setw(14) << "Peak RSS MB" << std::endl;
+
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](Clock::time_point from, Clock::time_point to) {
+		return std::chrono::duration<double, std::milli>(to - from).count();
+	};
+
+	for (const auto &workload: workloads) {
+		for (const auto &backend: backends) {
+			std::cout << std::left << std::setw(10) << workload.name << std::setw(12) << backend << std::right;
+			resetPeakMemory();
+
+			try {
+				auto start = Clock::now();
+				auto qRegister = createRegister(backend, numQubits, device);
+
+				auto gatesStart = Clock::now();
+				for (const auto &operation: workload.operations)
+					operation(*qRegister);
+				finish(*qRegister);
+
+				auto measureStart = Clock::now();
+				auto marginals = qRegister->marginals();
+				auto shots = qRegister->sample(randomNumbers);
+
+				auto ioStart = Clock::now();
+				qRegister->toFile(fileName);
+				auto end = Clock::now();
+
+				std::cout << std::fixed << std::setprecision(1) << std::setw(8) << workload.operations.size()
+						  << std::setw(12) << milliseconds(start, end) << std::setw(12) << milliseconds(start, gatesStart)
+						  << std::setw(12) << milliseconds(gatesStart, measureStart)
+						  << std::setw(12) << milliseconds(measureStart, ioStart) << std::setw(10) << milliseconds(ioStart, end)
+						  << std::setw(14) << peakMemory() << std::defaultfloat << std::endl;
+			} catch (const std::exception &e) {
+				std::cout << "  ERROR: " << e.what() << std::endl;
+			}
+		}
+	}
+
+	std::filesystem::remove(fileName);
+}
@@ -0,0 +1,680 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/circuit/BasicQuantumRegister.h"
+#include "../src/circuit/VectorizedQuantumRegister.h"
+#include "../src/circuit/SplitQuantumRegister.h"
+#include "../src/circuit/HalfPrecisionQuantumRegister.h"
+#include "../src/circuit/MPSRegister.h"
+#include "../src/circuit/DensityMatrixRegister.h"
+#include "../src/circuit/SparseQuantumRegister.h"
+#include "../src/circuit/StabilizerRegister.h"
+#include "../src/circuit/CLQuantumRegister.h"
+#include "../src/circuit/CLHalfPrecisionQuantumRegister.h"
+#include "../src/algebra/Constants.h"
+#include "CL/opencl.hpp"
+
+using namespace KQS;
+
+template<typename T>
+using Gate = Circuit::QuantumLogicGate<T>;
+
+/**
+ * Cross-checks the registers against BasicQuantumRegister. Runs random circuits covering every gate path (the named
+ * gates, dense gates on up to five qubits, diagonal, permutation, monomial and controlled gates and qubit map
+ * changes) on every register, compares the state vectors with the reference and reports the time of the gates
+ * relative to the reference. If a final state differs, the circuit is replayed to report the first differing gate.
+ * The check runs in each of the listed precisions, the tolerances of double precision are tighter; the 16-bit
+ * registers compute in single precision and only run in it.
+ *
+ * Usage: CrossCheck [numQubits = 12] [circuits = 20] [gates = 100]
+ *                   [backends = vectorized,split,half,half-bf16,sparse,stabilizer,cl,cl-half,cl-half-bf16] [seed = 1]
+ *                   [precisions = single,double]
+ *
+ * MPSRegister (backend mps) runs with the bond dimension of an exact state and no truncation threshold, so it must
+ * not truncate. It is not run by default: at the exact bond dimension its Jacobi SVDs make it about 350 times
+ * slower than the reference on 12 qubits (seconds instead of milliseconds). ctest runs it on 8 qubits.
+ * SparseQuantumRegister runs with a dense threshold of 1, so all gates go through its sparse kernels.
+ * StabilizerRegister (backend stabilizer) only accepts Clifford gates and has no state vector, so it runs separate
+ * random Clifford circuits (named Clifford gates and Clifford gate matrices): its marginals are compared with those
+ * of the reference and all outcomes it samples must have a non-zero probability in the reference. Its row reports
+ * the deviation of the marginals and the speedup over the reference on these circuits.
+ * DensityMatrixRegister (backend density) is not run by default, its 4^n elements make it slow on 12 qubits. It
+ * returns the state vector only up to a global phase, which is removed before comparing.
+ * HalfPrecisionQuantumRegister runs with FP16 (backend half) and bfloat16 (backend half-bf16) amplitudes, with
+ * tolerances scaled by the unit roundoff of the format.
+ * CLQuantumRegister (backend cl) and CLHalfPrecisionQuantumRegister (backends cl-half and cl-half-bf16) run on the
+ * first CPU device, or GPU if there is no CPU runtime. Without any device they are skipped and the other registers
+ * still checked.
+ * Exits with 1 if any register differs from the reference by more than its tolerance or fails, otherwise with
+ * SkipReturnCode if OpenCL registers were skipped (the SKIP_RETURN_CODE of the ctest), and 0 if all passed.
+ */
+
+template<typename T>
+using Operation = std::function<void(Circuit::QuantumRegister<T> &)>;
+
+template<typename T>
+struct Step {
+	/** Gate and qubits, for the report. */
+	std::string name;
+	Operation<T> apply;
+};
+
+/** Clifford gate, applied to a QuantumRegister or a StabilizerRegister, which have the same gate methods. */
+template<typename T>
+struct CliffordStep {
+	std::string name;
+	Operation<T> apply;
+	std::function<void(Circuit::StabilizerRegister<T> &)> applyStabilizer;
+};
+
+/**
+ * Euclidean distance of the state vectors at which the 16-bit registers fail, relative to the unit roundoff of their
+ * format times the square root of the number of gates. Every gate rounds the amplitudes anew, so the errors add up
+ * like a random walk; the measured distances stay below half of this bound, e.g. 1.7e-3 for FP16 and 1.4e-2 for
+ * bfloat16 after 112 gates.
+ */
+constexpr double HalfRoundingTolerance = 0.6;
+
+/** Euclidean distance of the state vectors at which the registers of the precision T fail, per gate. */
+template<typename T>
+constexpr double GateTolerance = std::is_same_v<T, float> ? 1e-5 : 1e-13;
+
+/** Deviation of the marginals at which the stabilizer register of the precision T fails. */
+template<typename T>
+constexpr double MarginalTolerance = std::is_same_v<T, float> ? 1e-4 : 1e-12;
+
+/** Probability in the reference below which a sampled outcome is outside its support. */
+constexpr double SupportTolerance = 1e-7;
+
+/** Shots sampled from the stabilizer register per circuit. */
+constexpr size_t CliffordShots = 256;
+
+/** Exit code when all checked registers passed but the OpenCL registers were skipped, as automake uses. */
+constexpr int SkipReturnCode = 77;
+
+/////////////// Random gates ///////////////
+
+/** Random unitary from the QR decomposition of a Gaussian matrix (Gram-Schmidt on its columns). */
+template<typename T>
+Gate<T> randomUnitary(size_t qubits, std::mt19937 &rng) {
+	size_t dimension = 1ULL << qubits;
+	std::normal_distribution<double> normal;
+
+	std::vector<std::vector<std::complex<double>>> columns(dimension, std::vector<std::complex<double>>(dimension));
+	for (size_t c = 0; c < dimension; ++c) {
+		for (auto &element: columns[c])
+			element = {normal(rng), normal(rng)};
+
+		for (size_t p = 0; p < c; ++p) {
+			std::complex<double> projection = 0;
+			for (size_t r = 0; r < dimension; ++r)
+				projection += std::conj(columns[p][r]) * columns[c][r];
+			for (size_t r = 0; r < dimension; ++r)
+				columns[c][r] -= projection * columns[p][r];
+		}
+
+		double norm = 0;
+		for (const auto &element: columns[c])
+			norm += std::norm(element);
+		for (auto &element: columns[c])
+			element /= std::sqrt(norm);
+	}
+
+	ComplexMatrix<T> matrix(dimension, dimension);
+	for (size_t r = 0; r < dimension; ++r)
+		for (size_t c = 0; c < dimension; ++c)
+			matrix[r, c, std::complex<T>(columns[c][r])];
+	return Gate<T>(matrix);
+}
+
+/** Random monomial gate, a permutation with phases, or a permutation or diagonal gate if requested. */
+template<typename T>
+Gate<T> randomMonomial(size_t qubits, bool permute, bool phases, std::mt19937 &rng) {
+	size_t dimension = 1ULL << qubits;
+	std::vector<size_t> sources(dimension);
+	std::iota(sources.begin(), sources.end(), 0);
+	if (permute)
+		std::ranges::shuffle(sources, rng);
+
+	std::uniform_real_distribution<T> angle(0, 2 * Algebra::PI<T>);
+	ComplexMatrix<T> matrix(dimension, dimension);
+	for (size_t r = 0; r < dimension; ++r)
+		matrix[r, sources[r], phases ? std::polar<T>(1, angle(rng)) : std::complex<T>(1)];
+	return Gate<T>(matrix);
+}
+
+/** Distinct random qubits. */
+std::vector<size_t> randomQubits(size_t count, size_t numQubits, std::mt19937 &rng) {
+	std::vector<size_t> qubits(numQubits);
+	std::iota(qubits.begin(), qubits.end(), 0);
+	std::ranges::shuffle(qubits, rng);
+	qubits.resize(count);
+	return qubits;
+}
+
+std::string qubitList(const std::vector<size_t> &qubits) {
+	std::string list;
+	for (size_t i = 0; i < qubits.size(); ++i)
+		list += std::format("{}{}", i > 0 ? "," : "", qubits[i]);
+	return list;
+}
+
+template<typename T>
+std::vector<Step<T>> randomCircuit(size_t numQubits, size_t gates, std::mt19937 &rng) {
+	std::vector<Step<T>> circuit;
+	std::uniform_real_distribution<T> angle(0, 2 * Algebra::PI<T>);
+	std::uniform_int_distribution<size_t> kinds(0, 19);
+
+	// starts from a random product state, so that no amplitude is zero
+	for (size_t q = 0; q < numQubits; ++q) {
+		Gate<T> gate = randomUnitary<T>(1, rng);
+		circuit.push_back({std::format("Dense {}", q), [=](auto &r) { r.gate(gate, {q}); }});
+	}
+
+	auto upTo = [&](size_t count) {
+		return std::uniform_int_distribution<size_t>(1, std::min(count, numQubits))(rng);
+	};
+
+	while (circuit.size() < numQubits + gates) {
+		size_t kind = kinds(rng);
+		// kinds using several qubits are skipped on too small registers
+		if ((kind >= 7 && numQubits < 2) || (kind == 11 && numQubits < 3))
+			continue;
+
+		std::vector<size_t> q = randomQubits(std::min<size_t>(3, numQubits), numQubits, rng);
+		T phi = angle(rng);
+		switch (kind) {
+			case 0: circuit.push_back({std::format("X {}", q[0]), [=](auto &r) { r.pauliX(q[0]); }}); break;
+			case 1: circuit.push_back({std::format("Y {}", q[0]), [=](auto &r) { r.pauliY(q[0]); }}); break;
+			case 2: circuit.push_back({std::format("Z {}", q[0]), [=](auto &r) { r.pauliZ(q[0]); }}); break;
+			case 3: circuit.push_back({std::format("H {}", q[0]), [=](auto &r) { r.hadamard(q[0]); }}); break;
+			case 4: circuit.push_back({std::format("Phase {}", q[0]), [=](auto &r) { r.phase(q[0], phi); }}); break;
+			case 5: circuit.push_back({std::format("T {}", q[0]), [=](auto &r) { r.piOverEight(q[0]); }}); break;
+			case 6: {
+				Gate<T> gate = randomUnitary<T>(1, rng);
+				circuit.push_back({std::format("Dense {}", q[0]), [=](auto &r) { r.gate(gate, {q[0]}); }});
+				break;
+			}
+			case 7:
+				circuit.push_back({std::format("CX {},{}", q[0], q[1]), [=](auto &r) { r.controlledX(q[0], q[1]); }});
+				break;
+			case 8:
+				circuit.push_back({std::format("CY {},{}", q[0], q[1]), [=](auto &r) { r.controlledY(q[0], q[1]); }});
+				break;
+			case 9:
+				circuit.push_back({std::format("CPhase {},{}", q[0], q[1]),
+								   [=](auto &r) { r.controlledPhase(q[0], q[1], phi); }});
+				break;
+			case 10:
+				circuit.push_back({std::format("Swap {},{}", q[0], q[1]), [=](auto &r) { r.swap(q[0], q[1]); }});
+				break;
+			case 11:
+				circuit.push_back({std::format("Toffoli {},{},{}", q[0], q[1], q[2]),
+								   [=](auto &r) { r.toffoli(q[0], q[1], q[2]); }});
+				break;
+			case 12: case 13: {
+				std::vector<size_t> qubits = randomQubits(upTo(5), numQubits, rng);
+				Gate<T> gate = randomUnitary<T>(qubits.size(), rng);
+				circuit.push_back({std::format("Dense {}", qubitList(qubits)), [=](auto &r) { r.gate(gate, qubits); }});
+				break;
+			}
+			case 14: {
+				std::vector<size_t> qubits = randomQubits(upTo(4), numQubits, rng);
+				Gate<T> gate = randomMonomial<T>(qubits.size(), false, true, rng);
+				circuit.push_back({std::format("Diagonal {}", qubitList(qubits)),
+								   [=](auto &r) { r.gate(gate, qubits); }});
+				break;
+			}
+			case 15: {
+				std::vector<size_t> qubits = randomQubits(upTo(4), numQubits, rng);
+				Gate<T> gate = randomMonomial<T>(qubits.size(), true, false, rng);
+				circuit.push_back({std::format("Permutation {}", qubitList(qubits)),
+								   [=](auto &r) { r.gate(gate, qubits); }});
+				break;
+			}
+			case 16: {
+				std::vector<size_t> qubits = randomQubits(upTo(4), numQubits, rng);
+				Gate<T> gate = randomMonomial<T>(qubits.size(), true, true, rng);
+				circuit.push_back({std::format("Monomial {}", qubitList(qubits)), [=](auto &r) { r.gate(gate, qubits); }});
+				break;
+			}
+			case 17: case 18: {
+				// controls first, then a dense gate on one or two targets
+				std::vector<size_t> qubits = randomQubits(upTo(4), numQubits, rng);
+				if (qubits.size() < 2)
+					continue;
+				size_t targets = qubits.size() > 2 ? upTo(2) : 1;
+				Gate<T> gate = Gate<T>::makeControlled(randomUnitary<T>(targets, rng), qubits.size() - targets);
+				circuit.push_back({std::format("Controlled {}", qubitList(qubits)),
+								   [=](auto &r) { r.gate(gate, qubits); }});
+				break;
+			}
+			default: {
+				std::vector<size_t> qubitMap = randomQubits(numQubits, numQubits, rng);
+				circuit.push_back({std::format("QubitMap {}", qubitList(qubitMap)),
+								   [=](auto &r) { r.setQubitMap(qubitMap); }});
+				break;
+			}
+		}
+	}
+
+	return circuit;
+}
+
+/** Step of a Clifford circuit applying the same gate to both kinds of registers. */
+template<typename T, typename F>
+CliffordStep<T> cliffordStep(std::string name, F apply) {
+	return {std::move(name), apply, apply};
+}
+
+template<typename T>
+std::vector<CliffordStep<T>> randomCliffordCircuit(size_t numQubits, size_t gates, std::mt19937 &rng) {
+	std::vector<CliffordStep<T>> circuit;
+	std::uniform_int_distribution<size_t> kinds(0, 11);
+	std::uniform_int_distribution<int> quarters(0, 3);
+
+	// Clifford gates given as matrices, for the path computing their action on the Pauli operators
+	Gate<T> sqrtX(ComplexMatrix<T>{{{0.5f, 0.5f}, {0.5f, -0.5f}}, {{0.5f, -0.5f}, {0.5f, 0.5f}}});
+	std::vector<std::pair<std::string, Gate<T>>> matrices = {
+			{"H", Gate<T>::hadamard()}, {"S", Gate<T>::phase(Algebra::PI<T> / 2)}, {"SqrtX", sqrtX},
+			{"CX", Gate<T>::controlledX()}, {"CZ", Gate<T>::controlledZ()}, {"Swap", Gate<T>::swap()}};
+
+	while (circuit.size() < gates) {
+		size_t kind = kinds(rng);
+		if (kind >= 6 && numQubits < 2)
+			continue;
+
+		std::vector<size_t> q = randomQubits(std::min<size_t>(2, numQubits), numQubits, rng);
+		T phi = static_cast<T>(quarters(rng)) * Algebra::PI<T> / 2;
+		switch (kind) {
+			case 0:
+				circuit.push_back(cliffordStep<T>(std::format("X {}", q[0]), [=](auto &r) { r.pauliX(q[0]); }));
+				break;
+			case 1:
+				circuit.push_back(cliffordStep<T>(std::format("Y {}", q[0]), [=](auto &r) { r.pauliY(q[0]); }));
+				break;
+			case 2:
+				circuit.push_back(cliffordStep<T>(std::format("Z {}", q[0]), [=](auto &r) { r.pauliZ(q[0]); }));
+				break;
+			case 3: case 4:
+				circuit.push_back(cliffordStep<T>(std::format("H {}", q[0]), [=](auto &r) { r.hadamard(q[0]); }));
+				break;
+			case 5:
+				circuit.push_back(cliffordStep<T>(std::format("Phase {}", q[0]), [=](auto &r) { r.phase(q[0], phi); }));
+				break;
+			case 6:
+				circuit.push_back(cliffordStep<T>(std::format("CX {},{}", q[0], q[1]),
+											   [=](auto &r) { r.controlledX(q[0], q[1]); }));
+				break;
+			case 7:
+				circuit.push_back(cliffordStep<T>(std::format("CY {},{}", q[0], q[1]),
+											   [=](auto &r) { r.controlledY(q[0], q[1]); }));
+				break;
+			case 8:
+				circuit.push_back(cliffordStep<T>(std::format("CPhase {},{}", q[0], q[1]),
+											   [=](auto &r) { r.controlledPhase(q[0], q[1], phi * 2); }));
+				break;
+			case 9:
+				circuit.push_back(cliffordStep<T>(std::format("Swap {},{}", q[0], q[1]),
+											   [=](auto &r) { r.swap(q[0], q[1]); }));
+				break;
+			default: {
+				const auto &[name, gate] = matrices[std::uniform_int_distribution<size_t>(0, 5)(rng)];
+				std::vector<size_t> qubits = q;
+				qubits.resize(gate.matrix().rows() == 2 ? 1 : 2);
+				circuit.push_back(cliffordStep<T>(std::format("{} matrix {}", name, qubitList(qubits)),
+											   [=](auto &r) { r.gate(gate, qubits); }));
+				break;
+			}
+		}
+	}
+
+	return circuit;
+}
+
+/////////////// Cross-check ///////////////
+
+std::optional<cl::Device> findDevice() {
+	std::vector<cl::Platform> platforms;
+	cl::Platform::get(&platforms);
+
+	for (cl_device_type type: {CL_DEVICE_TYPE_CPU, CL_DEVICE_TYPE_GPU}) {
+		for (const auto &platform: platforms) {
+			std::vector<cl::Device> devices;
+			platform.getDevices(type, &devices);
+
+			if (!devices.empty())
+				return devices[0];
+		}
+	}
+
+	return std::nullopt;
+}
+
+/** Euclidean distance of the state vectors after the number of gates at which the 16-bit register fails. */
+double halfTolerance(Circuit::HalfFormat format, size_t gates) {
+	// 11 significant bits in FP16, 8 in bfloat16
+	double unitRoundoff = std::ldexp(1.0, format == Circuit::HalfFormat::FP16 ? -11 : -8);
+	return HalfRoundingTolerance * unitRoundoff * std::sqrt(static_cast<double>(gates));
+}
+
+/** Format of the amplitudes of the 16-bit backends, empty for the others. */
+std::optional<Circuit::HalfFormat> halfFormat(const std::string &backend) {
+	if (backend == "half" || backend == "cl-half")
+		return Circuit::HalfFormat::FP16;
+	if (backend == "half-bf16" || backend == "cl-half-bf16")
+		return Circuit::HalfFormat::BF16;
+	return std::nullopt;
+}
+
+template<typename T>
+std::unique_ptr<Circuit::QuantumRegister<T>> createRegister(const std::string &backend, size_t numQubits,
+															const std::optional<cl::Device> &device) {
+	if (backend == "basic")
+		return std::make_unique<Circuit::BasicQuantumRegister<T>>(numQubits);
+	if (backend == "vectorized")
+		return std::make_unique<Circuit::VectorizedQuantumRegister<T>>(numQubits);
+	if (backend == "split")
+		return std::make_unique<Circuit::SplitQuantumRegister<T>>(numQubits);
+	if constexpr (std::is_same_v<T, float>) {
+		if (backend == "half" || backend == "half-bf16")
+			return std::make_unique<Circuit::HalfPrecisionQuantumRegister>(numQubits, *halfFormat(backend));
+		if (backend == "cl-half" || backend == "cl-half-bf16")
+			return std::make_unique<Circuit::CLHalfPrecisionQuantumRegister>(numQubits, cl::Context(*device), *device,
+																			 *halfFormat(backend));
+	}
+	if (backend == "mps")
+		return std::make_unique<Circuit::MPSRegister<T>>(numQubits, 1ULL << (numQubits / 2), 0);
+	if (backend == "sparse")
+		return std::make_unique<Circuit::SparseQuantumRegister<T>>(numQubits, 1.0);
+	if (backend == "density")
+		return std::make_unique<Circuit::DensityMatrixRegister<T>>(numQubits);
+	if (backend == "cl")
+		return std::make_unique<Circuit::CLQuantumRegister<T>>(numQubits, cl::Context(*device), *device);
+	throw std::runtime_error("Unknown backend " + backend);
+}
+
+/** Euclidean distance of the state vectors. */
+template<typename T>
+double distance(const std::vector<std::complex<T>> &a, const std::vector<std::complex<T>> &b) {
+	double sum = 0;
+	for (size_t i = 0; i < a.size(); ++i)
+		sum += std::norm(std::complex<double>(a[i]) - std::complex<double>(b[i]));
+	return std::sqrt(sum);
+}
+
+/**
+ * Returns the state vector of the register, with the global phase of the expected state if the register does not
+ * keep the global phase.
+ */
+template<typename T>
+std::vector<std::complex<T>> stateVector(const Circuit::QuantumRegister<T> &qRegister,
+										 const std::vector<std::complex<T>> &expected, bool alignPhase) {
+	std::vector<std::complex<T>> state = qRegister.stateVector();
+	if (!alignPhase)
+		return state;
+
+	std::complex<double> overlap = 0;
+	for (size_t i = 0; i < state.size(); ++i)
+		overlap += std::complex<double>(std::conj(state[i])) * std::complex<double>(expected[i]);
+	if (std::abs(overlap) > 0) {
+		auto phase = std::complex<T>(overlap / std::abs(overlap));
+		for (auto &amplitude: state)
+			amplitude *= phase;
+	}
+	return state;
+}
+
+/**
+ * Replays the circuit on the register and the reference and returns the index of the first differing gate.
+ * @param tolerance returns the distance allowed after the number of gates
+ */
+template<typename T>
+size_t firstDifference(const std::vector<Step<T>> &circuit, Circuit::QuantumRegister<T> &qRegister,
+					   Circuit::QuantumRegister<T> &reference, const std::function<double(size_t)> &tolerance,
+					   bool alignPhase) {
+	std::vector<std::complex<T>> initial(1ULL << qRegister.qubits());
+	initial[0] = 1;
+	qRegister.setStateVector(initial);
+	reference.setStateVector(initial);
+
+	for (size_t i = 0; i < circuit.size(); ++i) {
+		circuit[i].apply(qRegister);
+		circuit[i].apply(reference);
+		std::vector<std::complex<T>> expected = reference.stateVector();
+		if (distance(stateVector(qRegister, expected, alignPhase), expected) > tolerance(i + 1))
+			return i;
+	}
+	return circuit.size();
+}
+
+struct CliffordResult {
+	size_t failures = 0;
+	/** Maximal deviation of the marginals. */
+	double maxDistance = 0;
+	std::chrono::nanoseconds time{0};
+	std::chrono::nanoseconds referenceTime{0};
+};
+
+/**
+ * Runs random Clifford circuits on the stabilizer register and the reference, compares the marginals and checks
+ * that every sampled outcome has a non-zero probability in the reference.
+ */
+template<typename T>
+CliffordResult checkStabilizer(size_t numQubits, size_t circuits, size_t gates, std::mt19937 &rng) {
+	using Clock = std::chrono::steady_clock;
+	CliffordResult result;
+
+	for (size_t c = 0; c < circuits; ++c) {
+		std::vector<CliffordStep<T>> circuit = randomCliffordCircuit<T>(numQubits, gates, rng);
+		std::mt19937_64 random(rng());
+
+		Circuit::BasicQuantumRegister<T> reference(numQubits);
+		auto start = Clock::now();
+		for (const auto &step: circuit)
+			step.apply(reference);
+		result.referenceTime += Clock::now() - start;
+
+		try {
+			Circuit::StabilizerRegister<T> qRegister(numQubits);
+			start = Clock::now();
+			for (const auto &step: circuit)
+				step.applyStabilizer(qRegister);
+			result.time += Clock::now() - start;
+
+			std::vector<T> expected = reference.marginals();
+			std::vector<T> marginals = qRegister.marginals();
+			double d = 0;
+			for (size_t q = 0; q < numQubits; ++q)
+				d = std::max(d, std::abs(static_cast<double>(marginals[q] - expected[q])));
+			result.maxDistance = std::max(result.maxDistance, d);
+			if (d > MarginalTolerance<T>) {
+				result.failures++;
+				std::cout << std::format("stabilizer: circuit {} marginals differ by {:.3e}", c, d) << std::endl;
+				continue;
+			}
+
+			std::vector<std::complex<T>> state = reference.stateVector();
+			for (const auto &outcome: qRegister.sample(CliffordShots, random)) {
+				if (std::norm(state[outcome[0]]) >= SupportTolerance)
+					continue;
+				result.failures++;
+				std::cout << std::format("stabilizer: circuit {} sampled outcome {} of probability {:.3e}", c,
+										 outcome[0], std::norm(state[outcome[0]])) << std::endl;
+				break;
+			}
+		} catch (const std::exception &e) {
+			result.failures++;
+			std::cout << std::format("stabilizer: circuit {} failed: {}", c, e.what()) << std::endl;
+		}
+	}
+
+	return result;
+}
+
+/**
+ * Runs the random circuits on the registers of the backends in the precision T, prints their results and returns
+ * whether any register failed.
+ */
+template<typename T>
+bool check(size_t numQubits, size_t circuits, size_t gates, std::vector<std::string> backends, bool stabilizer,
+		   const std::optional<cl::Device> &device, unsigned seed) {
+	// 16-bit storage computes in single precision
+	if constexpr (!std::is_same_v<T, float>)
+		std::erase_if(backends, [](const std::string &backend) { return halfFormat(backend).has_value(); });
+
+	std::cout << std::endl << (precisionOf<T> == Precision::Single ? "Single" : "Double") << " precision"
+			  << std::endl;
+
+	using Clock = std::chrono::steady_clock;
+	std::mt19937 rng(seed);
+
+	std::vector<std::chrono::nanoseconds> times(backends.size());
+	std::vector<double> maxDistances(backends.size());
+	std::vector<size_t> failures(backends.size());
+	std::chrono::nanoseconds referenceTime{0};
+
+	for (size_t c = 0; c < circuits; ++c) {
+		std::vector<Step<T>> circuit = randomCircuit<T>(numQubits, gates, rng);
+
+		Circuit::BasicQuantumRegister<T> reference(numQubits);
+		auto start = Clock::now();
+		for (const auto &step: circuit)
+			step.apply(reference);
+		referenceTime += Clock::now() - start;
+		std::vector<std::complex<T>> expected = reference.stateVector();
+
+		for (size_t b = 0; b < backends.size(); ++b) {
+			std::optional<Circuit::HalfFormat> format = halfFormat(backends[b]);
+			auto tolerance = [format](size_t gates) {
+				return format ? halfTolerance(*format, gates) : GateTolerance<T> * static_cast<double>(gates);
+			};
+			bool alignPhase = backends[b] == "density";
+			try {
+				auto qRegister = createRegister<T>(backends[b], numQubits, device);
+				start = Clock::now();
+				for (const auto &step: circuit)
+					step.apply(*qRegister);
+				times[b] += Clock::now() - start;
+
+				double d = distance(stateVector(*qRegister, expected, alignPhase), expected);
+				maxDistances[b] = std::max(maxDistances[b], d);
+				if (d <= tolerance(circuit.size()))
+					continue;
+
+				failures[b]++;
+				size_t gate = firstDifference<T>(circuit, *qRegister, reference, tolerance, alignPhase);
+				std::cout << std::format("{}: circuit {} differs by {:.3e}, first at gate {} ({})", backends[b], c, d,
+										 gate, gate < circuit.size() ? circuit[gate].name : "none") << std::endl;
+			} catch (const std::exception &e) {
+				failures[b]++;
+				std::cout << std::format("{}: circuit {} failed: {}", backends[b], c, e.what()) << std::endl;
+			}
+		}
+	}
+
+	auto milliseconds = [](std::chrono::nanoseconds time) {
+		return std::chrono::duration<double, std::milli>(time).count();
+	};
+
+	std::cout << std::left << std::setw(12) << "Register" << std::right << std::setw(10) << "Failed"
+			  << std::setw(14) << "Max distance" << std::setw(12) << "Gates ms" << std::setw(10) << "Speedup"
+			  << std::endl;
+	std::cout << std::left << std::setw(12) << "basic" << std::right << std::setw(10) << "-" << std::setw(14) << "-"
+			  << std::fixed << std::setprecision(1) << std::setw(12) << milliseconds(referenceTime)
+			  << std::setw(10) << "1.00" << std::endl;
+
+	bool failed = false;
+	for (size_t b = 0; b < backends.size(); ++b) {
+		failed |= failures[b] > 0;
+		std::cout << std::left << std::setw(12) << backends[b] << std::right << std::setw(10)
+				  << std::format("{}/{}", failures[b], circuits) << std::setw(14) << std::scientific
+				  << std::setprecision(2) << maxDistances[b] << std::fixed << std::setprecision(1) << std::setw(12)
+				  << milliseconds(times[b]) << std::setprecision(2) << std::setw(10)
+				  << milliseconds(referenceTime) / std::max(milliseconds(times[b]), 1e-9) << std::endl;
+	}
+
+	if (stabilizer) {
+		CliffordResult clifford = checkStabilizer<T>(numQubits, circuits, gates, rng);
+		failed |= clifford.failures > 0;
+		std::cout << std::left << std::setw(12) << "stabilizer" << std::right << std::setw(10)
+				  << std::format("{}/{}", clifford.failures, circuits) << std::setw(14) << std::scientific
+				  << std::setprecision(2) << clifford.maxDistance << std::fixed << std::setprecision(1)
+				  << std::setw(12) << milliseconds(clifford.time) << std::setprecision(2) << std::setw(10)
+				  << milliseconds(clifford.referenceTime) / std::max(milliseconds(clifford.time), 1e-9) << std::endl;
+	}
+	std::cout << std::defaultfloat;
+
+	return failed;
+}
+
+int main(int argc, char **argv) {
+	size_t numQubits = argc > 1 ? std::stoul(argv[1]) : 12;
+	size_t circuits = argc > 2 ? std::stoul(argv[2]) : 20;
+	size_t gates = argc > 3 ? std::stoul(argv[3]) : 100;
+	std::string backendList = argc > 4 ? argv[4]
+									   : "vectorized,split,half,half-bf16,sparse,stabilizer,cl,cl-half,cl-half-bf16";
+	unsigned seed = argc > 5 ? static_cast<unsigned>(std::stoul(argv[5])) : 1;
+	std::string precisionList = argc > 6 ? argv[6] : "single,double";
+
+	std::vector<std::string> backends;
+	std::stringstream stream(backendList);
+	for (std::string backend; std::getline(stream, backend, ',');)
+		backends.push_back(backend);
+	// the stabilizer register runs its own Clifford circuits after the others
+	bool stabilizer = std::erase(backends, "stabilizer") > 0;
+
+	std::vector<Precision> precisions;
+	std::stringstream precisionStream(precisionList);
+	for (std::string precision; std::getline(precisionStream, precision, ',');)
+		precisions.push_back(parsePrecision(precision));
+
+	std::optional<cl::Device> device;
+	bool skipped = false;
+	auto openCL = [](const std::string &backend) { return backend.starts_with("cl"); };
+	if (std::ranges::any_of(backends, openCL)) {
+		device = findDevice();
+		if (device)
+			std::cout << "OpenCL device: " << device->getInfo<CL_DEVICE_NAME>() << std::endl;
+		else {
+			std::cout << "No OpenCL device, skipping the OpenCL registers" << std::endl;
+			std::erase_if(backends, openCL);
+			skipped = true;
+		}
+	}
+
+	std::cout << "Qubits: " << numQubits << ", circuits: " << circuits << ", gates: " << gates << ", seed: " << seed
+			  << std::endl;
+
+	// the same circuits, up to the rounding of their gates, in every precision
+	bool failed = false;
+	for (Precision precision: precisions)
+		failed |= dispatchPrecision(precision, [&]<typename T>() {
+			return check<T>(numQubits, circuits, gates, backends, stabilizer, device, seed);
+		});
+
+	std::cout << std::endl;
+	if (failed) {
+		std::cout << "FAILED" << std::endl;
+		return 1;
+	}
+	if (skipped) {
+		std::cout << "PASSED, OpenCL registers SKIPPED" << std::endl;
+		return SkipReturnCode;
+	}
+	std::cout << "PASSED" << std::endl;
+	return 0;
+}
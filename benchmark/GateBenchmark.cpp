@@ -0,0 +1,478 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+#include <format>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/parallel.h"
+#include "../src/circuit/BasicQuantumRegister.h"
+#include "../src/circuit/VectorizedQuantumRegister.h"
+#include "../src/circuit/SplitQuantumRegister.h"
+#include "../src/circuit/CLQuantumRegister.h"
+#include "../src/circuit/PerfCounters.h"
+#include "../src/algebra/Constants.h"
+#include "CL/opencl.hpp"
+
+using namespace KQS;
+
+template<typename T>
+using Gate = Circuit::QuantumLogicGate<T>;
+
+/**
+ * Benchmark suite of gate application. Sweeps the number of qubits, the position of the target qubit, the kind of
+ * the gate, the register and the number of threads, and reports the time per gate, the gates per second and the
+ * effective state vector bandwidth (every gate counted as reading and writing the whole state vector). Like Google
+ * Benchmark, every case is repeated until it runs for at least the minimal time, and the results can be written
+ * as JSON in the Google Benchmark format, so they can be compared between releases with its tools (compare.py).
+ *
+ * Usage: GateBenchmark [options]
+ *   --qubits=FIRST:LAST[:STEP]    numbers of qubits (default 10:30:4)
+ *   --targets=edges|all           target qubits: 0, 1, n/2 and n-1, or every qubit (default edges)
+ *   --backends=LIST               comma separated basic, vectorized, split, cl (default basic,vectorized,cl)
+ *   --threads=LIST                comma separated thread counts, 0 for all hardware threads (default 1,0)
+ *   --precision=single|double     precision of the registers (default single)
+ *   --cl_device=cpu|gpu           type of the OpenCL device (default cpu)
+ *   --benchmark_filter=REGEX      runs only the benchmarks with matching names
+ *   --benchmark_min_time=SECONDS  minimal time of every benchmark (default 0.2)
+ *   --benchmark_out=FILE          writes the results as JSON to the file
+ *   --perf_counters               reports cycles, instructions per cycle, LLC and dTLB misses per gate (Linux)
+ *
+ * The structured kinds (Diagonal1, Permutation1, Permutation2, Monomial2) have a twin prefixed with Dense that applies
+ * the same matrix with the dense kernels, the structured kernels must never be slower than their twin.
+ *
+ * Registers that do not fit into the memory are reported as errors and skipped.
+ */
+
+struct Options {
+	std::vector<size_t> qubits;
+	bool allTargets = false;
+	std::vector<std::string> backends = {"basic", "vectorized", "cl"};
+	std::vector<size_t> threads = {1, 0};
+	cl_device_type clDevice = CL_DEVICE_TYPE_CPU;
+	std::regex filter{".*"};
+	double minTime = 0.2;
+	std::string output;
+	bool perfCounters = false;
+	Precision precision = Precision::Single;
+};
+
+template<typename T>
+struct GateKind {
+	std::string name;
+	/** Number of qubits of the gate. */
+	size_t qubits;
+	/** Applies the gate to the given qubits. */
+	std::function<void(Circuit::QuantumRegister<T> &, const std::vector<size_t> &)> apply;
+};
+
+struct Result {
+	std::string name;
+	size_t iterations = 0;
+	/** Microseconds per gate. */
+	double time = 0;
+	double bytesPerSecond = 0;
+	double gatesPerSecond = 0;
+	size_t qubits = 0;
+	size_t target = 0;
+	size_t threads = 0;
+	/** Hardware counters per gate, if enabled. */
+	double cycles = 0;
+	double instructions = 0;
+	double llcMisses = 0;
+	double dtlbMisses = 0;
+	std::string error;
+};
+
+/** Quantum Fourier transform matrix, a dense unitary, so that no kernel can skip any multiplication. */
+template<typename T>
+Gate<T> denseGate(size_t qubits) {
+	size_t dimension = 1ULL << qubits;
+	ComplexMatrix<T> matrix(dimension, dimension);
+	auto scale = static_cast<T>(1 / std::sqrt(static_cast<double>(dimension)));
+	for (size_t r = 0; r < dimension; ++r)
+		for (size_t c = 0; c < dimension; ++c)
+			matrix[r, c, std::polar(scale, static_cast<T>(2 * Algebra::PI<double> * static_cast<double>(r * c) /
+																	  static_cast<double>(dimension)))];
+
+	return Gate<T>(matrix);
+}
+
+/** Permutation of the states of two qubits with phases, which no named gate applies. */
+template<typename T>
+Gate<T> monomialGate() {
+	ComplexMatrix<T> matrix(4, 4);
+	for (size_t r = 0; r < 4; ++r)
+		matrix[r, (r + 1) % 4, std::polar<T>(1, static_cast<T>(r) / 2)];
+	return Gate<T>(matrix);
+}
+
+template<typename T>
+std::vector<GateKind<T>> gateKinds() {
+	auto gate = [](Gate<T> gate) {
+		return [gate = std::move(gate)](Circuit::QuantumRegister<T> &qRegister, const std::vector<size_t> &q) {
+			qRegister.gate(gate, q);
+		};
+	};
+
+	return {
+			{"Hadamard", 1, [](auto &r, const auto &q) { r.hadamard(q[0]); }},
+			{"Dense1", 1, gate(denseGate<T>(1))},
+			{"Diagonal1", 1, gate(Gate<T>::phase(Algebra::PI<T> / 3))},
+			{"DenseDiagonal1", 1, gate(Gate<T>::dense(Gate<T>::phase(Algebra::PI<T> / 3).matrix()))},
+			{"Permutation1", 1, gate(Gate<T>::pauliX())},
+			{"DensePermutation1", 1, gate(Gate<T>::dense(Gate<T>::pauliX().matrix()))},
+			{"CNOT", 2, [](auto &r, const auto &q) { r.controlledX(q[0], q[1]); }},
+			{"Permutation2", 2, gate(Gate<T>::controlledX())},
+			{"DensePermutation2", 2, gate(Gate<T>::dense(Gate<T>::controlledX().matrix()))},
+			{"Monomial2", 2, gate(monomialGate<T>())},
+			{"DenseMonomial2", 2, gate(Gate<T>::dense(monomialGate<T>().matrix()))},
+			{"Dense2", 2, gate(denseGate<T>(2))},
+			{"Dense3", 3, gate(denseGate<T>(3))},
+			{"Dense5", 5, gate(denseGate<T>(5))},
+	};
+}
+
+/** Splits the text at the separator. */
+std::vector<std::string> split(const std::string &text, char separator) {
+	std::vector<std::string> parts;
+	std::stringstream stream(text);
+	for (std::string part; std::getline(stream, part, separator);)
+		parts.push_back(part);
+	return parts;
+}
+
+Options parseOptions(int argc, char **argv) {
+	Options options;
+	std::string qubits = "10:30:4";
+
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		size_t equals = argument.find('=');
+		std::string key = argument.substr(0, equals);
+		std::string value = equals == std::string::npos ? "" : argument.substr(equals + 1);
+
+		if (key == "--qubits")
+			qubits = value;
+		else if (key == "--targets")
+			options.allTargets = value == "all";
+		else if (key == "--backends")
+			options.backends = split(value, ',');
+		else if (key == "--threads") {
+			options.threads.clear();
+			for (const auto &count: split(value, ','))
+				options.threads.push_back(std::stoul(count));
+		} else if (key == "--cl_device")
+			options.clDevice = value == "gpu" ? CL_DEVICE_TYPE_GPU : CL_DEVICE_TYPE_CPU;
+		else if (key == "--benchmark_filter")
+			options.filter = std::regex(value);
+		else if (key == "--benchmark_min_time")
+			options.minTime = std::stod(value);
+		else if (key == "--benchmark_out")
+			options.output = value;
+		else if (key == "--perf_counters")
+			options.perfCounters = true;
+		else if (key == "--precision")
+			options.precision = parsePrecision(value);
+		else
+			throw std::runtime_error("Unknown option " + argument);
+	}
+
+	auto range = split(qubits, ':');
+	size_t first = std::stoul(range.at(0));
+	size_t last = range.size() > 1 ? std::stoul(range[1]) : first;
+	size_t step = range.size() > 2 ? std::stoul(range[2]) : 1;
+	for (size_t n = first; n <= last; n += std::max<size_t>(step, 1))
+		options.qubits.push_back(n);
+
+	return options;
+}
+
+std::optional<cl::Device> findDevice(cl_device_type type) {
+	std::vector<cl::Platform> platforms;
+	cl::Platform::get(&platforms);
+
+	for (const auto &platform: platforms) {
+		std::vector<cl::Device> devices;
+		platform.getDevices(type, &devices);
+
+		if (!devices.empty())
+			return devices[0];
+	}
+
+	return std::nullopt;
+}
+
+/** Waits for the gates enqueued on OpenCL registers, whose gate kernels are not waited for. */
+template<typename T>
+void finish(const Circuit::QuantumRegister<T> &qRegister) {
+	if (const auto *clRegister = dynamic_cast<const Circuit::CLQuantumRegister<T> *>(&qRegister))
+		clRegister->finish();
+}
+
+/**
+ * Applies the gate until it runs for at least the minimal time, increasing the number of iterations. The hardware
+ * counters of the last run are divided by its iterations if enabled.
+ */
+template<typename T>
+Result measure(Circuit::QuantumRegister<T> &qRegister, const std::function<void()> &apply, double minTime,
+			   bool perfCounters) {
+	apply(); // warm-up, touches all pages
+	finish(qRegister);
+
+	Result result;
+	size_t iterations = 1;
+	while (true) {
+		Circuit::PerfCounts counts;
+		if (perfCounters)
+			counts = Circuit::PerfCounters::forThisThread().read();
+		auto tick = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; ++i)
+			apply();
+		finish(qRegister);
+		auto tock = std::chrono::steady_clock::now();
+		if (perfCounters)
+			counts = Circuit::PerfCounters::forThisThread().read() - counts;
+
+		double seconds = std::chrono::duration<double>(tock - tick).count();
+		if (seconds >= minTime || iterations >= 1'000'000'000) {
+			double bytes = 2.0 * static_cast<double>((1ULL << qRegister.qubits()) * sizeof(std::complex<T>));
+			result.iterations = iterations;
+			result.time = seconds * 1e6 / static_cast<double>(iterations);
+			result.gatesPerSecond = static_cast<double>(iterations) / seconds;
+			result.bytesPerSecond = bytes * result.gatesPerSecond;
+
+			auto perGate = [&](uint64_t count) { return static_cast<double>(count) / static_cast<double>(iterations); };
+			result.cycles = perGate(counts.cycles);
+			result.instructions = perGate(counts.instructions);
+			result.llcMisses = perGate(counts.llcMisses);
+			result.dtlbMisses = perGate(counts.dtlbMisses);
+			return result;
+		}
+
+		double factor = std::clamp(1.4 * minTime / std::max(seconds, 1e-9), 2.0, 10.0);
+		iterations = static_cast<size_t>(std::ceil(static_cast<double>(iterations) * factor));
+	}
+}
+
+/** Escapes the quotes and backslashes of a JSON string. */
+std::string escape(const std::string &text) {
+	std::string escaped;
+	for (char c: text) {
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+		escaped += c;
+	}
+	return escaped;
+}
+
+void writeJson(std::ostream &stream, const std::vector<Result> &results, const std::string &executable,
+			   bool perfCounters, Precision precision) {
+	char date[32];
+	std::time_t now = std::time(nullptr);
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+	stream << "{\n  \"context\": {\n";
+	stream << "    \"date\": \"" << date << "\",\n";
+	stream << "    \"executable\": \"" << escape(executable) << "\",\n";
+	stream << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+	stream << "    \"precision\": \"" << (precision == Precision::Single ? "single" : "double") << "\",\n";
+#ifdef NDEBUG
+	stream << "    \"library_build_type\": \"release\"\n";
+#else
+	stream << "    \"library_build_type\": \"debug\"\n";
+#endif
+	stream << "  },\n  \"benchmarks\": [";
+
+	for (size_t i = 0; i < results.size(); ++i) {
+		const Result &result = results[i];
+		stream << (i > 0 ? "," : "") << "\n    {\n";
+		stream << "      \"name\": \"" << escape(result.name) << "\",\n";
+		stream << "      \"run_name\": \"" << escape(result.name) << "\",\n";
+		stream << "      \"run_type\": \"iteration\",\n";
+		if (!result.error.empty()) {
+			stream << "      \"error_occurred\": true,\n";
+			stream << "      \"error_message\": \"" << escape(result.error) << "\"\n    }";
+			continue;
+		}
+		stream << std::setprecision(10);
+		stream << "      \"iterations\": " << result.iterations << ",\n";
+		stream << "      \"real_time\": " << result.time << ",\n";
+		stream << "      \"cpu_time\": " << result.time << ",\n";
+		stream << "      \"time_unit\": \"us\",\n";
+		stream << "      \"bytes_per_second\": " << result.bytesPerSecond << ",\n";
+		stream << "      \"items_per_second\": " << result.gatesPerSecond << ",\n";
+		stream << "      \"qubits\": " << result.qubits << ",\n";
+		stream << "      \"target\": " << result.target << ",\n";
+		stream << "      \"threads\": " << result.threads;
+		// user counters of Google Benchmark, also per iteration
+		if (perfCounters) {
+			stream << ",\n      \"cycles\": " << result.cycles << ",\n";
+			stream << "      \"instructions\": " << result.instructions << ",\n";
+			stream << "      \"ipc\": " << (result.cycles > 0 ? result.instructions / result.cycles : 0) << ",\n";
+			stream << "      \"llc_misses\": " << result.llcMisses << ",\n";
+			stream << "      \"dtlb_misses\": " << result.dtlbMisses;
+		}
+		stream << "\n    }";
+	}
+
+	stream << "\n  ]\n}\n";
+}
+
+void printResult(const Result &result, bool perfCounters) {
+	std::cout << std::left << std::setw(52) << result.name << std::right;
+	if (!result.error.empty()) {
+		std::cout << "ERROR: " << result.error << std::endl;
+		return;
+	}
+
+	std::cout << std::fixed << std::setprecision(2) << std::setw(14) << result.time
+			  << std::setw(12) << std::setprecision(2) << result.bytesPerSecond / 1e9
+			  << std::setw(14) << std::setprecision(0) << result.gatesPerSecond
+			  << std::setw(12) << result.iterations;
+	if (perfCounters)
+		std::cout << std::setw(14) << result.cycles << std::setw(8) << std::setprecision(2)
+				  << (result.cycles > 0 ? result.instructions / result.cycles : 0) << std::setw(14)
+				  << std::setprecision(0) << result.llcMisses << std::setw(14) << result.dtlbMisses;
+	std::cout << std::defaultfloat << std::endl;
+}
+
+template<typename T>
+std::unique_ptr<Circuit::QuantumRegister<T>> createRegister(const std::string &backend, size_t numQubits,
+															const std::optional<cl::Device> &device) {
+	if (backend == "basic")
+		return std::make_unique<Circuit::BasicQuantumRegister<T>>(numQubits);
+	if (backend == "vectorized")
+		return std::make_unique<Circuit::VectorizedQuantumRegister<T>>(numQubits);
+	if (backend == "split")
+		return std::make_unique<Circuit::SplitQuantumRegister<T>>(numQubits);
+	if (backend == "cl") {
+		if (!device)
+			throw std::runtime_error("No OpenCL device of the requested type");
+		return std::make_unique<Circuit::CLQuantumRegister<T>>(numQubits, cl::Context(*device), *device);
+	}
+	throw std::runtime_error("Unknown backend " + backend);
+}
+
+/** Runs the benchmarks of all backends and numbers of qubits with registers of the precision T. */
+template<typename T>
+void runBenchmarks(const Options &options, const std::vector<size_t> &threadCounts,
+				   const std::optional<cl::Device> &device, std::vector<Result> &results) {
+	std::vector<GateKind<T>> kinds = gateKinds<T>();
+
+	for (const auto &backend: options.backends) {
+		for (size_t numQubits: options.qubits) {
+			std::unique_ptr<Circuit::QuantumRegister<T>> qRegister;
+			try {
+				qRegister = createRegister<T>(backend, numQubits, device);
+				for (size_t q = 0; q < numQubits; ++q)
+					qRegister->hadamard(q);
+			} catch (const std::exception &e) {
+				Result result;
+				result.name = std::format("{}/qubits:{}", backend, numQubits);
+				result.error = e.what();
+				printResult(result, options.perfCounters);
+				results.push_back(result);
+				continue;
+			}
+
+			std::vector<size_t> targets;
+			if (options.allTargets) {
+				for (size_t q = 0; q < numQubits; ++q)
+					targets.push_back(q);
+			} else {
+				targets = {0, 1, numQubits / 2, numQubits - 1};
+				std::ranges::sort(targets);
+				targets.erase(std::ranges::unique(targets).begin(), targets.end());
+			}
+
+			// the OpenCL register does not use the threads of the host
+			for (size_t threads: backend == "cl" ? std::vector<size_t>{1} : threadCounts) {
+				setMaxThreads(threads);
+				for (const auto &kind: kinds) {
+					if (kind.qubits > numQubits)
+						continue;
+
+					for (size_t target: targets) {
+						std::string name = std::format("{}/{}/qubits:{}/target:{}/threads:{}", kind.name, backend,
+													   numQubits, target, maxThreads());
+						if (!std::regex_search(name, options.filter))
+							continue;
+
+						// the gate acts on the target and the following qubits
+						std::vector<size_t> qubits;
+						for (size_t q = 0; q < kind.qubits; ++q)
+							qubits.push_back((target + q) % numQubits);
+
+						Result result;
+						try {
+							result = measure(*qRegister, [&] { kind.apply(*qRegister, qubits); }, options.minTime,
+											 options.perfCounters);
+						} catch (const std::exception &e) {
+							result.error = e.what();
+						}
+						result.name = name;
+						result.qubits = numQubits;
+						result.target = target;
+						result.threads = maxThreads();
+						printResult(result, options.perfCounters);
+						results.push_back(result);
+					}
+				}
+			}
+			setMaxThreads(0);
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	Options options = parseOptions(argc, argv);
+	std::vector<Result> results;
+
+	// thread counts resolved, so that 0 does not repeat an explicitly listed count
+	std::vector<size_t> threadCounts;
+	for (size_t threads: options.threads) {
+		setMaxThreads(threads);
+		if (std::ranges::find(threadCounts, maxThreads()) == threadCounts.end())
+			threadCounts.push_back(maxThreads());
+	}
+	setMaxThreads(0);
+
+	std::optional<cl::Device> device;
+	if (std::ranges::find(options.backends, "cl") != options.backends.end()) {
+		device = findDevice(options.clDevice);
+		if (device)
+			std::cout << "OpenCL device: " << device->getInfo<CL_DEVICE_NAME>() << std::endl;
+	}
+
+	if (options.perfCounters && !Circuit::PerfCounters::forThisThread().available())
+		std::cerr << "Hardware counters are not available (kernel.perf_event_paranoid, virtual machine or not Linux), "
+					 "they read as zero" << std::endl;
+
+	std::cout << std::left << std::setw(52) << "Benchmark" << std::right << std::setw(14) << "Time us"
+			  << std::setw(12) << "GB/s" << std::setw(14) << "Gates/s" << std::setw(12) << "Iterations";
+	if (options.perfCounters)
+		std::cout << std::setw(14) << "Cycles" << std::setw(8) << "IPC" << std::setw(14) << "LLC misses"
+				  << std::setw(14) << "dTLB misses";
+	std::cout << std::endl;
+
+	// the register templates are instantiated for both precisions, the selected one is chosen at runtime
+	dispatchPrecision(options.precision, [&]<typename T>() {
+		runBenchmarks<T>(options, threadCounts, device, results);
+	});
+
+	if (!options.output.empty()) {
+		std::ofstream file(options.output);
+		writeJson(file, results, argv[0], options.perfCounters, options.precision);
+	}
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <format>
+#include <cmath>
+
+#include "../src/circuit/VectorizedQuantumRegister.h"
+#include "../src/circuit/SplitQuantumRegister.h"
+#include "../src/algebra/Constants.h"
+
+using namespace KQS;
+
+/**
+ * Compares the interleaved (array of structures) VectorizedQuantumRegister with the SplitQuantumRegister storing
+ * real and imaginary parts separately (structure of arrays). Reports the time of a dense one-qubit gate on every
+ * target qubit and of a dense two-qubit gate on every pair of neighbouring qubits, in each of the listed precisions.
+ *
+ * Usage: LayoutBenchmark [numQubits = 22] [repetitions = 8] [precisions = single,double]
+ */
+
+/** Quantum Fourier transform matrix, a dense unitary, so that no kernel can skip any multiplication. */
+template<typename T>
+Circuit::QuantumLogicGate<T> denseGate(size_t qubits) {
+	size_t dimension = 1ULL << qubits;
+	ComplexMatrix<T> matrix(dimension, dimension);
+	T scale = static_cast<T>(1 / std::sqrt(static_cast<double>(dimension)));
+	for (size_t r = 0; r < dimension; ++r)
+		for (size_t c = 0; c < dimension; ++c)
+			matrix[r, c, std::polar(scale, static_cast<T>(2 * Algebra::PI<double> * static_cast<double>(r * c) /
+																static_cast<double>(dimension)))];
+
+	return Circuit::QuantumLogicGate<T>(matrix);
+}
+
+/** Milliseconds per application of the gate on the given targets. */
+template<typename T>
+double measure(Circuit::QuantumRegister<T> &qRegister, const Circuit::QuantumLogicGate<T> &gate,
+			   const std::vector<size_t> &targets, size_t repetitions) {
+	qRegister.gate(gate, targets); // warm-up, touches all pages
+
+	auto tick = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < repetitions; ++i)
+		qRegister.gate(gate, targets);
+	auto tock = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::milli>(tock - tick).count() / static_cast<double>(repetitions);
+}
+
+template<typename T>
+void compareLayouts(size_t numQubits, size_t repetitions) {
+	Circuit::VectorizedQuantumRegister<T> aos(numQubits);
+	Circuit::SplitQuantumRegister<T> soa(numQubits);
+
+	std::cout << std::endl << (precisionOf<T> == Precision::Single ? "Single" : "Double") << " precision" << std::endl;
+	std::cout << std::left << std::setw(10) << "Targets" << std::right << std::setw(12) << "AoS ms"
+			  << std::setw(12) << "SoA ms" << std::setw(10) << "Speedup" << std::endl;
+
+	auto print = [](const std::string &targets, double aosTime, double soaTime) {
+		std::cout << std::left << std::setw(10) << targets << std::right << std::fixed << std::setprecision(3)
+				  << std::setw(12) << aosTime << std::setw(12) << soaTime
+				  << std::setw(10) << std::setprecision(2) << aosTime / soaTime << std::defaultfloat << std::endl;
+	};
+
+	auto oneQubitGate = denseGate<T>(1);
+	for (size_t q = 0; q < numQubits; ++q)
+		print(std::to_string(q), measure(aos, oneQubitGate, {q}, repetitions),
+			  measure(soa, oneQubitGate, {q}, repetitions));
+
+	auto twoQubitGate = denseGate<T>(2);
+	for (size_t q = 0; q + 1 < numQubits; ++q)
+		print(std::format("{},{}", q, q + 1), measure(aos, twoQubitGate, {q, q + 1}, repetitions),
+			  measure(soa, twoQubitGate, {q, q + 1}, repetitions));
+}
+
+int main(int argc, char **argv) {
+	size_t numQubits = argc > 1 ? std::stoul(argv[1]) : 22;
+	size_t repetitions = argc > 2 ? std::stoul(argv[2]) : 8;
+	std::string precisions = argc > 3 ? argv[3] : "single,double";
+
+	std::cout << "Qubits: " << numQubits << ", repetitions: " << repetitions << std::endl;
+
+	std::stringstream stream(precisions);
+	for (std::string precision; std::getline(stream, precision, ',');)
+		dispatchPrecision(parsePrecision(precision), [&]<typename T>() { compareLayouts<T>(numQubits, repetitions); });
+}
@@ -0,0 +1,96 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "../src/circuit/VectorizedQuantumRegister.h"
+#include "../src/circuit/HalfPrecisionQuantumRegister.h"
+
+using namespace KQS;
+
+using complex_t = std::complex<float>;
+
+/**
+ * Compares registers storing amplitudes in 16-bit formats with the single precision VectorizedQuantumRegister.
+ * Reports the time per gate, the effective state vector bandwidth and the fidelity with the single precision result.
+ *
+ * Usage: PrecisionBenchmark [numQubits = 20] [depth = 4]
+ */
+
+/** Layers of Hadamards, phases and a chain of CNOTs, which spread the amplitudes over all states. */
+size_t runCircuit(Circuit::QuantumRegister<float> &qRegister, size_t depth) {
+	size_t gates = 0;
+	size_t n = qRegister.qubits();
+
+	for (size_t layer = 0; layer < depth; ++layer) {
+		for (size_t q = 0; q < n; ++q, ++gates)
+			qRegister.hadamard(q);
+		for (size_t q = 0; q < n; ++q, ++gates)
+			qRegister.phase(q, static_cast<float>(0.1 * (q + 1) * (layer + 1)));
+		for (size_t q = 0; q + 1 < n; ++q, ++gates)
+			qRegister.controlledX(q, q + 1);
+	}
+
+	return gates;
+}
+
+/** Computes |<reference|state>|^2 without widening the whole state at once. */
+double fidelity(const std::vector<complex_t> &reference, const Circuit::QuantumRegister<float> &qRegister) {
+	std::complex<double> overlap = 0;
+	qRegister.readStateVector([&](size_t offset, std::span<const complex_t> chunk) {
+		for (size_t i = 0; i < chunk.size(); ++i)
+			overlap += std::conj(std::complex<double>(reference[offset + i])) * std::complex<double>(chunk[i]);
+	});
+
+	double referenceNorm = 0;
+	for (const auto &amplitude: reference)
+		referenceNorm += std::norm(std::complex<double>(amplitude));
+
+	return std::norm(overlap) / (referenceNorm * qRegister.norm());
+}
+
+int main(int argc, char **argv) {
+	size_t numQubits = argc > 1 ? std::stoul(argv[1]) : 20;
+	size_t depth = argc > 2 ? std::stoul(argv[2]) : 4;
+	size_t numStates = 1ULL << numQubits;
+
+	std::cout << "Qubits: " << numQubits << ", depth: " << depth << std::endl;
+	std::cout << std::left << std::setw(14) << "Storage" << std::right << std::setw(12) << "State MB"
+			  << std::setw(14) << "ms per gate" << std::setw(10) << "GB/s" << std::setw(16) << "Fidelity loss"
+			  << std::endl;
+
+	std::vector<complex_t> reference;
+	auto measure = [&](const std::string &name, Circuit::QuantumRegister<float> &qRegister, size_t bytesPerState) {
+		auto tick = std::chrono::steady_clock::now();
+		size_t gates = runCircuit(qRegister, depth);
+		auto tock = std::chrono::steady_clock::now();
+
+		double seconds = std::chrono::duration<double>(tock - tick).count();
+		// every gate reads and writes the whole state vector
+		double bandwidth = 2.0 * static_cast<double>(numStates * bytesPerState) * static_cast<double>(gates) / seconds;
+
+		if (reference.empty())
+			reference = qRegister.stateVector();
+
+		std::cout << std::left << std::setw(14) << name << std::right << std::fixed
+				  << std::setw(12) << std::setprecision(1) << static_cast<double>(numStates * bytesPerState) / (1 << 20)
+				  << std::setw(14) << std::setprecision(3) << seconds * 1000 / static_cast<double>(gates)
+				  << std::setw(10) << std::setprecision(2) << bandwidth / 1e9
+				  << std::setw(16) << std::scientific << std::setprecision(2) << 1 - fidelity(reference, qRegister)
+				  << std::defaultfloat << std::endl;
+	};
+
+	{
+		Circuit::VectorizedQuantumRegister<float> qRegister(numQubits);
+		measure("fp32", qRegister, sizeof(complex_t));
+	}
+	{
+		Circuit::HalfPrecisionQuantumRegister qRegister(numQubits, Circuit::HalfFormat::FP16);
+		measure("fp16", qRegister, 2 * sizeof(uint16_t));
+	}
+	{
+		Circuit::HalfPrecisionQuantumRegister qRegister(numQubits, Circuit::HalfFormat::BF16);
+		measure("bf16", qRegister, 2 * sizeof(uint16_t));
+	}
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include "../src/circuit/BasicQuantumRegister.h"
+#include "../src/circuit/VectorizedQuantumRegister.h"
+#include "../src/algebra/Constants.h"
+
+using namespace KQS;
+
+using real_t = float;
+using Gate = Circuit::QuantumLogicGate<real_t>;
+
+/**
+ * Compares the dedicated kernels of the standard gates, used by the named gate methods, with applying the same
+ * gates as dense matrices through QuantumRegister::gate. The matrices are created with QuantumLogicGate::dense, so
+ * the structure detection does not send them to the diagonal and permutation kernels. swap() only relabels the
+ * qubits, so the SWAP row applies the swap matrix with structure detection, which uses the dedicated Swap kernel.
+ * Every gate is applied to every qubit (and for two-qubit gates with the next qubit as the second one), the time is
+ * averaged over all applications.
+ *
+ * Usage: StandardGateBenchmark [numQubits = 22] [repetitions = 2]
+ */
+
+struct Benchmark {
+	std::string name;
+	/** Applies the gate to the qubit using the dedicated kernel. */
+	std::function<void(Circuit::QuantumRegister<real_t> &, size_t)> named;
+	/** The matrix of the gate, applied densely to the qubit and, if it has two qubits, the next one. */
+	Gate dense;
+};
+
+/** Milliseconds per gate application. */
+double measure(Circuit::QuantumRegister<real_t> &qRegister, size_t repetitions,
+			   const std::function<void(size_t)> &apply) {
+	size_t n = qRegister.qubits();
+	apply(0); // warm-up, touches all pages
+
+	auto tick = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < repetitions; ++r)
+		for (size_t q = 0; q < n; ++q)
+			apply(q);
+	auto tock = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::milli>(tock - tick).count() / static_cast<double>(repetitions * n);
+}
+
+int main(int argc, char **argv) {
+	size_t numQubits = argc > 1 ? std::stoul(argv[1]) : 22;
+	size_t repetitions = argc > 2 ? std::stoul(argv[2]) : 2;
+
+	std::vector<Benchmark> benchmarks = {
+			{"H", [](auto &r, size_t q) { r.hadamard(q); }, Gate::hadamard()},
+			{"X", [](auto &r, size_t q) { r.pauliX(q); }, Gate::pauliX()},
+			{"Y", [](auto &r, size_t q) { r.pauliY(q); }, Gate::pauliY()},
+			{"S", [](auto &r, size_t q) { r.phase(q, Algebra::PI<real_t> / 2); }, Gate::phase(Algebra::PI<real_t> / 2)},
+			{"T", [](auto &r, size_t q) { r.piOverEight(q); }, Gate::piOverEight()},
+			{"CNOT", [n = numQubits](auto &r, size_t q) { r.controlledX((q + 1) % n, q); }, Gate::controlledX()},
+			{"CZ", [n = numQubits](auto &r, size_t q) { r.controlledZ((q + 1) % n, q); }, Gate::controlledZ()},
+			{"SWAP", [n = numQubits, swap = Gate::swap()](auto &r, size_t q) { r.gate(swap, {q, (q + 1) % n}); },
+			 Gate::swap()},
+	};
+
+	std::cout << "Qubits: " << numQubits << ", repetitions: " << repetitions << std::endl;
+	std::cout << std::left << std::setw(8) << "Gate" << std::setw(12) << "Register" << std::right
+			  << std::setw(12) << "Dense ms" << std::setw(16) << "Dedicated ms" << std::setw(10) << "Speedup"
+			  << std::endl;
+
+	auto run = [&](const std::string &registerName, Circuit::QuantumRegister<real_t> &qRegister) {
+		size_t n = qRegister.qubits();
+		for (const auto &benchmark: benchmarks) {
+			size_t qubits = benchmark.dense.matrix().rows() == 2 ? 1 : 2;
+			Gate gate = Gate::dense(benchmark.dense.matrix());
+			double dense = measure(qRegister, repetitions, [&](size_t q) {
+				if (qubits == 1)
+					qRegister.gate(gate, {q});
+				else
+					qRegister.gate(gate, {q, (q + 1) % n});
+			});
+			double dedicated = measure(qRegister, repetitions, [&](size_t q) { benchmark.named(qRegister, q); });
+
+			std::cout << std::left << std::setw(8) << benchmark.name << std::setw(12) << registerName << std::right
+					  << std::fixed << std::setprecision(3) << std::setw(12) << dense << std::setw(16) << dedicated
+					  << std::setw(10) << std::setprecision(2) << dense / dedicated << std::defaultfloat << std::endl;
+		}
+	};
+
+	{
+		Circuit::BasicQuantumRegister<real_t> qRegister(numQubits);
+		run("Basic", qRegister);
+	}
+	{
+		Circuit::VectorizedQuantumRegister<real_t> qRegister(numQubits);
+		run("Vectorized", qRegister);
+	}
+}
@@ -1,90 +1,459 @@
 #if REAL_PRECISION == 1
 typedef float real_t;
+typedef float2 complex_t; // maps directly to complex_t on host, x is the real part and y the imaginary part
 #elif REAL_PRECISION == 2
 typedef double real_t;
+typedef double2 complex_t;
 #elif REAL_PRECISION == 3
-typedef long double real_t;
+#error "long double is not supported in OpenCL kernels"
 #endif
 
-typedef struct { // maps directly to complex_t on host
-	real_t re;
-	real_t im;
-} complex_t;
+// registers with at most 2^32 states are indexed with 32-bit integers, which is cheaper on most GPUs
+#if INDEX_BITS == 32
+typedef uint index_t;
+#else
+typedef ulong index_t;
+#endif
 
-inline complex_t cadd(complex_t a, complex_t b) {
-	complex_t result;
-	result.re = a.re + b.re;
-	result.im = a.im + b.im;
-	return result;
-}
+// programs specialized for one target qubit get it as a compile-time constant, so the shifts are by constants
+#ifdef TARGET_QUBIT
+#define TARGET(runtimeQubit) ((index_t) TARGET_QUBIT)
+#else
+#define TARGET(runtimeQubit) ((index_t) (runtimeQubit))
+#endif
 
 inline complex_t cmul(complex_t a, complex_t b) {
-	complex_t result;
-	result.re = a.re * b.re - a.im * b.im;
-	result.im = a.re * b.im + a.im * b.re;
-	return result;
+	return (complex_t) (mad(a.x, b.x, -a.y * b.y), mad(a.x, b.y, a.y * b.x));
 }
 
-inline size_t insertBitAtPosition(size_t x, size_t bit, size_t position) {
-	size_t mask = ((1ULL << position) - 1); // mask, where first `position` bits are ones
-	size_t tmp = x & mask; // first `position` bits of x
+/** Computes a * b + c. */
+inline complex_t cmad(complex_t a, complex_t b, complex_t c) {
+	return (complex_t) (mad(a.x, b.x, mad(-a.y, b.y, c.x)), mad(a.x, b.y, mad(a.y, b.x, c.y)));
+}
 
-	x = x >> position;
-	x = x << 1;
-	x = x | bit;
-	x = x << position;
-	x = x | tmp;
+inline real_t cnorm(complex_t a) {
+	return dot(a, a);
+}
 
-	return x;
+// HALF_STORAGE keeps the amplitudes as pairs of 16-bit floats, 1 for IEEE half precision and 2 for bfloat16;
+// kernels widen them to complex_t on load and round them back on store, so all arithmetic is in single precision
+#if defined(HALF_STORAGE) && REAL_PRECISION != 1
+#error "16-bit storage requires single precision"
+#endif
+
+#if HALF_STORAGE == 1
+typedef half storage_t;
+#define LOAD_STATE(states, i) vload_half2((i), (states))
+#define STORE_STATE(states, i, value) vstore_half2_rte((value), (i), (states))
+#elif HALF_STORAGE == 2
+typedef ushort storage_t;
+#define LOAD_STATE(states, i) loadBF16((i), (states))
+#define STORE_STATE(states, i, value) storeBF16((value), (i), (states))
+#else
+typedef complex_t storage_t;
+#define LOAD_STATE(states, i) ((states)[i])
+#define STORE_STATE(states, i, value) ((states)[i] = (value))
+#endif
+
+#if HALF_STORAGE == 2
+/** bfloat16 is the upper half of a float, widening is a shift. */
+inline complex_t loadBF16(index_t i, __global const ushort *states) {
+	ushort2 bits = vload2(i, states);
+	return (complex_t) (as_float((uint) bits.x << 16), as_float((uint) bits.y << 16));
 }
 
-__kernel void applyOneQubitGate(__global complex_t *stateVector, ulong targetQubit,
+/** Rounds to nearest, ties to even, NaNs do not occur in valid states. */
+inline ushort roundBF16(float value) {
+	uint bits = as_uint(value);
+	return (bits + 0x7FFF + ((bits >> 16) & 1)) >> 16;
+}
+
+inline void storeBF16(complex_t value, index_t i, __global ushort *states) {
+	vstore2((ushort2) (roundBF16(value.x), roundBF16(value.y)), i, states);
+}
+#endif
+
+/** Inserts zero bit into x at the position. */
+inline index_t insertZeroBit(index_t x, index_t position) {
+	index_t mask = ((index_t) 1 << position) - 1; // mask, where first `position` bits are ones
+	return ((x & ~mask) << 1) | (x & mask);
+}
+
+__kernel void applyOneQubitGate(__global storage_t *stateVector, ulong targetQubit,
 								complex_t gate00, complex_t gate01, complex_t gate10, complex_t gate11) {
-	size_t i = get_global_id(0);
+	index_t target = TARGET(targetQubit);
+	index_t i0 = insertZeroBit(get_global_id(0), target);
+	index_t i1 = i0 | ((index_t) 1 << target);
+
+	complex_t a0 = LOAD_STATE(stateVector, i0);
+	complex_t a1 = LOAD_STATE(stateVector, i1);
+
+	STORE_STATE(stateVector, i0, cmad(gate00, a0, cmul(gate01, a1)));
+	STORE_STATE(stateVector, i1, cmad(gate10, a0, cmul(gate11, a1)));
+}
+
+__kernel void applyTwoQubitGate(__global storage_t *stateVector, ulong targetQubit0,
+								ulong targetQubit1, __constant complex_t *gate) {
+	index_t target0 = targetQubit0;
+	index_t target1 = targetQubit1;
+	index_t state = insertZeroBit(insertZeroBit(get_global_id(0), target0), target1);
+
+	// inserting the bit at target1 moved the first inserted bit, if it was not below target1
+	index_t bit0 = (index_t) 1 << (target0 + (target0 >= target1));
+	index_t bit1 = (index_t) 1 << target1;
+	index_t indices[4] = {state, state | bit0, state | bit1, state | bit0 | bit1};
+
+	complex_t group[4];
+	for (int j = 0; j < 4; ++j)
+		group[j] = LOAD_STATE(stateVector, indices[j]);
+
+	for (int j = 0; j < 4; ++j) {
+		complex_t result = cmul(gate[j * 4 + 0], group[0]);
+		result = cmad(gate[j * 4 + 1], group[1], result);
+		result = cmad(gate[j * 4 + 2], group[2], result);
+		result = cmad(gate[j * 4 + 3], group[3], result);
+		STORE_STATE(stateVector, indices[j], result);
+	}
+}
+
+
+/////////////// Standard gates ///////////////
+
+#define REC_SQRT2 ((real_t) 0.707106781186547524)
+
+__kernel void applyPauliX(__global storage_t *stateVector, ulong targetQubit) {
+	index_t target = TARGET(targetQubit);
+	index_t i0 = insertZeroBit(get_global_id(0), target);
+	index_t i1 = i0 | ((index_t) 1 << target);
+
+	complex_t a0 = LOAD_STATE(stateVector, i0);
+	STORE_STATE(stateVector, i0, LOAD_STATE(stateVector, i1));
+	STORE_STATE(stateVector, i1, a0);
+}
+
+__kernel void applyPauliY(__global storage_t *stateVector, ulong targetQubit) {
+	index_t target = TARGET(targetQubit);
+	index_t i0 = insertZeroBit(get_global_id(0), target);
+	index_t i1 = i0 | ((index_t) 1 << target);
+
+	// Y|0> = i|1>, Y|1> = -i|0>
+	complex_t a0 = LOAD_STATE(stateVector, i0);
+	complex_t a1 = LOAD_STATE(stateVector, i1);
+	STORE_STATE(stateVector, i0, (complex_t) (a1.y, -a1.x));
+	STORE_STATE(stateVector, i1, (complex_t) (-a0.y, a0.x));
+}
+
+__kernel void applyHadamard(__global storage_t *stateVector, ulong targetQubit) {
+	index_t target = TARGET(targetQubit);
+	index_t i0 = insertZeroBit(get_global_id(0), target);
+	index_t i1 = i0 | ((index_t) 1 << target);
+
+	complex_t a0 = LOAD_STATE(stateVector, i0);
+	complex_t a1 = LOAD_STATE(stateVector, i1);
+	STORE_STATE(stateVector, i0, (a0 + a1) * REC_SQRT2);
+	STORE_STATE(stateVector, i1, (a0 - a1) * REC_SQRT2);
+}
+
+/** Multiplies the states with the target qubit set by the factor, only these states are read and written. */
+__kernel void applyPhase(__global storage_t *stateVector, ulong targetQubit, complex_t factor) {
+	index_t target = TARGET(targetQubit);
+	index_t i1 = insertZeroBit(get_global_id(0), target) | ((index_t) 1 << target);
+
+	STORE_STATE(stateVector, i1, cmul(factor, LOAD_STATE(stateVector, i1)));
+}
+
+/** Index of the state of the work-item with zeros at both qubits. */
+inline index_t insertTwoZeroBits(index_t x, index_t qubit0, index_t qubit1) {
+	return insertZeroBit(insertZeroBit(x, min(qubit0, qubit1)), max(qubit0, qubit1));
+}
+
+__kernel void applyControlledX(__global storage_t *stateVector, ulong targetQubit, ulong controlQubit) {
+	index_t i0 = insertTwoZeroBits(get_global_id(0), targetQubit, controlQubit) | ((index_t) 1 << controlQubit);
+	index_t i1 = i0 | ((index_t) 1 << targetQubit);
+
+	complex_t a0 = LOAD_STATE(stateVector, i0);
+	STORE_STATE(stateVector, i0, LOAD_STATE(stateVector, i1));
+	STORE_STATE(stateVector, i1, a0);
+}
+
+__kernel void applyControlledPhase(__global storage_t *stateVector, ulong targetQubit, ulong controlQubit,
+								   complex_t factor) {
+	index_t i = insertTwoZeroBits(get_global_id(0), targetQubit, controlQubit) |
+				((index_t) 1 << targetQubit) | ((index_t) 1 << controlQubit);
+
+	STORE_STATE(stateVector, i, cmul(factor, LOAD_STATE(stateVector, i)));
+}
+
+__kernel void applySwap(__global storage_t *stateVector, ulong qubit0, ulong qubit1) {
+	index_t state = insertTwoZeroBits(get_global_id(0), qubit0, qubit1);
+	index_t i0 = state | ((index_t) 1 << qubit0);
+	index_t i1 = state | ((index_t) 1 << qubit1);
+
+	complex_t a0 = LOAD_STATE(stateVector, i0);
+	STORE_STATE(stateVector, i0, LOAD_STATE(stateVector, i1));
+	STORE_STATE(stateVector, i1, a0);
+}
+
+
+/////////////// Structured and k-qubit gates ///////////////
+
+// every work-item handles one group of states of the gate; the states are at fixed offsets (with the control bits
+// set) from the first state of the group, so the loops of the kernels have no bit manipulation
 
-	complex_t group[2];
-	size_t indices[2];
+// MAX_GATE_QUBITS, the maximal number of target qubits of the dense and monomial kernels, is set by the host;
+// these kernels keep the group in private memory
+#define MAX_GROUP_SIZE (1 << MAX_GATE_QUBITS)
 
-	for (int j = 0; j < 2; ++j) {
-		// combine i and j into a state
-		size_t state = i;
-		state = insertBitAtPosition(state, j, targetQubit);
+/** Inserts zero bits at the positions sorted in ascending order, i.e. maps a group to its first state. */
+inline index_t insertZeroBits(index_t x, __global const ulong *positions, uint numPositions) {
+	for (uint i = 0; i < numPositions; ++i)
+		x = insertZeroBit(x, positions[i]);
+	return x;
+}
 
-		indices[j] = state;
-		group[j] = stateVector[state];
+/** Multiplies the states at the offsets by the factors, states with factor one are not passed at all. */
+__kernel void applyDiagonalGate(__global storage_t *stateVector, __global const ulong *positions, uint numPositions,
+								__global const ulong *offsets, __global const complex_t *factors, uint count) {
+	index_t base = insertZeroBits(get_global_id(0), positions, numPositions);
+
+	for (uint j = 0; j < count; ++j) {
+		index_t i = base + offsets[j];
+		STORE_STATE(stateVector, i, cmul(factors[j], LOAD_STATE(stateVector, i)));
 	}
+}
 
-	complex_t result0 = cadd(cmul(gate00, group[0]), cmul(gate01, group[1]));
-	complex_t result1 = cadd(cmul(gate10, group[0]), cmul(gate11, group[1]));
+/** The state at offsets[j] becomes factors[j] times the state at sourceOffsets[j], for the changed states only. */
+__kernel void applyMonomialGate(__global storage_t *stateVector, __global const ulong *positions, uint numPositions,
+								__global const ulong *offsets, __global const ulong *sourceOffsets,
+								__global const complex_t *factors, uint count) {
+	index_t base = insertZeroBits(get_global_id(0), positions, numPositions);
 
-	stateVector[indices[0]] = result0;
-	stateVector[indices[1]] = result1;
+	// the sources are exactly the changed states, all of them are read before any is written
+	complex_t values[MAX_GROUP_SIZE];
+	for (uint j = 0; j < count; ++j)
+		values[j] = LOAD_STATE(stateVector, base + sourceOffsets[j]);
+
+	for (uint j = 0; j < count; ++j)
+		STORE_STATE(stateVector, base + offsets[j], cmul(factors[j], values[j]));
 }
 
-__kernel void applyTwoQubitGate(__global complex_t *stateVector, ulong targetQubit0,
-                                ulong targetQubit1, __global complex_t *gate) {
-    size_t i = get_global_id(0);
+/** Multiplies the group of states at the offsets by the dense gate matrix in row-major order. */
+__kernel void applyDenseGate(__global storage_t *stateVector, __global const ulong *positions, uint numPositions,
+							 __global const ulong *offsets, __global const complex_t *gate, uint groupSize) {
+	index_t base = insertZeroBits(get_global_id(0), positions, numPositions);
+
+	complex_t group[MAX_GROUP_SIZE];
+	for (uint j = 0; j < groupSize; ++j)
+		group[j] = LOAD_STATE(stateVector, base + offsets[j]);
+
+	for (uint i = 0; i < groupSize; ++i) {
+		complex_t result = (complex_t) (0, 0);
+		for (uint j = 0; j < groupSize; ++j)
+			result = cmad(gate[i * groupSize + j], group[j], result);
+		STORE_STATE(stateVector, base + offsets[i], result);
+	}
+}
+
+
+/////////////// Qubit permutation ///////////////
+
+/**
+ * Copies every state of the destination from the source index with the permuted bits, so the writes are coalesced.
+ * The source index is the OR of lookups of the bytes of the destination index in tables of 256 entries.
+ */
+__kernel void permuteQubits(__global const storage_t *source, __global storage_t *destination,
+							__global const ulong *tables, uint numTables) {
+	index_t i = get_global_id(0);
+
+	index_t from = 0;
+	for (uint b = 0; b < numTables; ++b)
+		from |= tables[256 * b + ((i >> (8 * b)) & 0xFF)];
+
+	STORE_STATE(destination, i, LOAD_STATE(source, from));
+}
 
-    complex_t group[4];
-    size_t indices[4];
 
-    for (int j = 0; j < 4; ++j) {
-        size_t state = i;
+/////////////// Transfers ///////////////
 
-        state = insertBitAtPosition(state, j & 1, targetQubit0);
-		state = insertBitAtPosition(state, (j >> 1) & 1, targetQubit1);
+/** Widens the chunk of the state vector starting at the offset into complex_t, for transfers to the host. */
+__kernel void widenStates(__global const storage_t *stateVector, __global complex_t *chunk, ulong offset) {
+	index_t i = get_global_id(0);
+	chunk[i] = LOAD_STATE(stateVector, offset + i);
+}
+
+/** Rounds the chunk of complex_t transferred from the host into the state vector starting at the offset. */
+__kernel void narrowStates(__global storage_t *stateVector, __global const complex_t *chunk, ulong offset) {
+	index_t i = get_global_id(0);
+	STORE_STATE(stateVector, offset + i, chunk[i]);
+}
+
+
+/////////////// Probabilities and sampling ///////////////
+
+/** Maximal number of qubits addressing states inside one probability block. */
+#define MAX_BLOCK_QUBITS 16
+
+/** Sums the values of all work-items in the work-group. Must be reached by all work-items. */
+inline real_t localSum(real_t value, __local real_t *scratch) {
+	size_t lid = get_local_id(0);
+
+	scratch[lid] = value;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (size_t s = get_local_size(0) / 2; s > 0; s /= 2) {
+		if (lid < s)
+			scratch[lid] += scratch[lid + s];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	real_t result = scratch[0];
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	return result;
+}
 
-        indices[j] = state;
-        group[j] = stateVector[state];
-    }
+/**
+ * Computes the probability of every block of 2^blockQubits consecutive states. One work-group handles one block,
+ * work-items read the block strided by the work-group size, so that the reads are coalesced.
+ */
+__kernel void blockProbabilities(__global const storage_t *stateVector, __global real_t *blockSums,
+								 ulong blockQubits, __local real_t *scratch) {
+	index_t blockSize = (index_t) 1 << blockQubits;
+	index_t offset = get_group_id(0) * blockSize;
 
-    complex_t result0 = cadd(cadd(cadd(cmul(gate[0 * 4 + 0], group[0]), cmul(gate[0 * 4 + 1], group[1])), cmul(gate[0 * 4 + 2], group[2])), cmul(gate[0 * 4 + 3], group[3]));
-    complex_t result1 = cadd(cadd(cadd(cmul(gate[1 * 4 + 0], group[0]), cmul(gate[1 * 4 + 1], group[1])), cmul(gate[1 * 4 + 2], group[2])), cmul(gate[1 * 4 + 3], group[3]));
-    complex_t result2 = cadd(cadd(cadd(cmul(gate[2 * 4 + 0], group[0]), cmul(gate[2 * 4 + 1], group[1])), cmul(gate[2 * 4 + 2], group[2])), cmul(gate[2 * 4 + 3], group[3]));
-    complex_t result3 = cadd(cadd(cadd(cmul(gate[3 * 4 + 0], group[0]), cmul(gate[3 * 4 + 1], group[1])), cmul(gate[3 * 4 + 2], group[2])), cmul(gate[3 * 4 + 3], group[3]));
+	real_t sum = 0;
+	for (index_t j = get_local_id(0); j < blockSize; j += get_local_size(0))
+		sum += cnorm(LOAD_STATE(stateVector, offset + j));
+
+	sum = localSum(sum, scratch);
+	if (get_local_id(0) == 0)
+		blockSums[get_group_id(0)] = sum;
+}
+
+/**
+ * Computes for every block the probabilities of qubits addressing states inside the block being one.
+ * Marginals of the remaining qubits follow from the block probabilities.
+ */
+__kernel void blockMarginals(__global const storage_t *stateVector, __global real_t *marginals,
+							 ulong blockQubits, __local real_t *scratch) {
+	index_t blockSize = (index_t) 1 << blockQubits;
+	index_t offset = get_group_id(0) * blockSize;
+
+	real_t sums[MAX_BLOCK_QUBITS];
+	for (size_t q = 0; q < blockQubits; ++q)
+		sums[q] = 0;
+
+	for (index_t j = get_local_id(0); j < blockSize; j += get_local_size(0)) {
+		real_t prob = cnorm(LOAD_STATE(stateVector, offset + j));
+		for (size_t q = 0; q < blockQubits; ++q)
+			if ((j >> q) & 1)
+				sums[q] += prob;
+	}
+
+	for (size_t q = 0; q < blockQubits; ++q) {
+		real_t sum = localSum(sums[q], scratch);
+		if (get_local_id(0) == 0)
+			marginals[get_group_id(0) * blockQubits + q] = sum;
+	}
+}
+
+/**
+ * Reduces the block marginals into the marginal probability of every qubit. One work-group handles one qubit,
+ * work-items sum the blocks strided by the work-group size and their sums are reduced as a tree.
+ */
+__kernel void reduceMarginals(__global const real_t *blockMarginals, __global const real_t *blockSums,
+							  ulong numBlocks, ulong blockQubits, __global real_t *marginals,
+							  __local real_t *scratch) {
+	size_t q = get_group_id(0);
+
+	// Kahan summation, every work-item still sums many blocks of large registers
+	real_t sum = 0;
+	real_t compensation = 0;
+	for (size_t b = get_local_id(0); b < numBlocks; b += get_local_size(0)) {
+		real_t value;
+		if (q < blockQubits)
+			value = blockMarginals[b * blockQubits + q];
+		else
+			value = ((b >> (q - blockQubits)) & 1) ? blockSums[b] : 0;
+
+		real_t y = value - compensation;
+		real_t t = sum + y;
+		compensation = (t - sum) - y;
+		sum = t;
+	}
+
+	sum = localSum(sum, scratch);
+	if (get_local_id(0) == 0)
+		marginals[q] = sum;
+}
+
+/**
+ * Computes the inclusive prefix sum of block probabilities, i.e. the cumulative distribution over blocks.
+ * Launched as a single work-group, every work-item scans one contiguous segment.
+ */
+__kernel void scanBlocks(__global const real_t *blockSums, __global real_t *cdf, ulong numBlocks,
+						 __local real_t *scratch) {
+	size_t lid = get_local_id(0);
+	size_t localSize = get_local_size(0);
+	size_t segment = (numBlocks + localSize - 1) / localSize;
+	size_t begin = min(lid * segment, (size_t) numBlocks);
+	size_t end = min(begin + segment, (size_t) numBlocks);
+
+	real_t sum = 0;
+	for (size_t b = begin; b < end; ++b)
+		sum += blockSums[b];
+
+	// inclusive scan of segment sums
+	scratch[lid] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	for (size_t s = 1; s < localSize; s *= 2) {
+		real_t add = lid >= s ? scratch[lid - s] : 0;
+		barrier(CLK_LOCAL_MEM_FENCE);
+		scratch[lid] += add;
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	real_t prefix = lid > 0 ? scratch[lid - 1] : 0;
+	for (size_t b = begin; b < end; ++b) {
+		prefix += blockSums[b];
+		cdf[b] = prefix;
+	}
+}
+
+/**
+ * Samples one state per work-item. The block is found by binary search in the block CDF,
+ * the state inside the block by accumulating its probabilities.
+ */
+__kernel void sampleStates(__global const storage_t *stateVector, __global const real_t *cdf, ulong numBlocks,
+						   ulong blockQubits, __global const real_t *randomNumbers, __global ulong *samples) {
+	size_t shot = get_global_id(0);
+	index_t blockSize = (index_t) 1 << blockQubits;
+	real_t r = randomNumbers[shot] * cdf[numBlocks - 1];
+
+	// first block whose cumulative probability exceeds r
+	size_t lo = 0;
+	size_t hi = numBlocks - 1;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (cdf[mid] > r)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	index_t offset = lo * blockSize;
+	real_t cumulative = lo > 0 ? cdf[lo - 1] : 0;
+	index_t result = offset;
+	for (index_t j = 0; j < blockSize; ++j) {
+		real_t prob = cnorm(LOAD_STATE(stateVector, offset + j));
+		if (prob == 0)
+			continue;
+
+		result = offset + j;
+		cumulative += prob;
+		if (cumulative > r)
+			break;
+	}
 
-    stateVector[indices[0]] = result0;
-    stateVector[indices[1]] = result1;
-    stateVector[indices[2]] = result2;
-    stateVector[indices[3]] = result3;
+	samples[shot] = result;
 }
@@ -0,0 +1,16 @@
+# Embeds a text file into a C++ header as a raw string literal.
+# Usage: cmake -DINPUT=<file> -DOUTPUT=<header> -DNAME=<variable> -P EmbedFile.cmake
+
+file(READ "${INPUT}" CONTENT)
+get_filename_component(INPUT_NAME "${INPUT}" NAME)
+
+file(WRITE "${OUTPUT}.tmp"
+        "#pragma once\n"
+        "// Generated from ${INPUT_NAME} during the build, do not edit.\n\n"
+        "namespace KQS::Embedded {\n"
+        "\tinline constexpr const char *${NAME} = R\"KQS_EMBED(${CONTENT})KQS_EMBED\";\n"
+        "}\n")
+
+# touch the header only when its content changed, so that dependants are not rebuilt needlessly
+file(COPY_FILE "${OUTPUT}.tmp" "${OUTPUT}" ONLY_IF_DIFFERENT)
+file(REMOVE "${OUTPUT}.tmp")
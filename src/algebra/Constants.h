@@ -7,11 +7,14 @@ using namespace std::complex_literals;
 
 namespace KQS::Algebra {
 	/** Pi. */
-	constexpr real_t PI = 3.141592653589793238;
+	template<typename T>
+	constexpr T PI = static_cast<T>(3.141592653589793238L);
 
 	/** Reciprocal square root of 2, i.e. 1/sqrt(2). */
-	constexpr real_t RecSqrt2 = 0.707106781186547524;
+	template<typename T>
+	constexpr T RecSqrt2 = static_cast<T>(0.707106781186547524L);
 
-	/** The imaginary unit. It is cast into the type of complex_t. */
-	constexpr complex_t I = static_cast<complex_t>(1i);
+	/** The imaginary unit. */
+	template<typename T>
+	constexpr std::complex<T> I = std::complex<T>(0, 1);
 }
@@ -1,12 +1,16 @@
 #include <format>
+#include <algorithm>
+#include <immintrin.h>
 #include "Matrix.h"
 
 namespace KQS::Algebra {
 
-	ComplexMatrix::ComplexMatrix(size_t rows, size_t columns)
+	template<typename T>
+	ComplexMatrix<T>::ComplexMatrix(size_t rows, size_t columns)
 			: fRows(rows), fColumns(columns), fData(rows * columns) {}
 
-	ComplexMatrix::ComplexMatrix(std::initializer_list<std::initializer_list<complex_t>> list) {
+	template<typename T>
+	ComplexMatrix<T>::ComplexMatrix(std::initializer_list<std::initializer_list<complex_t>> list) {
 
 		fRows = list.size();
 		if (fRows == 0) {
@@ -30,19 +34,31 @@ namespace KQS::Algebra {
 		}
 	}
 
-	size_t ComplexMatrix::rows() const {
+	template<typename T>
+	ComplexMatrix<T> ComplexMatrix<T>::identity(size_t size) {
+		ComplexMatrix matrix(size, size);
+		for (size_t i = 0; i < size; ++i)
+			matrix.fData[i * size + i] = 1;
+		return matrix;
+	}
+
+	template<typename T>
+	size_t ComplexMatrix<T>::rows() const {
 		return fRows;
 	}
 
-	size_t ComplexMatrix::columns() const {
+	template<typename T>
+	size_t ComplexMatrix<T>::columns() const {
 		return fColumns;
 	}
 
-	const std::vector<complex_t> &ComplexMatrix::data() const {
+	template<typename T>
+	const std::vector<std::complex<T>> &ComplexMatrix<T>::data() const {
 		return fData;
 	}
 
-	complex_t ComplexMatrix::operator[](size_t row, size_t column) const {
+	template<typename T>
+	std::complex<T> ComplexMatrix<T>::operator[](size_t row, size_t column) const {
 		if (row >= fRows)
 			throw std::runtime_error(std::format("Row {} is out of range for matrix of size {}x{}", row, fRows, fColumns));
 		if (column >= fColumns)
@@ -51,7 +67,8 @@ namespace KQS::Algebra {
 		return fData[row * fColumns + column];
 	}
 
-	void ComplexMatrix::operator[](size_t row, size_t column, complex_t value) {
+	template<typename T>
+	void ComplexMatrix<T>::operator[](size_t row, size_t column, complex_t value) {
 		if (row >= fRows)
 			throw std::runtime_error(std::format("Row {} is out of range for matrix of size {}x{}", row, fRows, fColumns));
 		if (column >= fColumns)
@@ -60,25 +77,215 @@ namespace KQS::Algebra {
 		fData[row * fColumns + column] = value;
 	}
 
-	ComplexVector ComplexMatrix::operator*(const ComplexVector &other) const {
+	template<typename T>
+	ComplexVector<T> ComplexMatrix<T>::operator*(const ComplexVector<T> &other) const {
 		if (other.size() != fColumns) {
 			throw std::runtime_error(std::format("Vector of size {} cannot be multiplied by matrix of size {}x{}",
 												 other.size(), fRows, fColumns));
 		}
-		ComplexVector result(fRows);
+		ComplexVector<T> result(fRows);
+		multiply(other, result);
+
+		return result;
+	}
+
+	/** Matrix-vector product of a square matrix with dimension known at compile time, the loops are unrolled. */
+	template<size_t N, typename T>
+	inline void multiplyFixed(const std::complex<T> *matrix, const std::complex<T> *vector, std::complex<T> *result) {
+		for (size_t i = 0; i < N; ++i) {
+			std::complex<T> value = 0;
+			for (size_t j = 0; j < N; ++j)
+				value = multiplyAdd(matrix[i * N + j], vector[j], value);
+			result[i] = value;
+		}
+	}
+
+	template<typename T>
+	void ComplexMatrix<T>::multiply(std::span<const complex_t> vector, std::span<complex_t> result) const {
+		if (fRows == fColumns) {
+			switch (fRows) {
+				case 2:
+					multiplyFixed<2>(fData.data(), vector.data(), result.data());
+					return;
+				case 4:
+					multiplyFixed<4>(fData.data(), vector.data(), result.data());
+					return;
+				case 8:
+					multiplyFixed<8>(fData.data(), vector.data(), result.data());
+					return;
+				default:
+					break;
+			}
+		}
 
 		for (size_t i = 0; i < fRows; ++i) {
+			const complex_t *row = fData.data() + i * fColumns;
 
 			complex_t value = 0;
 			for (size_t j = 0; j < fColumns; ++j)
-				value += operator[](i, j) * other[j];
+				value = multiplyAdd(row[j], vector[j], value);
 			result[i] = value;
 		}
+	}
+
+	/// Matrix-matrix product ///
+
+	/** Number of rows and columns of the blocks of the matrix product, a block of the other matrix fits into L1. */
+	constexpr size_t MultiplyBlockSize = 32;
+
+	/** Computes y += a * x for n complex numbers, 4 per AVX register. */
+	inline void complexAxpy(std::complex<float> a, const std::complex<float> *x, std::complex<float> *y, size_t n) {
+		__m256 aRe = _mm256_set1_ps(a.real());
+		__m256 aIm = _mm256_set1_ps(a.imag());
+
+		size_t j = 0;
+		for (; j + 4 <= n; j += 4) {
+			// [x_re, x_im, ...] and [x_im, x_re, ...]
+			__m256 xv = _mm256_loadu_ps(reinterpret_cast<const float *>(x + j));
+			__m256 xSwapped = _mm256_permute_ps(xv, 0b10'11'00'01);
+			// [a_re * x_re - a_im * x_im, a_re * x_im + a_im * x_re, ...]
+			__m256 product = _mm256_fmaddsub_ps(aRe, xv, _mm256_mul_ps(aIm, xSwapped));
+			__m256 yv = _mm256_loadu_ps(reinterpret_cast<const float *>(y + j));
+			_mm256_storeu_ps(reinterpret_cast<float *>(y + j), _mm256_add_ps(yv, product));
+		}
+		for (; j < n; ++j)
+			y[j] = multiplyAdd(a, x[j], y[j]);
+	}
+
+	/** Computes y += a * x for n complex numbers, 2 per AVX register. */
+	inline void complexAxpy(std::complex<double> a, const std::complex<double> *x, std::complex<double> *y, size_t n) {
+		__m256d aRe = _mm256_set1_pd(a.real());
+		__m256d aIm = _mm256_set1_pd(a.imag());
+
+		size_t j = 0;
+		for (; j + 2 <= n; j += 2) {
+			__m256d xv = _mm256_loadu_pd(reinterpret_cast<const double *>(x + j));
+			__m256d xSwapped = _mm256_permute_pd(xv, 0b0101);
+			__m256d product = _mm256_fmaddsub_pd(aRe, xv, _mm256_mul_pd(aIm, xSwapped));
+			__m256d yv = _mm256_loadu_pd(reinterpret_cast<const double *>(y + j));
+			_mm256_storeu_pd(reinterpret_cast<double *>(y + j), _mm256_add_pd(yv, product));
+		}
+		for (; j < n; ++j)
+			y[j] = multiplyAdd(a, x[j], y[j]);
+	}
+
+	template<typename T>
+	ComplexMatrix<T> ComplexMatrix<T>::operator*(const ComplexMatrix &other) const {
+		if (fColumns != other.fRows) {
+			throw std::runtime_error(std::format("Matrix of size {}x{} cannot be multiplied by matrix of size {}x{}",
+												 fRows, fColumns, other.fRows, other.fColumns));
+		}
+
+		ComplexMatrix result(fRows, other.fColumns);
+		multiply(other.fData, other.fColumns, result.fData);
 
 		return result;
 	}
 
-	std::vector<complex_t> ComplexMatrix::vector() {
+	template<typename T>
+	void ComplexMatrix<T>::multiply(std::span<const complex_t> other, size_t columns, std::span<complex_t> result) const {
+		const complex_t *a = fData.data();
+		const complex_t *b = other.data();
+		complex_t *c = result.data();
+		size_t n = fColumns;
+		size_t m = columns;
+
+		std::fill_n(c, fRows * m, complex_t(0));
+
+		// C[i, j] += A[i, k] * B[k, j] with the rows of B streamed through the vectorized axpy
+		for (size_t ii = 0; ii < fRows; ii += MultiplyBlockSize) {
+			size_t iEnd = std::min(ii + MultiplyBlockSize, fRows);
+			for (size_t kk = 0; kk < n; kk += MultiplyBlockSize) {
+				size_t kEnd = std::min(kk + MultiplyBlockSize, n);
+				for (size_t jj = 0; jj < m; jj += MultiplyBlockSize) {
+					size_t length = std::min(MultiplyBlockSize, m - jj);
+					for (size_t i = ii; i < iEnd; ++i)
+						for (size_t k = kk; k < kEnd; ++k)
+							complexAxpy(a[i * n + k], b + k * m + jj, c + i * m + jj, length);
+				}
+			}
+		}
+	}
+
+	/// Structural operations ///
+
+	template<typename T>
+	ComplexMatrix<T> ComplexMatrix<T>::kronecker(const ComplexMatrix &other) const {
+		ComplexMatrix result(fRows * other.fRows, fColumns * other.fColumns);
+		size_t columns = result.fColumns;
+
+		for (size_t i1 = 0; i1 < fRows; ++i1) {
+			for (size_t j1 = 0; j1 < fColumns; ++j1) {
+				complex_t a = fData[i1 * fColumns + j1];
+				if (a == complex_t(0))
+					continue;
+
+				for (size_t i2 = 0; i2 < other.fRows; ++i2) {
+					const complex_t *row = other.fData.data() + i2 * other.fColumns;
+					complex_t *target = result.fData.data() + (i1 * other.fRows + i2) * columns + j1 * other.fColumns;
+					for (size_t j2 = 0; j2 < other.fColumns; ++j2)
+						target[j2] = multiplyAdd(a, row[j2], complex_t(0));
+				}
+			}
+		}
+
+		return result;
+	}
+
+	template<typename T>
+	ComplexMatrix<T> ComplexMatrix<T>::adjoint() const {
+		ComplexMatrix result(fColumns, fRows);
+		for (size_t i = 0; i < fRows; ++i)
+			for (size_t j = 0; j < fColumns; ++j)
+				result.fData[j * fRows + i] = std::conj(fData[i * fColumns + j]);
+		return result;
+	}
+
+	template<typename T>
+	ComplexMatrix<T> ComplexMatrix<T>::conjugate() const {
+		ComplexMatrix result(fRows, fColumns);
+		for (size_t i = 0; i < fData.size(); ++i)
+			result.fData[i] = std::conj(fData[i]);
+		return result;
+	}
+
+	template<typename T>
+	ComplexMatrix<T> ComplexMatrix<T>::permuteQubits(std::span<const size_t> permutation) const {
+		size_t numQubits = permutation.size();
+		size_t size = 1ULL << numQubits;
+		if (fRows != size || fColumns != size) {
+			throw std::runtime_error(std::format("Matrix of size {}x{} is not a gate on {} qubits",
+												 fRows, fColumns, numQubits));
+		}
+
+		std::vector<bool> used(numQubits);
+		for (size_t qubit: permutation) {
+			if (qubit >= numQubits || used[qubit])
+				throw std::runtime_error(std::format("Invalid permutation of {} qubits", numQubits));
+			used[qubit] = true;
+		}
+
+		// index of this matrix for every index of the result
+		std::vector<size_t> source(size);
+		for (size_t i = 0; i < size; ++i)
+			for (size_t k = 0; k < numQubits; ++k)
+				source[i] |= ((i >> k) & 1ULL) << permutation[k];
+
+		ComplexMatrix result(size, size);
+		for (size_t i = 0; i < size; ++i) {
+			const complex_t *row = fData.data() + source[i] * size;
+			for (size_t j = 0; j < size; ++j)
+				result.fData[i * size + j] = row[source[j]];
+		}
+
+		return result;
+	}
+
+	template<typename T>
+	std::vector<std::complex<T>> ComplexMatrix<T>::vector() {
 		return fData;
 	}
+
+	template class ComplexMatrix<float>;
+	template class ComplexMatrix<double>;
 }
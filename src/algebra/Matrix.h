@@ -3,14 +3,24 @@
 
 #include <cstdlib>
 #include <vector>
+#include <span>
+#include <format>
+#include <stdexcept>
 #include "../types.h"
+#include "SmallMatrix.h"
 
 namespace KQS::Algebra {
 
 	/**
 	 * Class representing a matrix of complex numbers.
+	 * @tparam T type of the real and imaginary parts
 	 */
+	template<typename T>
 	class ComplexMatrix {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+
 	private:
 		size_t fRows;
 		size_t fColumns;
@@ -30,6 +40,28 @@ namespace KQS::Algebra {
 		 */
 		ComplexMatrix(std::initializer_list<std::initializer_list<complex_t>> list);
 
+		/**
+		 * Creates a copy of a matrix with components of another type.
+		 * @param other matrix to convert
+		 */
+		template<typename U>
+		explicit ComplexMatrix(const ComplexMatrix<U> &other)
+				: fRows(other.rows()), fColumns(other.columns()), fData(other.data().begin(), other.data().end()) {}
+
+		/**
+		 * Creates a copy of a fixed-size matrix.
+		 * @param matrix matrix to copy
+		 */
+		template<size_t N>
+		explicit ComplexMatrix(const SmallMatrix<T, N> &matrix)
+				: fRows(N), fColumns(N), fData(matrix.data().begin(), matrix.data().end()) {}
+
+		/**
+		 * Creates an identity matrix.
+		 * @param size number of rows and columns
+		 */
+		static ComplexMatrix identity(size_t size);
+
 		size_t rows() const;
 
 		size_t columns() const;
@@ -40,9 +72,81 @@ namespace KQS::Algebra {
 
 		void operator[](size_t row, size_t column, complex_t value);
 
-		ComplexVector operator*(const ComplexVector &other) const;
+		ComplexVector<T> operator*(const ComplexVector<T> &other) const;
+
+		/**
+		 * Multiplies the vector by the matrix without range checks and allocations. Matrices of dimension 2, 4 and 8
+		 * use fully unrolled kernels.
+		 * @param vector vector with columns() elements
+		 * @param result span of rows() elements receiving the product, must not overlap with the vector
+		 */
+		void multiply(std::span<const complex_t> vector, std::span<complex_t> result) const;
+
+		/**
+		 * Multiplies a block of vectors by the matrix without range checks and allocations, using the same blocked
+		 * kernel as the matrix product.
+		 * @param other row-major matrix with columns() rows and the given number of columns
+		 * @param columns number of columns of the other matrix and the result
+		 * @param result row-major span of rows() x columns elements receiving the product, must not overlap with other
+		 */
+		void multiply(std::span<const complex_t> other, size_t columns, std::span<complex_t> result) const;
+
+		/**
+		 * Multiplies the matrices, the kernel works on cache-sized blocks and vectorizes the rows of the other matrix.
+		 * The product of two gate matrices is the gate applying the other gate first.
+		 * @param other matrix with as many rows as this matrix has columns
+		 * @return product of the matrices
+		 */
+		ComplexMatrix operator*(const ComplexMatrix &other) const;
+
+		/**
+		 * Computes the Kronecker (tensor) product. If this matrix is a gate on qubits A and the other on qubits B,
+		 * the result is the gate on targets B followed by A, i.e. the other matrix acts on the low bits of the index.
+		 * @param other right operand of the product
+		 * @return matrix of size rows() * other.rows() x columns() * other.columns()
+		 */
+		ComplexMatrix kronecker(const ComplexMatrix &other) const;
+
+		/**
+		 * Computes the conjugate transpose, which is the inverse of a unitary matrix.
+		 * @return adjoint matrix
+		 */
+		ComplexMatrix adjoint() const;
+
+		/**
+		 * Computes the element-wise complex conjugate.
+		 * @return conjugate matrix
+		 */
+		ComplexMatrix conjugate() const;
+
+		/**
+		 * Reorders the qubits of a gate matrix. Bit k of the row and column indices of the result corresponds to bit
+		 * permutation[k] of the indices of this matrix, so applying the result to targets t' with
+		 * t'[k] = t[permutation[k]] is the same as applying this matrix to targets t.
+		 * @param permutation permutation of 0, ..., k - 1 for a matrix of size 2^k x 2^k
+		 * @return matrix with reordered qubits
+		 */
+		ComplexMatrix permuteQubits(std::span<const size_t> permutation) const;
 
 		std::vector<complex_t> vector();
+
+		/**
+		 * Copies the matrix into a fixed-size matrix.
+		 * @tparam N dimension of the fixed-size matrix, which must match the dimensions of this matrix
+		 * @return copy of the matrix
+		 */
+		template<size_t N>
+		SmallMatrix<T, N> toSmallMatrix() const {
+			if (fRows != N || fColumns != N)
+				throw std::runtime_error(std::format("Matrix of size {}x{} cannot be converted to size {}x{}",
+													 fRows, fColumns, N, N));
+
+			SmallMatrix<T, N> matrix;
+			for (size_t i = 0; i < N; ++i)
+				for (size_t j = 0; j < N; ++j)
+					matrix[i, j] = fData[i * fColumns + j];
+			return matrix;
+		}
 	};
 
 }
@@ -0,0 +1,267 @@
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include "SVD.h"
+
+namespace KQS::Algebra {
+
+	namespace {
+		/** Maximal number of sweeps over all column pairs, Jacobi rotations converge quadratically after a few. */
+		constexpr size_t MaxSweeps = 60;
+
+		/**
+		 * Orthogonalizes the columns of a tall matrix by Jacobi rotations, accumulating the rotations in v.
+		 * @param w column-major rows x columns matrix, its columns are the scaled left singular vectors afterwards
+		 * @param v column-major columns x columns matrix, set to the right singular vectors
+		 */
+		template<typename T>
+		void orthogonalizeColumns(std::vector<std::complex<T>> &w, std::vector<std::complex<T>> &v, size_t rows,
+								  size_t columns) {
+			using complex_t = std::complex<T>;
+			constexpr T epsilon = std::numeric_limits<T>::epsilon();
+
+			v.assign(columns * columns, 0);
+			for (size_t j = 0; j < columns; ++j)
+				v[j * columns + j] = 1;
+
+			for (size_t sweep = 0; sweep < MaxSweeps; ++sweep) {
+				bool rotated = false;
+				for (size_t p = 0; p + 1 < columns; ++p) {
+					complex_t *wp = &w[p * rows];
+					for (size_t q = p + 1; q < columns; ++q) {
+						complex_t *wq = &w[q * rows];
+
+						// the inner products are summed in double precision, so that float columns become orthogonal
+						// to float precision
+						double alpha = 0;
+						double beta = 0;
+						std::complex<double> sum = 0;
+						for (size_t i = 0; i < rows; ++i) {
+							std::complex<double> a = wp[i];
+							std::complex<double> b = wq[i];
+							alpha += std::norm(a);
+							beta += std::norm(b);
+							sum += std::conj(a) * b;
+						}
+
+						double magnitude = std::abs(sum);
+						if (magnitude == 0 || magnitude <= epsilon * std::sqrt(alpha * beta))
+							continue;
+						rotated = true;
+
+						// rotation zeroing the inner product of the columns, with the phase of the inner product
+						double zeta = (beta - alpha) / (2 * magnitude);
+						double t = std::copysign(1.0, zeta) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+						auto c = static_cast<T>(1 / std::sqrt(1 + t * t));
+						auto s = static_cast<T>(t / std::sqrt(1 + t * t));
+						auto phase = static_cast<complex_t>(sum / magnitude);
+
+						for (size_t i = 0; i < rows; ++i) {
+							complex_t a = wp[i];
+							complex_t b = wq[i];
+							wp[i] = c * a - s * std::conj(phase) * b;
+							wq[i] = s * phase * a + c * b;
+						}
+						complex_t *vp = &v[p * columns];
+						complex_t *vq = &v[q * columns];
+						for (size_t i = 0; i < columns; ++i) {
+							complex_t a = vp[i];
+							complex_t b = vq[i];
+							vp[i] = c * a - s * std::conj(phase) * b;
+							vq[i] = s * phase * a + c * b;
+						}
+					}
+				}
+				if (!rotated)
+					break;
+			}
+		}
+
+		/**
+		 * Householder QR decomposition, e.g. of a tall matrix so that the rotations of Jacobi work on the small R.
+		 * @param w column-major rows x columns matrix, replaced by the column-major k x columns R with
+		 * k = min(rows, columns)
+		 * @return reflectors, reflector j has rows - j elements acting on rows j to rows - 1
+		 */
+		template<typename T>
+		std::vector<std::vector<std::complex<T>>> householderQR(std::vector<std::complex<T>> &w, size_t rows,
+																size_t columns) {
+			using complex_t = std::complex<T>;
+			size_t k = std::min(rows, columns);
+
+			std::vector<std::vector<complex_t>> reflectors(k);
+			for (size_t j = 0; j < k; ++j) {
+				complex_t *column = &w[j * rows];
+				T norm = 0;
+				for (size_t i = j; i < rows; ++i)
+					norm += std::norm(column[i]);
+				norm = std::sqrt(norm);
+
+				// v = x - alpha e_j with alpha of the opposite phase of x_j, so that v is never cancelled
+				std::vector<complex_t> &v = reflectors[j];
+				v.assign(column + j, column + rows);
+				if (norm == 0) {
+					v.assign(v.size(), 0);
+					continue;
+				}
+				complex_t phase = std::abs(v[0]) > 0 ? v[0] / std::abs(v[0]) : complex_t(1);
+				v[0] += phase * norm;
+				T length = 0;
+				for (const complex_t &element: v)
+					length += std::norm(element);
+				length = std::sqrt(length);
+				for (complex_t &element: v)
+					element /= length;
+
+				for (size_t c = j; c < columns; ++c) {
+					complex_t *target = &w[c * rows + j];
+					complex_t dot = 0;
+					for (size_t i = 0; i < v.size(); ++i)
+						dot += std::conj(v[i]) * target[i];
+					for (size_t i = 0; i < v.size(); ++i)
+						target[i] -= T(2) * dot * v[i];
+				}
+			}
+
+			std::vector<complex_t> r(k * columns);
+			for (size_t c = 0; c < columns; ++c)
+				for (size_t i = 0; i <= std::min(c, k - 1); ++i)
+					r[c * k + i] = w[c * rows + i];
+			w = std::move(r);
+			return reflectors;
+		}
+
+		/**
+		 * Multiplies a matrix padded by zero rows by Q of householderQR().
+		 * @param matrix column-major k x columns matrix, k being the number of reflectors
+		 * @return column-major rows x columns product
+		 */
+		template<typename T>
+		std::vector<std::complex<T>> multiplyQ(const std::vector<std::vector<std::complex<T>>> &reflectors,
+											   const std::vector<std::complex<T>> &matrix, size_t rows,
+											   size_t columns) {
+			size_t k = reflectors.size();
+			std::vector<std::complex<T>> result(rows * columns);
+			for (size_t c = 0; c < columns; ++c)
+				std::copy_n(&matrix[c * k], k, &result[c * rows]);
+
+			for (size_t j = k; j-- > 0;) {
+				const std::vector<std::complex<T>> &v = reflectors[j];
+				for (size_t c = 0; c < columns; ++c) {
+					std::complex<T> *target = &result[c * rows + j];
+					std::complex<T> dot = 0;
+					for (size_t i = 0; i < v.size(); ++i)
+						dot += std::conj(v[i]) * target[i];
+					for (size_t i = 0; i < v.size(); ++i)
+						target[i] -= T(2) * dot * v[i];
+				}
+			}
+			return result;
+		}
+	}
+
+	template<typename T>
+	QRDecomposition<T> qrDecomposition(std::span<const std::complex<T>> matrix, size_t rows, size_t columns) {
+		using complex_t = std::complex<T>;
+		size_t k = std::min(rows, columns);
+
+		std::vector<complex_t> w(rows * columns);
+		for (size_t i = 0; i < rows; ++i)
+			for (size_t j = 0; j < columns; ++j)
+				w[j * rows + i] = matrix[i * columns + j];
+
+		auto reflectors = householderQR(w, rows, columns);
+		std::vector<complex_t> identity(k * k);
+		for (size_t j = 0; j < k; ++j)
+			identity[j * k + j] = 1;
+		std::vector<complex_t> q = multiplyQ(reflectors, identity, rows, k);
+
+		QRDecomposition<T> result;
+		result.q.resize(rows * k);
+		result.r.resize(k * columns);
+		for (size_t i = 0; i < rows; ++i)
+			for (size_t j = 0; j < k; ++j)
+				result.q[i * k + j] = q[j * rows + i];
+		for (size_t i = 0; i < k; ++i)
+			for (size_t j = 0; j < columns; ++j)
+				result.r[i * columns + j] = w[j * k + i];
+		return result;
+	}
+
+	template<typename T>
+	SingularValueDecomposition<T> singularValueDecomposition(std::span<const std::complex<T>> matrix, size_t rows,
+															 size_t columns) {
+		using complex_t = std::complex<T>;
+
+		// wide matrices are decomposed as A^+ = U' S V'^+, so A = V' S U'^+
+		bool wide = rows < columns;
+		size_t m = wide ? columns : rows;
+		size_t k = wide ? rows : columns;
+
+		// column-major copy of the tall matrix, the row-major wide matrix conjugated is its adjoint column-major
+		std::vector<complex_t> w(m * k);
+		if (wide) {
+			for (size_t i = 0; i < m * k; ++i)
+				w[i] = std::conj(matrix[i]);
+		} else {
+			for (size_t i = 0; i < rows; ++i)
+				for (size_t j = 0; j < columns; ++j)
+					w[j * rows + i] = matrix[i * columns + j];
+		}
+
+		// the rotations of long columns are expensive, they are applied to R of the QR decomposition instead
+		std::vector<complex_t> v;
+		if (m > k) {
+			auto reflectors = householderQR(w, m, k);
+			orthogonalizeColumns(w, v, k, k);
+			w = multiplyQ(reflectors, w, m, k);
+		} else
+			orthogonalizeColumns(w, v, m, k);
+
+		std::vector<T> norms(k);
+		for (size_t j = 0; j < k; ++j) {
+			T sum = 0;
+			for (size_t i = 0; i < m; ++i)
+				sum += std::norm(w[j * m + i]);
+			norms[j] = std::sqrt(sum);
+		}
+
+		std::vector<size_t> order(k);
+		std::iota(order.begin(), order.end(), 0);
+		std::ranges::stable_sort(order, std::ranges::greater{}, [&norms](size_t j) { return norms[j]; });
+
+		SingularValueDecomposition<T> result;
+		result.u.resize(rows * k);
+		result.singularValues.resize(k);
+		result.vh.resize(k * columns);
+
+		for (size_t n = 0; n < k; ++n) {
+			size_t j = order[n];
+			T sigma = norms[j];
+			T scale = sigma > 0 ? 1 / sigma : 0;
+			result.singularValues[n] = sigma;
+
+			if (wide) {
+				for (size_t i = 0; i < rows; ++i)
+					result.u[i * k + n] = v[j * k + i];
+				for (size_t c = 0; c < columns; ++c)
+					result.vh[n * columns + c] = std::conj(w[j * m + c]) * scale;
+			} else {
+				for (size_t i = 0; i < rows; ++i)
+					result.u[i * k + n] = w[j * m + i] * scale;
+				for (size_t c = 0; c < columns; ++c)
+					result.vh[n * columns + c] = std::conj(v[j * k + c]);
+			}
+		}
+
+		return result;
+	}
+
+	template QRDecomposition<float> qrDecomposition<float>(std::span<const std::complex<float>>, size_t, size_t);
+	template QRDecomposition<double> qrDecomposition<double>(std::span<const std::complex<double>>, size_t, size_t);
+	template SingularValueDecomposition<float> singularValueDecomposition<float>(
+			std::span<const std::complex<float>>, size_t, size_t);
+	template SingularValueDecomposition<double> singularValueDecomposition<double>(
+			std::span<const std::complex<double>>, size_t, size_t);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include <span>
+#include "../types.h"
+
+namespace KQS::Algebra {
+
+	/**
+	 * Singular value decomposition A = U diag(S) V^+ of a rows x columns matrix with k = min(rows, columns)
+	 * singular values.
+	 * @tparam T type of the real and imaginary parts
+	 */
+	template<typename T>
+	struct SingularValueDecomposition {
+		/** Left singular vectors, row-major rows x k matrix with orthonormal columns. */
+		std::vector<std::complex<T>> u;
+		/** Singular values in decreasing order. */
+		std::vector<T> singularValues;
+		/** Conjugate transposed right singular vectors V^+, row-major k x columns matrix with orthonormal rows. */
+		std::vector<std::complex<T>> vh;
+	};
+
+	/**
+	 * QR decomposition A = Q R of a rows x columns matrix with k = min(rows, columns).
+	 * @tparam T type of the real and imaginary parts
+	 */
+	template<typename T>
+	struct QRDecomposition {
+		/** Row-major rows x k matrix with orthonormal columns. */
+		std::vector<std::complex<T>> q;
+		/** Row-major upper triangular (trapezoidal for wide matrices) k x columns matrix. */
+		std::vector<std::complex<T>> r;
+	};
+
+	/**
+	 * Computes the QR decomposition by Householder reflections. It is much cheaper than the singular value
+	 * decomposition when only an orthonormal basis of the columns is needed.
+	 * @param matrix row-major matrix
+	 * @param rows number of rows of the matrix
+	 * @param columns number of columns of the matrix
+	 */
+	template<typename T>
+	QRDecomposition<T> qrDecomposition(std::span<const std::complex<T>> matrix, size_t rows, size_t columns);
+
+	/**
+	 * Computes the singular value decomposition by one-sided Jacobi rotations (Hestenes), which orthogonalize the
+	 * columns of the matrix pairwise until they are orthogonal to working precision. It is accurate also for
+	 * small singular values, which suits the small matrices of tensor network contractions. Tall matrices are
+	 * first reduced to the square R of their QR decomposition, wide matrices are decomposed through their adjoint.
+	 * @param matrix row-major matrix
+	 * @param rows number of rows of the matrix
+	 * @param columns number of columns of the matrix
+	 * @return decomposition, the singular vectors of zero singular values may be zero vectors
+	 */
+	template<typename T>
+	SingularValueDecomposition<T> singularValueDecomposition(std::span<const std::complex<T>> matrix, size_t rows,
+															 size_t columns);
+}
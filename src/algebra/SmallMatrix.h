@@ -0,0 +1,117 @@
+#pragma once
+
+
+#include <cstdlib>
+#include <array>
+#include <initializer_list>
+#include <stdexcept>
+#include "../types.h"
+
+namespace KQS::Algebra {
+
+	/**
+	 * Computes a * b + c. Unlike the std::complex operators it skips the recovery of infinities from NaN products
+	 * required by the C standard, so it compiles to plain multiply-adds instead of a library call.
+	 */
+	template<typename T>
+	constexpr std::complex<T> multiplyAdd(std::complex<T> a, std::complex<T> b, std::complex<T> c) {
+		return {a.real() * b.real() - a.imag() * b.imag() + c.real(),
+				a.real() * b.imag() + a.imag() * b.real() + c.imag()};
+	}
+
+	/** Computes a * b like multiplyAdd, without the addition of zero the compiler must keep for signed zeros. */
+	template<typename T>
+	constexpr std::complex<T> multiply(std::complex<T> a, std::complex<T> b) {
+		return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+	}
+
+	/**
+	 * Square matrix of complex numbers with dimension known at compile time, stored inline in row-major order.
+	 * Unlike ComplexMatrix it never allocates and all its operations are constexpr, so the matrices of the standard
+	 * gates are compile-time constants and kernels can keep their elements in registers.
+	 * @tparam T type of the real and imaginary parts
+	 * @tparam N number of rows and columns
+	 */
+	template<typename T, size_t N>
+	class SmallMatrix {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+
+	private:
+		std::array<complex_t, N * N> fData{};
+
+	public:
+		/** Creates a matrix of zeros. */
+		constexpr SmallMatrix() = default;
+
+		/**
+		 * Creates a matrix from 2D initializer list.
+		 * @param list initializer list with N rows of N elements
+		 */
+		constexpr SmallMatrix(std::initializer_list<std::initializer_list<complex_t>> list) {
+			if (list.size() != N)
+				throw std::runtime_error("Matrix must have the same number of rows as its dimension");
+
+			for (size_t i = 0; const auto &row: list) {
+				if (row.size() != N)
+					throw std::runtime_error("Matrix must have the same number of columns as its dimension");
+
+				for (size_t j = 0; const auto &value: row) {
+					fData[i * N + j] = value;
+					++j;
+				}
+				++i;
+			}
+		}
+
+		static constexpr SmallMatrix identity() {
+			SmallMatrix matrix;
+			for (size_t i = 0; i < N; ++i)
+				matrix[i, i] = 1;
+			return matrix;
+		}
+
+		static constexpr size_t rows() {
+			return N;
+		}
+
+		static constexpr size_t columns() {
+			return N;
+		}
+
+		constexpr const std::array<complex_t, N * N> &data() const {
+			return fData;
+		}
+
+		/** Element access without range checks, the indices are expected to be below N. */
+		constexpr complex_t operator[](size_t row, size_t column) const {
+			return fData[row * N + column];
+		}
+
+		constexpr complex_t &operator[](size_t row, size_t column) {
+			return fData[row * N + column];
+		}
+
+		constexpr std::array<complex_t, N> operator*(const std::array<complex_t, N> &vector) const {
+			std::array<complex_t, N> result{};
+			for (size_t i = 0; i < N; ++i)
+				for (size_t j = 0; j < N; ++j)
+					result[i] = multiplyAdd(fData[i * N + j], vector[j], result[i]);
+			return result;
+		}
+
+		constexpr SmallMatrix operator*(const SmallMatrix &other) const {
+			SmallMatrix result;
+			for (size_t i = 0; i < N; ++i)
+				for (size_t k = 0; k < N; ++k)
+					for (size_t j = 0; j < N; ++j)
+						result.fData[i * N + j] = multiplyAdd(fData[i * N + k], other.fData[k * N + j],
+															  result.fData[i * N + j]);
+			return result;
+		}
+
+		constexpr bool operator==(const SmallMatrix &other) const = default;
+	};
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <bit>
+#include <cstdlib>
+#include <cstdint>
+#include <complex>
+#include <vector>
+
+namespace KQS::Circuit {
+
+	/**
+	 * Hash map from basis state indices to amplitudes with open addressing: the entries are stored in flat arrays
+	 * with linear probing from Fibonacci hashes of the indices, so lookups touch one or two cache lines and
+	 * iterating the entries is a scan of the arrays. The capacity is a power of two and at least twice the number of
+	 * entries. Entries are never removed individually, filtered copies are made instead.
+	 * @tparam T type of the real and imaginary parts of the amplitudes
+	 */
+	template<typename T>
+	class AmplitudeMap {
+	public:
+		using complex_t = std::complex<T>;
+
+		static constexpr size_t MinCapacity = 16;
+
+	private:
+		std::vector<size_t> fKeys;
+		std::vector<complex_t> fValues;
+		std::vector<uint8_t> fUsed;
+		size_t fSize = 0;
+		/** Number of bits of the hashes, log2 of the capacity. */
+		size_t fBits = 0;
+
+	public:
+		AmplitudeMap() {
+			reserve(0);
+		}
+
+		size_t size() const {
+			return fSize;
+		}
+
+		size_t capacity() const {
+			return fKeys.size();
+		}
+
+		/** Removes all entries and makes room for the given number without rehashing. */
+		void reserve(size_t entries) {
+			size_t capacity = std::max(MinCapacity, std::bit_ceil(2 * entries + 1));
+			fBits = std::countr_zero(capacity);
+			fKeys.assign(capacity, 0);
+			fValues.assign(capacity, 0);
+			fUsed.assign(capacity, 0);
+			fSize = 0;
+		}
+
+		/** Returns the amplitude of the index, inserting zero if there is none. */
+		complex_t &operator[](size_t key) {
+			if (2 * (fSize + 1) > capacity())
+				grow();
+
+			size_t slot = find(key);
+			if (!fUsed[slot]) {
+				fUsed[slot] = 1;
+				fKeys[slot] = key;
+				fValues[slot] = 0;
+				++fSize;
+			}
+			return fValues[slot];
+		}
+
+		/** Returns the amplitude of the index, zero if there is none. */
+		complex_t at(size_t key) const {
+			size_t slot = find(key);
+			return fUsed[slot] ? fValues[slot] : complex_t(0);
+		}
+
+		/** Calls the function with the index and a reference to the amplitude of every entry. */
+		template<typename F>
+		void forEach(F &&function) {
+			for (size_t slot = 0; slot < capacity(); ++slot)
+				if (fUsed[slot])
+					function(fKeys[slot], fValues[slot]);
+		}
+
+		template<typename F>
+		void forEach(F &&function) const {
+			for (size_t slot = 0; slot < capacity(); ++slot)
+				if (fUsed[slot])
+					function(fKeys[slot], fValues[slot]);
+		}
+
+	private:
+		/** Slot of the index or the empty slot where it would be inserted. */
+		size_t find(size_t key) const {
+			size_t mask = capacity() - 1;
+			size_t slot = (key * 0x9E3779B97F4A7C15ULL) >> (64 - fBits);
+			while (fUsed[slot] && fKeys[slot] != key)
+				slot = (slot + 1) & mask;
+			return slot;
+		}
+
+		void grow() {
+			std::vector<size_t> keys = std::move(fKeys);
+			std::vector<complex_t> values = std::move(fValues);
+			std::vector<uint8_t> used = std::move(fUsed);
+
+			reserve(fSize + 1);
+			for (size_t slot = 0; slot < keys.size(); ++slot)
+				if (used[slot])
+					(*this)[keys[slot]] = values[slot];
+		}
+	};
+}
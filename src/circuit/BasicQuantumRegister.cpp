@@ -1,29 +1,48 @@
 #include <format>
 #include "BasicQuantumRegister.h"
+#include "StandardGateKernels.h"
+#include "DenseGateKernels.h"
+#include "StructuredGateKernels.h"
+#include "PermutationKernels.h"
 
 namespace KQS::Circuit {
 
-	BasicQuantumRegister::BasicQuantumRegister(size_t numberOfQubits)
-			: QuantumRegister(numberOfQubits), fStateVector(fNumStates) {
+	template<typename T>
+	BasicQuantumRegister<T>::BasicQuantumRegister(size_t numberOfQubits)
+			: QuantumRegister<T>(numberOfQubits), fStateVector(fNumStates) {
 		fStateVector[0] = 1;
 	}
 
-	void BasicQuantumRegister::setStateVector(const std::vector<complex_t> &stateVector) {
+	template<typename T>
+	void BasicQuantumRegister<T>::setPhysicalStateVector(const std::vector<complex_t> &stateVector) {
 		fStateVector = stateVector;
 	}
 
-	std::vector<complex_t> BasicQuantumRegister::stateVector() const {
+	template<typename T>
+	std::vector<std::complex<T>> BasicQuantumRegister<T>::physicalStateVector() const {
 		return fStateVector;
 	}
 
-	void BasicQuantumRegister::applyOneQubitGate(const QuantumLogicGate &gate, size_t targetQubit) {
+	template<typename T>
+	void BasicQuantumRegister<T>::readPhysicalStateVector(const StateChunkCallback &callback) const {
+		callback(0, fStateVector);
+	}
+
+	template<typename T>
+	std::vector<std::complex<double>> BasicQuantumRegister<T>::physicalReducedDensityMatrix(
+			const std::vector<size_t> &qubits) const {
+		return Kernels::reducedDensityMatrix(fNumStates, qubits, [this](size_t i) { return fStateVector[i]; });
+	}
+
+	template<typename T>
+	void BasicQuantumRegister<T>::applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) {
 		if (targetQubit >= fNumQubits)
 			throw std::runtime_error(
 					std::format("Cannot apply gate to qubit {} in {}-qubit register", targetQubit, fNumStates));
 
 		size_t groups = fNumStates / 2;
 
-		ComplexVector group(2);
+		std::array<complex_t, 2> group{};
 		std::array<size_t, 2> indices{};
 		for (size_t i = 0; i < groups; ++i) {
 
@@ -37,14 +56,15 @@ namespace KQS::Circuit {
 				group[j] = fStateVector[state];
 			}
 
-			ComplexVector result = gate.matrix() * group;
+			std::array<complex_t, 2> result = matrix * group;
 
 			fStateVector[indices[0]] = result[0];
 			fStateVector[indices[1]] = result[1];
 		}
 	}
 
-	void BasicQuantumRegister::applyTwoQubitGate(const QuantumLogicGate &gate, std::array<size_t, 2> targetQubits) {
+	template<typename T>
+	void BasicQuantumRegister<T>::applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) {
 		if (targetQubits[0] >= fNumQubits)
 			throw std::runtime_error(
 					std::format("Cannot apply gate to qubit {} in {}-qubit register", targetQubits[0], fNumStates));
@@ -57,7 +77,7 @@ namespace KQS::Circuit {
 		if (targetQubits[0] > targetQubits[1])
 			targetQubits[0]--;
 
-		ComplexVector group(4);
+		std::array<complex_t, 4> group{};
 		std::array<size_t, 4> indices{};
 		for (size_t i = 0; i < groups; ++i) {
 
@@ -72,54 +92,117 @@ namespace KQS::Circuit {
 				group[j] = fStateVector[state];
 			}
 
-			ComplexVector result = gate.matrix() * group;
+			std::array<complex_t, 4> result = matrix * group;
 
 			for (int j = 0; j < 4; ++j)
 				fStateVector[indices[j]] = result[j];
 		}
 	}
 
-	void BasicQuantumRegister::applyKQubitGate(const QuantumLogicGate &gate, const std::vector<size_t> &targetQubits) {
-		size_t groupSize = 1 << targetQubits.size(); // group size is 2^qubits
-		size_t groups = fNumStates / groupSize;
-
-		std::vector<size_t> targetQubitsModified(targetQubits.size());
-		for (size_t i = 0; i < targetQubits.size(); ++i) {
-			size_t pos = targetQubits[i];
-
-			for (size_t j = i + 1; j < targetQubits.size(); ++j)
-				if (targetQubits[j] < targetQubits[i])
-					pos--;
+	template<typename T>
+	void BasicQuantumRegister<T>::applyKQubitGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
+		Kernels::applyDenseGate(fStateVector.data(), fNumStates, gate.matrix(), targetQubits);
+	}
 
-			targetQubitsModified[i] = pos;
+	template<typename T>
+	void BasicQuantumRegister<T>::applyDiagonalGate(const QuantumLogicGate<T> &gate,
+													const std::vector<size_t> &targetQubits) {
+		// phases of the last state are standard gates, their kernels touch only the changed states
+		const std::vector<complex_t> &diagonal = gate.factors();
+		if (targetQubits.size() == 1 && diagonal[0] == complex_t(1) && diagonal[1] != complex_t(1)) {
+			applyStandardGate(StandardGate::Phase, {targetQubits[0], 0}, diagonal[1]);
+			return;
+		}
+		if (targetQubits.size() == 2 && diagonal[0] == complex_t(1) && diagonal[1] == complex_t(1) &&
+			diagonal[2] == complex_t(1) && diagonal[3] != complex_t(1)) {
+			applyStandardGate(StandardGate::ControlledPhase, {targetQubits[0], targetQubits[1]}, diagonal[3]);
+			return;
 		}
 
+		Kernels::applyDiagonalGate(fStateVector.data(), fNumStates, diagonal, targetQubits);
+	}
 
-		ComplexVector group(groupSize);
-		std::vector<size_t> indices(groupSize);
-		for (size_t i = 0; i < groups; ++i) {
-
-			for (size_t j = 0; j < groupSize; ++j) {
-				// combine i and j into a state
-				size_t state = i;
-				for (size_t k = 0; k < targetQubits.size(); ++k) {
-					size_t bit = (j >> k) & 1; // k-th bit in j
-					size_t position = targetQubitsModified[k];
-					state = insertBitAtPosition(state, bit, position);
+	template<typename T>
+	void BasicQuantumRegister<T>::applyMonomialGate(const QuantumLogicGate<T> &gate,
+													const std::vector<size_t> &targetQubits) {
+		// X, CNOT and Swap given as matrices use the kernels of the named gates
+		if (gate.structure() == GateStructure::Permutation) {
+			const std::vector<size_t> &sources = gate.sources();
+			if (targetQubits.size() == 1) {
+				applyStandardGate(StandardGate::PauliX, {targetQubits[0], 0}, 1);
+				return;
+			}
+			if (targetQubits.size() == 2) {
+				if (sources == std::vector<size_t>{0, 1, 3, 2}) {
+					applyStandardGate(StandardGate::ControlledX, {targetQubits[0], targetQubits[1]}, 1);
+					return;
+				}
+				if (sources == std::vector<size_t>{0, 3, 2, 1}) {
+					applyStandardGate(StandardGate::ControlledX, {targetQubits[1], targetQubits[0]}, 1);
+					return;
+				}
+				if (sources == std::vector<size_t>{0, 2, 1, 3}) {
+					applyStandardGate(StandardGate::Swap, {targetQubits[0], targetQubits[1]}, 1);
+					return;
 				}
-
-				indices[j] = state;
-				group[j] = fStateVector[state];
 			}
+		}
 
-			ComplexVector result = gate.matrix() * group;
+		Kernels::applyMonomialGate(fStateVector.data(), fNumStates, gate.sources(), gate.factors(), targetQubits);
+	}
 
-			for (size_t j = 0; j < groupSize; ++j)
-				fStateVector[indices[j]] = result[j];
+	template<typename T>
+	void BasicQuantumRegister<T>::applyControlledGate(const QuantumLogicGate<T> &gate,
+													  const std::vector<size_t> &targetQubits) {
+		auto [targets, controls] = this->splitControls(gate, targetQubits);
+		Kernels::applyDenseGate(fStateVector.data(), fNumStates, gate.targetMatrix(), targets, controls);
+	}
+
+	template<typename T>
+	void BasicQuantumRegister<T>::applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor) {
+		size_t usedQubits = isTwoQubitGate(gate) ? 2 : 1;
+		for (size_t i = 0; i < usedQubits; ++i)
+			if (qubits[i] >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Cannot apply gate to qubit {} in {}-qubit register", qubits[i], fNumQubits));
+		if (usedQubits == 2 && qubits[0] == qubits[1])
+			throw std::runtime_error(std::format("Cannot apply two-qubit gate twice to qubit {}", qubits[0]));
+
+		complex_t *state = fStateVector.data();
+		switch (gate) {
+			case StandardGate::PauliX:
+				Kernels::applyStandardGate<StandardGate::PauliX>(state, fNumStates, qubits, factor);
+				break;
+			case StandardGate::PauliY:
+				Kernels::applyStandardGate<StandardGate::PauliY>(state, fNumStates, qubits, factor);
+				break;
+			case StandardGate::Hadamard:
+				Kernels::applyStandardGate<StandardGate::Hadamard>(state, fNumStates, qubits, factor);
+				break;
+			case StandardGate::Phase:
+				Kernels::applyStandardGate<StandardGate::Phase>(state, fNumStates, qubits, factor);
+				break;
+			case StandardGate::ControlledX:
+				Kernels::applyStandardGate<StandardGate::ControlledX>(state, fNumStates, qubits, factor);
+				break;
+			case StandardGate::ControlledPhase:
+				Kernels::applyStandardGate<StandardGate::ControlledPhase>(state, fNumStates, qubits, factor);
+				break;
+			case StandardGate::Swap:
+				Kernels::applyStandardGate<StandardGate::Swap>(state, fNumStates, qubits, factor);
+				break;
 		}
 	}
 
-	size_t BasicQuantumRegister::insertBitAtPosition(size_t x, size_t bit, size_t position) {
+	template<typename T>
+	void BasicQuantumRegister<T>::permutePhysicalQubits(const std::vector<size_t> &permutation) {
+		std::vector<complex_t> permuted(fNumStates);
+		Kernels::permuteQubits<1>(fStateVector.data(), permuted.data(), fNumQubits, permutation);
+		fStateVector.swap(permuted);
+	}
+
+	template<typename T>
+	size_t BasicQuantumRegister<T>::insertBitAtPosition(size_t x, size_t bit, size_t position) {
 		size_t mask = (1ULL << position) - 1; // mask, where first `position` bits are ones
 		size_t tmp = x & mask; // first `position` bits of x
 
@@ -131,4 +214,7 @@ namespace KQS::Circuit {
 
 		return x;
 	}
+
+	template class BasicQuantumRegister<float>;
+	template class BasicQuantumRegister<double>;
 }
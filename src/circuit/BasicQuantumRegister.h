@@ -8,20 +8,36 @@
 #include "QuantumRegister.h"
 
 namespace KQS::Circuit {
-	class BasicQuantumRegister : public QuantumRegister {
+	template<typename T>
+	class BasicQuantumRegister : public QuantumRegister<T> {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+		using typename QuantumRegister<T>::StateChunkCallback;
+
 	protected:
+		using QuantumRegister<T>::fNumQubits;
+		using QuantumRegister<T>::fNumStates;
+
 		std::vector<complex_t> fStateVector;
 
 	public:
 		explicit BasicQuantumRegister(size_t numberOfQubits);
 
-		void setStateVector(const std::vector<complex_t> &stateVector) override;
-		std::vector<complex_t> stateVector() const override;
-
 	protected:
-		void applyOneQubitGate(const QuantumLogicGate &gate, size_t targetQubit) override;
-		void applyTwoQubitGate(const QuantumLogicGate &gate, std::array<size_t, 2> targetQubits) override;
-		void applyKQubitGate(const QuantumLogicGate &gate, const std::vector<size_t> &targetQubits) override;
+		void setPhysicalStateVector(const std::vector<complex_t> &stateVector) override;
+		std::vector<complex_t> physicalStateVector() const override;
+		void readPhysicalStateVector(const StateChunkCallback &callback) const override;
+		std::vector<std::complex<double>> physicalReducedDensityMatrix(const std::vector<size_t> &qubits) const override;
+
+		void applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) override;
+		void applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) override;
+		void applyKQubitGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyDiagonalGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyMonomialGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyControlledGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor) override;
+		void permutePhysicalQubits(const std::vector<size_t> &permutation) override;
 
 		static size_t insertBitAtPosition(size_t x, size_t bit, size_t position);
 	};
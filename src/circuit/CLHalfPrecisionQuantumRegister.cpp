@@ -0,0 +1,23 @@
+#include <format>
+#include "CLHalfPrecisionQuantumRegister.h"
+
+namespace KQS::Circuit {
+
+	/** Checks the number of qubits before the device buffers are allocated. */
+	inline size_t checkedQubits(size_t numberOfQubits, HalfFormat format) {
+		if (format == HalfFormat::FP16 && numberOfQubits > CLHalfPrecisionQuantumRegister::MaxFP16Qubits)
+			throw std::runtime_error(std::format("FP16 amplitudes of {} qubits are subnormal, at most {} qubits are "
+												 "supported, use bfloat16 or HalfPrecisionQuantumRegister",
+												 numberOfQubits, CLHalfPrecisionQuantumRegister::MaxFP16Qubits));
+		return numberOfQubits;
+	}
+
+	CLHalfPrecisionQuantumRegister::CLHalfPrecisionQuantumRegister(size_t numberOfQubits, const cl::Context &context,
+																   const cl::Device &device, HalfFormat format,
+																   size_t chunkStates)
+			: CLQuantumRegister<float>(checkedQubits(numberOfQubits, format), context, device, chunkStates, format) {}
+
+	HalfFormat CLHalfPrecisionQuantumRegister::format() const {
+		return *fHalfFormat;
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CLQuantumRegister.h"
+
+namespace KQS::Circuit {
+
+	/**
+	 * OpenCL register storing the amplitudes as pairs of 16-bit floats, the device counterpart of
+	 * HalfPrecisionQuantumRegister. The kernels widen the amplitudes to floats with vload_half2 (or a shift for
+	 * bfloat16), compute in single precision and round the results back, so the state vector takes half of the
+	 * device memory and bandwidth of CLQuantumRegister<float>.
+	 *
+	 * Unlike HalfPrecisionQuantumRegister, the device kernels do not scale the FP16 amplitudes. Amplitudes of a
+	 * uniform superposition of n qubits are 2^(-n/2) and IEEE half precision is normal only down to 2^-14, so FP16
+	 * registers are limited to MaxFP16Qubits; bfloat16 has the exponent range of float and no limit.
+	 */
+	class CLHalfPrecisionQuantumRegister : public CLQuantumRegister<float> {
+	public:
+		/** The largest FP16 register whose uniform superposition has normal amplitudes. */
+		static constexpr size_t MaxFP16Qubits = 28;
+
+		/** @throws std::runtime_error if the format is FP16 and there are more than MaxFP16Qubits qubits */
+		CLHalfPrecisionQuantumRegister(size_t numberOfQubits, const cl::Context &context, const cl::Device &device,
+									   HalfFormat format = HalfFormat::FP16, size_t chunkStates = DefaultChunkStates);
+
+		HalfFormat format() const;
+	};
+}
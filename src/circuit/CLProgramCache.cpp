@@ -0,0 +1,216 @@
+#include <fstream>
+#include <format>
+#include <cstdlib>
+#include <random>
+#include <iostream>
+#include "CLProgramCache.h"
+#include "../utils.h"
+
+namespace KQS::Circuit {
+
+	std::mutex CLProgramCache::fMutex;
+	std::map<CLProgramCache::Key, CLProgramCache::Entry> CLProgramCache::fPrograms;
+
+	std::filesystem::path CLProgramCache::fDirectory = [] {
+		if (const char *directory = std::getenv("KQS_CL_CACHE_DIR"))
+			return std::filesystem::path(directory);
+
+		std::error_code ec;
+		std::filesystem::path tmp = std::filesystem::temp_directory_path(ec);
+		return ec ? std::filesystem::path() : tmp / "KExQS-cl-cache";
+	}();
+
+	std::shared_ptr<const cl::Program> CLProgramCache::get(const cl::Context &context, const cl::Device &device,
+														   const std::string &source, const std::string &options) {
+		uint64_t sourceHash = hash(source);
+		Key key{context(), device(), sourceHash, options};
+
+		std::promise<std::shared_ptr<const cl::Program>> promise;
+		std::filesystem::path directory;
+		{
+			std::unique_lock lock(fMutex);
+
+			// entries of released programs are dropped, their contexts may be gone; a live program holds a
+			// reference to its context, so the handle in the key of a live entry cannot be reused
+			std::erase_if(fPrograms, [](const auto &entry) {
+				return entry.second.program.expired() && !entry.second.pending.valid();
+			});
+			if (auto it = fPrograms.find(key); it != fPrograms.end()) {
+				if (auto program = it->second.program.lock())
+					return program;
+
+				// another thread is building the program
+				std::shared_future<std::shared_ptr<const cl::Program>> pending = it->second.pending;
+				lock.unlock();
+				return pending.get();
+			}
+
+			fPrograms[key].pending = promise.get_future().share();
+			directory = fDirectory;
+		}
+
+		std::shared_ptr<const cl::Program> shared;
+		try {
+			cl::Program program;
+			std::string binaryKey;
+			if (!directory.empty()) {
+				binaryKey = diskKey(device, sourceHash, options);
+				program = loadBinary(directory, context, device, binaryKey, options);
+			}
+
+			if (program() == nullptr) {
+				program = buildSource(context, device, source, options);
+				if (!directory.empty())
+					storeBinary(directory, program, device, binaryKey);
+			}
+
+			shared = std::make_shared<const cl::Program>(std::move(program));
+		} catch (...) {
+			// the waiting threads fail too, later users try again
+			{
+				std::lock_guard lock(fMutex);
+				fPrograms.erase(key);
+			}
+			promise.set_exception(std::current_exception());
+			throw;
+		}
+
+		{
+			std::lock_guard lock(fMutex);
+			fPrograms[key] = {shared, {}};
+		}
+		promise.set_value(shared);
+		return shared;
+	}
+
+	void CLProgramCache::setDirectory(const std::filesystem::path &directory) {
+		std::lock_guard lock(fMutex);
+		fDirectory = directory;
+	}
+
+	std::filesystem::path CLProgramCache::directory() {
+		std::lock_guard lock(fMutex);
+		return fDirectory;
+	}
+
+	void CLProgramCache::clear() {
+		std::lock_guard lock(fMutex);
+		fPrograms.clear();
+	}
+
+	/// Private methods ///
+
+	uint64_t CLProgramCache::hash(const std::string &data) {
+		// FNV-1a, stable across runs and platforms unlike std::hash
+		uint64_t result = 14695981039346656037ULL;
+		for (unsigned char c: data) {
+			result ^= c;
+			result *= 1099511628211ULL;
+		}
+
+		return result;
+	}
+
+	std::string CLProgramCache::diskKey(const cl::Device &device, uint64_t sourceHash, const std::string &options) {
+		auto platform = device.getInfo<CL_DEVICE_PLATFORM>();
+
+		return std::format("{}\n{}\n{}\n{}\n{}\n{:016x}\n{}",
+						   platform.getInfo<CL_PLATFORM_NAME>(), device.getInfo<CL_DEVICE_VENDOR>(),
+						   device.getInfo<CL_DEVICE_NAME>(), device.getInfo<CL_DEVICE_VERSION>(),
+						   device.getInfo<CL_DRIVER_VERSION>(), sourceHash, options);
+	}
+
+	cl::Program CLProgramCache::loadBinary(const std::filesystem::path &directory, const cl::Context &context,
+										   const cl::Device &device, const std::string &key,
+										   const std::string &options) {
+		std::filesystem::path path = directory / std::format("{:016x}.bin", hash(key));
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		if (file.fail())
+			return {};
+
+		// the file starts with the full key, which guards against hash collisions
+		uint64_t keySize = 0;
+		file.read(reinterpret_cast<char *>(&keySize), sizeof(keySize));
+		if (!file || keySize != key.size())
+			return {};
+
+		std::string storedKey(keySize, '\0');
+		file.read(storedKey.data(), static_cast<std::streamsize>(keySize));
+		if (!file || storedKey != key)
+			return {};
+
+		std::vector<unsigned char> binary{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+		if (binary.empty())
+			return {};
+
+		cl_int err;
+		std::vector<cl_int> binaryStatus;
+		cl::Program program(context, std::vector<cl::Device>{device}, cl::Program::Binaries{binary}, &binaryStatus, &err);
+		if (err != CL_SUCCESS || binaryStatus.front() != CL_SUCCESS)
+			return {};
+
+		// binaries still have to be built, but this is only a link step
+		err = program.build(device, options);
+		if (err != CL_SUCCESS)
+			return {};
+
+		return program;
+	}
+
+	void CLProgramCache::storeBinary(const std::filesystem::path &directory, const cl::Program &program,
+									 const cl::Device &device, const std::string &key) {
+		cl_int err;
+		auto devices = program.getInfo<CL_PROGRAM_DEVICES>(&err);
+		CL_CHECK(err)
+		auto binaries = program.getInfo<CL_PROGRAM_BINARIES>(&err);
+		CL_CHECK(err)
+
+		for (size_t i = 0; i < devices.size(); ++i) {
+			if (devices[i]() != device() || binaries[i].empty())
+				continue;
+
+			std::error_code ec;
+			std::filesystem::create_directories(directory, ec);
+			if (ec)
+				return;
+
+			// written under a unique name and renamed, so that concurrent processes never read a partial file
+			std::filesystem::path path = directory / std::format("{:016x}.bin", hash(key));
+			std::filesystem::path tmpPath = path;
+			tmpPath += std::format(".{:08x}.tmp", std::random_device()());
+
+			{
+				std::ofstream file(tmpPath, std::ios::out | std::ios::binary);
+				uint64_t keySize = key.size();
+				file.write(reinterpret_cast<const char *>(&keySize), sizeof(keySize));
+				file.write(key.data(), static_cast<std::streamsize>(keySize));
+				file.write(reinterpret_cast<const char *>(binaries[i].data()),
+						   static_cast<std::streamsize>(binaries[i].size()));
+				if (!file)
+					ec = std::make_error_code(std::errc::io_error);
+			}
+
+			if (!ec)
+				std::filesystem::rename(tmpPath, path, ec);
+			if (ec)
+				std::filesystem::remove(tmpPath, ec);
+			return;
+		}
+	}
+
+	cl::Program CLProgramCache::buildSource(const cl::Context &context, const cl::Device &device,
+											const std::string &source, const std::string &options) {
+		cl_int err;
+		cl::Program program(context, source, false, &err);
+		CL_CHECK(err)
+
+		err = program.build(device, options);
+		if (err != CL_SUCCESS) {
+			std::string log = program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device);
+			std::cerr << log << std::endl;
+		}
+		CL_CHECK(err)
+
+		return program;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <memory>
+#include <future>
+#include <filesystem>
+#include "CL/opencl.hpp"
+
+namespace KQS::Circuit {
+
+	/**
+	 * Cache of built OpenCL programs. Programs are shared in-process between all users of the same context,
+	 * device, source and build options, and their binaries are stored on disk, so that later processes skip
+	 * the compilation. On-disk entries are keyed by the device, driver version, source hash and build options.
+	 *
+	 * The in-process cache holds the programs weakly. A program retains its context, so holding it strongly would
+	 * keep every context the cache has seen alive. A program is released with its last user, and then the context
+	 * can be released too. A later user on the same context reloads the program from the disk cache.
+	 *
+	 * Programs are loaded and built outside the lock of the cache, so building one program does not block users of
+	 * other programs. Concurrent users of a program that is being built wait for the first one to finish it.
+	 */
+	class CLProgramCache {
+	private:
+		using Key = std::tuple<cl_context, cl_device_id, uint64_t, std::string>;
+
+		/** Program of a key, or the result of its build while it is pending. */
+		struct Entry {
+			std::weak_ptr<const cl::Program> program;
+			std::shared_future<std::shared_ptr<const cl::Program>> pending;
+		};
+
+		static std::mutex fMutex;
+		static std::map<Key, Entry> fPrograms;
+		static std::filesystem::path fDirectory;
+
+	public:
+		/**
+		 * Returns a program built from the source for the device. The program is taken from the in-process cache,
+		 * loaded from a binary in the disk cache, or compiled and stored in both caches, in this order. The program
+		 * stays in the in-process cache while the caller, or another user, keeps the returned pointer.
+		 * @param context context of the program
+		 * @param device device the program is built for
+		 * @param source OpenCL C source of the program
+		 * @param options build options
+		 * @return built program
+		 */
+		static std::shared_ptr<const cl::Program> get(const cl::Context &context, const cl::Device &device,
+													  const std::string &source, const std::string &options);
+
+		/**
+		 * Sets the directory of the disk cache. An empty path disables the disk cache. By default, the directory
+		 * is taken from the KQS_CL_CACHE_DIR environment variable, or is KExQS-cl-cache in the temporary directory.
+		 * @param directory directory of the disk cache
+		 */
+		static void setDirectory(const std::filesystem::path &directory);
+
+		static std::filesystem::path directory();
+
+		/** Forgets all programs in the in-process cache, their users keep them. The disk cache is kept. */
+		static void clear();
+
+	private:
+		static uint64_t hash(const std::string &data);
+		static std::string diskKey(const cl::Device &device, uint64_t sourceHash, const std::string &options);
+
+		static cl::Program loadBinary(const std::filesystem::path &directory, const cl::Context &context,
+									  const cl::Device &device, const std::string &key, const std::string &options);
+		static void storeBinary(const std::filesystem::path &directory, const cl::Program &program,
+								const cl::Device &device, const std::string &key);
+		static cl::Program buildSource(const cl::Context &context, const cl::Device &device,
+									   const std::string &source, const std::string &options);
+	};
+}
@@ -1,109 +1,608 @@
-#include <fstream>
+#include <format>
+#include <cstring>
+#include <algorithm>
 #include "CLQuantumRegister.h"
+#include "CLProgramCache.h"
+#include "DenseGateKernels.h"
+#include "QubitPermutation.h"
+#include "CLQuantumRegisterSource.h"
 #include "../utils.h"
 
 namespace KQS::Circuit {
 
-	std::string readFileToString(const char *path) {
-		std::ifstream f(path); // bugged on MinGW
-		if (f.fail())
-			throw std::runtime_error("Failed to open file " + std::string(path));
+	template<typename T>
+	CLQuantumRegister<T>::CLQuantumRegister(size_t numberOfQubits, const cl::Context &context, const cl::Device &device,
+										 size_t chunkStates)
+			: CLQuantumRegister(numberOfQubits, context, device, chunkStates, std::nullopt) {}
 
-		std::stringstream ss;
-		ss << f.rdbuf();
+	template<typename T>
+	CLQuantumRegister<T>::CLQuantumRegister(size_t numberOfQubits, const cl::Context &context, const cl::Device &device,
+										 size_t chunkStates, std::optional<HalfFormat> halfFormat)
+			: QuantumRegister<T>(numberOfQubits), fHalfFormat(halfFormat), fContext(context), fDevice(device),
+			  fTargetKernels(numberOfQubits), fChunkStates(std::max<size_t>(std::min(chunkStates, fNumStates), 1)) {
+		if (fHalfFormat && !std::is_same_v<T, float>)
+			throw std::runtime_error("16-bit storage requires single precision");
 
-		return ss.str();
-	}
-
-	CLQuantumRegister::CLQuantumRegister(size_t numberOfQubits, const cl::Context &context, const cl::Device &device)
-			: QuantumRegister(numberOfQubits), fContext(context) {
 		cl_int err;
 
 		fQueue = cl::CommandQueue(context, device, cl::QueueProperties::None, &err);
 		CL_CHECK(err)
 
-		std::vector<complex_t> init(fNumStates);
-		init[0] = 1;
-		fStateVector = cl::Buffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-								  fNumStates * sizeof(complex_t), init.data(), &err);
+		// the device fills the zeros, only the amplitude of the first state is written from the host
+		fStateVector = cl::Buffer(context, CL_MEM_READ_WRITE, fNumStates * bytesPerState(), nullptr, &err);
 		CL_CHECK(err)
+		if (fHalfFormat) {
+			// one in IEEE half precision and in bfloat16
+			std::array<cl_half, 2> one = {static_cast<cl_half>(*fHalfFormat == HalfFormat::FP16 ? 0x3C00 : 0x3F80), 0};
+			err = fQueue.enqueueFillBuffer(fStateVector, cl_half(0), 0, fNumStates * bytesPerState());
+			CL_CHECK(err)
+			err = fQueue.enqueueWriteBuffer(fStateVector, CL_TRUE, 0, sizeof(one), one.data());
+			CL_CHECK(err)
 
-		std::string source = readFileToString("cl/CLQuantumRegister.cl");
-		fKernels = cl::Program(context, source, false, &err);
-		CL_CHECK(err)
+			for (cl::Buffer &chunk: fTransferChunks) {
+				chunk = cl::Buffer(context, CL_MEM_READ_WRITE, fChunkStates * sizeof(complex_t), nullptr, &err);
+				CL_CHECK(err)
+			}
+		} else {
+			complex_t one = 1;
+			err = fQueue.enqueueFillBuffer(fStateVector, complex_t(0), 0, fNumStates * bytesPerState());
+			CL_CHECK(err)
+			err = fQueue.enqueueWriteBuffer(fStateVector, CL_TRUE, 0, sizeof(one), &one);
+			CL_CHECK(err)
+		}
+
+		for (cl::Buffer &gateBuffer: fGateBuffers) {
+			gateBuffer = cl::Buffer(context, CL_MEM_READ_ONLY, 16 * sizeof(complex_t), nullptr, &err);
+			CL_CHECK(err)
+		}
+
+		// the program is shared by all registers on the same context and device, and its binary is cached on disk
+		fKernels = CLProgramCache::get(context, device, Embedded::CLQuantumRegisterSource, buildOptions());
 
-		if constexpr (std::is_same_v<real_t, float>)
-			err = fKernels.build("-cl-std=CL3.0 -D REAL_PRECISION=1");
-		if constexpr (std::is_same_v<real_t, double>)
-			err = fKernels.build("-cl-std=CL3.0 -D REAL_PRECISION=2");
-		if constexpr (std::is_same_v<real_t, long double>)
-			err = fKernels.build("-cl-std=CL3.0 -D REAL_PRECISION=3");
+		// staging buffers stay mapped for the lifetime of the register, so their host pointers can be used
+		// directly as the source and destination of asynchronous transfers
+		for (size_t b = 0; b < fStaging.size(); ++b) {
+			fStaging[b] = cl::Buffer(context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+									 fChunkStates * sizeof(complex_t), nullptr, &err);
+			CL_CHECK(err)
 
-		if (err != CL_SUCCESS) {
-			std::string log = fKernels.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device);
-			std::cerr << log << std::endl;
+			void *data = fQueue.enqueueMapBuffer(fStaging[b], CL_TRUE, CL_MAP_READ | CL_MAP_WRITE,
+												 0, fChunkStates * sizeof(complex_t), nullptr, nullptr, &err);
+			CL_CHECK(err)
+			fStagingData[b] = static_cast<complex_t *>(data);
 		}
-		CL_CHECK(err)
 	}
 
-	void CLQuantumRegister::setStateVector(const std::vector<complex_t> &stateVector) {
-		cl_int err = fQueue.enqueueWriteBuffer(fStateVector, CL_TRUE, 0, fNumStates * sizeof(complex_t), stateVector.data());
+	template<typename T>
+	CLQuantumRegister<T>::~CLQuantumRegister() {
+		for (size_t b = 0; b < fStaging.size(); ++b)
+			if (fStagingData[b] != nullptr)
+				fQueue.enqueueUnmapMemObject(fStaging[b], fStagingData[b]);
+		fQueue.finish();
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::setPhysicalStateVector(const std::vector<complex_t> &stateVector) {
+		if (stateVector.size() != fNumStates)
+			throw std::runtime_error(std::format("State vector of size {} cannot be set to {}-qubit register",
+												 stateVector.size(), fNumQubits));
+
+		std::array<cl::Event, 2> written;
+		for (size_t offset = 0, chunk = 0; offset < fNumStates; offset += fChunkStates, ++chunk) {
+			size_t b = chunk % 2;
+			size_t count = std::min(fChunkStates, fNumStates - offset);
+
+			// the staging buffer can be refilled only after its previous transfer has finished,
+			// the other buffer is meanwhile being copied to the device
+			if (chunk >= 2) {
+				cl_int err = written[b].wait();
+				CL_CHECK(err)
+			}
+			std::memcpy(fStagingData[b], stateVector.data() + offset, count * sizeof(complex_t));
+
+			// 16-bit states are written through the transfer chunk and rounded on the device
+			const cl::Buffer &destination = fHalfFormat ? fTransferChunks[b] : fStateVector;
+			cl_int err = fQueue.enqueueWriteBuffer(destination, CL_FALSE, fHalfFormat ? 0 : offset * sizeof(complex_t),
+												   count * sizeof(complex_t), fStagingData[b], nullptr, &written[b]);
+			CL_CHECK(err)
+			if (fHalfFormat)
+				enqueueConversion("narrowStates", b, offset, count);
+			err = fQueue.flush();
+			CL_CHECK(err)
+		}
+
+		cl_int err = fQueue.finish();
 		CL_CHECK(err)
 	}
 
-	std::vector<complex_t> CLQuantumRegister::stateVector() const {
+	template<typename T>
+	std::vector<std::complex<T>> CLQuantumRegister<T>::physicalStateVector() const {
 		std::vector<complex_t> result(fNumStates);
-		cl_int err = fQueue.enqueueReadBuffer(fStateVector, CL_TRUE, 0, fNumStates * sizeof(complex_t), result.data());
+		readPhysicalStateVector([&result](size_t offset, std::span<const complex_t> chunk) {
+			std::memcpy(result.data() + offset, chunk.data(), chunk.size_bytes());
+		});
+		return result;
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::readPhysicalStateVector(const StateChunkCallback &callback) const {
+		std::array<cl::Event, 2> read;
+		auto enqueueRead = [this, &read](size_t offset, size_t chunk) {
+			size_t count = std::min(fChunkStates, fNumStates - offset);
+
+			// 16-bit states are widened on the device into the transfer chunk, which is then read
+			if (fHalfFormat)
+				enqueueConversion("widenStates", chunk % 2, offset, count);
+			const cl::Buffer &source = fHalfFormat ? fTransferChunks[chunk % 2] : fStateVector;
+			cl_int err = fQueue.enqueueReadBuffer(source, CL_FALSE, fHalfFormat ? 0 : offset * sizeof(complex_t),
+												  count * sizeof(complex_t), fStagingData[chunk % 2], nullptr,
+												  &read[chunk % 2]);
+			CL_CHECK(err)
+			err = fQueue.flush();
+			CL_CHECK(err)
+		};
+
+		enqueueRead(0, 0);
+		for (size_t offset = 0, chunk = 0; offset < fNumStates; offset += fChunkStates, ++chunk) {
+			// start copying the next chunk before the current one is handed over to the callback
+			if (offset + fChunkStates < fNumStates)
+				enqueueRead(offset + fChunkStates, chunk + 1);
+
+			cl_int err = read[chunk % 2].wait();
+			CL_CHECK(err)
+
+			size_t count = std::min(fChunkStates, fNumStates - offset);
+			callback(offset, std::span<const complex_t>(fStagingData[chunk % 2], count));
+		}
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::setTargetSpecialization(bool specialize) {
+		fSpecializeTargets = specialize;
+	}
+
+	template<typename T>
+	T CLQuantumRegister<T>::norm() const {
+		size_t numBlocks = fNumStates >> probabilityBlockQubits();
+		cl::Buffer cdf = cumulativeProbabilities();
+
+		// the last element of the cumulative distribution is the total probability
+		real_t result;
+		cl_int err = fQueue.enqueueReadBuffer(cdf, CL_TRUE, (numBlocks - 1) * sizeof(real_t), sizeof(real_t), &result);
 		CL_CHECK(err)
+
 		return result;
 	}
 
-	void CLQuantumRegister::applyOneQubitGate(const QuantumLogicGate &gate, size_t targetQubit) {
-		size_t groups = fNumStates / 2;
+	template<typename T>
+	std::vector<T> CLQuantumRegister<T>::physicalMarginals() const {
+		cl_int err;
+		size_t blockQubits = probabilityBlockQubits();
+		size_t numBlocks = fNumStates >> blockQubits;
+		size_t localSize = probabilityLocalSize();
+
+		cl::Buffer blockSums = blockProbabilities();
+		cl::Buffer dBlockMarginals(fContext, CL_MEM_READ_WRITE, numBlocks * blockQubits * sizeof(real_t), nullptr, &err);
+		CL_CHECK(err)
+		cl::Buffer dMarginals(fContext, CL_MEM_READ_WRITE, fNumQubits * sizeof(real_t), nullptr, &err);
+		CL_CHECK(err)
+
+		cl::Kernel blockKernel(*fKernels, "blockMarginals");
+		blockKernel.setArg(0, fStateVector);
+		blockKernel.setArg(1, dBlockMarginals);
+		blockKernel.setArg(2, blockQubits);
+		blockKernel.setArg(3, cl::Local(localSize * sizeof(real_t)));
+
+		err = fQueue.enqueueNDRangeKernel(blockKernel, cl::NullRange, cl::NDRange(numBlocks * localSize),
+										  cl::NDRange(localSize));
+		CL_CHECK(err)
+
+		cl::Kernel reduceKernel(*fKernels, "reduceMarginals");
+		reduceKernel.setArg(0, dBlockMarginals);
+		reduceKernel.setArg(1, blockSums);
+		reduceKernel.setArg(2, numBlocks);
+		reduceKernel.setArg(3, blockQubits);
+		reduceKernel.setArg(4, dMarginals);
+		reduceKernel.setArg(5, cl::Local(localSize * sizeof(real_t)));
+
+		err = fQueue.enqueueNDRangeKernel(reduceKernel, cl::NullRange, cl::NDRange(fNumQubits * localSize),
+										  cl::NDRange(localSize));
+		CL_CHECK(err)
+
+		std::vector<real_t> result(fNumQubits);
+		err = fQueue.enqueueReadBuffer(dMarginals, CL_TRUE, 0, fNumQubits * sizeof(real_t), result.data());
+		CL_CHECK(err)
+
+		return result;
+	}
+
+	template<typename T>
+	std::vector<size_t> CLQuantumRegister<T>::samplePhysical(std::span<const real_t> randomNumbers) const {
+		if (randomNumbers.empty())
+			return {};
+
+		cl_int err;
+		size_t blockQubits = probabilityBlockQubits();
+		size_t numBlocks = fNumStates >> blockQubits;
+		size_t numShots = randomNumbers.size();
+
+		cl::Buffer cdf = cumulativeProbabilities();
+		cl::Buffer dRandomNumbers(fContext, CL_MEM_READ_ONLY, numShots * sizeof(real_t), nullptr, &err);
+		CL_CHECK(err)
+		err = fQueue.enqueueWriteBuffer(dRandomNumbers, CL_FALSE, 0, numShots * sizeof(real_t), randomNumbers.data());
+		CL_CHECK(err)
+		cl::Buffer dSamples(fContext, CL_MEM_WRITE_ONLY, numShots * sizeof(cl_ulong), nullptr, &err);
+		CL_CHECK(err)
 
-		cl::Kernel kernel(fKernels, "applyOneQubitGate");
+		cl::Kernel kernel(*fKernels, "sampleStates");
 		kernel.setArg(0, fStateVector);
-		kernel.setArg(1, targetQubit);
-		kernel.setArg(2, gate.matrix()[0, 0]);
-		kernel.setArg(3, gate.matrix()[0, 1]);
-		kernel.setArg(4, gate.matrix()[1, 0]);
-		kernel.setArg(5, gate.matrix()[1, 1]);
+		kernel.setArg(1, cdf);
+		kernel.setArg(2, numBlocks);
+		kernel.setArg(3, blockQubits);
+		kernel.setArg(4, dRandomNumbers);
+		kernel.setArg(5, dSamples);
 
-		cl_int err = fQueue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(groups));
+		err = fQueue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(numShots));
 		CL_CHECK(err)
 
-		err = fQueue.finish();
+		std::vector<cl_ulong> samples(numShots);
+		err = fQueue.enqueueReadBuffer(dSamples, CL_TRUE, 0, numShots * sizeof(cl_ulong), samples.data());
 		CL_CHECK(err)
+
+		return {samples.begin(), samples.end()};
 	}
 
-	void CLQuantumRegister::applyTwoQubitGate(const QuantumLogicGate &gate, std::array<size_t, 2> targetQubits) {
+	template<typename T>
+	void CLQuantumRegister<T>::applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) {
+		size_t groups = fNumStates / 2;
+
+		cl::Kernel kernel(targetProgram(targetQubit), "applyOneQubitGate");
+		kernel.setArg(0, fStateVector);
+		kernel.setArg(1, targetQubit);
+		kernel.setArg(2, matrix[0, 0]);
+		kernel.setArg(3, matrix[0, 1]);
+		kernel.setArg(4, matrix[1, 0]);
+		kernel.setArg(5, matrix[1, 1]);
+
+		runKernel(kernel, cl::NDRange(groups));
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) {
 		cl_int err;
 		size_t groups = fNumStates / 4;
 
 		if (targetQubits[0] > targetQubits[1])
 			targetQubits[0]--;
 
-		cl::Buffer dGate(fContext, CL_MEM_READ_WRITE,
-			gate.matrix().rows() * gate.matrix().columns() * sizeof(complex_t), nullptr, &err);
-		CL_CHECK(err)
-		err = fQueue.enqueueWriteBuffer(dGate, CL_TRUE, 0,
-			gate.matrix().rows() * gate.matrix().columns() * sizeof(complex_t), gate.matrix().data().data());
+		// the queue is in order, so the write to a slot waits for the kernel that used it before, and only the host
+		// copy has to wait for the previous write from it
+		size_t slot = fNextGateSlot;
+		fNextGateSlot = (fNextGateSlot + 1) % GateSlots;
+		if (fGateWritten[slot]()) {
+			err = fGateWritten[slot].wait();
+			CL_CHECK(err)
+		}
+		fGateMatrices[slot] = matrix;
+		err = fQueue.enqueueWriteBuffer(fGateBuffers[slot], CL_FALSE, 0, sizeof(matrix.data()),
+										fGateMatrices[slot].data().data(), nullptr, &fGateWritten[slot]);
 		CL_CHECK(err)
 
-		cl::Kernel kernel(fKernels, "applyTwoQubitGate");
+		cl::Kernel kernel(*fKernels, "applyTwoQubitGate");
 		kernel.setArg(0, fStateVector);
 		kernel.setArg(1, targetQubits[0]);
 		kernel.setArg(2, targetQubits[1]);
-		kernel.setArg(3, dGate);
+		kernel.setArg(3, fGateBuffers[slot]);
+
+		runKernel(kernel, cl::NDRange(groups));
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::applyKQubitGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
+		applyDenseMatrix(gate.matrix(), targetQubits, {});
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::applyDiagonalGate(const QuantumLogicGate<T> &gate,
+												 const std::vector<size_t> &targetQubits) {
+		std::vector<size_t> offsets = Kernels::groupOffsets(targetQubits);
+
+		// only the states with factors other than one are passed to the kernel
+		std::vector<cl_ulong> changedOffsets;
+		std::vector<complex_t> factors;
+		for (size_t j = 0; j < offsets.size(); ++j) {
+			if (gate.factors()[j] != complex_t(1)) {
+				changedOffsets.push_back(offsets[j]);
+				factors.push_back(gate.factors()[j]);
+			}
+		}
+		if (factors.empty())
+			return;
+
+		runGroupKernel("applyDiagonalGate", targetQubits, changedOffsets, readOnlyBuffer(factors),
+					   static_cast<cl_uint>(factors.size()));
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::applyMonomialGate(const QuantumLogicGate<T> &gate,
+												 const std::vector<size_t> &targetQubits) {
+		if (targetQubits.size() > MaxGateQubits)
+			throw std::runtime_error(std::format("Monomial gates on more than {} qubits are not supported", MaxGateQubits));
+
+		std::vector<size_t> offsets = Kernels::groupOffsets(targetQubits);
+
+		// states that stay in place with factor one are neither read nor written
+		std::vector<cl_ulong> changedOffsets;
+		std::vector<cl_ulong> sourceOffsets;
+		std::vector<complex_t> factors;
+		for (size_t j = 0; j < offsets.size(); ++j) {
+			size_t source = gate.sources()[j];
+			if (source != j || gate.factors()[j] != complex_t(1)) {
+				changedOffsets.push_back(offsets[j]);
+				sourceOffsets.push_back(offsets[source]);
+				factors.push_back(gate.factors()[j]);
+			}
+		}
+		if (factors.empty())
+			return;
+
+		runGroupKernel("applyMonomialGate", targetQubits, changedOffsets, readOnlyBuffer(sourceOffsets),
+					   readOnlyBuffer(factors), static_cast<cl_uint>(factors.size()));
+	}
 
-		err = fQueue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(groups));
+	template<typename T>
+	void CLQuantumRegister<T>::applyControlledGate(const QuantumLogicGate<T> &gate,
+												   const std::vector<size_t> &targetQubits) {
+		auto [targets, controls] = this->splitControls(gate, targetQubits);
+		applyDenseMatrix(gate.targetMatrix(), targets, controls);
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor) {
+		bool twoQubit = isTwoQubitGate(gate);
+		for (size_t i = 0; i < (twoQubit ? 2 : 1); ++i)
+			if (qubits[i] >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Cannot apply gate to qubit {} in {}-qubit register", qubits[i], fNumQubits));
+		if (twoQubit && qubits[0] == qubits[1])
+			throw std::runtime_error(std::format("Cannot apply two-qubit gate twice to qubit {}", qubits[0]));
+
+		const char *name = nullptr;
+		switch (gate) {
+			case StandardGate::PauliX: name = "applyPauliX"; break;
+			case StandardGate::PauliY: name = "applyPauliY"; break;
+			case StandardGate::Hadamard: name = "applyHadamard"; break;
+			case StandardGate::Phase: name = "applyPhase"; break;
+			case StandardGate::ControlledX: name = "applyControlledX"; break;
+			case StandardGate::ControlledPhase: name = "applyControlledPhase"; break;
+			case StandardGate::Swap: name = "applySwap"; break;
+		}
+
+		// one-qubit kernels use the programs specialized for the target qubit
+		cl::Kernel kernel(twoQubit ? *fKernels : targetProgram(qubits[0]), name);
+		cl_uint arg = 0;
+		kernel.setArg(arg++, fStateVector);
+		kernel.setArg(arg++, qubits[0]);
+		if (twoQubit)
+			kernel.setArg(arg++, qubits[1]);
+		if (gate == StandardGate::Phase || gate == StandardGate::ControlledPhase)
+			kernel.setArg(arg++, factor);
+
+		// every work-item handles one pair, or one quadruple of states for two-qubit gates
+		runKernel(kernel, cl::NDRange(fNumStates >> (twoQubit ? 2 : 1)));
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::permutePhysicalQubits(const std::vector<size_t> &permutation) {
+		cl_int err;
+
+		// the kernel gathers, so it maps the destination indices to the source ones
+		QubitPermutation toSource(QubitPermutation::inverse(permutation));
+		std::vector<cl_ulong> tables;
+		for (const auto &table: toSource.tables())
+			tables.insert(tables.end(), table.begin(), table.end());
+
+		cl::Buffer permuted(fContext, CL_MEM_READ_WRITE, fNumStates * bytesPerState(), nullptr, &err);
+		CL_CHECK(err)
+
+		cl::Kernel kernel(*fKernels, "permuteQubits");
+		kernel.setArg(0, fStateVector);
+		kernel.setArg(1, permuted);
+		kernel.setArg(2, readOnlyBuffer(tables));
+		kernel.setArg(3, static_cast<cl_uint>(toSource.tables().size()));
+
+		runKernel(kernel, cl::NDRange(fNumStates));
+
+		fStateVector = permuted;
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::profilingChanged(bool enabled) {
+		cl_int err = fQueue.finish();
 		CL_CHECK(err)
 
-		err = fQueue.finish();
+		// the staging buffers stay mapped, mappings belong to the buffers and not to the queue
+		fQueue = cl::CommandQueue(fContext, fDevice, enabled ? cl::QueueProperties::Profiling : cl::QueueProperties::None,
+								  &err);
 		CL_CHECK(err)
+		fProfiling = enabled;
 	}
 
-	void CLQuantumRegister::applyKQubitGate(const QuantumLogicGate &gate, const std::vector<size_t> &targetQubits) {
+	template<typename T>
+	void CLQuantumRegister<T>::finish() const {
+		cl_int err = fQueue.finish();
+		CL_CHECK(err)
+	}
 
+	template<typename T>
+	size_t CLQuantumRegister<T>::bytesPerState() const {
+		return fHalfFormat ? 2 * sizeof(cl_half) : sizeof(complex_t);
 	}
+
+	/// Private methods ///
+
+	template<typename T>
+	void CLQuantumRegister<T>::runKernel(const cl::Kernel &kernel, const cl::NDRange &globalSize) {
+		cl::Event event;
+		cl_int err = fQueue.enqueueNDRangeKernel(kernel, cl::NullRange, globalSize, cl::NullRange, nullptr,
+												 fProfiling ? &event : nullptr);
+		CL_CHECK(err)
+
+		if (fProfiling) {
+			err = event.wait();
+			CL_CHECK(err)
+			cl_ulong start = event.getProfilingInfo<CL_PROFILING_COMMAND_START>(&err);
+			CL_CHECK(err)
+			cl_ulong end = event.getProfilingInfo<CL_PROFILING_COMMAND_END>(&err);
+			CL_CHECK(err)
+			this->fDeviceTime += std::chrono::nanoseconds(end - start);
+		}
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::enqueueConversion(const char *name, size_t chunk, size_t offset, size_t count) const {
+		cl::Kernel kernel(*fKernels, name);
+		kernel.setArg(0, fStateVector);
+		kernel.setArg(1, fTransferChunks[chunk]);
+		kernel.setArg(2, offset);
+
+		cl_int err = fQueue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(count));
+		CL_CHECK(err)
+	}
+
+	template<typename T>
+	std::string CLQuantumRegister<T>::buildOptions() const {
+		std::string options = "-cl-std=CL3.0";
+
+		if constexpr (std::is_same_v<T, float>)
+			options += " -D REAL_PRECISION=1";
+		if constexpr (std::is_same_v<T, double>)
+			options += " -D REAL_PRECISION=2";
+
+		// all states of registers up to 32 qubits are addressable with 32-bit indices
+		options += fNumQubits <= 32 ? " -D INDEX_BITS=32" : " -D INDEX_BITS=64";
+		options += std::format(" -D MAX_GATE_QUBITS={}", MaxGateQubits);
+		if (fHalfFormat)
+			options += *fHalfFormat == HalfFormat::FP16 ? " -D HALF_STORAGE=1" : " -D HALF_STORAGE=2";
+
+		return options;
+	}
+
+	template<typename T>
+	const cl::Program &CLQuantumRegister<T>::targetProgram(size_t targetQubit) {
+		if (!fSpecializeTargets)
+			return *fKernels;
+
+		auto &program = fTargetKernels[targetQubit];
+		if (program == nullptr)
+			program = CLProgramCache::get(fContext, fDevice, Embedded::CLQuantumRegisterSource,
+										  buildOptions() + std::format(" -D TARGET_QUBIT={}", targetQubit));
+
+		return *program;
+	}
+
+	template<typename T>
+	template<typename U>
+	cl::Buffer CLQuantumRegister<T>::readOnlyBuffer(const std::vector<U> &data) const {
+		cl_int err;
+		cl::Buffer buffer(fContext, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, data.size() * sizeof(U),
+						  const_cast<U *>(data.data()), &err);
+		CL_CHECK(err)
+		return buffer;
+	}
+
+	template<typename T>
+	template<typename... Args>
+	void CLQuantumRegister<T>::runGroupKernel(const char *name, const std::vector<size_t> &qubits,
+											  const std::vector<cl_ulong> &offsets, const Args &... arguments) {
+		std::vector<size_t> sorted = Kernels::sortedQubits(qubits);
+		std::vector<cl_ulong> positions(sorted.begin(), sorted.end());
+
+		cl::Kernel kernel(*fKernels, name);
+		cl_uint arg = 0;
+		kernel.setArg(arg++, fStateVector);
+		kernel.setArg(arg++, readOnlyBuffer(positions));
+		kernel.setArg(arg++, static_cast<cl_uint>(positions.size()));
+		kernel.setArg(arg++, readOnlyBuffer(offsets));
+		(kernel.setArg(arg++, arguments), ...);
+
+		runKernel(kernel, cl::NDRange(fNumStates >> qubits.size()));
+	}
+
+	template<typename T>
+	void CLQuantumRegister<T>::applyDenseMatrix(const ComplexMatrix<T> &matrix, const std::vector<size_t> &targetQubits,
+												const std::vector<size_t> &controlQubits) {
+		if (targetQubits.size() > MaxGateQubits)
+			throw std::runtime_error(std::format("Dense gates on more than {} qubits are not supported", MaxGateQubits));
+
+		std::vector<size_t> qubits = targetQubits;
+		qubits.insert(qubits.end(), controlQubits.begin(), controlQubits.end());
+
+		std::vector<size_t> groupOffsets = Kernels::groupOffsets(targetQubits);
+		std::vector<cl_ulong> offsets(groupOffsets.begin(), groupOffsets.end());
+		for (size_t qubit: controlQubits)
+			for (cl_ulong &offset: offsets)
+				offset |= 1ULL << qubit;
+
+		runGroupKernel("applyDenseGate", qubits, offsets, readOnlyBuffer(matrix.data()),
+					   static_cast<cl_uint>(matrix.rows()));
+	}
+
+	template<typename T>
+	size_t CLQuantumRegister<T>::probabilityBlockQubits() const {
+		return std::min<size_t>(fNumQubits, 11);
+	}
+
+	template<typename T>
+	size_t CLQuantumRegister<T>::probabilityLocalSize() const {
+		return std::min<size_t>(1ULL << probabilityBlockQubits(), 256);
+	}
+
+	template<typename T>
+	cl::Buffer CLQuantumRegister<T>::blockProbabilities() const {
+		cl_int err;
+		size_t blockQubits = probabilityBlockQubits();
+		size_t numBlocks = fNumStates >> blockQubits;
+		size_t localSize = probabilityLocalSize();
+
+		cl::Buffer blockSums(fContext, CL_MEM_READ_WRITE, numBlocks * sizeof(real_t), nullptr, &err);
+		CL_CHECK(err)
+
+		cl::Kernel kernel(*fKernels, "blockProbabilities");
+		kernel.setArg(0, fStateVector);
+		kernel.setArg(1, blockSums);
+		kernel.setArg(2, blockQubits);
+		kernel.setArg(3, cl::Local(localSize * sizeof(real_t)));
+
+		err = fQueue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(numBlocks * localSize),
+										  cl::NDRange(localSize));
+		CL_CHECK(err)
+
+		return blockSums;
+	}
+
+	template<typename T>
+	cl::Buffer CLQuantumRegister<T>::cumulativeProbabilities() const {
+		cl_int err;
+		size_t numBlocks = fNumStates >> probabilityBlockQubits();
+		size_t localSize = 256;
+
+		cl::Buffer blockSums = blockProbabilities();
+		cl::Buffer cdf(fContext, CL_MEM_READ_WRITE, numBlocks * sizeof(real_t), nullptr, &err);
+		CL_CHECK(err)
+
+		cl::Kernel kernel(*fKernels, "scanBlocks");
+		kernel.setArg(0, blockSums);
+		kernel.setArg(1, cdf);
+		kernel.setArg(2, numBlocks);
+		kernel.setArg(3, cl::Local(localSize * sizeof(real_t)));
+
+		err = fQueue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(localSize), cl::NDRange(localSize));
+		CL_CHECK(err)
+
+		return cdf;
+	}
+
+	template class CLQuantumRegister<float>;
+	template class CLQuantumRegister<double>;
 }
@@ -2,29 +2,198 @@
 
 #include <vector>
 #include <array>
+#include <optional>
 #include "CL/opencl.hpp"
 #include "../types.h"
 #include "QuantumLogicGate.h"
 #include "QuantumRegister.h"
+#include "HalfPrecisionQuantumRegister.h"
 
 namespace KQS::Circuit {
-	class CLQuantumRegister : public QuantumRegister {
+	/**
+	 * Quantum register keeping the state vector on an OpenCL device.
+	 * @tparam T type of the real and imaginary parts of the amplitudes, float or double (requires cl_khr_fp64)
+	 */
+	template<typename T>
+	class CLQuantumRegister : public QuantumRegister<T> {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+		using typename QuantumRegister<T>::StateChunkCallback;
+
 	protected:
+		using QuantumRegister<T>::fNumQubits;
+		using QuantumRegister<T>::fNumStates;
+
 		cl::Buffer fStateVector;
+		/** Format of the amplitudes stored as pairs of 16-bit floats, empty if they are stored as complex_t. */
+		std::optional<HalfFormat> fHalfFormat;
 
 		cl::Context fContext;
+		cl::Device fDevice;
 		cl::CommandQueue fQueue;
-		cl::Program fKernels;
+		std::shared_ptr<const cl::Program> fKernels;
+
+		/** Whether one-qubit gates use programs specialized for the target qubit. */
+		bool fSpecializeTargets = true;
+		/** Programs specialized for each target qubit, built on first use. */
+		std::vector<std::shared_ptr<const cl::Program>> fTargetKernels;
+
+		/** Whether the queue has profiling enabled and the device time of gate kernels is reported. */
+		bool fProfiling = false;
+
+		/** Number of states transferred between host and device in one chunk. */
+		size_t fChunkStates;
+		/** Pinned (CL_MEM_ALLOC_HOST_PTR) buffers used for double-buffered transfers. */
+		std::array<cl::Buffer, 2> fStaging;
+		/** Host pointers of the persistently mapped staging buffers. */
+		std::array<complex_t *, 2> fStagingData{};
+		/** Device buffers of complex_t the chunks are widened into or rounded from, with 16-bit storage only. */
+		std::array<cl::Buffer, 2> fTransferChunks;
+
+		/** Number of slots for the matrices of two-qubit gates, used in turn. */
+		static constexpr size_t GateSlots = 8;
+		/** Device buffers of the matrices of two-qubit gates, allocated once. */
+		std::array<cl::Buffer, GateSlots> fGateBuffers;
+		/** Host copies of the matrices, which must stay valid until their non-blocking writes complete. */
+		std::array<SmallMatrix<T, 4>, GateSlots> fGateMatrices;
+		/** Completion of the last write of each slot. */
+		std::array<cl::Event, GateSlots> fGateWritten;
+		size_t fNextGateSlot = 0;
 
 	public:
-		CLQuantumRegister(size_t numberOfQubits, const cl::Context &context, const cl::Device &device);
+		/** Default number of states in one host-device transfer chunk (16 MB with floats). */
+		static constexpr size_t DefaultChunkStates = 1 << 21;
+
+		/**
+		 * Maximal number of target qubits of dense and monomial gates (for controlled gates without the controls),
+		 * the kernels keep all states of a group in private memory. Diagonal gates have no limit.
+		 */
+		static constexpr size_t MaxGateQubits = 6;
 
-		void setStateVector(const std::vector<complex_t> &stateVector) override;
-		std::vector<complex_t> stateVector() const override;
+		CLQuantumRegister(size_t numberOfQubits, const cl::Context &context, const cl::Device &device,
+						  size_t chunkStates = DefaultChunkStates);
+		~CLQuantumRegister() override;
+
+		CLQuantumRegister(const CLQuantumRegister &) = delete;
+		CLQuantumRegister &operator=(const CLQuantumRegister &) = delete;
+
+		/**
+		 * Enables or disables programs specialized for the target qubit of one-qubit gates. Specialized programs
+		 * have the target qubit as a compile-time constant, they are built on the first use of each qubit.
+		 * @param specialize whether to use the specialized programs
+		 */
+		void setTargetSpecialization(bool specialize);
+
+		real_t norm() const override;
+
+		/**
+		 * Waits until all enqueued gates have been applied. Gate kernels are not waited for, reading the state,
+		 * the marginals or samples waits for them implicitly, so this is only needed to time the gates.
+		 */
+		void finish() const;
 
 	protected:
-		void applyOneQubitGate(const QuantumLogicGate &gate, size_t targetQubit) override;
-		void applyTwoQubitGate(const QuantumLogicGate &gate, std::array<size_t, 2> targetQubits) override;
-		void applyKQubitGate(const QuantumLogicGate &gate, const std::vector<size_t> &targetQubits) override;
+		/**
+		 * Creates the register, optionally storing the amplitudes as pairs of 16-bit floats. The kernels then widen
+		 * them to floats on load and round the results on store.
+		 * @param halfFormat format of the stored amplitudes, empty to store complex_t
+		 */
+		CLQuantumRegister(size_t numberOfQubits, const cl::Context &context, const cl::Device &device,
+						  size_t chunkStates, std::optional<HalfFormat> halfFormat);
+
+		void setPhysicalStateVector(const std::vector<complex_t> &stateVector) override;
+		std::vector<complex_t> physicalStateVector() const override;
+
+		/**
+		 * Streams the state vector through the pinned staging buffers. While the callback processes one chunk,
+		 * the next one is already being copied from the device.
+		 * @param callback function called for every chunk
+		 */
+		void readPhysicalStateVector(const StateChunkCallback &callback) const override;
+
+		std::vector<real_t> physicalMarginals() const override;
+
+		/**
+		 * Samples the states on the device. Only the random numbers are uploaded and the sampled states
+		 * downloaded, the state vector never leaves the device.
+		 * @param randomNumbers numbers uniformly distributed in [0, 1), one per shot
+		 * @return sampled states, one per shot
+		 */
+		std::vector<size_t> samplePhysical(std::span<const real_t> randomNumbers) const override;
+
+		void applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) override;
+		void applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) override;
+		void applyKQubitGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyDiagonalGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyMonomialGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyControlledGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor) override;
+
+		/** Permutes the state into a new buffer in one pass, the device needs memory for both copies. */
+		void permutePhysicalQubits(const std::vector<size_t> &permutation) override;
+
+		/** Recreates the queue with CL_QUEUE_PROFILING_ENABLE, so that the kernel times come from OpenCL events. */
+		void profilingChanged(bool enabled) override;
+
+		size_t bytesPerState() const override;
+
+	private:
+		/**
+		 * Enqueues the gate kernel without waiting for it. Only with profiling enabled the kernel is waited for and
+		 * its device time added to the gate.
+		 */
+		void runKernel(const cl::Kernel &kernel, const cl::NDRange &globalSize);
+
+		/** Creates a read-only device buffer initialized with the data. */
+		template<typename U>
+		cl::Buffer readOnlyBuffer(const std::vector<U> &data) const;
+
+		/**
+		 * Runs one of the group kernels, which take the sorted positions of the qubits of the gate, the offsets of
+		 * the states of a group the kernel works on and further arguments, with one work-item per group.
+		 * @param name name of the kernel
+		 * @param qubits all qubits of the gate, including the controls
+		 * @param offsets offsets of the states from the first state of a group
+		 * @param arguments remaining arguments of the kernel
+		 */
+		template<typename... Args>
+		void runGroupKernel(const char *name, const std::vector<size_t> &qubits, const std::vector<cl_ulong> &offsets,
+							const Args &... arguments);
+
+		/** Applies the dense matrix to the targets on the states with all controls set. */
+		void applyDenseMatrix(const ComplexMatrix<T> &matrix, const std::vector<size_t> &targetQubits,
+							  const std::vector<size_t> &controlQubits);
+
+		/**
+		 * Enqueues the kernel converting count states of the 16-bit state vector from the offset on, to or from the
+		 * transfer chunk. The kernel is not waited for.
+		 * @param name widenStates or narrowStates
+		 * @param chunk index of the transfer chunk
+		 */
+		void enqueueConversion(const char *name, size_t chunk, size_t offset, size_t count) const;
+
+		/** Returns the options the kernels are built with. */
+		std::string buildOptions() const;
+
+		/** Returns the program for one-qubit gates on the target qubit. */
+		const cl::Program &targetProgram(size_t targetQubit);
+
+		/** Number of qubits addressing states inside one block of the probability reductions. */
+		size_t probabilityBlockQubits() const;
+		/** Work-group size of the probability reductions. */
+		size_t probabilityLocalSize() const;
+
+		/**
+		 * Computes the probability of every block of states on the device.
+		 * @return buffer with one probability per block
+		 */
+		cl::Buffer blockProbabilities() const;
+
+		/**
+		 * Computes the cumulative distribution over blocks of states on the device.
+		 * @return buffer with the inclusive prefix sum of block probabilities
+		 */
+		cl::Buffer cumulativeProbabilities() const;
 	};
 }
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <complex>
+#include "../types.h"
+#include "../parallel.h"
+#include "../algebra/Matrix.h"
+
+/**
+ * Kernel applying a dense k-qubit gate to an interleaved state vector. The 2^k amplitudes of a group differ from the
+ * first state of the group by fixed offsets computed once per gate, so the inner loops have no bit manipulation.
+ * Batches of groups are gathered into the columns of a 2^k x DenseGateBatch block and multiplied by the gate as one
+ * blocked matrix product, which reuses every matrix element for the whole batch instead of reloading the matrix
+ * per group. The batches are distributed over threads.
+ */
+namespace KQS::Circuit::Kernels {
+
+	/** Number of groups multiplied by the gate matrix at once. */
+	constexpr size_t DenseGateBatch = 32;
+
+	/** Minimal number of complex multiply-adds per thread worth the cost of starting it. */
+	constexpr size_t DenseGateWorkPerThread = 1ULL << 18;
+
+	/**
+	 * Inserts zero bits at the positions, i.e. maps the index of a group to the first state of the group.
+	 * @param x index of the group
+	 * @param sortedPositions positions of the inserted bits in ascending order
+	 */
+	inline size_t insertZeroBits(size_t x, const std::vector<size_t> &sortedPositions) {
+		for (size_t position: sortedPositions)
+			x = ((x >> position) << (position + 1)) | (x & ((1ULL << position) - 1));
+		return x;
+	}
+
+	/** Offsets of the states of a group from its first state, bit q of the index corresponds to targetQubits[q]. */
+	inline std::vector<size_t> groupOffsets(const std::vector<size_t> &targetQubits) {
+		std::vector<size_t> offsets(1ULL << targetQubits.size());
+		for (size_t j = 0; j < offsets.size(); ++j)
+			for (size_t q = 0; q < targetQubits.size(); ++q)
+				offsets[j] |= ((j >> q) & 1ULL) << targetQubits[q];
+		return offsets;
+	}
+
+	/** All qubits of the gate in ascending order, as expected by insertZeroBits. */
+	inline std::vector<size_t> sortedQubits(const std::vector<size_t> &targetQubits,
+											const std::vector<size_t> &controlQubits = {}) {
+		std::vector<size_t> sorted = targetQubits;
+		sorted.insert(sorted.end(), controlQubits.begin(), controlQubits.end());
+		std::ranges::sort(sorted);
+		return sorted;
+	}
+
+	/**
+	 * Applies the gate to the state vector. The qubits are expected to be valid and distinct.
+	 * @param state interleaved amplitudes
+	 * @param numStates number of amplitudes
+	 * @param matrix gate matrix of size 2^k x 2^k, bit q of its indices corresponds to targetQubits[q]
+	 * @param targetQubits the k target qubits
+	 * @param controlQubits qubits that must all be one for the gate to be applied, the other states are not touched
+	 */
+	template<typename T>
+	void applyDenseGate(std::complex<T> *state, size_t numStates, const Algebra::ComplexMatrix<T> &matrix,
+						const std::vector<size_t> &targetQubits, const std::vector<size_t> &controlQubits = {}) {
+		size_t groupSize = 1ULL << targetQubits.size();
+		size_t groups = numStates >> (targetQubits.size() + controlQubits.size());
+
+		std::vector<size_t> offsets = groupOffsets(targetQubits);
+		for (size_t qubit: controlQubits)
+			for (size_t &offset: offsets)
+				offset |= 1ULL << qubit;
+
+		std::vector<size_t> positions = sortedQubits(targetQubits, controlQubits);
+
+		size_t minGroupsPerThread = std::max<size_t>(DenseGateBatch, DenseGateWorkPerThread / (groupSize * groupSize));
+		parallelFor(groups, minGroupsPerThread, [&](size_t begin, size_t end) {
+			// the block holds a batch of groups in its columns
+			ComplexVector<T> block(groupSize * DenseGateBatch);
+			ComplexVector<T> result(groupSize * DenseGateBatch);
+			std::vector<size_t> bases(DenseGateBatch);
+
+			for (size_t first = begin; first < end; first += DenseGateBatch) {
+				size_t batch = std::min(DenseGateBatch, end - first);
+				for (size_t i = 0; i < batch; ++i)
+					bases[i] = insertZeroBits(first + i, positions);
+
+				for (size_t j = 0; j < groupSize; ++j)
+					for (size_t i = 0; i < batch; ++i)
+						block[j * batch + i] = state[bases[i] + offsets[j]];
+
+				matrix.multiply(std::span(block.data(), groupSize * batch), batch,
+								std::span(result.data(), groupSize * batch));
+
+				for (size_t j = 0; j < groupSize; ++j)
+					for (size_t i = 0; i < batch; ++i)
+						state[bases[i] + offsets[j]] = result[j * batch + i];
+			}
+		});
+	}
+
+	/**
+	 * Computes the reduced density matrix rho(a, b) = sum_rest psi(a, rest) conj(psi(b, rest)) of the qubits, reading
+	 * the amplitudes in place instead of copying the state vector. The groups are distributed over threads, each
+	 * accumulating its own matrix in double precision.
+	 * @param numStates number of amplitudes
+	 * @param qubits the k qubits, expected to be valid and distinct
+	 * @param amplitude callable returning the amplitude of a state
+	 * @return row-major matrix of size 2^k x 2^k, bit q of its indices corresponds to qubits[q]
+	 */
+	template<typename Amplitude>
+	std::vector<std::complex<double>> reducedDensityMatrix(size_t numStates, const std::vector<size_t> &qubits,
+														   const Amplitude &amplitude) {
+		size_t dimension = 1ULL << qubits.size();
+		std::vector<size_t> offsets = groupOffsets(qubits);
+		std::vector<size_t> positions = sortedQubits(qubits);
+
+		std::vector<std::vector<std::complex<double>>> partials(maxThreads() + 1);
+		std::atomic<size_t> nextPartial = 0;
+		size_t minGroupsPerThread = std::max<size_t>(1, DenseGateWorkPerThread / (dimension * dimension));
+		parallelFor(numStates / dimension, minGroupsPerThread, [&](size_t begin, size_t end) {
+			std::vector<std::complex<double>> rho(dimension * dimension);
+			std::vector<std::complex<double>> group(dimension);
+			for (size_t g = begin; g < end; ++g) {
+				size_t base = insertZeroBits(g, positions);
+				for (size_t j = 0; j < dimension; ++j)
+					group[j] = amplitude(base + offsets[j]);
+
+				// the matrix is hermitian, the lower triangle is filled in at the end
+				for (size_t a = 0; a < dimension; ++a)
+					for (size_t b = a; b < dimension; ++b)
+						rho[a * dimension + b] += group[a] * std::conj(group[b]);
+			}
+			partials[nextPartial++] = std::move(rho);
+		});
+
+		std::vector<std::complex<double>> result(dimension * dimension);
+		for (const auto &partial: partials)
+			for (size_t i = 0; i < partial.size(); ++i)
+				result[i] += partial[i];
+		for (size_t a = 0; a < dimension; ++a)
+			for (size_t b = 0; b < a; ++b)
+				result[a * dimension + b] = std::conj(result[b * dimension + a]);
+		return result;
+	}
+}
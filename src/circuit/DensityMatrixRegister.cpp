@@ -0,0 +1,277 @@
+#include <cmath>
+#include <format>
+#include <numeric>
+#include <algorithm>
+#include "DensityMatrixRegister.h"
+#include "VectorizedQuantumRegister.h"
+#include "QubitPermutation.h"
+
+namespace KQS::Circuit {
+
+	template<typename T>
+	DensityMatrixRegister<T>::DensityMatrixRegister(size_t numberOfQubits)
+			: DensityMatrixRegister(numberOfQubits, std::make_unique<VectorizedQuantumRegister<T>>(2 * numberOfQubits)) {}
+
+	template<typename T>
+	DensityMatrixRegister<T>::DensityMatrixRegister(size_t numberOfQubits,
+													std::unique_ptr<QuantumRegister<T>> densityRegister)
+			: QuantumRegister<T>(numberOfQubits), fDensity(std::move(densityRegister)) {
+		if (!fDensity || fDensity->qubits() != 2 * numberOfQubits)
+			throw std::runtime_error(std::format("Density matrix of {} qubits needs a register of {} qubits",
+												 numberOfQubits, 2 * numberOfQubits));
+	}
+
+	/// Channels ///
+
+	template<typename T>
+	void DensityMatrixRegister<T>::applyChannel(const KrausChannel<T> &channel, const std::vector<size_t> &targetQubits) {
+		if (targetQubits.size() != channel.qubits())
+			throw std::runtime_error(std::format("Channel on {} qubits cannot be applied to {} qubits",
+												 channel.qubits(), targetQubits.size()));
+		std::vector<size_t> physical(targetQubits.size());
+		for (size_t i = 0; i < targetQubits.size(); ++i) {
+			if (targetQubits[i] >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Qubit {} does not exist in {}-qubit register", targetQubits[i], fNumQubits));
+			for (size_t j = 0; j < i; ++j)
+				if (targetQubits[j] == targetQubits[i])
+					throw std::runtime_error(std::format("Cannot apply channel twice to qubit {}", targetQubits[i]));
+			physical[i] = fQubitMap[targetQubits[i]];
+		}
+
+		this->profiled("Channel", targetQubits, 1, [&] {
+			fDensity->gate(channel.superoperator(), withShadows(physical));
+		});
+	}
+
+	/// Density matrix ///
+
+	template<typename T>
+	std::vector<std::complex<T>> DensityMatrixRegister<T>::densityMatrix() const {
+		std::vector<complex_t> vectorized = fDensity->stateVector();
+		QubitPermutation toLogical(QubitPermutation::inverse(fQubitMap));
+
+		std::vector<complex_t> result(vectorized.size());
+		for (size_t column = 0; column < fNumStates; ++column) {
+			size_t logicalColumn = toLogical(column);
+			for (size_t row = 0; row < fNumStates; ++row)
+				result[toLogical(row) * fNumStates + logicalColumn] = vectorized[row + fNumStates * column];
+		}
+		return result;
+	}
+
+	template<typename T>
+	T DensityMatrixRegister<T>::purity() const {
+		// rho is hermitian, so Tr(rho^2) = sum_rc |rho_rc|^2, the squared norm of vec(rho)
+		return fDensity->norm();
+	}
+
+	template<typename T>
+	T DensityMatrixRegister<T>::norm() const {
+		std::vector<real_t> probabilities = diagonal();
+		return static_cast<real_t>(std::accumulate(probabilities.begin(), probabilities.end(), 0.0));
+	}
+
+	template<typename T>
+	std::vector<T> DensityMatrixRegister<T>::diagonal() const {
+		std::vector<size_t> indices(fNumStates);
+		for (size_t i = 0; i < fNumStates; ++i)
+			indices[i] = i + fNumStates * i;
+
+		std::vector<complex_t> elements = this->elements(indices);
+		std::vector<real_t> result(fNumStates);
+		for (size_t i = 0; i < fNumStates; ++i)
+			result[i] = elements[i].real();
+		return result;
+	}
+
+	template<typename T>
+	std::vector<std::complex<T>> DensityMatrixRegister<T>::elements(const std::vector<size_t> &indices) const {
+		// the elements are collected in order of their position in the inner register, which streams its states
+		std::vector<std::pair<size_t, size_t>> order(indices.size());
+		for (size_t i = 0; i < indices.size(); ++i)
+			order[i] = {indices[i], i};
+		if (!std::ranges::is_sorted(fDensity->qubitMap())) {
+			QubitPermutation toPhysical(fDensity->qubitMap());
+			for (auto &[index, position]: order)
+				index = toPhysical(index);
+		}
+		if (!std::ranges::is_sorted(order))
+			std::ranges::sort(order);
+
+		std::vector<complex_t> result(indices.size());
+		auto next = order.begin();
+		fDensity->readPhysicalStates([&](size_t offset, std::span<const complex_t> chunk) {
+			for (; next != order.end() && next->first < offset + chunk.size(); ++next)
+				result[next->second] = chunk[next->first - offset];
+		});
+		return result;
+	}
+
+	/// Physical state ///
+
+	template<typename T>
+	void DensityMatrixRegister<T>::setPhysicalStateVector(const std::vector<complex_t> &stateVector) {
+		if (stateVector.size() != fNumStates)
+			throw std::runtime_error(std::format("State vector of size {} cannot be set to {}-qubit register",
+												 stateVector.size(), fNumQubits));
+
+		std::vector<complex_t> vectorized(fNumStates * fNumStates);
+		for (size_t column = 0; column < fNumStates; ++column) {
+			complex_t factor = std::conj(stateVector[column]);
+			for (size_t row = 0; row < fNumStates; ++row)
+				vectorized[row + fNumStates * column] = stateVector[row] * factor;
+		}
+		fDensity->setStateVector(vectorized);
+	}
+
+	template<typename T>
+	std::vector<std::complex<T>> DensityMatrixRegister<T>::physicalStateVector() const {
+		real_t purity = this->purity();
+		real_t trace = norm();
+		if (purity < PurityTolerance * trace * trace)
+			throw std::runtime_error(std::format("State of purity {} is mixed and has no state vector",
+												 purity / (trace * trace)));
+
+		// for rho = |psi><psi| the column of the largest diagonal element j is psi conj(psi_j)
+		std::vector<real_t> probabilities = diagonal();
+		size_t column = std::ranges::max_element(probabilities) - probabilities.begin();
+		real_t scale = 1 / std::sqrt(probabilities[column]);
+
+		std::vector<size_t> indices(fNumStates);
+		for (size_t row = 0; row < fNumStates; ++row)
+			indices[row] = row + fNumStates * column;
+
+		std::vector<complex_t> result = elements(indices);
+		for (complex_t &amplitude: result)
+			amplitude *= scale;
+		return result;
+	}
+
+	template<typename T>
+	std::vector<T> DensityMatrixRegister<T>::physicalMarginals() const {
+		std::vector<real_t> probabilities = diagonal();
+		std::vector<double> sums(fNumQubits);
+		for (size_t i = 0; i < fNumStates; ++i)
+			for (size_t q = 0; q < fNumQubits; ++q)
+				if ((i >> q & 1) == 1)
+					sums[q] += probabilities[i];
+		return {sums.begin(), sums.end()};
+	}
+
+	template<typename T>
+	std::vector<size_t> DensityMatrixRegister<T>::samplePhysical(std::span<const real_t> randomNumbers) const {
+		std::vector<real_t> probabilities = diagonal();
+		std::vector<double> cumulative(fNumStates);
+		double sum = 0;
+		for (size_t i = 0; i < fNumStates; ++i) {
+			// rounding can make tiny diagonal elements negative
+			sum += std::max<real_t>(probabilities[i], 0);
+			cumulative[i] = sum;
+		}
+
+		std::vector<size_t> samples(randomNumbers.size());
+		for (size_t shot = 0; shot < randomNumbers.size(); ++shot) {
+			auto it = std::ranges::upper_bound(cumulative, randomNumbers[shot] * sum);
+			// shots beyond the total due to rounding belong to the last state with non-zero probability
+			if (it == cumulative.end())
+				it = std::ranges::lower_bound(cumulative, sum);
+			samples[shot] = it - cumulative.begin();
+		}
+		return samples;
+	}
+
+	template<typename T>
+	size_t DensityMatrixRegister<T>::bytesPerState() const {
+		return fNumStates * sizeof(complex_t);
+	}
+
+	/// Gates ///
+
+	template<typename T>
+	std::vector<size_t> DensityMatrixRegister<T>::withShadows(const std::vector<size_t> &qubits) const {
+		std::vector<size_t> result(qubits);
+		for (size_t qubit: qubits)
+			result.push_back(qubit + fNumQubits);
+		return result;
+	}
+
+	template<typename T>
+	void DensityMatrixRegister<T>::applyToBoth(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
+		// conj(U) (x) U keeps the structure of diagonal and monomial gates, one pass of their kernels applies both;
+		// permutations only move amplitudes, two passes of them are faster than one on twice the qubits
+		GateStructure structure = gate.structure();
+		if (structure == GateStructure::Diagonal || structure == GateStructure::Monomial ||
+			(targetQubits.size() == 1 && structure != GateStructure::Permutation)) {
+			fDensity->gate(QuantumLogicGate<T>(gate.matrix().conjugate().kronecker(gate.matrix())),
+						   withShadows(targetQubits));
+			return;
+		}
+
+		fDensity->gate(gate, targetQubits);
+		std::vector<size_t> shadows(targetQubits.size());
+		for (size_t i = 0; i < targetQubits.size(); ++i)
+			shadows[i] = targetQubits[i] + fNumQubits;
+		fDensity->gate(QuantumLogicGate<T>(gate.matrix().conjugate()), shadows);
+	}
+
+	template<typename T>
+	void DensityMatrixRegister<T>::applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) {
+		applyToBoth(QuantumLogicGate<T>(matrix), {targetQubit});
+	}
+
+	template<typename T>
+	void DensityMatrixRegister<T>::applyTwoQubitGate(const SmallMatrix<T, 4> &matrix,
+													 std::array<size_t, 2> targetQubits) {
+		applyToBoth(QuantumLogicGate<T>(matrix), {targetQubits[0], targetQubits[1]});
+	}
+
+	template<typename T>
+	void DensityMatrixRegister<T>::applyKQubitGate(const QuantumLogicGate<T> &gate,
+												   const std::vector<size_t> &targetQubits) {
+		applyToBoth(gate, targetQubits);
+	}
+
+	template<typename T>
+	void DensityMatrixRegister<T>::applyDiagonalGate(const QuantumLogicGate<T> &gate,
+													 const std::vector<size_t> &targetQubits) {
+		applyToBoth(gate, targetQubits);
+	}
+
+	template<typename T>
+	void DensityMatrixRegister<T>::applyMonomialGate(const QuantumLogicGate<T> &gate,
+													 const std::vector<size_t> &targetQubits) {
+		applyToBoth(gate, targetQubits);
+	}
+
+	template<typename T>
+	void DensityMatrixRegister<T>::applyControlledGate(const QuantumLogicGate<T> &gate,
+													   const std::vector<size_t> &targetQubits) {
+		applyToBoth(gate, targetQubits);
+	}
+
+	template<typename T>
+	void DensityMatrixRegister<T>::applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits,
+													 complex_t factor) {
+		switch (gate) {
+			case StandardGate::PauliX:
+				fDensity->pauliX(qubits[0]);
+				fDensity->pauliX(qubits[0] + fNumQubits);
+				break;
+			case StandardGate::ControlledX:
+				fDensity->controlledX(qubits[1], qubits[0]);
+				fDensity->controlledX(qubits[1] + fNumQubits, qubits[0] + fNumQubits);
+				break;
+			case StandardGate::Swap:
+				fDensity->swap(qubits[0], qubits[1]);
+				fDensity->swap(qubits[0] + fNumQubits, qubits[1] + fNumQubits);
+				break;
+			default:
+				QuantumRegister<T>::applyStandardGate(gate, qubits, factor);
+				break;
+		}
+	}
+
+	template class DensityMatrixRegister<float>;
+	template class DensityMatrixRegister<double>;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <array>
+#include "../types.h"
+#include "QuantumLogicGate.h"
+#include "QuantumRegister.h"
+#include "KrausChannel.h"
+
+namespace KQS::Circuit {
+
+	/**
+	 * Register of a mixed state, stored as its density matrix rho vectorized into the state vector of a register
+	 * with twice as many qubits: element (r, c) of rho is amplitude r + 2^n c, so qubit q of the row index is qubit
+	 * q of the inner register and qubit q of the column index is qubit q + n. A gate U maps rho to U rho U^+, which
+	 * is U applied to qubits q and conj(U) to the shadow qubits q + n, so every gate runs on the kernels of the inner
+	 * register (structured, SIMD, multithreaded or OpenCL). Dense one-qubit, diagonal and monomial gates apply
+	 * conj(U) (x) U as one gate of twice the size and channels apply their superoperator, so they take a single pass
+	 * over the 4^n elements.
+	 *
+	 * The diagonal of rho gives the marginals and samples. Reading the state vector is only possible for pure states.
+	 * @tparam T type of the real and imaginary parts of the density matrix elements
+	 */
+	template<typename T>
+	class DensityMatrixRegister : public QuantumRegister<T> {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+
+		/** Minimal purity Tr(rho^2) of a state whose state vector can be read. */
+		static constexpr real_t PurityTolerance = 1 - 1e-4;
+
+	protected:
+		using QuantumRegister<T>::fNumQubits;
+		using QuantumRegister<T>::fNumStates;
+		using QuantumRegister<T>::fQubitMap;
+
+		/** Register holding vec(rho) on 2n qubits. */
+		std::unique_ptr<QuantumRegister<T>> fDensity;
+
+	public:
+		/** Creates the register in state |0...0><0...0| stored in a VectorizedQuantumRegister. */
+		explicit DensityMatrixRegister(size_t numberOfQubits);
+
+		/**
+		 * Creates the register in state |0...0><0...0| stored in the given register, whose kernels apply the gates.
+		 * @param numberOfQubits number of qubits n
+		 * @param densityRegister register of 2n qubits in state |0...0>
+		 */
+		DensityMatrixRegister(size_t numberOfQubits, std::unique_ptr<QuantumRegister<T>> densityRegister);
+
+		/**
+		 * Applies the channel, e.g. noise after a gate, in one pass over the density matrix.
+		 * @param channel channel on as many qubits as given
+		 * @param targetQubits logical qubits of the channel, in the order of the bits of its operators
+		 */
+		void applyChannel(const KrausChannel<T> &channel, const std::vector<size_t> &targetQubits);
+
+		/** Returns the density matrix in the logical order of the qubits, row-major 2^n x 2^n. */
+		std::vector<complex_t> densityMatrix() const;
+
+		/** Computes Tr(rho^2), 1 for pure states. */
+		real_t purity() const;
+
+		/** Computes the trace of rho. */
+		real_t norm() const override;
+
+	protected:
+		/** Sets the pure state rho = |psi><psi|. */
+		void setPhysicalStateVector(const std::vector<complex_t> &stateVector) override;
+
+		/**
+		 * Returns the state vector of a pure state, up to a global phase, with its largest amplitude real. Throws if
+		 * the purity is below PurityTolerance.
+		 */
+		std::vector<complex_t> physicalStateVector() const override;
+
+		std::vector<real_t> physicalMarginals() const override;
+		std::vector<size_t> samplePhysical(std::span<const real_t> randomNumbers) const override;
+
+		/** Every state of the register has a row of 2^n elements of the density matrix. */
+		size_t bytesPerState() const override;
+
+		void applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) override;
+		void applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) override;
+		void applyKQubitGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyDiagonalGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyMonomialGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyControlledGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+
+		/** Swaps only relabel the qubits of the inner register, X and controlled X use its dedicated kernels. */
+		void applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor) override;
+
+	private:
+		/**
+		 * Applies the gate to the qubits and its conjugate to their shadow qubits, as one gate conj(U) (x) U on both
+		 * for dense one-qubit, diagonal and monomial gates, otherwise as two gates.
+		 */
+		void applyToBoth(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits);
+
+		/** Returns the qubits followed by their shadow qubits. */
+		std::vector<size_t> withShadows(const std::vector<size_t> &qubits) const;
+
+		/** Returns the real diagonal of rho in the physical order. */
+		std::vector<real_t> diagonal() const;
+
+		/**
+		 * Reads elements of vec(rho) through the qubit map of the inner register, so that swaps pending in it do not
+		 * translate the whole vector.
+		 * @param indices indices r + 2^n c of the elements in the physical order of the qubits of rho
+		 */
+		std::vector<complex_t> elements(const std::vector<size_t> &indices) const;
+	};
+}
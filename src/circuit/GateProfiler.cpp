@@ -0,0 +1,178 @@
+#include <fstream>
+#include <format>
+#include <algorithm>
+#include "GateProfiler.h"
+
+namespace KQS::Circuit {
+
+	namespace {
+		std::string qubitList(const std::vector<size_t> &qubits) {
+			std::string list;
+			for (size_t i = 0; i < qubits.size(); ++i)
+				list += std::format("{}{}", i > 0 ? "," : "", qubits[i]);
+			return list;
+		}
+
+		double microseconds(std::chrono::nanoseconds time) {
+			return std::chrono::duration<double, std::micro>(time).count();
+		}
+	}
+
+	GateProfiler::Measurement GateProfiler::start() const {
+		Measurement measurement;
+		if (fHardwareCounters)
+			measurement.counts = PerfCounters::forThisThread().read();
+		// the clock is read last and first in finish(), so reading the counters is not part of the time
+		measurement.start = Clock::now();
+		return measurement;
+	}
+
+	void GateProfiler::finish(const Measurement &measurement, std::string_view name, std::span<const size_t> qubits,
+							  std::chrono::nanoseconds deviceTime, size_t bytes) {
+		auto end = Clock::now();
+		PerfCounts counts;
+		if (fHardwareCounters)
+			counts = PerfCounters::forThisThread().read() - measurement.counts;
+
+		record(name, qubits, measurement.start, end - measurement.start, deviceTime, bytes, counts);
+	}
+
+	void GateProfiler::record(std::string_view name, std::span<const size_t> qubits, Clock::time_point start,
+							  std::chrono::nanoseconds hostTime, std::chrono::nanoseconds deviceTime, size_t bytes,
+							  const PerfCounts &counts) {
+		std::lock_guard lock(fMutex);
+
+		Key key{std::string(name), std::vector<size_t>(qubits.begin(), qubits.end())};
+		Statistics &statistics = fStatistics[key];
+		if (statistics.count == 0) {
+			statistics.name = key.first;
+			statistics.qubits = key.second;
+		}
+		statistics.count++;
+		statistics.totalTime += hostTime;
+		statistics.maxTime = std::max(statistics.maxTime, hostTime);
+		statistics.deviceTime += deviceTime;
+		statistics.bytes += bytes;
+		statistics.counts += counts;
+
+		if (fKeepEvents) {
+			size_t thread = fThreads.try_emplace(std::this_thread::get_id(), fThreads.size()).first->second;
+			fEvents.push_back({std::move(key.first), std::move(key.second), start, thread, hostTime, deviceTime, bytes,
+							   counts});
+		}
+	}
+
+	bool GateProfiler::setHardwareCounters(bool enable) {
+		fHardwareCounters = enable;
+		return PerfCounters::forThisThread().available();
+	}
+
+	void GateProfiler::setKeepEvents(bool keep) {
+		std::lock_guard lock(fMutex);
+		fKeepEvents = keep;
+	}
+
+	std::vector<GateProfiler::Statistics> GateProfiler::statistics() const {
+		std::vector<Statistics> result;
+		{
+			std::lock_guard lock(fMutex);
+			for (const auto &[key, statistics]: fStatistics)
+				result.push_back(statistics);
+		}
+
+		std::ranges::sort(result, std::ranges::greater{}, &Statistics::totalTime);
+		return result;
+	}
+
+	std::vector<GateProfiler::Event> GateProfiler::events() const {
+		std::lock_guard lock(fMutex);
+		return fEvents;
+	}
+
+	std::string GateProfiler::summary() const {
+		std::vector<Statistics> rows = statistics();
+
+		std::chrono::nanoseconds total{0};
+		for (const auto &row: rows)
+			total += row.totalTime;
+
+		std::string table = std::format("{:<18}{:<16}{:>10}{:>12}{:>8}{:>12}{:>12}{:>12}{:>10}", "Gate", "Qubits",
+										"Count", "Total ms", "%", "Mean us", "Max us", "Device ms", "GB/s");
+		if (fHardwareCounters)
+			table += std::format("{:>14}{:>8}{:>14}{:>14}", "Cycles", "IPC", "LLC misses", "dTLB misses");
+		table += "\n";
+
+		for (const auto &row: rows) {
+			double seconds = std::chrono::duration<double>(row.totalTime).count();
+			auto count = static_cast<double>(row.count);
+			table += std::format("{:<18}{:<16}{:>10}{:>12.3f}{:>8.1f}{:>12.2f}{:>12.2f}{:>12.3f}{:>10.2f}",
+								 row.name, qubitList(row.qubits), row.count, microseconds(row.totalTime) / 1000,
+								 total.count() > 0 ? 100.0 * static_cast<double>(row.totalTime.count()) /
+													 static_cast<double>(total.count()) : 0.0,
+								 microseconds(row.totalTime) / count, microseconds(row.maxTime),
+								 microseconds(row.deviceTime) / 1000,
+								 seconds > 0 ? static_cast<double>(row.bytes) / seconds / 1e9 : 0.0);
+
+			// counters are averaged per gate
+			if (fHardwareCounters) {
+				const PerfCounts &counts = row.counts;
+				table += std::format("{:>14.0f}{:>8.2f}{:>14.0f}{:>14.0f}", static_cast<double>(counts.cycles) / count,
+									 counts.cycles > 0 ? static_cast<double>(counts.instructions) /
+														 static_cast<double>(counts.cycles) : 0.0,
+									 static_cast<double>(counts.llcMisses) / count,
+									 static_cast<double>(counts.dtlbMisses) / count);
+			}
+			table += "\n";
+		}
+		return table;
+	}
+
+	void GateProfiler::toChromeTrace(const std::string &fileName) const {
+		std::vector<Event> events;
+		Clock::time_point epoch;
+		size_t deviceTrack;
+		{
+			std::lock_guard lock(fMutex);
+			events = fEvents;
+			epoch = fEpoch;
+			deviceTrack = fThreads.size();
+		}
+		std::ofstream file(fileName);
+
+		file << "{\"traceEvents\": [\n";
+		for (size_t thread = 0; thread < deviceTrack; ++thread)
+			file << std::format(R"(  {{"name": "thread_name", "ph": "M", "pid": 0, "tid": {}, )"
+								R"("args": {{"name": "host {}"}}}},)", thread, thread) << "\n";
+		file << std::format(R"(  {{"name": "thread_name", "ph": "M", "pid": 0, "tid": {}, )"
+							R"("args": {{"name": "device"}}}})", deviceTrack);
+
+		for (const auto &event: events) {
+			double start = microseconds(event.start - epoch);
+			std::string arguments = std::format(R"({{"qubits": "{}", "bytes": {})", qubitList(event.qubits),
+												event.bytes);
+			if (fHardwareCounters)
+				arguments += std::format(R"(, "cycles": {}, "instructions": {}, "llc_misses": {}, "dtlb_misses": {})",
+										 event.counts.cycles, event.counts.instructions, event.counts.llcMisses,
+										 event.counts.dtlbMisses);
+			arguments += "}";
+
+			file << std::format(",\n  {{\"name\": \"{}\", \"cat\": \"gate\", \"ph\": \"X\", \"pid\": 0, \"tid\": {}, "
+								"\"ts\": {:.3f}, \"dur\": {:.3f}, \"args\": {}}}",
+								event.name, event.thread, start, microseconds(event.hostTime), arguments);
+			if (event.deviceTime.count() > 0)
+				file << std::format(",\n  {{\"name\": \"{}\", \"cat\": \"kernel\", \"ph\": \"X\", \"pid\": 0, "
+									"\"tid\": {}, \"ts\": {:.3f}, \"dur\": {:.3f}, \"args\": {}}}",
+									event.name, deviceTrack, start, microseconds(event.deviceTime), arguments);
+		}
+
+		file << "\n]}\n";
+	}
+
+	void GateProfiler::clear() {
+		std::lock_guard lock(fMutex);
+		fStatistics.clear();
+		fEvents.clear();
+		fThreads.clear();
+		fEpoch = Clock::now();
+	}
+}
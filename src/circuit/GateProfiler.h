@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "PerfCounters.h"
+
+namespace KQS::Circuit {
+
+	/**
+	 * Records the gates applied by the registers it is set to (QuantumRegister::setProfiler), with their qubits,
+	 * time and the bytes of the state vector they read and write. Statistics are aggregated per gate kind and
+	 * qubits and can be printed as a table, the individual gates can be exported as a Chrome trace (chrome://tracing,
+	 * Perfetto). Registers without a profiler only test a pointer per gate. The profiler can be shared by registers
+	 * running on different threads.
+	 */
+	class GateProfiler {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		/** One applied gate. */
+		struct Event {
+			std::string name;
+			/** Logical qubits of the gate. */
+			std::vector<size_t> qubits;
+			Clock::time_point start;
+			/** Index of the thread that applied the gate, threads are numbered in the order of their first gate. */
+			size_t thread;
+			/** Wall time of the gate on the host. */
+			std::chrono::nanoseconds hostTime;
+			/** Time of the kernels on the device, zero for registers computing on the host. */
+			std::chrono::nanoseconds deviceTime;
+			/** Estimated bytes of the state vector read and written. */
+			size_t bytes;
+			/** Hardware counters of the gate, zero if they are disabled. */
+			PerfCounts counts;
+		};
+
+		/** Statistics of all gates of one kind on the same qubits. */
+		struct Statistics {
+			std::string name;
+			std::vector<size_t> qubits;
+			size_t count = 0;
+			std::chrono::nanoseconds totalTime{0};
+			std::chrono::nanoseconds maxTime{0};
+			std::chrono::nanoseconds deviceTime{0};
+			size_t bytes = 0;
+			PerfCounts counts;
+		};
+
+		/** State at the start of a gate, see start() and finish(). */
+		struct Measurement {
+			Clock::time_point start;
+			PerfCounts counts;
+		};
+
+	private:
+		using Key = std::pair<std::string, std::vector<size_t>>;
+
+		mutable std::mutex fMutex;
+		std::map<Key, Statistics> fStatistics;
+		std::vector<Event> fEvents;
+		/** Index of every thread that recorded a gate. */
+		std::map<std::thread::id, size_t> fThreads;
+		bool fKeepEvents = true;
+		std::atomic<bool> fHardwareCounters = false;
+		Clock::time_point fEpoch = Clock::now();
+
+	public:
+		/** Starts measuring a gate on the calling thread. */
+		Measurement start() const;
+
+		/**
+		 * Finishes measuring the gate started on the calling thread and records it.
+		 * @param measurement value returned by start()
+		 * @param name kind of the gate
+		 * @param qubits logical qubits of the gate
+		 * @param deviceTime time of the device kernels, zero if the gate ran on the host
+		 * @param bytes estimated bytes of the state vector read and written
+		 */
+		void finish(const Measurement &measurement, std::string_view name, std::span<const size_t> qubits,
+					std::chrono::nanoseconds deviceTime, size_t bytes);
+
+		/**
+		 * Records one gate applied by the calling thread.
+		 * @param name kind of the gate
+		 * @param qubits logical qubits of the gate
+		 * @param start time the gate started
+		 * @param hostTime wall time of the gate
+		 * @param deviceTime time of the device kernels, zero if the gate ran on the host
+		 * @param bytes estimated bytes of the state vector read and written
+		 * @param counts hardware counters of the gate
+		 */
+		void record(std::string_view name, std::span<const size_t> qubits, Clock::time_point start,
+					std::chrono::nanoseconds hostTime, std::chrono::nanoseconds deviceTime, size_t bytes,
+					const PerfCounts &counts = {});
+
+		/**
+		 * Enables or disables reading the hardware counters (PerfCounters) around every gate, which costs a few
+		 * system calls per gate. The summary then shows cycles, instructions per cycle, LLC and dTLB misses per gate.
+		 * @return whether the counters are available on the calling thread
+		 */
+		bool setHardwareCounters(bool enable);
+
+		/**
+		 * Enables or disables keeping every gate for the trace, statistics are collected in any case.
+		 * Long circuits need memory for every gate if enabled (the default).
+		 */
+		void setKeepEvents(bool keep);
+
+		/** Returns the statistics sorted by decreasing total time. */
+		std::vector<Statistics> statistics() const;
+
+		std::vector<Event> events() const;
+
+		/**
+		 * Returns the statistics as a table with count, total, mean and max time, device time and bandwidth, and the
+		 * hardware counters if they are enabled.
+		 */
+		std::string summary() const;
+
+		/**
+		 * Writes the recorded gates as Chrome trace JSON. Host times are on one track per thread that applied gates,
+		 * device times on a track after them, starting with the host time of their gate, since the device clock is not
+		 * synchronized with the host.
+		 * @param fileName path of the JSON file
+		 */
+		void toChromeTrace(const std::string &fileName) const;
+
+		/** Drops all recorded gates and statistics. */
+		void clear();
+	};
+}
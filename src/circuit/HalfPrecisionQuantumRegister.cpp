@@ -0,0 +1,591 @@
+#include <format>
+#include <bit>
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+#include "HalfPrecisionQuantumRegister.h"
+#include "PermutationKernels.h"
+#include "DenseGateKernels.h"
+#include "StandardGateKernels.h"
+#include "../algebra/Constants.h"
+#include "immintrin.h"
+
+namespace KQS::Circuit {
+
+	/// Conversions between floats and 16-bit formats ///
+
+	template<HalfFormat F>
+	inline float toFloat(uint16_t value) {
+		if constexpr (F == HalfFormat::FP16)
+			return _cvtsh_ss(value);
+		else
+			return std::bit_cast<float>(static_cast<uint32_t>(value) << 16);
+	}
+
+	template<HalfFormat F>
+	inline uint16_t fromFloat(float value) {
+		if constexpr (F == HalfFormat::FP16)
+			return _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+		else {
+			uint32_t bits = std::bit_cast<uint32_t>(value);
+			if ((bits & 0x7FFFFFFF) > 0x7F800000) // NaN must not be rounded to infinity
+				return static_cast<uint16_t>((bits >> 16) | 0x40);
+
+			// round to nearest, ties to even
+			bits += 0x7FFF + ((bits >> 16) & 1);
+			return static_cast<uint16_t>(bits >> 16);
+		}
+	}
+
+	/** Loads four complex numbers (eight 16-bit values) and widens them to floats. */
+	template<HalfFormat F>
+	inline __m256 load4(const uint16_t *data) {
+		__m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+
+		if constexpr (F == HalfFormat::FP16)
+			return _mm256_cvtph_ps(half);
+		else
+			return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(half), 16));
+	}
+
+	/** Rounds four complex numbers to 16-bit values and stores them. */
+	template<HalfFormat F>
+	inline void store4(uint16_t *data, __m256 value) {
+		__m128i half;
+
+		if constexpr (F == HalfFormat::FP16)
+			half = _mm256_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT);
+		else {
+			// round to nearest, ties to even, NaNs do not occur in valid states
+			__m256i bits = _mm256_castps_si256(value);
+			__m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+			bits = _mm256_add_epi32(bits, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF)));
+			bits = _mm256_srli_epi32(bits, 16);
+			half = _mm_packus_epi32(_mm256_castsi256_si128(bits), _mm256_extracti128_si256(bits, 1));
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(data), half);
+	}
+
+	/** Wrapper allowing arrays of SIMD registers without dropping their alignment attributes. */
+	struct PackedFloats {
+		__m256 value;
+	};
+
+	/** Largest gate dimension applied by the vector kernel, larger gates use the scalar kernel. */
+	constexpr size_t MaxVectorDimension = 64;
+
+	/**
+	 * Multiplies four complex numbers by four complex numbers given as [re, re, ...] and [-im, im, ...],
+	 * i.e. m * x = re * x + im * swap(x), where swap exchanges real and imaginary parts.
+	 */
+	inline __m256 cmul4(__m256 re, __m256 im, __m256 x) {
+		return _mm256_fmadd_ps(re, x, _mm256_mul_ps(im, _mm256_permute_ps(x, 0b10'11'00'01)));
+	}
+
+	/** Broadcasts complex numbers into the [re, re, ...] and [-im, im, ...] form used by cmul4. */
+	inline void broadcast4(std::array<std::complex<float>, 4> m, __m256 &re, __m256 &im) {
+		re = _mm256_setr_ps(m[0].real(), m[0].real(), m[1].real(), m[1].real(),
+							m[2].real(), m[2].real(), m[3].real(), m[3].real());
+		im = _mm256_setr_ps(-m[0].imag(), m[0].imag(), -m[1].imag(), m[1].imag(),
+							-m[2].imag(), m[2].imag(), -m[3].imag(), m[3].imag());
+	}
+
+	/**
+	 * Applies a gate whose targets are all above the two lowest qubits. Four consecutive groups are then four
+	 * consecutive states at every offset, so one SIMD register holds the same state of four groups.
+	 * D is the dimension of the gate if known at compile time, zero otherwise.
+	 */
+	template<HalfFormat F, size_t D, typename FirstState>
+	void applyGroupsVectorized(uint16_t *data, size_t groups, size_t dimension, const std::vector<size_t> &offsets,
+							   std::span<const std::complex<float>> m, FirstState firstState) {
+		const size_t dim = D != 0 ? D : dimension;
+
+		std::array<PackedFloats, (D != 0 ? D : MaxVectorDimension) * (D != 0 ? D : MaxVectorDimension)> mRe{};
+		std::array<PackedFloats, (D != 0 ? D : MaxVectorDimension) * (D != 0 ? D : MaxVectorDimension)> mIm{};
+		for (size_t i = 0; i < dim * dim; ++i)
+			broadcast4({m[i], m[i], m[i], m[i]}, mRe[i].value, mIm[i].value);
+
+		// every item of the parallel loop is four consecutive groups
+		size_t minItemsPerThread = std::max<size_t>(1, Kernels::DenseGateWorkPerThread / (4 * dim * dim));
+		parallelFor(groups / 4, minItemsPerThread, [&](size_t begin, size_t end) {
+			std::array<PackedFloats, D != 0 ? D : MaxVectorDimension> x{};
+			for (size_t g = 4 * begin; g < 4 * end; g += 4) {
+				size_t state = firstState(g);
+
+				for (size_t j = 0; j < dim; ++j)
+					x[j].value = load4<F>(data + 2 * (state + offsets[j]));
+
+				for (size_t r = 0; r < dim; ++r) {
+					__m256 y = cmul4(mRe[r * dim].value, mIm[r * dim].value, x[0].value);
+					for (size_t c = 1; c < dim; ++c)
+						y = _mm256_add_ps(y, cmul4(mRe[r * dim + c].value, mIm[r * dim + c].value, x[c].value));
+
+					store4<F>(data + 2 * (state + offsets[r]), y);
+				}
+			}
+		});
+	}
+
+	/**
+	 * Applies a one-qubit gate to one of the two lowest qubits. Both states of a pair are in the same SIMD register,
+	 * they are duplicated across the pair by permutations and multiplied by the matching matrix elements.
+	 */
+	template<HalfFormat F>
+	void applyLowQubitVectorized(uint16_t *data, size_t numStates, size_t targetQubit,
+								 std::span<const std::complex<float>> m) {
+		__m256 leftRe, leftIm, rightRe, rightIm;
+		if (targetQubit == 0) {
+			// pairs (0, 1), (2, 3)
+			broadcast4({m[0], m[2], m[0], m[2]}, leftRe, leftIm);
+			broadcast4({m[1], m[3], m[1], m[3]}, rightRe, rightIm);
+		} else {
+			// pairs (0, 2), (1, 3)
+			broadcast4({m[0], m[0], m[2], m[2]}, leftRe, leftIm);
+			broadcast4({m[1], m[1], m[3], m[3]}, rightRe, rightIm);
+		}
+
+		parallelFor(numStates / 4, Kernels::DenseGateWorkPerThread / 8, [&](size_t begin, size_t end) {
+			for (size_t state = 4 * begin; state < 4 * end; state += 4) {
+				__m256 x = load4<F>(data + 2 * state);
+
+				__m256 left, right;
+				if (targetQubit == 0) {
+					// [x0, x0, x2, x2] and [x1, x1, x3, x3]
+					left = _mm256_castpd_ps(_mm256_permute_pd(_mm256_castps_pd(x), 0b0000));
+					right = _mm256_castpd_ps(_mm256_permute_pd(_mm256_castps_pd(x), 0b1111));
+				} else {
+					// [x0, x1, x0, x1] and [x2, x3, x2, x3]
+					left = _mm256_permute2f128_ps(x, x, 0x00);
+					right = _mm256_permute2f128_ps(x, x, 0x11);
+				}
+
+				store4<F>(data + 2 * state, _mm256_add_ps(cmul4(leftRe, leftIm, left), cmul4(rightRe, rightIm, right)));
+			}
+		});
+	}
+
+	/// Named gates ///
+
+	/** Sign bit of both formats. */
+	constexpr uint16_t SignBit = 0x8000;
+
+	/** Exchanges the amplitudes of the states, both 16-bit values of each. */
+	inline void swapStates(uint16_t *data, size_t i, size_t j) {
+		std::swap(data[2 * i], data[2 * j]);
+		std::swap(data[2 * i + 1], data[2 * j + 1]);
+	}
+
+	/**
+	 * Multiplies the states [begin, end) + offset by the factor. Runs are processed four states at a time, the
+	 * remaining states one by one.
+	 */
+	template<HalfFormat F>
+	inline void multiplyRun(uint16_t *data, size_t begin, size_t end, size_t offset, __m256 re, __m256 im,
+							std::complex<float> factor) {
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+			store4<F>(data + 2 * (i + offset), cmul4(re, im, load4<F>(data + 2 * (i + offset))));
+
+		for (; i < end; ++i) {
+			uint16_t *amplitude = data + 2 * (i + offset);
+			std::complex<float> value = factor * std::complex<float>(toFloat<F>(amplitude[0]), toFloat<F>(amplitude[1]));
+			amplitude[0] = fromFloat<F>(value.real());
+			amplitude[1] = fromFloat<F>(value.imag());
+		}
+	}
+
+	/** Hadamard butterflies of the states [begin, end) with the states at the offset. */
+	template<HalfFormat F>
+	inline void hadamardRun(uint16_t *data, size_t begin, size_t end, size_t offset) {
+		size_t i = begin;
+		__m256 scale = _mm256_set1_ps(Algebra::RecSqrt2<float>);
+		for (; i + 4 <= end; i += 4) {
+			__m256 a0 = load4<F>(data + 2 * i);
+			__m256 a1 = load4<F>(data + 2 * (i + offset));
+			store4<F>(data + 2 * i, _mm256_mul_ps(_mm256_add_ps(a0, a1), scale));
+			store4<F>(data + 2 * (i + offset), _mm256_mul_ps(_mm256_sub_ps(a0, a1), scale));
+		}
+
+		for (; i < end; ++i) {
+			for (size_t part = 0; part < 2; ++part) {
+				float a0 = toFloat<F>(data[2 * i + part]);
+				float a1 = toFloat<F>(data[2 * (i + offset) + part]);
+				data[2 * i + part] = fromFloat<F>((a0 + a1) * Algebra::RecSqrt2<float>);
+				data[2 * (i + offset) + part] = fromFloat<F>((a0 - a1) * Algebra::RecSqrt2<float>);
+			}
+		}
+	}
+
+	/** Whether the matrix of the dimension in row-major order is unitary up to single precision rounding. */
+	inline bool isUnitary(std::span<const std::complex<float>> matrix, size_t dimension) {
+		for (size_t r = 0; r < dimension; ++r) {
+			for (size_t c = 0; c < dimension; ++c) {
+				std::complex<float> product = 0;
+				for (size_t k = 0; k < dimension; ++k)
+					product += std::conj(matrix[k * dimension + r]) * matrix[k * dimension + c];
+				if (std::abs(product - std::complex<float>(r == c)) > 1e-4f * static_cast<float>(dimension))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	/// Register ///
+
+	HalfPrecisionQuantumRegister::HalfPrecisionQuantumRegister(size_t numberOfQubits, HalfFormat format)
+			: QuantumRegister(numberOfQubits), fFormat(format), fStateVector(2 * fNumStates),
+			  fScaleExponent(format == HalfFormat::FP16 ? StoredNormExponent : 0) {
+		// powers of two are exactly representable in both formats
+		float one = std::ldexp(1.0f, fScaleExponent);
+		fStateVector[0] = format == HalfFormat::FP16 ? fromFloat<HalfFormat::FP16>(one)
+													 : fromFloat<HalfFormat::BF16>(one);
+	}
+
+	HalfFormat HalfPrecisionQuantumRegister::format() const {
+		return fFormat;
+	}
+
+	int HalfPrecisionQuantumRegister::scaleExponent() const {
+		return fScaleExponent;
+	}
+
+	void HalfPrecisionQuantumRegister::setPhysicalStateVector(const std::vector<complex_t> &stateVector) {
+		if (stateVector.size() != fNumStates)
+			throw std::runtime_error(std::format("State vector of size {} cannot be set to {}-qubit register",
+												 stateVector.size(), fNumQubits));
+
+		if (fFormat == HalfFormat::FP16) {
+			double norm = 0;
+			for (const auto &amplitude: stateVector)
+				norm += std::norm(std::complex<double>(amplitude));
+			fScaleExponent = scaleExponentFor(norm);
+		}
+
+		float scale = std::ldexp(1.0f, fScaleExponent);
+		for (size_t i = 0; i < fNumStates; ++i) {
+			auto re = static_cast<float>(stateVector[i].real()) * scale;
+			auto im = static_cast<float>(stateVector[i].imag()) * scale;
+
+			if (fFormat == HalfFormat::FP16) {
+				fStateVector[2 * i] = fromFloat<HalfFormat::FP16>(re);
+				fStateVector[2 * i + 1] = fromFloat<HalfFormat::FP16>(im);
+			} else {
+				fStateVector[2 * i] = fromFloat<HalfFormat::BF16>(re);
+				fStateVector[2 * i + 1] = fromFloat<HalfFormat::BF16>(im);
+			}
+		}
+	}
+
+	std::vector<std::complex<float>> HalfPrecisionQuantumRegister::physicalStateVector() const {
+		std::vector<complex_t> result(fNumStates);
+		if (fFormat == HalfFormat::FP16)
+			widen<HalfFormat::FP16>(0, result);
+		else
+			widen<HalfFormat::BF16>(0, result);
+
+		return result;
+	}
+
+	void HalfPrecisionQuantumRegister::readPhysicalStateVector(const StateChunkCallback &callback) const {
+		// widened in chunks, so that the single precision copy of the whole state vector is never needed
+		std::vector<complex_t> chunk(std::min<size_t>(fNumStates, 1 << 16));
+
+		for (size_t offset = 0; offset < fNumStates; offset += chunk.size()) {
+			std::span<complex_t> view(chunk.data(), std::min(chunk.size(), fNumStates - offset));
+			if (fFormat == HalfFormat::FP16)
+				widen<HalfFormat::FP16>(offset, view);
+			else
+				widen<HalfFormat::BF16>(offset, view);
+
+			callback(offset, view);
+		}
+	}
+
+	std::vector<std::complex<double>> HalfPrecisionQuantumRegister::physicalReducedDensityMatrix(
+			const std::vector<size_t> &qubits) const {
+		// the scale is a power of two, so removing it is exact
+		float scale = std::ldexp(1.0f, -fScaleExponent);
+		const uint16_t *data = fStateVector.data();
+		if (fFormat == HalfFormat::FP16)
+			return Kernels::reducedDensityMatrix(fNumStates, qubits, [=](size_t i) {
+				return scale * complex_t(toFloat<HalfFormat::FP16>(data[2 * i]),
+										 toFloat<HalfFormat::FP16>(data[2 * i + 1]));
+			});
+		return Kernels::reducedDensityMatrix(fNumStates, qubits, [=](size_t i) {
+			return scale * complex_t(toFloat<HalfFormat::BF16>(data[2 * i]), toFloat<HalfFormat::BF16>(data[2 * i + 1]));
+		});
+	}
+
+	void HalfPrecisionQuantumRegister::applyOneQubitGate(const SmallMatrix<float, 2> &matrix, size_t targetQubit) {
+		applyMatrix(matrix.data(), {targetQubit});
+	}
+
+	void HalfPrecisionQuantumRegister::applyTwoQubitGate(const SmallMatrix<float, 4> &matrix, std::array<size_t, 2> targetQubits) {
+		applyMatrix(matrix.data(), {targetQubits[0], targetQubits[1]});
+	}
+
+	void HalfPrecisionQuantumRegister::applyKQubitGate(const QuantumLogicGate<float> &gate, const std::vector<size_t> &targetQubits) {
+		if (gate.matrix().rows() != 1ULL << targetQubits.size())
+			throw std::runtime_error(std::format("Gate of dimension {} cannot be applied to {} qubits",
+												 gate.matrix().rows(), targetQubits.size()));
+
+		applyMatrix(gate.matrix().data(), targetQubits);
+	}
+
+	void HalfPrecisionQuantumRegister::applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits,
+														 complex_t factor) {
+		size_t usedQubits = isTwoQubitGate(gate) ? 2 : 1;
+		for (size_t i = 0; i < usedQubits; ++i)
+			if (qubits[i] >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Cannot apply gate to qubit {} in {}-qubit register", qubits[i], fNumQubits));
+		if (usedQubits == 2 && qubits[0] == qubits[1])
+			throw std::runtime_error(std::format("Cannot apply two-qubit gate twice to qubit {}", qubits[0]));
+
+		if (fFormat == HalfFormat::FP16)
+			applyNamedGate<HalfFormat::FP16>(gate, qubits, factor);
+		else
+			applyNamedGate<HalfFormat::BF16>(gate, qubits, factor);
+	}
+
+	void HalfPrecisionQuantumRegister::permutePhysicalQubits(const std::vector<size_t> &permutation) {
+		std::vector<uint16_t> permuted(fStateVector.size());
+		Kernels::permuteQubits<2>(fStateVector.data(), permuted.data(), fNumQubits, permutation);
+		fStateVector.swap(permuted);
+	}
+
+	size_t HalfPrecisionQuantumRegister::bytesPerState() const {
+		return 2 * sizeof(uint16_t);
+	}
+
+	/// Private methods ///
+
+	void HalfPrecisionQuantumRegister::applyMatrix(std::span<const complex_t> matrix, const std::vector<size_t> &targetQubits) {
+		for (size_t targetQubit: targetQubits)
+			if (targetQubit >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Cannot apply gate to qubit {} in {}-qubit register", targetQubit, fNumQubits));
+
+		if (fFormat == HalfFormat::BF16) {
+			applyGate<HalfFormat::BF16>(matrix, targetQubits);
+			return;
+		}
+
+		// the squared norm grows at most by the squared Frobenius norm of the matrix
+		size_t dimension = 1ULL << targetQubits.size();
+		bool unitary = isUnitary(matrix, dimension);
+		if (!unitary) {
+			double growth = 0;
+			for (const auto &element: matrix)
+				growth += std::norm(element);
+			rescale(growth);
+		}
+
+		applyGate<HalfFormat::FP16>(matrix, targetQubits);
+
+		if (!unitary)
+			rescale();
+	}
+
+	void HalfPrecisionQuantumRegister::rescale(double growth) {
+		if (fFormat != HalfFormat::FP16)
+			return;
+
+		double norm = storedNorm();
+		if (norm == 0)
+			return;
+
+		int exponent = scaleExponentFor(std::ldexp(norm, -2 * fScaleExponent) * std::max(growth, 1.0));
+		if (exponent == fScaleExponent)
+			return;
+
+		uint16_t *data = fStateVector.data();
+		__m256 factor = _mm256_set1_ps(std::ldexp(1.0f, exponent - fScaleExponent));
+		parallelFor(fNumStates / 4, Kernels::DenseGateWorkPerThread, [=](size_t begin, size_t end) {
+			for (size_t i = 4 * begin; i < 4 * end; i += 4)
+				store4<HalfFormat::FP16>(data + 2 * i, _mm256_mul_ps(load4<HalfFormat::FP16>(data + 2 * i), factor));
+		});
+
+		// registers of one qubit have fewer states than a vector
+		float scalarFactor = std::ldexp(1.0f, exponent - fScaleExponent);
+		for (size_t i = 2 * (fNumStates / 4 * 4); i < fStateVector.size(); ++i)
+			data[i] = fromFloat<HalfFormat::FP16>(toFloat<HalfFormat::FP16>(data[i]) * scalarFactor);
+
+		fScaleExponent = exponent;
+	}
+
+	double HalfPrecisionQuantumRegister::storedNorm() const {
+		std::vector<double> sums(maxThreads() + 1);
+		std::atomic<size_t> nextSum = 0;
+		const uint16_t *data = fStateVector.data();
+		parallelFor(fStateVector.size(), 2 * Kernels::DenseGateWorkPerThread, [&](size_t begin, size_t end) {
+			double sum = 0;
+			for (size_t i = begin; i < end; ++i) {
+				float value = toFloat<HalfFormat::FP16>(data[i]);
+				sum += value * value;
+			}
+			sums[nextSum++] = sum;
+		});
+
+		double result = 0;
+		for (double sum: sums)
+			result += sum;
+		return result;
+	}
+
+	int HalfPrecisionQuantumRegister::scaleExponentFor(double norm) {
+		if (norm <= 0 || !std::isfinite(norm))
+			return StoredNormExponent;
+
+		// the square root of the stored norm is at most 2^StoredNormExponent
+		return StoredNormExponent - static_cast<int>(std::ceil(0.5 * std::log2(norm)));
+	}
+
+	template<HalfFormat F>
+	void HalfPrecisionQuantumRegister::applyGate(std::span<const complex_t> m, const std::vector<size_t> &targetQubits) {
+		size_t dimension = 1ULL << targetQubits.size();
+		size_t groups = fNumStates / dimension;
+
+		if (targetQubits.size() == 1 && targetQubits[0] < 2 && fNumStates >= 4) {
+			applyLowQubitVectorized<F>(fStateVector.data(), fNumStates, targetQubits[0], m);
+			return;
+		}
+
+		// offset of each state of a group from the first state of the group
+		std::vector<size_t> offsets(dimension, 0);
+		for (size_t j = 0; j < dimension; ++j)
+			for (size_t k = 0; k < targetQubits.size(); ++k)
+				offsets[j] |= ((j >> k) & 1) << targetQubits[k];
+
+		// zero bits inserted in ascending order end up exactly at the target positions
+		std::vector<size_t> sortedTargets = targetQubits;
+		std::ranges::sort(sortedTargets);
+		auto firstState = [&sortedTargets](size_t group) {
+			for (size_t position: sortedTargets) {
+				size_t mask = (1ULL << position) - 1;
+				group = ((group & ~mask) << 1) | (group & mask);
+			}
+			return group;
+		};
+
+		if (sortedTargets.front() >= 2 && groups >= 4 && dimension <= MaxVectorDimension) {
+			switch (dimension) {
+				case 2:
+					applyGroupsVectorized<F, 2>(fStateVector.data(), groups, dimension, offsets, m, firstState);
+					break;
+				case 4:
+					applyGroupsVectorized<F, 4>(fStateVector.data(), groups, dimension, offsets, m, firstState);
+					break;
+				default:
+					applyGroupsVectorized<F, 0>(fStateVector.data(), groups, dimension, offsets, m, firstState);
+					break;
+			}
+			return;
+		}
+
+		// scalar kernel for the remaining cases, the states of a group are closer than four states apart
+		uint16_t *data = fStateVector.data();
+		size_t minGroupsPerThread = std::max<size_t>(1, Kernels::DenseGateWorkPerThread / (dimension * dimension));
+		parallelFor(groups, minGroupsPerThread, [&](size_t begin, size_t end) {
+			std::vector<std::complex<float>> group(dimension);
+			for (size_t g = begin; g < end; ++g) {
+				size_t state = firstState(g);
+
+				for (size_t j = 0; j < dimension; ++j) {
+					size_t index = 2 * (state + offsets[j]);
+					group[j] = {toFloat<F>(data[index]), toFloat<F>(data[index + 1])};
+				}
+
+				for (size_t r = 0; r < dimension; ++r) {
+					std::complex<float> value = 0;
+					for (size_t c = 0; c < dimension; ++c)
+						value += m[r * dimension + c] * group[c];
+
+					size_t index = 2 * (state + offsets[r]);
+					data[index] = fromFloat<F>(value.real());
+					data[index + 1] = fromFloat<F>(value.imag());
+				}
+			}
+		});
+	}
+
+	template<HalfFormat F>
+	void HalfPrecisionQuantumRegister::applyNamedGate(StandardGate gate, std::array<size_t, 2> qubits,
+													  complex_t factor) {
+		uint16_t *data = fStateVector.data();
+		size_t bit0 = 1ULL << qubits[0];
+		size_t bit1 = 1ULL << qubits[1];
+
+		__m256 re, im;
+		broadcast4({factor, factor, factor, factor}, re, im);
+
+		switch (gate) {
+			case StandardGate::PauliX:
+				Kernels::forEachPair(fNumStates, qubits[0], [=](size_t i) { swapStates(data, i, i | bit0); });
+				break;
+			case StandardGate::PauliY:
+				// Y|0> = i|1>, Y|1> = -i|0>, i.e. the parts are exchanged and one of them negated, which is exact
+				Kernels::forEachPair(fNumStates, qubits[0], [=](size_t i) {
+					uint16_t *a0 = data + 2 * i;
+					uint16_t *a1 = data + 2 * (i | bit0);
+					uint16_t re0 = a0[0];
+					uint16_t im0 = a0[1];
+					a0[0] = a1[1];
+					a0[1] = a1[0] ^ SignBit;
+					a1[0] = im0 ^ SignBit;
+					a1[1] = re0;
+				});
+				break;
+			case StandardGate::Hadamard:
+				// runs of the lowest two qubits are too short for the vector kernel, the dense one permutes lanes
+				if (qubits[0] < 2 && fNumStates >= 4) {
+					applyLowQubitVectorized<F>(data, fNumStates, qubits[0], Gates::Hadamard<float>.data());
+					break;
+				}
+				Kernels::forEachPairRun(fNumStates, qubits[0], [=](size_t begin, size_t end) {
+					hadamardRun<F>(data, begin, end, bit0);
+				});
+				break;
+			case StandardGate::Phase:
+				Kernels::forEachPairRun(fNumStates, qubits[0], [=](size_t begin, size_t end) {
+					multiplyRun<F>(data, begin, end, bit0, re, im, factor);
+				});
+				break;
+			case StandardGate::ControlledX:
+				Kernels::forEachQuad(fNumStates, qubits[0], qubits[1], [=](size_t i) {
+					swapStates(data, i | bit1, i | bit1 | bit0);
+				});
+				break;
+			case StandardGate::ControlledPhase:
+				Kernels::forEachQuadRun(fNumStates, qubits[0], qubits[1], [=](size_t begin, size_t end) {
+					multiplyRun<F>(data, begin, end, bit0 | bit1, re, im, factor);
+				});
+				break;
+			case StandardGate::Swap:
+				Kernels::forEachQuad(fNumStates, qubits[0], qubits[1], [=](size_t i) {
+					swapStates(data, i | bit0, i | bit1);
+				});
+				break;
+		}
+	}
+
+	template<HalfFormat F>
+	void HalfPrecisionQuantumRegister::widen(size_t offset, std::span<complex_t> chunk) const {
+		// the scale is a power of two, so removing it is exact
+		float scale = std::ldexp(1.0f, -fScaleExponent);
+		__m256 scales = _mm256_set1_ps(scale);
+
+		size_t i = 0;
+		alignas(32) float values[8];
+		for (; i + 4 <= chunk.size(); i += 4) {
+			_mm256_store_ps(values, _mm256_mul_ps(load4<F>(fStateVector.data() + 2 * (offset + i)), scales));
+			for (size_t j = 0; j < 4; ++j)
+				chunk[i + j] = complex_t(values[2 * j], values[2 * j + 1]);
+		}
+
+		for (; i < chunk.size(); ++i)
+			chunk[i] = complex_t(toFloat<F>(fStateVector[2 * (offset + i)]) * scale,
+								 toFloat<F>(fStateVector[2 * (offset + i) + 1]) * scale);
+	}
+}
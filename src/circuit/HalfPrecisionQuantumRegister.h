@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <array>
+#include "../types.h"
+#include "QuantumLogicGate.h"
+#include "QuantumRegister.h"
+
+namespace KQS::Circuit {
+
+	/** 16-bit floating point format of the amplitudes stored in HalfPrecisionQuantumRegister. */
+	enum class HalfFormat {
+		/** IEEE 754 half precision, 10-bit mantissa. */
+		FP16,
+		/** bfloat16, the upper half of a float, 7-bit mantissa. */
+		BF16
+	};
+
+	/**
+	 * Quantum register storing the amplitudes as pairs of 16-bit floats. Gates widen the amplitudes to floats
+	 * using SIMD instructions, compute in single precision and round the results back, so the state vector takes
+	 * half of the memory and bandwidth of the single precision registers at the cost of fidelity. The named gates
+	 * have dedicated kernels: X, Y, CNOT and Swap only move and flip the sign bits of the 16-bit values, H and the
+	 * phases convert just the states they change. All kernels are distributed over threads.
+	 *
+	 * IEEE half precision has normal numbers only down to 2^-14, while the amplitudes of a uniform superposition
+	 * of n qubits are 2^(-n/2). FP16 amplitudes are therefore stored multiplied by 2^scaleExponent(), chosen so that
+	 * the square root of the stored norm is 2^14: no stored value can exceed 2^14 under unitary gates, and
+	 * amplitudes stay normal down to 2^-28, i.e. uniform superpositions keep full precision up to 56 qubits. Gates
+	 * are linear, so the kernels work on the scaled values; only conversions to and from single precision apply the
+	 * scale. Non-unitary gates, e.g. collapsing Kraus operators, change the norm, so the exponent is chosen again
+	 * around them. bfloat16 has the exponent range of float and is not scaled.
+	 */
+	class HalfPrecisionQuantumRegister : public QuantumRegister<float> {
+	protected:
+		HalfFormat fFormat;
+		/** Real and imaginary parts of the amplitudes, interleaved. */
+		std::vector<uint16_t> fStateVector;
+		/** The stored values are the amplitudes times 2^fScaleExponent, always zero for bfloat16. */
+		int fScaleExponent = 0;
+
+		/** Exponent of the square root of the stored norm of FP16 states. */
+		static constexpr int StoredNormExponent = 14;
+
+	public:
+		explicit HalfPrecisionQuantumRegister(size_t numberOfQubits, HalfFormat format = HalfFormat::FP16);
+
+		HalfFormat format() const;
+
+		/** Returns the exponent of the power of two the stored amplitudes are multiplied by. */
+		int scaleExponent() const;
+
+	protected:
+		void setPhysicalStateVector(const std::vector<complex_t> &stateVector) override;
+		std::vector<complex_t> physicalStateVector() const override;
+		void readPhysicalStateVector(const StateChunkCallback &callback) const override;
+		std::vector<std::complex<double>> physicalReducedDensityMatrix(const std::vector<size_t> &qubits) const override;
+
+		void applyOneQubitGate(const SmallMatrix<float, 2> &matrix, size_t targetQubit) override;
+		void applyTwoQubitGate(const SmallMatrix<float, 4> &matrix, std::array<size_t, 2> targetQubits) override;
+		void applyKQubitGate(const QuantumLogicGate<float> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor) override;
+		void permutePhysicalQubits(const std::vector<size_t> &permutation) override;
+		size_t bytesPerState() const override;
+
+	private:
+		/** Applies a gate given by its elements in row-major order. */
+		void applyMatrix(std::span<const complex_t> matrix, const std::vector<size_t> &targetQubits);
+
+		/**
+		 * Chooses the scale exponent of FP16 storage again for the current norm, multiplied by the growth, and
+		 * rescales the stored values. Multiplying by powers of two is exact for normal numbers.
+		 * @param growth bound on the factor the squared norm grows by in the next gate, one after the gate
+		 */
+		void rescale(double growth = 1);
+
+		/** Sum of the squares of the stored values. */
+		double storedNorm() const;
+
+		/** Exponent for which the stored norm of amplitudes with the squared norm is 4^StoredNormExponent. */
+		static int scaleExponentFor(double norm);
+
+		template<HalfFormat F>
+		void applyGate(std::span<const complex_t> matrix, const std::vector<size_t> &targetQubits);
+
+		template<HalfFormat F>
+		void applyNamedGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor);
+
+		template<HalfFormat F>
+		void widen(size_t offset, std::span<complex_t> chunk) const;
+	};
+}
@@ -0,0 +1,118 @@
+#include <bit>
+#include <cmath>
+#include <format>
+#include "KrausChannel.h"
+
+namespace KQS::Circuit {
+
+	namespace {
+		template<typename T>
+		void checkProbability(T probability) {
+			if (!(probability >= 0 && probability <= 1))
+				throw std::runtime_error(std::format("Probability {} of channel is not in [0, 1]", probability));
+		}
+	}
+
+	template<typename T>
+	KrausChannel<T>::KrausChannel(std::vector<ComplexMatrix<T>> operators)
+			: fNumQubits(0), fOperators(std::move(operators)), fSuperoperator(makeSuperoperator(fOperators)) {
+		fNumQubits = std::countr_zero(fOperators[0].rows());
+	}
+
+	template<typename T>
+	size_t KrausChannel<T>::qubits() const {
+		return fNumQubits;
+	}
+
+	template<typename T>
+	const std::vector<ComplexMatrix<T>> &KrausChannel<T>::operators() const {
+		return fOperators;
+	}
+
+	template<typename T>
+	const QuantumLogicGate<T> &KrausChannel<T>::superoperator() const {
+		return fSuperoperator;
+	}
+
+	template<typename T>
+	QuantumLogicGate<T> KrausChannel<T>::makeSuperoperator(const std::vector<ComplexMatrix<T>> &operators) {
+		if (operators.empty())
+			throw std::runtime_error("Kraus channel needs at least one operator");
+
+		size_t dimension = operators[0].rows();
+		if (!std::has_single_bit(dimension))
+			throw std::runtime_error(std::format("Kraus operator of size {} does not act on qubits", dimension));
+
+		ComplexMatrix<T> completeness(dimension, dimension);
+		ComplexMatrix<T> superoperator(dimension * dimension, dimension * dimension);
+		for (const auto &op: operators) {
+			if (op.rows() != dimension || op.columns() != dimension)
+				throw std::runtime_error(std::format("Kraus operators of sizes {}x{} and {}x{} cannot be combined",
+													 op.rows(), op.columns(), dimension, dimension));
+
+			ComplexMatrix<T> product = op.adjoint() * op;
+			ComplexMatrix<T> term = op.conjugate().kronecker(op);
+			for (size_t i = 0; i < dimension; ++i)
+				for (size_t j = 0; j < dimension; ++j)
+					completeness[i, j, completeness[i, j] + product[i, j]];
+			for (size_t i = 0; i < term.rows(); ++i)
+				for (size_t j = 0; j < term.columns(); ++j)
+					superoperator[i, j, superoperator[i, j] + term[i, j]];
+		}
+
+		for (size_t i = 0; i < dimension; ++i)
+			for (size_t j = 0; j < dimension; ++j)
+				if (std::abs(completeness[i, j] - complex_t(i == j ? 1 : 0)) > CompletenessTolerance)
+					throw std::runtime_error("Kraus operators are not complete, the channel does not preserve the trace");
+
+		return QuantumLogicGate<T>(superoperator);
+	}
+
+	/// Standard channels ///
+
+	template<typename T>
+	KrausChannel<T> KrausChannel<T>::depolarizing(real_t probability) {
+		checkProbability(probability);
+		real_t identity = std::sqrt(1 - probability);
+		real_t pauli = std::sqrt(probability / 3);
+		return KrausChannel({ComplexMatrix<T>{{identity, 0}, {0, identity}},
+							 ComplexMatrix<T>{{0, pauli}, {pauli, 0}},
+							 ComplexMatrix<T>{{0, complex_t(0, -pauli)}, {complex_t(0, pauli), 0}},
+							 ComplexMatrix<T>{{pauli, 0}, {0, -pauli}}});
+	}
+
+	template<typename T>
+	KrausChannel<T> KrausChannel<T>::amplitudeDamping(real_t gamma) {
+		checkProbability(gamma);
+		return KrausChannel({ComplexMatrix<T>{{1, 0}, {0, std::sqrt(1 - gamma)}},
+							 ComplexMatrix<T>{{0, std::sqrt(gamma)}, {0, 0}}});
+	}
+
+	template<typename T>
+	KrausChannel<T> KrausChannel<T>::phaseDamping(real_t lambda) {
+		checkProbability(lambda);
+		return KrausChannel({ComplexMatrix<T>{{1, 0}, {0, std::sqrt(1 - lambda)}},
+							 ComplexMatrix<T>{{0, 0}, {0, std::sqrt(lambda)}}});
+	}
+
+	template<typename T>
+	KrausChannel<T> KrausChannel<T>::bitFlip(real_t probability) {
+		checkProbability(probability);
+		real_t identity = std::sqrt(1 - probability);
+		real_t flip = std::sqrt(probability);
+		return KrausChannel({ComplexMatrix<T>{{identity, 0}, {0, identity}},
+							 ComplexMatrix<T>{{0, flip}, {flip, 0}}});
+	}
+
+	template<typename T>
+	KrausChannel<T> KrausChannel<T>::phaseFlip(real_t probability) {
+		checkProbability(probability);
+		real_t identity = std::sqrt(1 - probability);
+		real_t flip = std::sqrt(probability);
+		return KrausChannel({ComplexMatrix<T>{{identity, 0}, {0, identity}},
+							 ComplexMatrix<T>{{flip, 0}, {0, -flip}}});
+	}
+
+	template class KrausChannel<float>;
+	template class KrausChannel<double>;
+}
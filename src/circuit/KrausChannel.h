@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include <limits>
+#include "../types.h"
+#include "../algebra/Matrix.h"
+#include "QuantumLogicGate.h"
+
+namespace KQS::Circuit {
+
+	/**
+	 * Quantum channel on k qubits given by its Kraus operators K_i, mapping a density matrix rho to
+	 * sum_i K_i rho K_i^+. The operators must be complete, sum_i K_i^+ K_i = I, so that the channel preserves the
+	 * trace.
+	 * @tparam T type of the real and imaginary parts of the operator elements
+	 */
+	template<typename T>
+	class KrausChannel {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+
+		/** Maximal deviation of sum_i K_i^+ K_i from the identity. */
+		static constexpr real_t CompletenessTolerance = 1024 * std::numeric_limits<real_t>::epsilon();
+
+	private:
+		size_t fNumQubits;
+		std::vector<ComplexMatrix<T>> fOperators;
+		/** Superoperator as a gate on the 2k qubits of vec(rho), see superoperator(). */
+		QuantumLogicGate<T> fSuperoperator;
+
+	public:
+		/**
+		 * Creates the channel and precomputes its superoperator.
+		 * @param operators complete Kraus operators, square matrices of the same size 2^k
+		 */
+		explicit KrausChannel(std::vector<ComplexMatrix<T>> operators);
+
+		size_t qubits() const;
+		const std::vector<ComplexMatrix<T>> &operators() const;
+
+		/**
+		 * Returns the superoperator sum_i conj(K_i) (x) K_i, the action of the channel on the vectorized density
+		 * matrix, whose element (r, c) is at r + 2^n c. As a gate its first k qubits are the qubits of the channel
+		 * (the row index) and the last k their copies in the column index, so the whole channel is applied in one
+		 * pass over vec(rho).
+		 */
+		const QuantumLogicGate<T> &superoperator() const;
+
+		/** Depolarizing channel, with the given probability one of X, Y and Z is applied, each equally likely. */
+		static KrausChannel depolarizing(real_t probability);
+
+		/** Amplitude damping, |1> decays to |0> with the given probability. */
+		static KrausChannel amplitudeDamping(real_t gamma);
+
+		/** Phase damping, the coherences are multiplied by sqrt(1 - lambda). */
+		static KrausChannel phaseDamping(real_t lambda);
+
+		/** Applies X with the given probability. */
+		static KrausChannel bitFlip(real_t probability);
+
+		/** Applies Z with the given probability. */
+		static KrausChannel phaseFlip(real_t probability);
+
+	private:
+		static QuantumLogicGate<T> makeSuperoperator(const std::vector<ComplexMatrix<T>> &operators);
+	};
+}
@@ -0,0 +1,615 @@
+#include <cmath>
+#include <format>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include "MPSRegister.h"
+#include "QubitPermutation.h"
+#include "../algebra/SVD.h"
+#include "../parallel.h"
+
+namespace KQS::Circuit {
+
+	namespace {
+		/**
+		 * Multiplies row-major matrices.
+		 * @return row-major rows x columns product
+		 */
+		template<typename T>
+		std::vector<std::complex<T>> multiply(const std::complex<T> *a, const std::complex<T> *b, size_t rows,
+											  size_t inner, size_t columns) {
+			std::vector<std::complex<T>> result(rows * columns);
+			for (size_t i = 0; i < rows; ++i) {
+				std::complex<T> *row = &result[i * columns];
+				for (size_t k = 0; k < inner; ++k) {
+					std::complex<T> factor = a[i * inner + k];
+					if (factor == std::complex<T>(0))
+						continue;
+					const std::complex<T> *other = &b[k * columns];
+					for (size_t j = 0; j < columns; ++j)
+						row[j] = Algebra::multiplyAdd(factor, other[j], row[j]);
+				}
+			}
+			return result;
+		}
+
+		/** Conjugate transpose of a row-major matrix. */
+		template<typename T>
+		std::vector<std::complex<T>> adjoint(const std::vector<std::complex<T>> &matrix, size_t rows, size_t columns) {
+			std::vector<std::complex<T>> result(rows * columns);
+			for (size_t i = 0; i < rows; ++i)
+				for (size_t j = 0; j < columns; ++j)
+					result[j * rows + i] = std::conj(matrix[i * columns + j]);
+			return result;
+		}
+
+		/**
+		 * Extends the left environment of a site, the contraction of the sites left of it with their conjugates, by
+		 * the site with an optional operator between the tensor and its conjugate.
+		 * @param environment row-major left x left matrix, element (l, l') contracts the conjugate at l and the
+		 * tensor at l'
+		 * @param tensor tensor of the site
+		 * @param op one-qubit operator or null for the identity
+		 * @return right x right environment of the next site
+		 */
+		template<typename T>
+		std::vector<std::complex<T>> leftTransfer(const std::vector<std::complex<T>> &environment,
+												  const std::vector<std::complex<T>> &tensor, size_t left,
+												  size_t right, const Algebra::SmallMatrix<T, 2> *op) {
+			// x(l, s', r') = sum_l' E(l, l') A(l', s', r')
+			std::vector<std::complex<T>> x = multiply(environment.data(), tensor.data(), left, left, 2 * right);
+			if (op != nullptr) {
+				for (size_t l = 0; l < left; ++l) {
+					for (size_t r = 0; r < right; ++r) {
+						std::complex<T> &zero = x[(l * 2) * right + r];
+						std::complex<T> &one = x[(l * 2 + 1) * right + r];
+						std::complex<T> a = zero;
+						std::complex<T> b = one;
+						zero = (*op)[0, 0] * a + (*op)[0, 1] * b;
+						one = (*op)[1, 0] * a + (*op)[1, 1] * b;
+					}
+				}
+			}
+
+			// E'(r, r') = sum_{l, s} conj(A(l, s, r)) x(l, s, r')
+			std::vector<std::complex<T>> result(right * right);
+			for (size_t ls = 0; ls < 2 * left; ++ls) {
+				for (size_t r = 0; r < right; ++r) {
+					std::complex<T> factor = std::conj(tensor[ls * right + r]);
+					if (factor == std::complex<T>(0))
+						continue;
+					for (size_t r2 = 0; r2 < right; ++r2)
+						result[r * right + r2] = Algebra::multiplyAdd(factor, x[ls * right + r2], result[r * right + r2]);
+				}
+			}
+			return result;
+		}
+
+		/**
+		 * Extends the right environment of a site by the site.
+		 * @param environment row-major right x right matrix, element (r, r') contracts the conjugate at r and the
+		 * tensor at r'
+		 * @return left x left environment of the previous site
+		 */
+		template<typename T>
+		std::vector<std::complex<T>> rightTransfer(const std::vector<std::complex<T>> &environment,
+												   const std::vector<std::complex<T>> &tensor, size_t left,
+												   size_t right) {
+			// x(l', s, r) = sum_r' A(l', s, r') F(r, r')
+			std::vector<std::complex<T>> x(2 * left * right);
+			for (size_t ls = 0; ls < 2 * left; ++ls)
+				for (size_t r = 0; r < right; ++r)
+					for (size_t r2 = 0; r2 < right; ++r2)
+						x[ls * right + r] += tensor[ls * right + r2] * environment[r * right + r2];
+
+			// F'(l, l') = sum_{s, r} conj(A(l, s, r)) x(l', s, r)
+			std::vector<std::complex<T>> result(left * left);
+			for (size_t l = 0; l < left; ++l)
+				for (size_t l2 = 0; l2 < left; ++l2)
+					for (size_t sr = 0; sr < 2 * right; ++sr)
+						result[l * left + l2] += std::conj(tensor[l * 2 * right + sr]) * x[l2 * 2 * right + sr];
+			return result;
+		}
+
+		/**
+		 * Number of singular values kept by a split.
+		 * @param singularValues singular values in decreasing order
+		 * @param maxCount maximal number of values kept
+		 * @param threshold maximal fraction of the total weight dropped, besides the values beyond maxCount
+		 * @param dropped set to the dropped weight
+		 * @param total set to the total weight
+		 */
+		template<typename T>
+		size_t keptValues(const std::vector<T> &singularValues, size_t maxCount, double threshold, double &dropped,
+						  double &total) {
+			total = 0;
+			for (T value: singularValues)
+				total += static_cast<double>(value) * value;
+
+			// values that are zero to working precision are always dropped
+			T zero = singularValues[0] * std::numeric_limits<T>::epsilon();
+			size_t keep = std::min(singularValues.size(), maxCount);
+			while (keep > 1 && singularValues[keep - 1] <= zero)
+				--keep;
+
+			dropped = 0;
+			for (size_t n = keep; n < singularValues.size(); ++n)
+				dropped += static_cast<double>(singularValues[n]) * singularValues[n];
+			while (keep > 1) {
+				double weight = static_cast<double>(singularValues[keep - 1]) * singularValues[keep - 1];
+				if (dropped + weight > threshold * total)
+					break;
+				dropped += weight;
+				--keep;
+			}
+			return keep;
+		}
+
+		/** Whether the matrix is unitary, so that applying it to a site keeps the canonical form. */
+		template<typename T>
+		bool isUnitary(const Algebra::SmallMatrix<T, 2> &matrix) {
+			constexpr T tolerance = 1024 * std::numeric_limits<T>::epsilon();
+			for (size_t i = 0; i < 2; ++i) {
+				for (size_t j = 0; j < 2; ++j) {
+					std::complex<T> product = std::conj(matrix[0, i]) * matrix[0, j] +
+											  std::conj(matrix[1, i]) * matrix[1, j];
+					if (std::abs(product - std::complex<T>(i == j ? 1 : 0)) > tolerance)
+						return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	template<typename T>
+	MPSRegister<T>::MPSRegister(size_t numberOfQubits, size_t maxBondDimension, real_t truncationThreshold)
+			: QuantumRegister<T>(numberOfQubits), fMaxBondDimension(maxBondDimension),
+			  fTruncationThreshold(truncationThreshold), fTensors(numberOfQubits, {1, 0}),
+			  fBonds(numberOfQubits + 1, 1), fSites(numberOfQubits) {
+		if (numberOfQubits == 0)
+			throw std::runtime_error("Matrix product state needs at least one qubit");
+		if (maxBondDimension == 0)
+			throw std::runtime_error("Maximal bond dimension must be at least 1");
+
+		resetSites();
+	}
+
+	template<typename T>
+	size_t MPSRegister<T>::maxBondDimension() const {
+		return fMaxBondDimension;
+	}
+
+	template<typename T>
+	T MPSRegister<T>::truncationThreshold() const {
+		return fTruncationThreshold;
+	}
+
+	template<typename T>
+	size_t MPSRegister<T>::bondDimension() const {
+		return *std::ranges::max_element(fBonds);
+	}
+
+	template<typename T>
+	double MPSRegister<T>::truncationError() const {
+		return 1 - fFidelity;
+	}
+
+	/// Contractions ///
+
+	template<typename T>
+	T MPSRegister<T>::norm() const {
+		std::vector<complex_t> environment{1};
+		for (size_t k = 0; k < fNumQubits; ++k)
+			environment = leftTransfer<T>(environment, fTensors[k], fBonds[k], fBonds[k + 1], nullptr);
+		return environment[0].real();
+	}
+
+	template<typename T>
+	std::complex<T> MPSRegister<T>::expectation(const std::vector<size_t> &qubits,
+												const std::vector<SmallMatrix<T, 2>> &operators) const {
+		if (qubits.size() != operators.size())
+			throw std::runtime_error(std::format("Expectation of {} operators cannot be computed on {} qubits",
+												 operators.size(), qubits.size()));
+
+		std::vector<const SmallMatrix<T, 2> *> siteOperators(fNumQubits);
+		for (size_t i = 0; i < qubits.size(); ++i) {
+			if (qubits[i] >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Cannot apply operator to qubit {} in {}-qubit register", qubits[i], fNumQubits));
+
+			size_t site = fSites[fQubitMap[qubits[i]]];
+			if (siteOperators[site] != nullptr)
+				throw std::runtime_error(std::format("Cannot apply operator twice to qubit {}", qubits[i]));
+			siteOperators[site] = &operators[i];
+		}
+
+		std::vector<complex_t> environment{1};
+		for (size_t k = 0; k < fNumQubits; ++k)
+			environment = leftTransfer<T>(environment, fTensors[k], fBonds[k], fBonds[k + 1], siteOperators[k]);
+		return environment[0] / norm();
+	}
+
+	template<typename T>
+	std::vector<T> MPSRegister<T>::physicalMarginals() const {
+		// right environments of all sites, then the left ones are built while sweeping over the sites
+		std::vector<std::vector<complex_t>> rightEnvironments(fNumQubits + 1);
+		rightEnvironments[fNumQubits] = {1};
+		for (size_t k = fNumQubits; k-- > 0;)
+			rightEnvironments[k] = rightTransfer<T>(rightEnvironments[k + 1], fTensors[k], fBonds[k], fBonds[k + 1]);
+		real_t total = rightEnvironments[0][0].real();
+
+		std::vector<real_t> siteMarginals(fNumQubits);
+		static constexpr SmallMatrix<T, 2> projector{{0, 0}, {0, 1}};
+		std::vector<complex_t> environment{1};
+		for (size_t k = 0; k < fNumQubits; ++k) {
+			std::vector<complex_t> projected = leftTransfer<T>(environment, fTensors[k], fBonds[k], fBonds[k + 1],
+															   &projector);
+			const std::vector<complex_t> &right = rightEnvironments[k + 1];
+			complex_t probability = 0;
+			for (size_t i = 0; i < projected.size(); ++i)
+				probability += projected[i] * right[i];
+			siteMarginals[k] = probability.real() / total;
+
+			environment = leftTransfer<T>(environment, fTensors[k], fBonds[k], fBonds[k + 1], nullptr);
+		}
+
+		std::vector<real_t> result(fNumQubits);
+		for (size_t p = 0; p < fNumQubits; ++p)
+			result[p] = siteMarginals[fSites[p]];
+		return result;
+	}
+
+	/// Sampling ///
+
+	template<typename T>
+	MPSRegister<T> MPSRegister<T>::canonicalForSampling() const {
+		MPSRegister copy(*this);
+		copy.moveCenter(fNumQubits - 1);
+		return copy;
+	}
+
+	template<typename T>
+	template<typename F>
+	std::vector<bool> MPSRegister<T>::sampleSites(F &&choose) const {
+		// the sites left of the center are left-canonical, so the probability of the values of the sites sampled so
+		// far is the squared norm of the contraction of their tensors with the remaining ones
+		std::vector<bool> values(fNumQubits);
+		std::vector<complex_t> vector{1};
+		for (size_t k = fNumQubits; k-- > 0;) {
+			size_t left = fBonds[k];
+			size_t right = fBonds[k + 1];
+			const std::vector<complex_t> &tensor = fTensors[k];
+
+			std::array<std::vector<complex_t>, 2> branches{std::vector<complex_t>(left), std::vector<complex_t>(left)};
+			std::array<double, 2> probabilities{};
+			for (size_t s = 0; s < 2; ++s) {
+				for (size_t l = 0; l < left; ++l) {
+					complex_t sum = 0;
+					for (size_t r = 0; r < right; ++r)
+						sum += tensor[(l * 2 + s) * right + r] * vector[r];
+					branches[s][l] = sum;
+					probabilities[s] += std::norm(sum);
+				}
+			}
+
+			double total = probabilities[0] + probabilities[1];
+			bool value = choose(total > 0 ? probabilities[0] / total : 1.0);
+			values[k] = value;
+
+			auto scale = static_cast<real_t>(1 / std::sqrt(probabilities[value]));
+			vector = std::move(branches[value]);
+			for (complex_t &element: vector)
+				element *= scale;
+		}
+		return values;
+	}
+
+	template<typename T>
+	std::vector<size_t> MPSRegister<T>::samplePhysical(std::span<const real_t> randomNumbers) const {
+		checkIndexable();
+		MPSRegister canonical = canonicalForSampling();
+
+		std::vector<size_t> samples(randomNumbers.size());
+		parallelFor(samples.size(), 16, [&](size_t begin, size_t end) {
+			for (size_t shot = begin; shot < end; ++shot) {
+				// the random number is rescaled to the interval of the chosen value, so it selects the value of every
+				// site in turn
+				double number = randomNumbers[shot];
+				std::vector<bool> values = canonical.sampleSites([&number](double zeroProbability) {
+					if (number < zeroProbability) {
+						number /= zeroProbability;
+						return false;
+					}
+					number = zeroProbability < 1 ? std::min((number - zeroProbability) / (1 - zeroProbability), 1.0) : 0;
+					return true;
+				});
+
+				size_t sample = 0;
+				for (size_t p = 0; p < fNumQubits; ++p)
+					sample |= static_cast<size_t>(values[fSites[p]]) << p;
+				samples[shot] = sample;
+			}
+		});
+		return samples;
+	}
+
+	template<typename T>
+	std::vector<typename MPSRegister<T>::Outcome> MPSRegister<T>::sampleOutcomes(size_t shots,
+																				 std::mt19937_64 &random) const {
+		MPSRegister canonical = canonicalForSampling();
+
+		// every site gets its own random number, a single rescaled number runs out of precision after 53 sites
+		std::uniform_real_distribution<double> distribution;
+		std::vector<size_t> siteOfQubit(fNumQubits);
+		for (size_t q = 0; q < fNumQubits; ++q)
+			siteOfQubit[q] = fSites[fQubitMap[q]];
+
+		std::vector<Outcome> outcomes(shots, Outcome((fNumQubits + 63) / 64));
+		for (Outcome &outcome: outcomes) {
+			std::vector<bool> values = canonical.sampleSites([&](double zeroProbability) {
+				return distribution(random) >= zeroProbability;
+			});
+			for (size_t q = 0; q < fNumQubits; ++q)
+				outcome[q / 64] |= static_cast<uint64_t>(values[siteOfQubit[q]]) << (q % 64);
+		}
+		return outcomes;
+	}
+
+	/// Physical state ///
+
+	template<typename T>
+	void MPSRegister<T>::setPhysicalStateVector(const std::vector<complex_t> &stateVector) {
+		checkIndexable();
+		if (stateVector.size() != fNumStates)
+			throw std::runtime_error(std::format("State vector of size {} cannot be set to {}-qubit register",
+												 stateVector.size(), fNumQubits));
+
+		resetSites();
+		fFidelity = 1;
+		std::ranges::fill(fBonds, 1);
+
+		// the tensor of all sites has the first site most significant, the state vector the first qubit least
+		std::vector<size_t> reversed(fNumQubits);
+		for (size_t q = 0; q < fNumQubits; ++q)
+			reversed[q] = fNumQubits - 1 - q;
+		QubitPermutation toState(reversed);
+
+		std::vector<complex_t> theta(fNumStates);
+		for (size_t i = 0; i < fNumStates; ++i)
+			theta[i] = stateVector[toState(i)];
+		splitSites(std::move(theta), 0, fNumQubits);
+	}
+
+	template<typename T>
+	std::vector<std::complex<T>> MPSRegister<T>::physicalStateVector() const {
+		checkIndexable();
+
+		// contraction of the first sites with their values as row index, the first site most significant
+		std::vector<complex_t> contracted = fTensors[0];
+		for (size_t k = 1; k < fNumQubits; ++k)
+			contracted = multiply(contracted.data(), fTensors[k].data(), 1ULL << k, fBonds[k], 2 * fBonds[k + 1]);
+
+		std::vector<size_t> bits(fNumQubits);
+		for (size_t p = 0; p < fNumQubits; ++p)
+			bits[p] = fNumQubits - 1 - fSites[p];
+		QubitPermutation toContracted(bits);
+
+		std::vector<complex_t> result(fNumStates);
+		for (size_t i = 0; i < fNumStates; ++i)
+			result[i] = contracted[toContracted(i)];
+		return result;
+	}
+
+	template<typename T>
+	void MPSRegister<T>::permutePhysicalQubits(const std::vector<size_t> &permutation) {
+		std::vector<size_t> sites(fNumQubits);
+		for (size_t q = 0; q < fNumQubits; ++q)
+			sites[permutation[q]] = fSites[q];
+		fSites = std::move(sites);
+	}
+
+	template<typename T>
+	size_t MPSRegister<T>::bytesPerState() const {
+		return 0;
+	}
+
+	/// Gates ///
+
+	template<typename T>
+	void MPSRegister<T>::applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) {
+		size_t site = fSites[targetQubit];
+
+		// other gates change the norm of the site, which has to be the center to keep the other sites canonical
+		if (!isUnitary(matrix))
+			moveCenter(site);
+
+		std::vector<complex_t> &tensor = fTensors[site];
+		size_t left = fBonds[site];
+		size_t right = fBonds[site + 1];
+		for (size_t l = 0; l < left; ++l) {
+			for (size_t r = 0; r < right; ++r) {
+				complex_t &zero = tensor[(l * 2) * right + r];
+				complex_t &one = tensor[(l * 2 + 1) * right + r];
+				std::array<complex_t, 2> result = matrix * std::array{zero, one};
+				zero = result[0];
+				one = result[1];
+			}
+		}
+	}
+
+	template<typename T>
+	void MPSRegister<T>::applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) {
+		applyLocalGate(matrix.data(), {targetQubits[0], targetQubits[1]});
+	}
+
+	template<typename T>
+	void MPSRegister<T>::applyKQubitGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
+		applyLocalGate(gate.matrix().data(), targetQubits);
+	}
+
+	template<typename T>
+	void MPSRegister<T>::applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor) {
+		if (gate == StandardGate::Swap) {
+			std::swap(fSites[qubits[0]], fSites[qubits[1]]);
+			return;
+		}
+		QuantumRegister<T>::applyStandardGate(gate, qubits, factor);
+	}
+
+	template<typename T>
+	void MPSRegister<T>::applyLocalGate(std::span<const complex_t> matrix, const std::vector<size_t> &qubits) {
+		size_t count = qubits.size();
+
+		// the sites of the qubits are moved next to the rightmost one, the sites in between move to the left; moving
+		// to the right leaves the center at the site of the next swap
+		std::vector<size_t> sorted(count);
+		for (size_t j = 0; j < count; ++j)
+			sorted[j] = fSites[qubits[j]];
+		std::ranges::sort(sorted);
+
+		size_t first = sorted[count - 1] + 1 - count;
+		for (size_t t = count - 1; t-- > 0;)
+			for (size_t site = sorted[t]; site < first + t; ++site)
+				swapSites(site);
+
+		moveCenter(first);
+		size_t left = fBonds[first];
+		size_t right = fBonds[first + count];
+		size_t dimension = 1ULL << count;
+
+		std::vector<complex_t> theta = fTensors[first];
+		for (size_t t = 1; t < count; ++t)
+			theta = multiply(theta.data(), fTensors[first + t].data(), left << t, fBonds[first + t],
+							 2 * fBonds[first + t + 1]);
+
+		// bit j of the gate index is the value of qubit j, the values of the sites have the first site most significant
+		std::vector<size_t> gateIndex(dimension);
+		for (size_t c = 0; c < dimension; ++c)
+			for (size_t j = 0; j < count; ++j)
+				gateIndex[c] |= ((c >> (count - 1 - (fSites[qubits[j]] - first))) & 1ULL) << j;
+
+		std::vector<complex_t> result(theta.size());
+		for (size_t l = 0; l < left; ++l) {
+			for (size_t c = 0; c < dimension; ++c) {
+				complex_t *row = &result[(l * dimension + c) * right];
+				for (size_t c2 = 0; c2 < dimension; ++c2) {
+					complex_t element = matrix[gateIndex[c] * dimension + gateIndex[c2]];
+					if (element == complex_t(0))
+						continue;
+					const complex_t *source = &theta[(l * dimension + c2) * right];
+					for (size_t r = 0; r < right; ++r)
+						row[r] = Algebra::multiplyAdd(element, source[r], row[r]);
+				}
+			}
+		}
+
+		splitSites(std::move(result), first, count);
+	}
+
+	template<typename T>
+	void MPSRegister<T>::swapSites(size_t site) {
+		moveCenter(site);
+		size_t left = fBonds[site];
+		size_t middle = fBonds[site + 1];
+		size_t right = fBonds[site + 2];
+
+		// theta(l, s1, s2, r) with the values exchanged
+		std::vector<complex_t> theta = multiply(fTensors[site].data(), fTensors[site + 1].data(), 2 * left, middle,
+												2 * right);
+		std::vector<complex_t> swapped(theta.size());
+		for (size_t l = 0; l < left; ++l)
+			for (size_t s1 = 0; s1 < 2; ++s1)
+				for (size_t s2 = 0; s2 < 2; ++s2)
+					std::copy_n(&theta[((l * 2 + s1) * 2 + s2) * right], right,
+								&swapped[((l * 2 + s2) * 2 + s1) * right]);
+		splitSites(std::move(swapped), site, 2);
+
+		for (size_t &qubitSite: fSites) {
+			if (qubitSite == site)
+				qubitSite = site + 1;
+			else if (qubitSite == site + 1)
+				qubitSite = site;
+		}
+	}
+
+	template<typename T>
+	void MPSRegister<T>::moveCenter(size_t site) {
+		while (fCenter < site) {
+			// A = Q R, Q stays and R moves into the next site
+			size_t left = fBonds[fCenter];
+			size_t right = fBonds[fCenter + 1];
+			auto qr = Algebra::qrDecomposition<T>(fTensors[fCenter], 2 * left, right);
+			size_t bond = std::min(2 * left, right);
+
+			fTensors[fCenter] = std::move(qr.q);
+			fTensors[fCenter + 1] = multiply(qr.r.data(), fTensors[fCenter + 1].data(), bond, right,
+											 2 * fBonds[fCenter + 2]);
+			fBonds[fCenter + 1] = bond;
+			++fCenter;
+		}
+
+		while (fCenter > site) {
+			// A = L Q from the decomposition A^+ = Q' R', Q = Q'^+ stays and L = R'^+ moves into the previous site
+			size_t left = fBonds[fCenter];
+			size_t right = fBonds[fCenter + 1];
+			auto qr = Algebra::qrDecomposition<T>(adjoint(fTensors[fCenter], left, 2 * right), 2 * right, left);
+			size_t bond = std::min(left, 2 * right);
+
+			fTensors[fCenter] = adjoint(qr.q, 2 * right, bond);
+			std::vector<complex_t> l = adjoint(qr.r, bond, left);
+			fTensors[fCenter - 1] = multiply(fTensors[fCenter - 1].data(), l.data(), 2 * fBonds[fCenter - 1], left,
+											 bond);
+			fBonds[fCenter] = bond;
+			--fCenter;
+		}
+	}
+
+	template<typename T>
+	void MPSRegister<T>::splitSites(std::vector<complex_t> theta, size_t first, size_t count) {
+		size_t left = fBonds[first];
+		for (size_t t = 0; t + 1 < count; ++t) {
+			size_t rows = 2 * left;
+			size_t columns = theta.size() / rows;
+			auto svd = Algebra::singularValueDecomposition<T>(theta, rows, columns);
+			size_t rank = svd.singularValues.size();
+
+			double dropped;
+			double total;
+			size_t keep = keptValues(svd.singularValues, fMaxBondDimension, fTruncationThreshold, dropped, total);
+			if (total > 0)
+				fFidelity *= 1 - dropped / total;
+
+			// the kept values are rescaled, so that the truncated state keeps the norm
+			auto scale = static_cast<real_t>(total > dropped ? std::sqrt(total / (total - dropped)) : 1);
+
+			std::vector<complex_t> u(rows * keep);
+			for (size_t i = 0; i < rows; ++i)
+				std::copy_n(&svd.u[i * rank], keep, &u[i * keep]);
+			fTensors[first + t] = std::move(u);
+			fBonds[first + t + 1] = keep;
+
+			theta.resize(keep * columns);
+			for (size_t n = 0; n < keep; ++n)
+				for (size_t c = 0; c < columns; ++c)
+					theta[n * columns + c] = svd.vh[n * columns + c] * (svd.singularValues[n] * scale);
+			left = keep;
+		}
+
+		fTensors[first + count - 1] = std::move(theta);
+		fCenter = first + count - 1;
+	}
+
+	template<typename T>
+	void MPSRegister<T>::resetSites() {
+		std::iota(fSites.begin(), fSites.end(), 0);
+	}
+
+	template<typename T>
+	void MPSRegister<T>::checkIndexable() const {
+		if (fNumStates == 0)
+			throw std::runtime_error(std::format("States of {}-qubit register cannot be indexed", fNumQubits));
+	}
+
+	template class MPSRegister<float>;
+	template class MPSRegister<double>;
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <array>
+#include "../types.h"
+#include "QuantumLogicGate.h"
+#include "QuantumRegister.h"
+
+namespace KQS::Circuit {
+
+	/**
+	 * Quantum register storing the state as a matrix product state: a chain of tensors, one per qubit, connected by
+	 * bonds of limited dimension. Memory and gate cost grow with the entanglement of the state instead of 2^n, so
+	 * low-entanglement circuits on many qubits (also more than 64, whose state vector cannot be indexed) can be
+	 * simulated.
+	 *
+	 * Gates are applied by contracting the tensors of their qubits, multiplying by the gate matrix and splitting the
+	 * result back by singular value decompositions, truncated to the maximal bond dimension and dropping singular
+	 * values whose weight is below the truncation threshold. Qubits of a gate that are not neighbours in the chain
+	 * are first moved next to each other by swaps of adjacent tensors; they stay there, the register only records on
+	 * which site of the chain every physical qubit is, like the qubit map records the physical qubit of every logical
+	 * one. The weight dropped by all truncations is reported by truncationError().
+	 *
+	 * Marginals, sampling and expectation values contract the chain directly and never build the state vector, which
+	 * is only built when it is read and needs fewer than 64 qubits.
+	 *
+	 * The register pays off only when the bond dimension stays small. A two-qubit gate costs an SVD of a
+	 * 2 bond x 2 bond matrix, and the one-sided Jacobi SVD takes several O(bond^3) sweeps. At the bond dimension of
+	 * an exact state, 2^(n/2), this is far slower than a state vector. On random 12-qubit circuits it is about 350
+	 * times slower than BasicQuantumRegister.
+	 * @tparam T type of the real and imaginary parts of the tensor elements
+	 */
+	template<typename T>
+	class MPSRegister : public QuantumRegister<T> {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+		using typename QuantumRegister<T>::StateChunkCallback;
+
+		/** Measured values of all logical qubits, bit q % 64 of word q / 64 holds qubit q. */
+		using Outcome = std::vector<uint64_t>;
+
+	protected:
+		using QuantumRegister<T>::fNumQubits;
+		using QuantumRegister<T>::fNumStates;
+		using QuantumRegister<T>::fQubitMap;
+
+		size_t fMaxBondDimension;
+		real_t fTruncationThreshold;
+
+		/**
+		 * Tensor of every site with indices (left bond, qubit value, right bond), element (l, s, r) is at
+		 * (l * 2 + s) * right + r.
+		 */
+		std::vector<std::vector<complex_t>> fTensors;
+		/** Dimension of the bond left of every site, the last entry is the bond right of the last site, always 1. */
+		std::vector<size_t> fBonds;
+		/** Site of every physical qubit. */
+		std::vector<size_t> fSites;
+		/** Orthogonality center, the tensors left of it are left-canonical and the ones right of it right-canonical. */
+		size_t fCenter = 0;
+
+		/** Product of the fractions of the norm kept by all truncations. */
+		double fFidelity = 1;
+
+	public:
+		/**
+		 * Creates the register in state |0...0>.
+		 * @param numberOfQubits number of qubits, not limited to 64
+		 * @param maxBondDimension maximal dimension of the bonds between adjacent sites
+		 * @param truncationThreshold maximal fraction of the squared norm dropped by a split of two sites, the
+		 * smallest singular values with a total weight below it are dropped even if the bond dimension allows them
+		 */
+		explicit MPSRegister(size_t numberOfQubits, size_t maxBondDimension = 64, real_t truncationThreshold = 1e-10);
+
+		size_t maxBondDimension() const;
+		real_t truncationThreshold() const;
+
+		/** Largest dimension of the bonds of the current state. */
+		size_t bondDimension() const;
+
+		/**
+		 * Estimated error of the state caused by the truncations since the state was set, one minus the product of the
+		 * fractions of the squared norm kept by every truncation. It bounds the infidelity of the state only
+		 * approximately, as the dropped weights of different splits are not exactly independent.
+		 */
+		double truncationError() const;
+
+		/**
+		 * Computes the expectation value of a product of one-qubit operators, e.g. the Pauli operators of a Pauli
+		 * string, by contracting the chain with the operators, without building the state vector.
+		 * @param qubits logical qubits of the operators, all different
+		 * @param operators operator of every qubit
+		 * @return <psi|O|psi> / <psi|psi>
+		 */
+		complex_t expectation(const std::vector<size_t> &qubits, const std::vector<SmallMatrix<T, 2>> &operators) const;
+
+		/**
+		 * Samples measurement outcomes of the whole register without collapsing the state, also for registers of more
+		 * than 64 qubits. Every shot samples the sites one by one from their conditional probabilities.
+		 * @param shots number of outcomes
+		 * @param random generator of the random numbers
+		 * @return sampled outcomes, one per shot
+		 */
+		std::vector<Outcome> sampleOutcomes(size_t shots, std::mt19937_64 &random) const;
+
+		real_t norm() const override;
+
+	protected:
+		void setPhysicalStateVector(const std::vector<complex_t> &stateVector) override;
+		std::vector<complex_t> physicalStateVector() const override;
+		std::vector<real_t> physicalMarginals() const override;
+
+		/**
+		 * Samples every shot site by site with a single random number, which is rescaled to the conditional
+		 * probability of the chosen value of every site, so the outcome is the state at which the cumulative
+		 * distribution exceeds it in the order of the sites.
+		 */
+		std::vector<size_t> samplePhysical(std::span<const real_t> randomNumbers) const override;
+
+		/** Only relabels the sites of the physical qubits, no tensor is touched. */
+		void permutePhysicalQubits(const std::vector<size_t> &permutation) override;
+
+		/** There is no state vector, profiled gates report no memory traffic. */
+		size_t bytesPerState() const override;
+
+		void applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) override;
+		void applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) override;
+		void applyKQubitGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+
+		/** Swaps only exchange the sites of the qubits. */
+		void applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor) override;
+
+	private:
+		/**
+		 * Applies a gate to adjacent sites after moving its qubits next to each other.
+		 * @param matrix row-major gate matrix, bit j of its indices is the value of qubit j
+		 * @param qubits physical qubits of the gate
+		 */
+		void applyLocalGate(std::span<const complex_t> matrix, const std::vector<size_t> &qubits);
+
+		/** Exchanges the qubits of the sites site and site + 1, leaving the center at site + 1. */
+		void swapSites(size_t site);
+
+		/** Moves the orthogonality center to the site by QR decompositions of the sites in between. */
+		void moveCenter(size_t site);
+
+		/**
+		 * Splits the tensor of the given sites into one tensor per site from left to right by truncated singular
+		 * value decompositions, leaving the center at the last of them.
+		 * @param theta tensor with indices (left bond, values of the sites with the first site most significant,
+		 * right bond)
+		 * @param first first of the sites
+		 * @param count number of sites
+		 */
+		void splitSites(std::vector<complex_t> theta, size_t first, size_t count);
+
+		/** Resets the sites of the physical qubits to the identity. */
+		void resetSites();
+
+		/** Throws if the register has too many qubits to index its states. */
+		void checkIndexable() const;
+
+		/**
+		 * Samples one shot site by site from the last to the first, the center must be at the last site.
+		 * @param choose function returning the value of a site given the probability of zero
+		 * @return value of every site
+		 */
+		template<typename F>
+		std::vector<bool> sampleSites(F &&choose) const;
+
+		/** Copy of the register with the orthogonality center at the last site, for sampling. */
+		MPSRegister canonicalForSampling() const;
+	};
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cstring>
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace KQS::Circuit {
+
+#ifdef __linux__
+	namespace {
+		int openCounter(uint32_t type, uint64_t config) {
+			perf_event_attr attributes;
+			std::memset(&attributes, 0, sizeof(attributes));
+			attributes.size = sizeof(attributes);
+			attributes.type = type;
+			attributes.config = config;
+			attributes.disabled = 1;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			// the calling thread on any CPU
+			int descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+			if (descriptor >= 0)
+				ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+			return descriptor;
+		}
+
+		constexpr uint64_t cacheEvent(uint64_t cache, uint64_t operation, uint64_t result) {
+			return cache | (operation << 8) | (result << 16);
+		}
+	}
+
+	PerfCounters::PerfCounters() {
+		fDescriptors[Cycles] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+		fDescriptors[Instructions] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+		// the generic cache miss event is the last level cache on x86, unlike PERF_COUNT_HW_CACHE_LL it exists on AMD
+		fDescriptors[LLCMisses] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+		fDescriptors[DTLBMisses] = openCounter(PERF_TYPE_HW_CACHE,
+											   cacheEvent(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+														  PERF_COUNT_HW_CACHE_RESULT_MISS));
+	}
+
+	PerfCounters::~PerfCounters() {
+		for (int descriptor: fDescriptors)
+			if (descriptor >= 0)
+				close(descriptor);
+	}
+
+	PerfCounts PerfCounters::readOwn() const {
+		std::array<uint64_t, NumCounters> values{};
+		for (size_t c = 0; c < NumCounters; ++c) {
+			if (fDescriptors[c] < 0)
+				continue;
+
+			// value, time enabled, time running
+			uint64_t data[3] = {};
+			if (::read(fDescriptors[c], data, sizeof(data)) != sizeof(data))
+				continue;
+
+			values[c] = data[2] > 0 && data[2] < data[1]
+						? static_cast<uint64_t>(static_cast<double>(data[0]) * static_cast<double>(data[1]) /
+												static_cast<double>(data[2]))
+						: data[0];
+		}
+		return {values[Cycles], values[Instructions], values[LLCMisses], values[DTLBMisses]};
+	}
+#else
+	PerfCounters::PerfCounters() = default;
+
+	PerfCounters::~PerfCounters() = default;
+
+	PerfCounts PerfCounters::readOwn() const {
+		return {};
+	}
+#endif
+
+	namespace {
+		/** Counts of the worker thread at the start of its chunk. */
+		thread_local PerfCounts tChunkStart;
+	}
+
+	PerfCounters &PerfCounters::forThisThread() {
+		thread_local PerfCounters counters;
+		// workers are observed only if there is something to count, opening their counters costs a few system calls
+		if (counters.available())
+			tWorkerObserver = &counters;
+		return counters;
+	}
+
+	PerfCounts PerfCounters::read() const {
+		PerfCounts counts = readOwn();
+		std::lock_guard lock(fWorkerMutex);
+		counts += fWorkerCounts;
+		return counts;
+	}
+
+	void PerfCounters::workerStarted() {
+		tChunkStart = forThisThread().readOwn();
+	}
+
+	void PerfCounters::workerFinished() {
+		PerfCounts counts = forThisThread().readOwn() - tChunkStart;
+		std::lock_guard lock(fWorkerMutex);
+		fWorkerCounts += counts;
+	}
+
+	bool PerfCounters::available(Counter counter) const {
+		return fDescriptors[counter] >= 0;
+	}
+
+	bool PerfCounters::available() const {
+		return std::ranges::any_of(fDescriptors, [](int descriptor) { return descriptor >= 0; });
+	}
+
+	const char *PerfCounters::name(Counter counter) {
+		switch (counter) {
+			case Cycles: return "cycles";
+			case Instructions: return "instructions";
+			case LLCMisses: return "LLC misses";
+			case DTLBMisses: return "dTLB misses";
+			default: return "unknown";
+		}
+	}
+}
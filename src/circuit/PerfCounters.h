@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <array>
+#include <mutex>
+#include "../parallel.h"
+
+namespace KQS::Circuit {
+
+	/** Values of the hardware counters, see PerfCounters. */
+	struct PerfCounts {
+		uint64_t cycles = 0;
+		uint64_t instructions = 0;
+		/** Last level cache misses. */
+		uint64_t llcMisses = 0;
+		/** Data TLB read misses. */
+		uint64_t dtlbMisses = 0;
+
+		PerfCounts operator-(const PerfCounts &other) const {
+			return {cycles - other.cycles, instructions - other.instructions, llcMisses - other.llcMisses,
+					dtlbMisses - other.dtlbMisses};
+		}
+
+		PerfCounts &operator+=(const PerfCounts &other) {
+			cycles += other.cycles;
+			instructions += other.instructions;
+			llcMisses += other.llcMisses;
+			dtlbMisses += other.dtlbMisses;
+			return *this;
+		}
+	};
+
+	/**
+	 * Hardware performance counters of the calling thread and the threads it starts (cycles, instructions, last
+	 * level cache misses and data TLB misses), read with perf_event_open on Linux. The counters run in user mode
+	 * only, so they also work with kernel.perf_event_paranoid = 2. Counters the CPU, kernel or permissions do not
+	 * provide read as zero; on other systems all of them do.
+	 *
+	 * The counters are opened for a thread, so every thread uses its own instance, see forThisThread(). Intervals
+	 * are measured as differences of read() values. The kernel does not count other threads, so the instances of
+	 * forThisThread() observe the workers of the parallelFor calls of their thread: every worker opens its own
+	 * counters and adds the counts of its chunk to the calling thread's instance before it finishes, and parallelFor
+	 * joins the workers before it returns. Threads started otherwise are not counted.
+	 */
+	class PerfCounters : public WorkerObserver {
+	public:
+		enum Counter {
+			Cycles,
+			Instructions,
+			LLCMisses,
+			DTLBMisses,
+			NumCounters
+		};
+
+	private:
+		std::array<int, NumCounters> fDescriptors{-1, -1, -1, -1};
+
+		/** Counts of the chunks of parallelFor workers, added by the workers. */
+		PerfCounts fWorkerCounts;
+		mutable std::mutex fWorkerMutex;
+
+	public:
+		/** Opens and enables the counters for the calling thread. */
+		PerfCounters();
+		~PerfCounters() override;
+
+		PerfCounters(const PerfCounters &) = delete;
+		PerfCounters &operator=(const PerfCounters &) = delete;
+
+		/** Returns the counters of the calling thread, opened on the first call in the thread. */
+		static PerfCounters &forThisThread();
+
+		/** Whether the counter could be opened. */
+		bool available(Counter counter) const;
+
+		/** Whether any counter could be opened. */
+		bool available() const;
+
+		/**
+		 * Reads the current values, scaled up if the kernel multiplexed the counters, including the counts of the
+		 * parallelFor workers observed so far.
+		 */
+		PerfCounts read() const;
+
+		static const char *name(Counter counter);
+
+		/** Starts counting the chunk of a parallelFor worker, called on the worker thread. */
+		void workerStarted() override;
+		/** Adds the counts of the chunk of a parallelFor worker, called on the worker thread. */
+		void workerFinished() override;
+
+	private:
+		/** Reads the counters of the thread the instance was opened for only. */
+		PerfCounts readOwn() const;
+	};
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include "../parallel.h"
+#include "QubitPermutation.h"
+#include "DenseGateKernels.h"
+
+/**
+ * Kernel permuting the qubits of a state vector in one out-of-place pass. The states are copied in tiles spanning
+ * the low source qubits and the source qubits moving to the low destination qubits, so that both the reads and the
+ * writes of a tile are contiguous runs of 2^PermutationRunQubits states and a tile stays in the cache, as in blocked
+ * matrix transposes. The tiles are distributed over threads.
+ */
+namespace KQS::Circuit::Kernels {
+
+	/** Number of qubits of the contiguous runs of states read and written by the permutation kernel. */
+	constexpr size_t PermutationRunQubits = 6;
+
+	/** Minimal number of states per thread worth the cost of starting it. */
+	constexpr size_t PermutationStatesPerThread = 1ULL << 16;
+
+	/**
+	 * Copies the state of every index i of the source to index P(i) of the destination, where P moves bit q of
+	 * the index to bit permutation[q].
+	 * @tparam Components number of consecutive elements forming one state
+	 * @param source state vector to permute
+	 * @param destination state vector of the same size receiving the result, must not overlap with the source
+	 * @param numQubits number of qubits of the state vectors
+	 * @param permutation new position of every qubit
+	 */
+	template<size_t Components, typename E>
+	void permuteQubits(const E *source, E *destination, size_t numQubits, const std::vector<size_t> &permutation) {
+		std::vector<size_t> inverse = QubitPermutation::inverse(permutation);
+		size_t runQubits = std::min(numQubits, PermutationRunQubits);
+
+		size_t tileMask = 0;
+		for (size_t q = 0; q < runQubits; ++q)
+			tileMask |= (1ULL << q) | (1ULL << inverse[q]);
+
+		std::vector<size_t> tileQubits;
+		for (size_t q = 0; q < numQubits; ++q)
+			if (tileMask & (1ULL << q))
+				tileQubits.push_back(q);
+
+		// offsets of the states of a tile in the source and the destination, in the order of the source
+		size_t tileSize = 1ULL << tileQubits.size();
+		std::vector<size_t> sourceOffsets(tileSize);
+		std::vector<size_t> destinationOffsets(tileSize);
+		for (size_t k = 0; k < tileSize; ++k) {
+			for (size_t j = 0; j < tileQubits.size(); ++j) {
+				size_t bit = (k >> j) & 1ULL;
+				sourceOffsets[k] |= bit << tileQubits[j];
+				destinationOffsets[k] |= bit << permutation[tileQubits[j]];
+			}
+		}
+
+		// the states of a tile in the order of the destination
+		std::vector<size_t> writeOrder(tileSize);
+		std::iota(writeOrder.begin(), writeOrder.end(), 0);
+		std::ranges::sort(writeOrder, {}, [&](size_t k) { return destinationOffsets[k]; });
+
+		QubitPermutation toDestination(permutation);
+		size_t tiles = 1ULL << (numQubits - tileQubits.size());
+		parallelFor(tiles, std::max<size_t>(1, PermutationStatesPerThread / tileSize), [&](size_t begin, size_t end) {
+			// the runs of a tile are powers of two apart and would evict each other from the cache if copied
+			// directly, so the tile is gathered into a contiguous buffer first
+			std::vector<E> buffer(tileSize * Components);
+
+			for (size_t tile = begin; tile < end; ++tile) {
+				size_t sourceBase = insertZeroBits(tile, tileQubits);
+				size_t destinationBase = toDestination(sourceBase);
+
+				for (size_t k = 0; k < tileSize; ++k)
+					std::copy_n(source + (sourceBase + sourceOffsets[k]) * Components, Components,
+								buffer.data() + k * Components);
+
+				for (size_t k: writeOrder)
+					std::copy_n(buffer.data() + k * Components, Components,
+								destination + (destinationBase + destinationOffsets[k]) * Components);
+			}
+		});
+	}
+}
@@ -1,161 +1,265 @@
+#include <bit>
+#include <algorithm>
 #include "QuantumLogicGate.h"
 #include "../algebra/Constants.h"
+#include "StandardGates.h"
 
 namespace KQS::Circuit {
 
-	QuantumLogicGate::QuantumLogicGate(const ComplexMatrix &matrix)
+	template<typename T>
+	QuantumLogicGate<T>::QuantumLogicGate(const ComplexMatrix<T> &matrix)
 			: fDimension(matrix.columns()), fMatrix(matrix) {
 		if (fMatrix.rows() != fMatrix.columns())
 			throw std::runtime_error("Cannot create quantum logic gate from non-square matrix");
-		// TODO check if matrix is unitary
+
+		fUnitary = detectUnitary();
+		detectStructure();
 	}
 
-	const ComplexMatrix &QuantumLogicGate::matrix() const {
+	template<typename T>
+	const ComplexMatrix<T> &QuantumLogicGate<T>::matrix() const {
 		return fMatrix;
 	}
 
-	/// Pauli gates ///
-
-	QuantumLogicGate QuantumLogicGate::pauliX() {
-		ComplexMatrix matrix = {
-				{0, 1},
-				{1, 0}
-		};
+	template<typename T>
+	bool QuantumLogicGate<T>::isUnitary() const {
+		return fUnitary;
+	}
 
-		return QuantumLogicGate(matrix);
+	template<typename T>
+	GateStructure QuantumLogicGate<T>::structure() const {
+		return fStructure;
 	}
 
-	QuantumLogicGate QuantumLogicGate::pauliY() {
-		ComplexMatrix matrix = {
-				{0, -I},
-				{I, 0}
-		};
+	template<typename T>
+	const std::vector<size_t> &QuantumLogicGate<T>::sources() const {
+		return fSources;
+	}
 
-		return QuantumLogicGate(matrix);
+	template<typename T>
+	const std::vector<std::complex<T>> &QuantumLogicGate<T>::factors() const {
+		return fFactors;
 	}
 
-	QuantumLogicGate QuantumLogicGate::pauliZ() {
-		ComplexMatrix matrix = {
-				{1, 0},
-				{0, -1}
-		};
+	template<typename T>
+	size_t QuantumLogicGate<T>::controlMask() const {
+		return fControlMask;
+	}
 
-		return QuantumLogicGate(matrix);
+	template<typename T>
+	const ComplexMatrix<T> &QuantumLogicGate<T>::targetMatrix() const {
+		return fTargetMatrix;
 	}
 
-	/// Controlled Pauli gates ///
+	/// Pauli gates ///
 
-	QuantumLogicGate QuantumLogicGate::controlledX() {
-		ComplexMatrix matrix = {
-				{1, 0, 0, 0},
-				{0, 1, 0, 0},
-				{0, 0, 0, 1},
-				{0, 0, 1, 0},
-		};
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::pauliX() {
+		return QuantumLogicGate(Gates::PauliX<T>);
+	}
 
-		return QuantumLogicGate(matrix);
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::pauliY() {
+		return QuantumLogicGate(Gates::PauliY<T>);
 	}
 
-	QuantumLogicGate QuantumLogicGate::controlledY() {
-		ComplexMatrix matrix = {
-				{1, 0, 0, 0},
-				{0, 1, 0, 0},
-				{0, 0, 0, -I},
-				{0, 0, I, 0},
-		};
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::pauliZ() {
+		return QuantumLogicGate(Gates::PauliZ<T>);
+	}
 
-		return QuantumLogicGate(matrix);
+	/// Controlled Pauli gates ///
+
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::controlledX() {
+		return QuantumLogicGate(Gates::ControlledX<T>);
 	}
 
-	QuantumLogicGate QuantumLogicGate::controlledZ() {
-		ComplexMatrix matrix = {
-				{1, 0, 0, 0},
-				{0, 1, 0, 0},
-				{0, 0, 1, 0},
-				{0, 0, 0, -1},
-		};
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::controlledY() {
+		return QuantumLogicGate(Gates::ControlledY<T>);
+	}
 
-		return QuantumLogicGate(matrix);
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::controlledZ() {
+		return QuantumLogicGate(Gates::ControlledZ<T>);
 	}
 
-	QuantumLogicGate QuantumLogicGate::hadamard() {
-		ComplexMatrix matrix = {
-				{RecSqrt2, RecSqrt2},
-				{RecSqrt2, -RecSqrt2}
-		};
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::hadamard() {
+		return QuantumLogicGate(Gates::Hadamard<T>);
+	}
 
-		return QuantumLogicGate(matrix);
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::phase(real_t phase) {
+		return QuantumLogicGate(Gates::phase<T>(phase));
 	}
 
-	QuantumLogicGate QuantumLogicGate::phase(real_t phase) {
-		complex_t p = std::exp(phase * I);
-		ComplexMatrix matrix = {
-				{1, 0},
-				{0, p}
-		};
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::controlledPhase(real_t phase) {
+		return QuantumLogicGate(Gates::controlledPhase<T>(phase));
+	}
 
-		return QuantumLogicGate(matrix);
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::piOverEight() {
+		return QuantumLogicGate(Gates::PiOverEight<T>);
 	}
 
-	QuantumLogicGate QuantumLogicGate::controlledPhase(real_t phase) {
-		complex_t p = std::exp(phase * I);
-		ComplexMatrix matrix = {
-				{1, 0, 0, 0},
-				{0, 1, 0, 0},
-				{0, 0, 1, 0},
-				{0, 0, 0, p},
-		};
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::swap() {
+		return QuantumLogicGate(Gates::Swap<T>);
+	}
 
-		return QuantumLogicGate(matrix);
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::toffoli() {
+		return QuantumLogicGate(Gates::Toffoli<T>);
 	}
 
-	QuantumLogicGate QuantumLogicGate::piOverEight() {
-		complex_t p = std::exp(PI / 4 * I);
-		ComplexMatrix matrix = {
-				{1, 0},
-				{0, p}
-		};
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::makeControlled(const QuantumLogicGate<T> &gate, size_t numberOfControlQubits) {
+		size_t new_size = gate.fDimension << numberOfControlQubits;
+		ComplexMatrix<T> matrix(new_size, new_size);
+
+		for (size_t i = 0; i < new_size - gate.fDimension; ++i)
+			matrix[i, i, 1];
+
+		for (size_t i = 0; i < gate.fDimension; ++i)
+			for (size_t j = 0; j < gate.fDimension; ++j)
+				matrix[new_size - gate.fDimension + i, new_size - gate.fDimension + j, gate.fMatrix[i, j]];
 
 		return QuantumLogicGate(matrix);
 	}
 
-	QuantumLogicGate QuantumLogicGate::swap() {
-		ComplexMatrix matrix = {
-				{1, 0, 0, 0},
-				{0, 0, 1, 0},
-				{0, 1, 0, 0},
-				{0, 0, 0, 1},
-		};
+	template<typename T>
+	QuantumLogicGate<T> QuantumLogicGate<T>::dense(const ComplexMatrix<T> &matrix) {
+		QuantumLogicGate gate(matrix);
+		gate.fStructure = GateStructure::Dense;
+		gate.fSources.clear();
+		gate.fFactors.clear();
+		gate.fControlMask = 0;
+		gate.fTargetMatrix = ComplexMatrix<T>(0, 0);
+		return gate;
+	}
 
-		return QuantumLogicGate(matrix);
+	/// Private methods ///
+
+	template<typename T>
+	bool QuantumLogicGate<T>::detectUnitary() const {
+		// rounding errors of the elements add up over the rows of the product
+		ComplexMatrix<T> product = fMatrix.adjoint() * fMatrix;
+		auto tolerance = StructureTolerance * static_cast<real_t>(fDimension);
+		for (size_t i = 0; i < fDimension; ++i)
+			for (size_t j = 0; j < fDimension; ++j)
+				if (std::abs(product[i, j] - complex_t(i == j ? 1 : 0)) > tolerance)
+					return false;
+		return true;
 	}
 
-	QuantumLogicGate QuantumLogicGate::toffoli() {
-		ComplexMatrix matrix = {
-				{1, 0, 0, 0, 0, 0, 0, 0},
-				{0, 1, 0, 0, 0, 0, 0, 0},
-				{0, 0, 1, 0, 0, 0, 0, 0},
-				{0, 0, 0, 1, 0, 0, 0, 0},
-				{0, 0, 0, 0, 1, 0, 0, 0},
-				{0, 0, 0, 0, 0, 1, 0, 0},
-				{0, 0, 0, 0, 0, 0, 0, 1},
-				{0, 0, 0, 0, 0, 0, 1, 0},
-		};
+	template<typename T>
+	void QuantumLogicGate<T>::detectStructure() {
+		// only gates on whole qubits have a structure the kernels can use
+		if (!std::has_single_bit(fDimension))
+			return;
 
-		return QuantumLogicGate(matrix);
+		if (detectMonomial())
+			return;
+
+		if (detectControlled())
+			fStructure = GateStructure::Controlled;
 	}
 
-	QuantumLogicGate QuantumLogicGate::makeControlled(const QuantumLogicGate &gate, size_t numberOfControlQubits) {
-		size_t new_size = gate.fDimension << numberOfControlQubits;
-		ComplexMatrix matrix(new_size, new_size);
+	template<typename T>
+	bool QuantumLogicGate<T>::detectMonomial() {
+		const complex_t *data = fMatrix.data().data();
+		std::vector<size_t> sources(fDimension);
+		std::vector<complex_t> factors(fDimension);
+		std::vector<bool> usedColumns(fDimension);
+
+		for (size_t i = 0; i < fDimension; ++i) {
+			size_t nonZeros = 0;
+			for (size_t j = 0; j < fDimension; ++j) {
+				if (std::abs(data[i * fDimension + j]) <= StructureTolerance)
+					continue;
+
+				if (++nonZeros > 1 || usedColumns[j])
+					return false;
+				usedColumns[j] = true;
+				sources[i] = j;
+				factors[i] = data[i * fDimension + j];
+			}
+			if (nonZeros == 0)
+				return false;
+		}
+
+		bool diagonal = true;
+		bool permutation = true;
+		for (size_t i = 0; i < fDimension; ++i) {
+			diagonal &= sources[i] == i;
+			permutation &= std::abs(factors[i] - complex_t(1)) <= StructureTolerance;
+		}
+
+		if (diagonal) {
+			fStructure = GateStructure::Diagonal;
+		} else if (permutation) {
+			fStructure = GateStructure::Permutation;
+			std::ranges::fill(factors, complex_t(1));
+		} else {
+			fStructure = GateStructure::Monomial;
+		}
+
+		fSources = std::move(sources);
+		fFactors = std::move(factors);
+		return true;
+	}
 
-		for (size_t i = 0; i < new_size - gate.fDimension; ++i)
-			matrix[i, i] = 1;
+	template<typename T>
+	bool QuantumLogicGate<T>::detectControlled() {
+		size_t numQubits = std::countr_zero(fDimension);
+		const complex_t *data = fMatrix.data().data();
+
+		// a bit is a control if the matrix is the identity on all rows and columns with the bit zero
+		for (size_t bit = 0; bit < numQubits; ++bit) {
+			size_t mask = 1ULL << bit;
+			bool control = true;
+			for (size_t i = 0; i < fDimension && control; ++i) {
+				for (size_t j = 0; j < fDimension; ++j) {
+					if ((i & mask) && (j & mask))
+						continue;
+
+					complex_t expected = i == j ? 1 : 0;
+					if (std::abs(data[i * fDimension + j] - expected) > StructureTolerance) {
+						control = false;
+						break;
+					}
+				}
+			}
+			if (control)
+				fControlMask |= mask;
+		}
+
+		if (fControlMask == 0)
+			return false;
+
+		// spreads the bits of an index of the target matrix to the bits outside the control mask
+		auto spread = [this, numQubits](size_t index) {
+			size_t result = fControlMask;
+			for (size_t bit = 0, k = 0; bit < numQubits; ++bit) {
+				if (fControlMask & (1ULL << bit))
+					continue;
+				result |= ((index >> k++) & 1ULL) << bit;
+			}
+			return result;
+		};
 
-		for (size_t i = 0; i < gate.fDimension; ++i)
-			for (size_t j = 0; j < gate.fDimension; ++j)
-				matrix[new_size - gate.fDimension + i, new_size - gate.fDimension + j] = gate.fMatrix[i, j];
+		size_t targetDimension = fDimension >> std::popcount(fControlMask);
+		fTargetMatrix = ComplexMatrix<T>(targetDimension, targetDimension);
+		for (size_t i = 0; i < targetDimension; ++i)
+			for (size_t j = 0; j < targetDimension; ++j)
+				fTargetMatrix[i, j, data[spread(i) * fDimension + spread(j)]];
 
-		return QuantumLogicGate(matrix);
+		return true;
 	}
+
+	template class QuantumLogicGate<float>;
+	template class QuantumLogicGate<double>;
 }
@@ -2,21 +2,89 @@
 
 
 #include <cstdlib>
+#include <vector>
+#include <limits>
 #include "../algebra/Matrix.h"
 
 using namespace KQS::Algebra;
 
 namespace KQS::Circuit {
 
+	/**
+	 * Structure of a gate matrix, detected when the gate is created. Registers pick the cheapest kernel for it,
+	 * the structures are listed from the cheapest to apply.
+	 */
+	enum class GateStructure {
+		/** Only the diagonal is non-zero, the gate multiplies every state by a factor. */
+		Diagonal,
+		/** Permutation matrix, the gate only moves amplitudes. */
+		Permutation,
+		/** Exactly one non-zero element in every row and column, i.e. a permutation with phases. */
+		Monomial,
+		/** Identity unless some of the qubits (the controls) are all one, then a smaller gate on the others. */
+		Controlled,
+		/** General matrix. */
+		Dense
+	};
+
+	/**
+	 * Quantum logic gate given by its unitary matrix.
+	 * @tparam T type of the real and imaginary parts of the matrix elements
+	 */
+	template<typename T>
 	class QuantumLogicGate {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+
+		/** Elements with smaller magnitude are treated as zeros by the structure detection. */
+		static constexpr real_t StructureTolerance = 64 * std::numeric_limits<real_t>::epsilon();
+
 	private:
 		size_t fDimension;
-		ComplexMatrix fMatrix;
+		ComplexMatrix<T> fMatrix;
+
+		/** Whether U^+ U is the identity within the structure tolerance. */
+		bool fUnitary = false;
+		GateStructure fStructure = GateStructure::Dense;
+		/** Column of the non-zero element in every row of diagonal, permutation and monomial gates. */
+		std::vector<size_t> fSources;
+		/** Non-zero element in every row of diagonal, permutation and monomial gates. */
+		std::vector<complex_t> fFactors;
+		/** Bits of the row and column indices that are the controls of a controlled gate. */
+		size_t fControlMask = 0;
+		/** Matrix applied to the bits outside the control mask when all controls are one. */
+		ComplexMatrix<T> fTargetMatrix{0, 0};
 
 	public:
-		explicit QuantumLogicGate(const ComplexMatrix &matrix);
+		explicit QuantumLogicGate(const ComplexMatrix<T> &matrix);
+
+		template<size_t N>
+		explicit QuantumLogicGate(const SmallMatrix<T, N> &matrix)
+				: QuantumLogicGate(ComplexMatrix<T>(matrix)) {}
+
+		const ComplexMatrix<T> &matrix() const;
+
+		/**
+		 * Whether the matrix is unitary. Non-unitary gates are still applied, e.g. the normalized Kraus operators of
+		 * noise channels, but they do not preserve the norm of the state.
+		 */
+		bool isUnitary() const;
 
-		const ComplexMatrix &matrix() const;
+		GateStructure structure() const;
+
+		/**
+		 * For diagonal, permutation and monomial gates, row i of the matrix has its only non-zero element in column
+		 * sources()[i], i.e. the gate maps amplitude a to a'[i] = factors()[i] * a[sources()[i]].
+		 */
+		const std::vector<size_t> &sources() const;
+		const std::vector<complex_t> &factors() const;
+
+		/** For controlled gates, the bits of the matrix indices (i.e. the target qubits) that are controls. */
+		size_t controlMask() const;
+
+		/** For controlled gates, the matrix on the bits outside the control mask, in the order of the bits. */
+		const ComplexMatrix<T> &targetMatrix() const;
 
 		static QuantumLogicGate pauliX();
 		static QuantumLogicGate pauliY();
@@ -32,6 +100,25 @@ namespace KQS::Circuit {
 		static QuantumLogicGate toffoli();
 
 		static QuantumLogicGate makeControlled(const QuantumLogicGate &gate, size_t numberOfControlQubits);
+
+		/**
+		 * Creates a gate that is applied with the dense kernels whatever the structure of its matrix, to compare the
+		 * structured kernels with the dense ones.
+		 */
+		static QuantumLogicGate dense(const ComplexMatrix<T> &matrix);
+
+	private:
+		/** Checks U^+ U = I within the structure tolerance, scaled by the dimension for the sums of the product. */
+		bool detectUnitary() const;
+
+		/** Detects the structure of the matrix and fills the description of the structure. */
+		void detectStructure();
+
+		/** Detects diagonal, permutation and monomial matrices. */
+		bool detectMonomial();
+
+		/** Detects controlled matrices. */
+		bool detectControlled();
 	};
 
 }
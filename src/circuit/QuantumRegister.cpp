@@ -1,21 +1,245 @@
+#include <bit>
 #include <bitset>
+#include <format>
 #include <iomanip>
 #include <cstdint>
 #include <fstream>
+#include <numeric>
+#include <algorithm>
 #include "QuantumRegister.h"
+#include "StandardGates.h"
+#include "QubitPermutation.h"
+#include "DenseGateKernels.h"
 
 namespace KQS::Circuit {
 
-	QuantumRegister::QuantumRegister(size_t numberOfQubits)
-			: fNumQubits(numberOfQubits), fNumStates(1 << numberOfQubits) {}
+	template<typename T>
+	QuantumRegister<T>::QuantumRegister(size_t numberOfQubits)
+			: fNumQubits(numberOfQubits), fNumStates(numberOfQubits < 64 ? 1ULL << numberOfQubits : 0),
+			  fQubitMap(numberOfQubits) {
+		std::iota(fQubitMap.begin(), fQubitMap.end(), 0);
+	}
 
-	QuantumRegister::~QuantumRegister() = default;
+	template<typename T>
+	QuantumRegister<T>::~QuantumRegister() = default;
 
-	size_t QuantumRegister::qubits() const {
+	template<typename T>
+	size_t QuantumRegister<T>::qubits() const {
 		return fNumQubits;
 	}
 
-	std::string QuantumRegister::toString() const {
+	/// Qubit map ///
+
+	template<typename T>
+	void QuantumRegister<T>::setStateVector(const std::vector<complex_t> &stateVector) {
+		setPhysicalStateVector(stateVector);
+		std::iota(fQubitMap.begin(), fQubitMap.end(), 0);
+	}
+
+	template<typename T>
+	std::vector<std::complex<T>> QuantumRegister<T>::stateVector() const {
+		std::vector<complex_t> physical = physicalStateVector();
+		if (std::ranges::is_sorted(fQubitMap))
+			return physical;
+
+		QubitPermutation toPhysical(fQubitMap);
+		std::vector<complex_t> result(fNumStates);
+		for (size_t i = 0; i < fNumStates; ++i)
+			result[i] = physical[toPhysical(i)];
+		return result;
+	}
+
+	template<typename T>
+	void QuantumRegister<T>::readStateVector(const StateChunkCallback &callback) const {
+		if (std::ranges::is_sorted(fQubitMap)) {
+			readPhysicalStateVector(callback);
+			return;
+		}
+
+		std::vector<complex_t> vector = stateVector();
+		callback(0, vector);
+	}
+
+	template<typename T>
+	void QuantumRegister<T>::readPhysicalStates(const StateChunkCallback &callback) const {
+		readPhysicalStateVector(callback);
+	}
+
+	template<typename T>
+	const std::vector<size_t> &QuantumRegister<T>::qubitMap() const {
+		return fQubitMap;
+	}
+
+	template<typename T>
+	void QuantumRegister<T>::setQubitMap(const std::vector<size_t> &qubitMap) {
+		if (qubitMap.size() != fNumQubits)
+			throw std::runtime_error(std::format("Qubit map of size {} cannot be set to {}-qubit register",
+												 qubitMap.size(), fNumQubits));
+
+		std::vector<bool> used(fNumQubits);
+		for (size_t qubit: qubitMap) {
+			if (qubit >= fNumQubits || used[qubit])
+				throw std::runtime_error(std::format("Invalid qubit map of {}-qubit register", fNumQubits));
+			used[qubit] = true;
+		}
+
+		if (qubitMap == fQubitMap)
+			return;
+
+		// physical qubit fQubitMap[q] moves to qubitMap[q]
+		std::vector<size_t> permutation(fNumQubits);
+		for (size_t q = 0; q < fNumQubits; ++q)
+			permutation[fQubitMap[q]] = qubitMap[q];
+
+		profiled("QubitMap", {}, 1, [&] { permutePhysicalQubits(permutation); });
+		fQubitMap = qubitMap;
+	}
+
+	template<typename T>
+	void QuantumRegister<T>::applyQubitMap() {
+		std::vector<size_t> identity(fNumQubits);
+		std::iota(identity.begin(), identity.end(), 0);
+		setQubitMap(identity);
+	}
+
+	template<typename T>
+	void QuantumRegister<T>::permutePhysicalQubits(const std::vector<size_t> &permutation) {
+		// position[q] is the current position of the qubit that was at q
+		std::vector<size_t> position(fNumQubits);
+		std::iota(position.begin(), position.end(), 0);
+
+		for (size_t target = 0; target < fNumQubits; ++target) {
+			size_t qubit = std::ranges::find(permutation, target) - permutation.begin();
+			if (position[qubit] == target)
+				continue;
+
+			// the qubit currently at the target moves to where the qubit was
+			size_t other = std::ranges::find(position, target) - position.begin();
+			applyStandardGate(StandardGate::Swap, {position[qubit], target}, 1);
+			position[other] = position[qubit];
+			position[qubit] = target;
+		}
+	}
+
+	template<typename T>
+	size_t QuantumRegister<T>::physicalQubit(size_t qubit) const {
+		return qubit < fNumQubits ? fQubitMap[qubit] : qubit;
+	}
+
+	template<typename T>
+	std::vector<T> QuantumRegister<T>::marginals() const {
+		std::vector<real_t> physical = physicalMarginals();
+
+		std::vector<real_t> result(fNumQubits);
+		for (size_t q = 0; q < fNumQubits; ++q)
+			result[q] = physical[fQubitMap[q]];
+		return result;
+	}
+
+	template<typename T>
+	std::vector<std::complex<double>> QuantumRegister<T>::reducedDensityMatrix(const std::vector<size_t> &qubits) const {
+		std::vector<size_t> physical(qubits.size());
+		for (size_t i = 0; i < qubits.size(); ++i) {
+			if (qubits[i] >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Cannot trace qubit {} in {}-qubit register", qubits[i], fNumQubits));
+			for (size_t j = 0; j < i; ++j)
+				if (qubits[j] == qubits[i])
+					throw std::runtime_error(std::format("Cannot trace qubit {} twice", qubits[i]));
+			physical[i] = fQubitMap[qubits[i]];
+		}
+
+		return physicalReducedDensityMatrix(physical);
+	}
+
+	template<typename T>
+	std::vector<size_t> QuantumRegister<T>::sample(std::span<const real_t> randomNumbers) const {
+		std::vector<size_t> samples = samplePhysical(randomNumbers);
+		if (std::ranges::is_sorted(fQubitMap))
+			return samples;
+
+		QubitPermutation toLogical(QubitPermutation::inverse(fQubitMap));
+		for (size_t &sample: samples)
+			sample = toLogical(sample);
+		return samples;
+	}
+
+	/// Physical state ///
+
+	template<typename T>
+	void QuantumRegister<T>::readPhysicalStateVector(const StateChunkCallback &callback) const {
+		std::vector<complex_t> vector = physicalStateVector();
+		callback(0, vector);
+	}
+
+	template<typename T>
+	T QuantumRegister<T>::norm() const {
+		double sum = 0;
+		readPhysicalStateVector([&sum](size_t, std::span<const complex_t> chunk) {
+			for (const auto &state: chunk)
+				sum += std::norm(state);
+		});
+
+		return static_cast<real_t>(sum);
+	}
+
+	template<typename T>
+	std::vector<T> QuantumRegister<T>::physicalMarginals() const {
+		std::vector<double> sums(fNumQubits);
+		readPhysicalStateVector([this, &sums](size_t offset, std::span<const complex_t> chunk) {
+			for (size_t i = 0; i < chunk.size(); ++i) {
+				real_t prob = std::norm(chunk[i]);
+				for (size_t q = 0; q < fNumQubits; ++q)
+					if (((offset + i) >> q & 1) == 1)
+						sums[q] += prob;
+			}
+		});
+
+		return {sums.begin(), sums.end()};
+	}
+
+	template<typename T>
+	std::vector<std::complex<double>> QuantumRegister<T>::physicalReducedDensityMatrix(
+			const std::vector<size_t> &qubits) const {
+		std::vector<complex_t> state = physicalStateVector();
+		return Kernels::reducedDensityMatrix(state.size(), qubits, [&state](size_t i) { return state[i]; });
+	}
+
+	template<typename T>
+	std::vector<size_t> QuantumRegister<T>::samplePhysical(std::span<const real_t> randomNumbers) const {
+		double total = norm();
+
+		// random numbers are processed in increasing order, so all shots are assigned in one pass over the states
+		std::vector<size_t> order(randomNumbers.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::ranges::sort(order, {}, [&randomNumbers](size_t i) { return randomNumbers[i]; });
+
+		std::vector<size_t> samples(randomNumbers.size());
+		size_t next = 0;
+		size_t lastNonZero = 0;
+		double cumulative = 0;
+		readPhysicalStateVector([&](size_t offset, std::span<const complex_t> chunk) {
+			for (size_t i = 0; i < chunk.size() && next < order.size(); ++i) {
+				real_t prob = std::norm(chunk[i]);
+				if (prob == 0)
+					continue;
+
+				cumulative += prob;
+				lastNonZero = offset + i;
+				while (next < order.size() && randomNumbers[order[next]] * total < cumulative)
+					samples[order[next++]] = lastNonZero;
+			}
+		});
+
+		// shots left over due to rounding belong to the last state with non-zero probability
+		for (; next < order.size(); ++next)
+			samples[order[next]] = lastNonZero;
+
+		return samples;
+	}
+
+	template<typename T>
+	std::string QuantumRegister<T>::toString() const {
 		auto vector = stateVector();
 
 		std::stringstream ss;
@@ -40,8 +264,8 @@ namespace KQS::Circuit {
 		return ss.str();
 	}
 
-	void QuantumRegister::toFile(const std::string &fileName) const {
-		std::vector<complex_t> vector = stateVector();
+	template<typename T>
+	void QuantumRegister<T>::toFile(const std::string &fileName) const {
 		std::ofstream outFile(fileName, std::ios::out | std::ios::binary);
 
 		struct header_t {
@@ -55,66 +279,215 @@ namespace KQS::Circuit {
 		header.numQubits = fNumQubits;
 
 		outFile.write(reinterpret_cast<const char *>(&header), sizeof(header_t));
-		outFile.write(reinterpret_cast<const char *>(vector.data()), vector.size() * sizeof(complex_t));
+		readStateVector([&outFile](size_t, std::span<const complex_t> chunk) {
+			outFile.write(reinterpret_cast<const char *>(chunk.data()), static_cast<std::streamsize>(chunk.size_bytes()));
+		});
 	}
 
 	/////////////// Gates ///////////////
 
-	void QuantumRegister::pauliX(size_t targetQubit) {
-		applyOneQubitGate(QuantumLogicGate::pauliX(), targetQubit);
+	template<typename T>
+	void QuantumRegister<T>::pauliX(size_t targetQubit) {
+		profiled("PauliX", std::array{targetQubit}, 1, [&] {
+			applyStandardGate(StandardGate::PauliX, {physicalQubit(targetQubit), 0}, 1);
+		});
+	}
+
+	template<typename T>
+	void QuantumRegister<T>::pauliY(size_t targetQubit) {
+		profiled("PauliY", std::array{targetQubit}, 1, [&] {
+			applyStandardGate(StandardGate::PauliY, {physicalQubit(targetQubit), 0}, 1);
+		});
+	}
+
+	template<typename T>
+	void QuantumRegister<T>::pauliZ(size_t targetQubit) {
+		profiled("PauliZ", std::array{targetQubit}, 0.5, [&] {
+			applyStandardGate(StandardGate::Phase, {physicalQubit(targetQubit), 0}, -1);
+		});
 	}
 
-	void QuantumRegister::pauliY(size_t targetQubit) {
-		applyOneQubitGate(QuantumLogicGate::pauliY(), targetQubit);
+	template<typename T>
+	void QuantumRegister<T>::controlledX(size_t controlQubit, size_t targetQubit) {
+		profiled("ControlledX", std::array{controlQubit, targetQubit}, 0.5, [&] {
+			applyStandardGate(StandardGate::ControlledX, {physicalQubit(targetQubit), physicalQubit(controlQubit)}, 1);
+		});
 	}
 
-	void QuantumRegister::pauliZ(size_t targetQubit) {
-		applyOneQubitGate(QuantumLogicGate::pauliZ(), targetQubit);
+	template<typename T>
+	void QuantumRegister<T>::controlledY(size_t controlQubit, size_t targetQubit) {
+		profiled("ControlledY", std::array{controlQubit, targetQubit}, 1, [&] {
+			applyTwoQubitGate(Gates::ControlledY<T>, {physicalQubit(targetQubit), physicalQubit(controlQubit)});
+		});
 	}
 
-	void QuantumRegister::controlledX(size_t controlQubit, size_t targetQubit) {
-		applyTwoQubitGate(QuantumLogicGate::controlledX(), {targetQubit, controlQubit});
+	template<typename T>
+	void QuantumRegister<T>::controlledZ(size_t controlQubit, size_t targetQubit) {
+		profiled("ControlledZ", std::array{controlQubit, targetQubit}, 0.25, [&] {
+			applyStandardGate(StandardGate::ControlledPhase, {physicalQubit(targetQubit), physicalQubit(controlQubit)},
+							  -1);
+		});
 	}
 
-	void QuantumRegister::controlledY(size_t controlQubit, size_t targetQubit) {
-		applyTwoQubitGate(QuantumLogicGate::controlledY(), {targetQubit, controlQubit});
+	template<typename T>
+	void QuantumRegister<T>::hadamard(size_t targetQubit) {
+		profiled("Hadamard", std::array{targetQubit}, 1, [&] {
+			applyStandardGate(StandardGate::Hadamard, {physicalQubit(targetQubit), 0}, 1);
+		});
 	}
 
-	void QuantumRegister::controlledZ(size_t controlQubit, size_t targetQubit) {
-		applyTwoQubitGate(QuantumLogicGate::controlledZ(), {targetQubit, controlQubit});
+	template<typename T>
+	void QuantumRegister<T>::phase(size_t targetQubit, real_t phase) {
+		profiled("Phase", std::array{targetQubit}, 0.5, [&] {
+			applyStandardGate(StandardGate::Phase, {physicalQubit(targetQubit), 0}, std::polar<T>(1, phase));
+		});
 	}
 
-	void QuantumRegister::hadamard(size_t targetQubit) {
-		applyOneQubitGate(QuantumLogicGate::hadamard(), targetQubit);
+	template<typename T>
+	void QuantumRegister<T>::controlledPhase(size_t controlQubit, size_t targetQubit, real_t phase) {
+		profiled("ControlledPhase", std::array{controlQubit, targetQubit}, 0.25, [&] {
+			applyStandardGate(StandardGate::ControlledPhase, {physicalQubit(targetQubit), physicalQubit(controlQubit)},
+							  std::polar<T>(1, phase));
+		});
 	}
 
-	void QuantumRegister::phase(size_t targetQubit, real_t phase) {
-		applyOneQubitGate(QuantumLogicGate::phase(phase), targetQubit);
+	template<typename T>
+	void QuantumRegister<T>::piOverEight(size_t targetQubit) {
+		profiled("PiOverEight", std::array{targetQubit}, 0.5, [&] {
+			applyStandardGate(StandardGate::Phase, {physicalQubit(targetQubit), 0}, Gates::PiOverEight<T>[1, 1]);
+		});
 	}
 
-	void QuantumRegister::controlledPhase(size_t controlQubit, size_t targetQubit, real_t phase) {
-		applyTwoQubitGate(QuantumLogicGate::controlledPhase(phase), {targetQubit, controlQubit});
+	template<typename T>
+	void QuantumRegister<T>::swap(size_t targetQubit1, size_t targetQubit2) {
+		for (size_t qubit: {targetQubit1, targetQubit2})
+			if (qubit >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Cannot apply gate to qubit {} in {}-qubit register", qubit, fNumQubits));
+		if (targetQubit1 == targetQubit2)
+			throw std::runtime_error(std::format("Cannot apply two-qubit gate twice to qubit {}", targetQubit1));
+
+		// the qubits are only relabeled, the state is not touched
+		profiled("Swap", std::array{targetQubit1, targetQubit2}, 0, [&] {
+			std::swap(fQubitMap[targetQubit1], fQubitMap[targetQubit2]);
+		});
 	}
 
-	void QuantumRegister::piOverEight(size_t targetQubit) {
-		applyOneQubitGate(QuantumLogicGate::piOverEight(), targetQubit);
+	template<typename T>
+	void QuantumRegister<T>::toffoli(size_t controlQubit1, size_t controlQubit2, size_t targetQubit) {
+		static const QuantumLogicGate<T> toffoliGate(Gates::Toffoli<T>);
+		profiled("Toffoli", std::array{controlQubit1, controlQubit2, targetQubit}, 0.25, [&] {
+			dispatchGate(toffoliGate, {targetQubit, controlQubit2, controlQubit1});
+		});
 	}
 
-	void QuantumRegister::swap(size_t targetQubit1, size_t targetQubit2) {
-		applyTwoQubitGate(QuantumLogicGate::swap(), {targetQubit2, targetQubit1});
+	template<typename T>
+	void QuantumRegister<T>::gate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
+		if (!fProfiler) {
+			dispatchGate(gate, targetQubits);
+			return;
+		}
+
+		// fraction of the states the kernel of the structure reads and writes
+		double touchedStates = 1;
+		const char *name = "Dense";
+		switch (gate.structure()) {
+			case GateStructure::Diagonal:
+			case GateStructure::Permutation:
+			case GateStructure::Monomial: {
+				name = gate.structure() == GateStructure::Diagonal ? "Diagonal" :
+					   gate.structure() == GateStructure::Permutation ? "Permutation" : "Monomial";
+				size_t changed = 0;
+				for (size_t j = 0; j < gate.factors().size(); ++j)
+					changed += gate.sources()[j] != j || gate.factors()[j] != complex_t(1);
+				touchedStates = static_cast<double>(changed) / static_cast<double>(gate.factors().size());
+				break;
+			}
+			case GateStructure::Controlled:
+				name = "Controlled";
+				touchedStates = 1.0 / static_cast<double>(1ULL << std::popcount(gate.controlMask()));
+				break;
+			case GateStructure::Dense:
+				break;
+		}
+
+		profiled(name, targetQubits, touchedStates, [&] { dispatchGate(gate, targetQubits); });
 	}
 
-	void QuantumRegister::toffoli(size_t controlQubit1, size_t controlQubit2, size_t targetQubit) {
-		applyKQubitGate(QuantumLogicGate::toffoli(), {targetQubit, controlQubit2, controlQubit1});
+	template<typename T>
+	void QuantumRegister<T>::dispatchGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
+		if (gate.matrix().rows() != 1ULL << targetQubits.size())
+			throw std::runtime_error(std::format("Gate of size {}x{} cannot be applied to {} qubits",
+												 gate.matrix().rows(), gate.matrix().columns(), targetQubits.size()));
+
+		for (size_t i = 0; i < targetQubits.size(); ++i) {
+			if (targetQubits[i] >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Cannot apply gate to qubit {} in {}-qubit register", targetQubits[i], fNumQubits));
+			for (size_t j = 0; j < i; ++j)
+				if (targetQubits[j] == targetQubits[i])
+					throw std::runtime_error(std::format("Cannot apply gate twice to qubit {}", targetQubits[i]));
+		}
+
+		std::vector<size_t> physicalQubits(targetQubits.size());
+		for (size_t i = 0; i < targetQubits.size(); ++i)
+			physicalQubits[i] = fQubitMap[targetQubits[i]];
+
+		switch (gate.structure()) {
+			case GateStructure::Diagonal:
+				applyDiagonalGate(gate, physicalQubits);
+				break;
+			case GateStructure::Permutation:
+			case GateStructure::Monomial:
+				applyMonomialGate(gate, physicalQubits);
+				break;
+			case GateStructure::Controlled:
+				applyControlledGate(gate, physicalQubits);
+				break;
+			case GateStructure::Dense:
+				applyGateMatrix(gate, physicalQubits);
+				break;
+		}
 	}
 
-	void QuantumRegister::gate(const QuantumLogicGate &gate, const std::vector<size_t> &targetQubits) {
+	template<typename T>
+	void QuantumRegister<T>::applyDiagonalGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
+		applyGateMatrix(gate, targetQubits);
+	}
+
+	template<typename T>
+	void QuantumRegister<T>::applyMonomialGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
+		applyGateMatrix(gate, targetQubits);
+	}
+
+	template<typename T>
+	void QuantumRegister<T>::applyControlledGate(const QuantumLogicGate<T> &gate,
+												 const std::vector<size_t> &targetQubits) {
+		applyGateMatrix(gate, targetQubits);
+	}
+
+	template<typename T>
+	std::pair<std::vector<size_t>, std::vector<size_t>>
+	QuantumRegister<T>::splitControls(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
+		std::vector<size_t> targets;
+		std::vector<size_t> controls;
+		for (size_t q = 0; q < targetQubits.size(); ++q) {
+			if (gate.controlMask() & (1ULL << q))
+				controls.push_back(targetQubits[q]);
+			else
+				targets.push_back(targetQubits[q]);
+		}
+		return {targets, controls};
+	}
+
+	template<typename T>
+	void QuantumRegister<T>::applyGateMatrix(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
 		switch (targetQubits.size()) {
 			case 1:
-				applyOneQubitGate(gate, targetQubits[0]);
+				applyOneQubitGate(gate.matrix().template toSmallMatrix<2>(), targetQubits[0]);
 				break;
 			case 2:
-				applyTwoQubitGate(gate, {targetQubits[0], targetQubits[1]});
+				applyTwoQubitGate(gate.matrix().template toSmallMatrix<4>(), {targetQubits[0], targetQubits[1]});
 				break;
 			default:
 				applyKQubitGate(gate, targetQubits);
@@ -122,14 +495,63 @@ namespace KQS::Circuit {
 		}
 	}
 
-	/// Private methods ///
+	template<typename T>
+	void QuantumRegister<T>::applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor) {
+		switch (gate) {
+			case StandardGate::PauliX:
+				applyOneQubitGate(Gates::PauliX<T>, qubits[0]);
+				break;
+			case StandardGate::PauliY:
+				applyOneQubitGate(Gates::PauliY<T>, qubits[0]);
+				break;
+			case StandardGate::Hadamard:
+				applyOneQubitGate(Gates::Hadamard<T>, qubits[0]);
+				break;
+			case StandardGate::Phase:
+				applyOneQubitGate({{1, 0}, {0, factor}}, qubits[0]);
+				break;
+			case StandardGate::ControlledX:
+				applyTwoQubitGate(Gates::ControlledX<T>, qubits);
+				break;
+			case StandardGate::ControlledPhase:
+				applyTwoQubitGate({{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, factor}}, qubits);
+				break;
+			case StandardGate::Swap:
+				applyTwoQubitGate(Gates::Swap<T>, qubits);
+				break;
+		}
+	}
 
-	void QuantumRegister::isNormalized() const {
-		real_t sum = 0;
-		for (const auto &state: stateVector())
-			sum += std::norm(state);
+	/// Private methods ///
 
+	template<typename T>
+	void QuantumRegister<T>::isNormalized() const {
+		real_t sum = norm();
 		if (std::abs(sum - 1) > 1e-8)
 			throw std::runtime_error("State vector is not normalized. Sum of probs: " + std::to_string(sum));
 	}
+
+	template<typename T>
+	void QuantumRegister<T>::setProfiler(std::shared_ptr<GateProfiler> profiler) {
+		bool changed = !fProfiler != !profiler;
+		fProfiler = std::move(profiler);
+		if (changed)
+			profilingChanged(fProfiler != nullptr);
+	}
+
+	template<typename T>
+	const std::shared_ptr<GateProfiler> &QuantumRegister<T>::profiler() const {
+		return fProfiler;
+	}
+
+	template<typename T>
+	size_t QuantumRegister<T>::bytesPerState() const {
+		return sizeof(complex_t);
+	}
+
+	template<typename T>
+	void QuantumRegister<T>::profilingChanged(bool) {}
+
+	template class QuantumRegister<float>;
+	template class QuantumRegister<double>;
 }
@@ -3,23 +3,120 @@
 #include <cstdlib>
 #include <vector>
 #include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <span>
 #include "../types.h"
 #include "QuantumLogicGate.h"
+#include "StandardGates.h"
+#include "GateProfiler.h"
 
 namespace KQS::Circuit {
+	/**
+	 * Base class of quantum registers.
+	 * @tparam T type of the real and imaginary parts of the amplitudes
+	 */
+	template<typename T>
 	class QuantumRegister {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+
+		/**
+		 * Callback receiving consecutive chunks of the state vector.
+		 * The offset is the index of the first state of the chunk; the chunk is only valid during the call.
+		 */
+		using StateChunkCallback = std::function<void(size_t offset, std::span<const complex_t> chunk)>;
+
 	protected:
 		size_t fNumQubits;
+		/** Number of states, 0 for registers of 64 or more qubits that do not store a state vector (MPSRegister). */
 		size_t fNumStates;
 
+		/**
+		 * Physical qubit holding every logical qubit. Swaps only exchange two entries, gates are applied to the
+		 * physical qubits and the state vector is translated to the logical order when it is read.
+		 */
+		std::vector<size_t> fQubitMap;
+
+		/** Records the applied gates if set. */
+		std::shared_ptr<GateProfiler> fProfiler;
+		/** Time of the device kernels of the gate being profiled, added by registers measuring it on the device. */
+		std::chrono::nanoseconds fDeviceTime{0};
+
 	public:
 		explicit QuantumRegister(size_t numberOfQubits);
 		virtual ~QuantumRegister();
 
-		virtual void setStateVector(const std::vector<complex_t> &stateVector) = 0;
+		/** Sets the state vector in the logical order, which also resets the qubit map. */
+		void setStateVector(const std::vector<complex_t> &stateVector);
 
 		size_t qubits() const;
-		virtual std::vector<complex_t> stateVector() const = 0;
+
+		/** Returns the state vector in the logical order of the qubits. */
+		std::vector<complex_t> stateVector() const;
+
+		/**
+		 * Streams the state vector to the callback chunk by chunk, in order of increasing offset. If swapped
+		 * qubits are pending in the qubit map, the whole translated vector is passed as one chunk; call
+		 * applyQubitMap() first to keep streaming in chunks.
+		 * @param callback function called for every chunk
+		 */
+		void readStateVector(const StateChunkCallback &callback) const;
+
+		/**
+		 * Streams the states in the physical order of the qubits chunk by chunk, like readStateVector(), but never
+		 * translates them through the qubit map. Logical qubit q is bit qubitMap()[q] of the physical indices.
+		 * @param callback function called for every chunk
+		 */
+		void readPhysicalStates(const StateChunkCallback &callback) const;
+
+		/** Returns the physical qubit holding every logical qubit. */
+		const std::vector<size_t> &qubitMap() const;
+
+		/**
+		 * Moves the logical qubits to the given physical qubits with one bulk permutation of the state, e.g. to bring
+		 * the qubits of the next gates to the low physical qubits.
+		 * @param qubitMap new physical qubit of every logical qubit
+		 */
+		void setQubitMap(const std::vector<size_t> &qubitMap);
+
+		/**
+		 * Permutes the physical state, so that every logical qubit is held by the physical qubit of the same index
+		 * and reading the state vector needs no translation.
+		 */
+		void applyQubitMap();
+
+		/**
+		 * Computes the squared norm of the state vector, i.e. the sum of probabilities of all states.
+		 * @return squared norm of the state vector
+		 */
+		virtual real_t norm() const;
+
+		/**
+		 * Computes the marginal probability of measuring each qubit in state one.
+		 * @return vector with the probability for every qubit
+		 */
+		std::vector<real_t> marginals() const;
+
+		/**
+		 * Computes the reduced density matrix of the qubits, tracing out all others, without copying the state
+		 * vector on registers that read their amplitudes in place.
+		 * @param qubits distinct qubits, bit q of the matrix indices corresponds to qubits[q]
+		 * @return row-major matrix of size 2^k x 2^k for k qubits
+		 */
+		std::vector<std::complex<double>> reducedDensityMatrix(const std::vector<size_t> &qubits) const;
+
+		/**
+		 * Samples measurement outcomes of the whole register without collapsing the state. Every random number
+		 * produces one shot, the outcome is the state at which the cumulative distribution exceeds it. The states
+		 * are ordered physically, so with swaps pending in the qubit map the same random numbers can produce
+		 * different, equally distributed, outcomes.
+		 * @param randomNumbers numbers uniformly distributed in [0, 1), one per shot
+		 * @return sampled states, one per shot
+		 */
+		std::vector<size_t> sample(std::span<const real_t> randomNumbers) const;
 		std::string toString() const;
 		void toFile(const std::string &fileName) const;
 
@@ -35,13 +132,118 @@ namespace KQS::Circuit {
 		void piOverEight(size_t targetQubit);
 		void swap(size_t targetQubit1, size_t targetQubit2);
 		void toffoli(size_t controlQubit1, size_t controlQubit2, size_t targetQubit);
-		void gate(const QuantumLogicGate &gate, const std::vector<size_t> &targetQubits);
+		void gate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits);
 
 		void isNormalized() const;
 
+		/**
+		 * Sets the profiler recording every gate applied by the named gate methods, gate() and setQubitMap(), or
+		 * disables profiling if null. The same profiler can be set to several registers, their gates are then
+		 * combined in its statistics. Builds with KQS_NO_PROFILING defined never record anything.
+		 * @param profiler profiler recording the gates
+		 */
+		void setProfiler(std::shared_ptr<GateProfiler> profiler);
+
+		const std::shared_ptr<GateProfiler> &profiler() const;
+
 	protected:
-		virtual void applyOneQubitGate(const QuantumLogicGate &gate, size_t targetQubit) = 0;
-		virtual void applyTwoQubitGate(const QuantumLogicGate &gate, std::array<size_t, 2> targetQubits) = 0;
-		virtual void applyKQubitGate(const QuantumLogicGate &gate, const std::vector<size_t> &targetQubits) = 0;
+		/**
+		 * Access to the state in the physical order of the qubits, the public methods translate it through
+		 * the qubit map.
+		 */
+		virtual void setPhysicalStateVector(const std::vector<complex_t> &stateVector) = 0;
+		virtual std::vector<complex_t> physicalStateVector() const = 0;
+
+		/**
+		 * Streams the physical state vector to the callback chunk by chunk, in order of increasing offset.
+		 * The default implementation passes the whole vector returned by physicalStateVector() as one chunk.
+		 */
+		virtual void readPhysicalStateVector(const StateChunkCallback &callback) const;
+		virtual std::vector<real_t> physicalMarginals() const;
+
+		/**
+		 * Reduced density matrix of the physical qubits. The default implementation reads a copy of the physical
+		 * state vector, registers with directly addressable amplitudes override it.
+		 */
+		virtual std::vector<std::complex<double>> physicalReducedDensityMatrix(const std::vector<size_t> &qubits) const;
+		virtual std::vector<size_t> samplePhysical(std::span<const real_t> randomNumbers) const;
+
+		/**
+		 * Permutes the physical qubits, the state of every index i moves to the index with bit q of i at bit
+		 * permutation[q]. The default implementation swaps the qubits one pair at a time, registers with a bulk
+		 * permutation kernel override it.
+		 * @param permutation new position of every physical qubit
+		 */
+		virtual void permutePhysicalQubits(const std::vector<size_t> &permutation);
+
+		/** Number of bytes storing one amplitude, used to estimate the memory traffic of profiled gates. */
+		virtual size_t bytesPerState() const;
+
+		/** Called when profiling is enabled or disabled, e.g. to turn on timing of device kernels. */
+		virtual void profilingChanged(bool enabled);
+
+		/**
+		 * Calls the function applying a gate and records it if a profiler is set.
+		 * @param name kind of the gate
+		 * @param qubits logical qubits of the gate
+		 * @param touchedStates fraction of the states the gate reads and writes
+		 * @param apply function applying the gate
+		 */
+		template<typename F>
+		void profiled(std::string_view name, std::span<const size_t> qubits, double touchedStates, F &&apply) {
+#ifndef KQS_NO_PROFILING
+			if (fProfiler) {
+				fDeviceTime = std::chrono::nanoseconds(0);
+				auto measurement = fProfiler->start();
+				apply();
+
+				auto bytes = static_cast<size_t>(2 * touchedStates * static_cast<double>(fNumStates * bytesPerState()));
+				fProfiler->finish(measurement, name, qubits, fDeviceTime, bytes);
+				return;
+			}
+#endif
+			apply();
+		}
+
+		/** Returns the physical qubit of the logical one, qubits out of range are returned unchanged. */
+		size_t physicalQubit(size_t qubit) const;
+
+		/** One- and two-qubit gates are passed as fixed-size matrices, so applying them never allocates. */
+		virtual void applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) = 0;
+		virtual void applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) = 0;
+		virtual void applyKQubitGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) = 0;
+
+		/**
+		 * Hooks for gates with a structure, gate() dispatches to them after validating the target qubits.
+		 * The default implementations apply the dense matrix of the gate, registers with kernels for the structure
+		 * override them.
+		 */
+		virtual void applyDiagonalGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits);
+		/** Applies a permutation or monomial gate. */
+		virtual void applyMonomialGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits);
+		virtual void applyControlledGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits);
+
+		/** Validates the target qubits and dispatches the gate to the hook of its structure. */
+		void dispatchGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits);
+
+		/** Applies the dense matrix of the gate using the one-, two- or k-qubit hook. */
+		void applyGateMatrix(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits);
+
+		/**
+		 * Splits the target qubits of a controlled gate into the control qubits and the targets of its target matrix.
+		 * @return pair of the targets of the target matrix and the control qubits
+		 */
+		static std::pair<std::vector<size_t>, std::vector<size_t>> splitControls(const QuantumLogicGate<T> &gate,
+																				 const std::vector<size_t> &targetQubits);
+
+		/**
+		 * Applies one of the standard gates, the named gate methods dispatch here. The default implementation applies
+		 * the dense matrix of the gate, registers with dedicated kernels override it.
+		 * @param gate kind of the gate
+		 * @param qubits target qubit, for controlled gates followed by the control qubit, for Swap both qubits;
+		 * the second qubit is ignored by one-qubit gates
+		 * @param factor phase of Phase and ControlledPhase gates
+		 */
+		virtual void applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor);
 	};
 }
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include <array>
+
+namespace KQS::Circuit {
+
+	/**
+	 * Maps state indices under a permutation of qubits: bit q of an index moves to bit permutation[q]. The bits
+	 * move independently, so the mapped index is the OR of table lookups for every byte of the index.
+	 */
+	class QubitPermutation {
+	private:
+		std::vector<std::array<size_t, 256>> fTables;
+
+	public:
+		explicit QubitPermutation(const std::vector<size_t> &permutation)
+				: fTables((permutation.size() + 7) / 8) {
+			for (size_t b = 0; b < fTables.size(); ++b) {
+				for (size_t value = 0; value < 256; ++value) {
+					size_t mapped = 0;
+					for (size_t bit = 0; bit < 8 && 8 * b + bit < permutation.size(); ++bit)
+						mapped |= ((value >> bit) & 1ULL) << permutation[8 * b + bit];
+					fTables[b][value] = mapped;
+				}
+			}
+		}
+
+		size_t operator()(size_t index) const {
+			size_t mapped = 0;
+			for (size_t b = 0; b < fTables.size(); ++b)
+				mapped |= fTables[b][(index >> (8 * b)) & 0xFF];
+			return mapped;
+		}
+
+		/** Lookup tables of the bytes of the index, entry v of table b holds byte value v at byte b mapped. */
+		const std::vector<std::array<size_t, 256>> &tables() const {
+			return fTables;
+		}
+
+		/** Returns the inverse of the permutation. */
+		static std::vector<size_t> inverse(const std::vector<size_t> &permutation) {
+			std::vector<size_t> result(permutation.size());
+			for (size_t q = 0; q < permutation.size(); ++q)
+				result[permutation[q]] = q;
+			return result;
+		}
+	};
+}
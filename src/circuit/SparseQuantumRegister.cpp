@@ -0,0 +1,410 @@
+#include <cmath>
+#include <format>
+#include <numeric>
+#include <algorithm>
+#include "SparseQuantumRegister.h"
+#include "VectorizedQuantumRegister.h"
+#include "QubitPermutation.h"
+#include "DenseGateKernels.h"
+
+namespace KQS::Circuit {
+
+	template<typename T>
+	SparseQuantumRegister<T>::SparseQuantumRegister(size_t numberOfQubits, double denseThreshold)
+			: QuantumRegister<T>(numberOfQubits), fDenseThreshold(denseThreshold) {
+		if (numberOfQubits > 64)
+			throw std::runtime_error(
+					std::format("Sparse register of {} qubits cannot index its states, at most 64", numberOfQubits));
+		fAmplitudes[0] = 1;
+	}
+
+	template<typename T>
+	double SparseQuantumRegister<T>::denseThreshold() const {
+		return fDenseThreshold;
+	}
+
+	template<typename T>
+	bool SparseQuantumRegister<T>::isDense() const {
+		return fDense != nullptr;
+	}
+
+	template<typename T>
+	size_t SparseQuantumRegister<T>::nonZeros() const {
+		return fDense ? fNumStates : fAmplitudes.size();
+	}
+
+	template<typename T>
+	std::vector<std::pair<size_t, std::complex<T>>> SparseQuantumRegister<T>::amplitudes() const {
+		QubitPermutation toLogical(QubitPermutation::inverse(fQubitMap));
+
+		std::vector<std::pair<size_t, complex_t>> result;
+		if (fDense) {
+			std::vector<complex_t> physical = fDense->stateVector();
+			for (size_t i = 0; i < physical.size(); ++i)
+				if (physical[i] != complex_t(0))
+					result.emplace_back(toLogical(i), physical[i]);
+		} else {
+			result.reserve(fAmplitudes.size());
+			fAmplitudes.forEach([&](size_t index, complex_t amplitude) {
+				result.emplace_back(toLogical(index), amplitude);
+			});
+		}
+
+		std::ranges::sort(result, {}, &std::pair<size_t, complex_t>::first);
+		return result;
+	}
+
+	template<typename T>
+	T SparseQuantumRegister<T>::norm() const {
+		if (fDense)
+			return fDense->norm();
+
+		double sum = 0;
+		fAmplitudes.forEach([&sum](size_t, complex_t amplitude) { sum += std::norm(amplitude); });
+		return static_cast<real_t>(sum);
+	}
+
+	/// Physical state ///
+
+	template<typename T>
+	void SparseQuantumRegister<T>::setPhysicalStateVector(const std::vector<complex_t> &stateVector) {
+		checkIndexable();
+		if (stateVector.size() != fNumStates)
+			throw std::runtime_error(std::format("State vector of size {} cannot be set to {}-qubit register",
+												 stateVector.size(), fNumQubits));
+
+		size_t nonZeros = std::ranges::count_if(stateVector, [](complex_t a) { return a != complex_t(0); });
+		if (static_cast<double>(nonZeros) > fDenseThreshold * static_cast<double>(fNumStates)) {
+			if (!fDense)
+				fDense = std::make_unique<VectorizedQuantumRegister<T>>(fNumQubits);
+			fDense->setStateVector(stateVector);
+			fAmplitudes.reserve(0);
+			return;
+		}
+
+		fDense.reset();
+		fAmplitudes.reserve(nonZeros);
+		for (size_t i = 0; i < stateVector.size(); ++i)
+			if (stateVector[i] != complex_t(0))
+				fAmplitudes[i] = stateVector[i];
+	}
+
+	template<typename T>
+	std::vector<std::complex<T>> SparseQuantumRegister<T>::physicalStateVector() const {
+		if (fDense)
+			return fDense->stateVector();
+
+		checkIndexable();
+		std::vector<complex_t> result(fNumStates);
+		fAmplitudes.forEach([&result](size_t index, complex_t amplitude) { result[index] = amplitude; });
+		return result;
+	}
+
+	template<typename T>
+	void SparseQuantumRegister<T>::readPhysicalStateVector(const StateChunkCallback &callback) const {
+		if (fDense)
+			fDense->readStateVector(callback);
+		else
+			callback(0, physicalStateVector());
+	}
+
+	template<typename T>
+	std::vector<T> SparseQuantumRegister<T>::physicalMarginals() const {
+		if (fDense)
+			return fDense->marginals();
+
+		std::vector<double> sums(fNumQubits);
+		fAmplitudes.forEach([&](size_t index, complex_t amplitude) {
+			double prob = std::norm(amplitude);
+			for (size_t q = 0; q < fNumQubits; ++q)
+				if ((index >> q & 1) == 1)
+					sums[q] += prob;
+		});
+		return {sums.begin(), sums.end()};
+	}
+
+	template<typename T>
+	std::vector<std::complex<double>> SparseQuantumRegister<T>::physicalReducedDensityMatrix(
+			const std::vector<size_t> &qubits) const {
+		if (fDense)
+			return fDense->reducedDensityMatrix(qubits);
+
+		size_t dimension = 1ULL << qubits.size();
+		size_t mask = 0;
+		for (size_t qubit: qubits)
+			mask |= 1ULL << qubit;
+		std::vector<size_t> offsets = Kernels::groupOffsets(qubits);
+
+		// every stored amplitude is paired with the amplitudes of its group, missing ones are zero
+		std::vector<std::complex<double>> result(dimension * dimension);
+		fAmplitudes.forEach([&](size_t index, complex_t amplitude) {
+			size_t a = 0;
+			for (size_t q = 0; q < qubits.size(); ++q)
+				a |= ((index >> qubits[q]) & 1ULL) << q;
+			for (size_t b = 0; b < dimension; ++b) {
+				complex_t partner = fAmplitudes.at((index & ~mask) | offsets[b]);
+				result[a * dimension + b] += std::complex<double>(amplitude) * std::conj(std::complex<double>(partner));
+			}
+		});
+		return result;
+	}
+
+	template<typename T>
+	std::vector<size_t> SparseQuantumRegister<T>::samplePhysical(std::span<const real_t> randomNumbers) const {
+		if (fDense)
+			return fDense->sample(randomNumbers);
+
+		// the entries in the order of the states, so the outcomes match those of a dense register
+		std::vector<std::pair<size_t, double>> entries;
+		entries.reserve(fAmplitudes.size());
+		fAmplitudes.forEach([&entries](size_t index, complex_t amplitude) {
+			entries.emplace_back(index, std::norm(amplitude));
+		});
+		std::ranges::sort(entries, {}, &std::pair<size_t, double>::first);
+
+		double total = 0;
+		for (auto &[index, prob]: entries)
+			total += prob;
+
+		std::vector<size_t> order(randomNumbers.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::ranges::sort(order, {}, [&randomNumbers](size_t i) { return randomNumbers[i]; });
+
+		std::vector<size_t> samples(randomNumbers.size());
+		size_t next = 0;
+		double cumulative = 0;
+		for (const auto &[index, prob]: entries) {
+			cumulative += prob;
+			while (next < order.size() && randomNumbers[order[next]] * total < cumulative)
+				samples[order[next++]] = index;
+		}
+
+		// shots left over due to rounding belong to the last state
+		for (; next < order.size(); ++next)
+			samples[order[next]] = entries.empty() ? 0 : entries.back().first;
+		return samples;
+	}
+
+	template<typename T>
+	void SparseQuantumRegister<T>::permutePhysicalQubits(const std::vector<size_t> &permutation) {
+		if (fDense) {
+			QuantumRegister<T>::permutePhysicalQubits(permutation);
+			return;
+		}
+
+		QubitPermutation move(permutation);
+		moveIndices(move);
+	}
+
+	template<typename T>
+	size_t SparseQuantumRegister<T>::bytesPerState() const {
+		return fDense ? sizeof(complex_t) : 0;
+	}
+
+	/// Gates ///
+
+	template<typename T>
+	void SparseQuantumRegister<T>::applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) {
+		if (fDense)
+			fDense->gate(QuantumLogicGate<T>(matrix), {targetQubit});
+		else
+			applyMatrix(matrix.data(), {targetQubit});
+	}
+
+	template<typename T>
+	void SparseQuantumRegister<T>::applyTwoQubitGate(const SmallMatrix<T, 4> &matrix,
+													 std::array<size_t, 2> targetQubits) {
+		if (fDense)
+			fDense->gate(QuantumLogicGate<T>(matrix), {targetQubits[0], targetQubits[1]});
+		else
+			applyMatrix(matrix.data(), {targetQubits[0], targetQubits[1]});
+	}
+
+	template<typename T>
+	void SparseQuantumRegister<T>::applyKQubitGate(const QuantumLogicGate<T> &gate,
+												   const std::vector<size_t> &targetQubits) {
+		if (fDense)
+			fDense->gate(gate, targetQubits);
+		else
+			applyMatrix(gate.matrix().data(), targetQubits);
+	}
+
+	template<typename T>
+	void SparseQuantumRegister<T>::applyDiagonalGate(const QuantumLogicGate<T> &gate,
+													 const std::vector<size_t> &targetQubits) {
+		applyKQubitGate(gate, targetQubits);
+	}
+
+	template<typename T>
+	void SparseQuantumRegister<T>::applyMonomialGate(const QuantumLogicGate<T> &gate,
+													 const std::vector<size_t> &targetQubits) {
+		applyKQubitGate(gate, targetQubits);
+	}
+
+	template<typename T>
+	void SparseQuantumRegister<T>::applyControlledGate(const QuantumLogicGate<T> &gate,
+													   const std::vector<size_t> &targetQubits) {
+		applyKQubitGate(gate, targetQubits);
+	}
+
+	template<typename T>
+	void SparseQuantumRegister<T>::applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits,
+													 complex_t factor) {
+		size_t target = qubits[0];
+		size_t other = qubits[1];
+		if (fDense) {
+			switch (gate) {
+				case StandardGate::PauliX:
+					fDense->pauliX(target);
+					break;
+				case StandardGate::PauliY:
+					fDense->pauliY(target);
+					break;
+				case StandardGate::Hadamard:
+					fDense->hadamard(target);
+					break;
+				case StandardGate::Phase:
+					fDense->phase(target, std::arg(factor));
+					break;
+				case StandardGate::ControlledX:
+					fDense->controlledX(other, target);
+					break;
+				case StandardGate::ControlledPhase:
+					fDense->controlledPhase(other, target, std::arg(factor));
+					break;
+				case StandardGate::Swap:
+					fDense->swap(target, other);
+					break;
+			}
+			return;
+		}
+
+		size_t targetBit = 1ULL << target;
+		size_t otherBit = 1ULL << other;
+		switch (gate) {
+			case StandardGate::PauliX:
+				moveIndices([=](size_t i) { return i ^ targetBit; });
+				break;
+			case StandardGate::ControlledX:
+				moveIndices([=](size_t i) { return i & otherBit ? i ^ targetBit : i; });
+				break;
+			case StandardGate::Swap:
+				moveIndices([=](size_t i) {
+					bool differ = ((i >> target) & 1) != ((i >> other) & 1);
+					return differ ? i ^ targetBit ^ otherBit : i;
+				});
+				break;
+			case StandardGate::Phase:
+				fAmplitudes.forEach([=](size_t i, complex_t &amplitude) {
+					if (i & targetBit)
+						amplitude *= factor;
+				});
+				break;
+			case StandardGate::ControlledPhase:
+				fAmplitudes.forEach([=](size_t i, complex_t &amplitude) {
+					if ((i & targetBit) && (i & otherBit))
+						amplitude *= factor;
+				});
+				break;
+			default:
+				QuantumRegister<T>::applyStandardGate(gate, qubits, factor);
+				break;
+		}
+	}
+
+	/// Private methods ///
+
+	template<typename T>
+	void SparseQuantumRegister<T>::applyMatrix(std::span<const complex_t> matrix, const std::vector<size_t> &qubits) {
+		size_t dimension = 1ULL << qubits.size();
+		size_t mask = 0;
+		std::vector<size_t> offsets(dimension);
+		for (size_t b = 0; b < qubits.size(); ++b) {
+			mask |= 1ULL << qubits[b];
+			for (size_t j = 0; j < dimension; ++j)
+				offsets[j] |= ((j >> b) & 1ULL) << qubits[b];
+		}
+		auto local = [&qubits](size_t index) {
+			size_t result = 0;
+			for (size_t b = 0; b < qubits.size(); ++b)
+				result |= ((index >> qubits[b]) & 1ULL) << b;
+			return result;
+		};
+
+		// non-zero elements of every column, the amplitude of local state c is scattered to them
+		bool diagonal = true;
+		std::vector<std::vector<std::pair<size_t, complex_t>>> columns(dimension);
+		for (size_t r = 0; r < dimension; ++r) {
+			for (size_t c = 0; c < dimension; ++c) {
+				complex_t element = matrix[r * dimension + c];
+				if (element != complex_t(0)) {
+					columns[c].emplace_back(r, element);
+					diagonal &= r == c;
+				}
+			}
+		}
+
+		if (diagonal) {
+			fAmplitudes.forEach([&](size_t index, complex_t &amplitude) {
+				size_t c = local(index);
+				amplitude *= columns[c].empty() ? complex_t(0) : columns[c][0].second;
+			});
+		} else {
+			AmplitudeMap<T> result;
+			result.reserve(fAmplitudes.size());
+			fAmplitudes.forEach([&](size_t index, complex_t amplitude) {
+				size_t base = index & ~mask;
+				for (const auto &[r, element]: columns[local(index)]) {
+					complex_t &target = result[base | offsets[r]];
+					target = multiplyAdd(element, amplitude, target);
+				}
+			});
+			fAmplitudes = std::move(result);
+		}
+
+		compact();
+	}
+
+	template<typename T>
+	template<typename F>
+	void SparseQuantumRegister<T>::moveIndices(F &&target) {
+		AmplitudeMap<T> result;
+		result.reserve(fAmplitudes.size());
+		fAmplitudes.forEach([&](size_t index, complex_t amplitude) { result[target(index)] = amplitude; });
+		fAmplitudes = std::move(result);
+	}
+
+	template<typename T>
+	void SparseQuantumRegister<T>::compact() {
+		size_t pruned = 0;
+		fAmplitudes.forEach([&pruned](size_t, complex_t amplitude) { pruned += std::abs(amplitude) < PruneTolerance; });
+		if (pruned > 0) {
+			AmplitudeMap<T> result;
+			result.reserve(fAmplitudes.size() - pruned);
+			fAmplitudes.forEach([&result](size_t index, complex_t amplitude) {
+				if (std::abs(amplitude) >= PruneTolerance)
+					result[index] = amplitude;
+			});
+			fAmplitudes = std::move(result);
+		}
+
+		// registers of 64 qubits have no state count and always stay sparse
+		double states = static_cast<double>(fNumStates);
+		if (fNumStates == 0 || static_cast<double>(fAmplitudes.size()) <= fDenseThreshold * states)
+			return;
+
+		std::vector<complex_t> stateVector = physicalStateVector();
+		fDense = std::make_unique<VectorizedQuantumRegister<T>>(fNumQubits);
+		fDense->setStateVector(stateVector);
+		fAmplitudes.reserve(0);
+	}
+
+	template<typename T>
+	void SparseQuantumRegister<T>::checkIndexable() const {
+		if (fNumStates == 0 || fNumStates > std::vector<complex_t>().max_size())
+			throw std::runtime_error(std::format("State vector of {}-qubit register cannot be indexed", fNumQubits));
+	}
+
+	template class SparseQuantumRegister<float>;
+	template class SparseQuantumRegister<double>;
+}
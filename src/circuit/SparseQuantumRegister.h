@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <array>
+#include <limits>
+#include "../types.h"
+#include "QuantumLogicGate.h"
+#include "QuantumRegister.h"
+#include "AmplitudeMap.h"
+
+namespace KQS::Circuit {
+
+	/**
+	 * Quantum register storing only the non-zero amplitudes, in a hash map from basis state indices to amplitudes.
+	 * Gates iterate the non-zero entries: diagonal gates scale them in place, X, CNOT and swaps only move their
+	 * indices and other gates scatter every entry to the non-zero elements of its column of the gate matrix. Circuits
+	 * on basis states that are mostly permutations (X, CNOT, Toffoli, reversible arithmetic and oracles) keep a
+	 * handful of entries, so they run on up to 64 qubits in time independent of 2^n.
+	 *
+	 * When the fraction of non-zero amplitudes exceeds the dense threshold, the state moves to a
+	 * VectorizedQuantumRegister which applies all further gates, until a sparse state vector is set. Amplitudes whose
+	 * magnitude falls below PruneTolerance, e.g. after interference, are dropped.
+	 * @tparam T type of the real and imaginary parts of the amplitudes
+	 */
+	template<typename T>
+	class SparseQuantumRegister : public QuantumRegister<T> {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+		using typename QuantumRegister<T>::StateChunkCallback;
+
+		/** Amplitudes of smaller magnitude are removed from the map. */
+		static constexpr real_t PruneTolerance = 16 * std::numeric_limits<real_t>::epsilon();
+
+	protected:
+		using QuantumRegister<T>::fNumQubits;
+		using QuantumRegister<T>::fNumStates;
+		using QuantumRegister<T>::fQubitMap;
+
+		double fDenseThreshold;
+		/** Non-zero amplitudes by physical index while the state is sparse. */
+		AmplitudeMap<T> fAmplitudes;
+		/** Register holding the state once it is dense, its logical qubits are the physical qubits of this one. */
+		std::unique_ptr<QuantumRegister<T>> fDense;
+
+	public:
+		/**
+		 * Creates the register in state |0...0>.
+		 * @param numberOfQubits number of qubits, at most 64
+		 * @param denseThreshold fraction of non-zero amplitudes above which the state is stored densely, 1 to stay
+		 * sparse
+		 */
+		explicit SparseQuantumRegister(size_t numberOfQubits, double denseThreshold = 1.0 / 16);
+
+		double denseThreshold() const;
+
+		/** Whether the state moved to a dense register. */
+		bool isDense() const;
+
+		/** Number of stored amplitudes, 2^n once the state is dense. */
+		size_t nonZeros() const;
+
+		/** Returns the non-zero amplitudes with their indices in the logical order of the qubits, sorted by index. */
+		std::vector<std::pair<size_t, complex_t>> amplitudes() const;
+
+		real_t norm() const override;
+
+	protected:
+		/** Stores the state sparsely if its fraction of non-zero amplitudes is below the threshold. */
+		void setPhysicalStateVector(const std::vector<complex_t> &stateVector) override;
+		std::vector<complex_t> physicalStateVector() const override;
+		void readPhysicalStateVector(const StateChunkCallback &callback) const override;
+		std::vector<real_t> physicalMarginals() const override;
+		std::vector<std::complex<double>> physicalReducedDensityMatrix(const std::vector<size_t> &qubits) const override;
+		std::vector<size_t> samplePhysical(std::span<const real_t> randomNumbers) const override;
+
+		/** Moves the indices of the entries, dense states swap the qubits of their register. */
+		void permutePhysicalQubits(const std::vector<size_t> &permutation) override;
+
+		/** Dense states report the traffic of their register, sparse states none. */
+		size_t bytesPerState() const override;
+
+		void applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) override;
+		void applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) override;
+		void applyKQubitGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyDiagonalGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyMonomialGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void applyControlledGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+
+		/**
+		 * X, CNOT and swaps move the indices of the entries and phases scale them in place, dense states use the
+		 * named gates of their register.
+		 */
+		void applyStandardGate(StandardGate gate, std::array<size_t, 2> qubits, complex_t factor) override;
+
+	private:
+		/**
+		 * Applies a gate matrix to the entries, in place if it is diagonal.
+		 * @param matrix row-major 2^k x 2^k matrix, bit j of its indices is the value of qubit j
+		 * @param qubits physical qubits of the gate
+		 */
+		void applyMatrix(std::span<const complex_t> matrix, const std::vector<size_t> &qubits);
+
+		/** Moves the amplitude of every index i to index f(i), f must be a bijection. */
+		template<typename F>
+		void moveIndices(F &&target);
+
+		/** Removes the amplitudes below PruneTolerance and moves the state to a dense register if it is too full. */
+		void compact();
+
+		/** Throws if the register has too many qubits to hold its state vector. */
+		void checkIndexable() const;
+	};
+}
@@ -0,0 +1,411 @@
+#include <format>
+#include <algorithm>
+#include <cstdint>
+#include "SplitQuantumRegister.h"
+#include "PermutationKernels.h"
+#include "immintrin.h"
+
+namespace KQS::Circuit {
+
+	/// AVX operations on vectors of real or imaginary parts ///
+
+	template<typename T>
+	struct SplitVector;
+
+	template<>
+	struct SplitVector<float> {
+		using type = __m256;
+		/** Number of amplitudes in one vector and the number of qubits they span. */
+		static constexpr size_t Width = 8;
+		static constexpr size_t Qubits = 3;
+
+		static type load(const float *data) { return _mm256_loadu_ps(data); }
+		static void store(float *data, type value) { _mm256_storeu_ps(data, value); }
+		static type set1(float value) { return _mm256_set1_ps(value); }
+		static type zero() { return _mm256_setzero_ps(); }
+		static type fmadd(type a, type b, type c) { return _mm256_fmadd_ps(a, b, c); }
+		static type fnmadd(type a, type b, type c) { return _mm256_fnmadd_ps(a, b, c); }
+
+		/** Indices of a permutation moving the amplitude of lane `lane ^ mask` to every lane. */
+		static __m256i lanePermutation(size_t mask) {
+			alignas(32) int32_t indices[Width];
+			for (size_t lane = 0; lane < Width; ++lane)
+				indices[lane] = static_cast<int32_t>(lane ^ mask);
+			return _mm256_load_si256(reinterpret_cast<const __m256i *>(indices));
+		}
+
+		static type permute(type value, __m256i permutation) { return _mm256_permutevar8x32_ps(value, permutation); }
+	};
+
+	template<>
+	struct SplitVector<double> {
+		using type = __m256d;
+		static constexpr size_t Width = 4;
+		static constexpr size_t Qubits = 2;
+
+		static type load(const double *data) { return _mm256_loadu_pd(data); }
+		static void store(double *data, type value) { _mm256_storeu_pd(data, value); }
+		static type set1(double value) { return _mm256_set1_pd(value); }
+		static type zero() { return _mm256_setzero_pd(); }
+		static type fmadd(type a, type b, type c) { return _mm256_fmadd_pd(a, b, c); }
+		static type fnmadd(type a, type b, type c) { return _mm256_fnmadd_pd(a, b, c); }
+
+		/** Doubles are permuted as pairs of 32-bit halves. */
+		static __m256i lanePermutation(size_t mask) {
+			alignas(32) int32_t indices[2 * Width];
+			for (size_t lane = 0; lane < Width; ++lane) {
+				indices[2 * lane] = static_cast<int32_t>(2 * (lane ^ mask));
+				indices[2 * lane + 1] = static_cast<int32_t>(2 * (lane ^ mask) + 1);
+			}
+			return _mm256_load_si256(reinterpret_cast<const __m256i *>(indices));
+		}
+
+		static type permute(type value, __m256i permutation) {
+			return _mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(value), permutation));
+		}
+	};
+
+	/** Accumulates the product of complex vectors c and x into y, every part being a separate vector. */
+	template<typename V>
+	inline void complexMultiplyAdd(typename V::type cRe, typename V::type cIm, typename V::type xRe,
+								   typename V::type xIm, typename V::type &yRe, typename V::type &yIm) {
+		yRe = V::fmadd(cRe, xRe, yRe);
+		yRe = V::fnmadd(cIm, xIm, yRe);
+		yIm = V::fmadd(cRe, xIm, yIm);
+		yIm = V::fmadd(cIm, xRe, yIm);
+	}
+
+	/** Largest gate dimension applied by the vector kernel, larger gates use the scalar kernel. */
+	constexpr size_t MaxSplitVectorDimension = 64;
+
+	/**
+	 * Applies a gate whose targets are all at or above V::Qubits. Width consecutive groups are then Width consecutive
+	 * states at every offset, so every vector holds the same state of Width groups and the matrix elements are
+	 * broadcast. D is the dimension of the gate if known at compile time, zero otherwise.
+	 */
+	template<typename V, size_t D, typename T, typename FirstState>
+	void applyGroupsSplit(T *re, T *im, size_t groups, size_t dimension, const std::vector<size_t> &offsets,
+						  const std::vector<T> &mRe, const std::vector<T> &mIm, FirstState firstState) {
+		using vec = typename V::type;
+		const size_t dim = D != 0 ? D : dimension;
+
+		vec xRe[D != 0 ? D : MaxSplitVectorDimension];
+		vec xIm[D != 0 ? D : MaxSplitVectorDimension];
+		for (size_t g = 0; g < groups; g += V::Width) {
+			size_t state = firstState(g);
+
+			for (size_t j = 0; j < dim; ++j) {
+				xRe[j] = V::load(re + state + offsets[j]);
+				xIm[j] = V::load(im + state + offsets[j]);
+			}
+
+			for (size_t r = 0; r < dim; ++r) {
+				vec yRe = V::zero(), yIm = V::zero();
+				for (size_t c = 0; c < dim; ++c)
+					complexMultiplyAdd<V>(V::set1(mRe[r * dim + c]), V::set1(mIm[r * dim + c]), xRe[c], xIm[c],
+										  yRe, yIm);
+
+				V::store(re + state + offsets[r], yRe);
+				V::store(im + state + offsets[r], yIm);
+			}
+		}
+	}
+
+	/**
+	 * Applies a gate with some targets below V::Qubits, whose states of a group share a vector. The vectors at the
+	 * offsets of the high targets are loaded and permuted by every combination of the low targets, so each lane
+	 * meets every state of its group. Each such product gets its own vector of matrix elements, one per lane.
+	 * H and P are the numbers of loaded vectors and of permutations if known at compile time, zero otherwise.
+	 */
+	template<typename V, size_t H, size_t P, typename T>
+	void applyMixedSplit(T *re, T *im, size_t numStates, std::span<const std::complex<T>> m,
+						 const std::vector<size_t> &targetQubits) {
+		using vec = typename V::type;
+
+		// indices of the targets within and above a vector
+		std::vector<size_t> low, high;
+		for (size_t k = 0; k < targetQubits.size(); ++k)
+			(targetQubits[k] < V::Qubits ? low : high).push_back(k);
+
+		const size_t highDimension = H != 0 ? H : 1ULL << high.size();
+		const size_t patterns = P != 0 ? P : 1ULL << low.size();
+
+		// lanes exchanged by each combination of the low targets
+		std::vector<size_t> patternMasks(patterns, 0);
+		__m256i permutations[1ULL << V::Qubits];
+		for (size_t p = 0; p < patterns; ++p) {
+			for (size_t i = 0; i < low.size(); ++i)
+				patternMasks[p] |= ((p >> i) & 1) << targetQubits[low[i]];
+			permutations[p] = V::lanePermutation(patternMasks[p]);
+		}
+
+		// index of the state of a lane in the given vector of a group into the gate matrix
+		auto matrixIndex = [&](size_t lane, size_t vector) {
+			size_t index = 0;
+			for (size_t k: low)
+				index |= ((lane >> targetQubits[k]) & 1) << k;
+			for (size_t i = 0; i < high.size(); ++i)
+				index |= ((vector >> i) & 1) << high[i];
+			return index;
+		};
+
+		std::vector<T> cRe(highDimension * highDimension * patterns * V::Width);
+		std::vector<T> cIm(cRe.size());
+		for (size_t out = 0; out < highDimension; ++out)
+			for (size_t in = 0; in < highDimension; ++in)
+				for (size_t p = 0; p < patterns; ++p)
+					for (size_t lane = 0; lane < V::Width; ++lane) {
+						size_t index = ((out * highDimension + in) * patterns + p) * V::Width + lane;
+						auto element = m[(matrixIndex(lane, out) << targetQubits.size()) |
+										 matrixIndex(lane ^ patternMasks[p], in)];
+						cRe[index] = element.real();
+						cIm[index] = element.imag();
+					}
+
+		std::vector<size_t> offsets(highDimension, 0);
+		for (size_t h = 0; h < highDimension; ++h)
+			for (size_t i = 0; i < high.size(); ++i)
+				offsets[h] |= ((h >> i) & 1) << targetQubits[high[i]];
+
+		std::vector<size_t> highPositions;
+		for (size_t k: high)
+			highPositions.push_back(targetQubits[k]);
+		std::ranges::sort(highPositions);
+
+		// with known sizes the matrix elements are kept in registers, the compiler must reload them otherwise,
+		// because they might alias the state vector
+		constexpr bool Known = H != 0 && P != 0;
+		vec knownRe[Known ? H * H * P : 1], knownIm[Known ? H * H * P : 1];
+		if constexpr (Known)
+			for (size_t index = 0; index < H * H * P; ++index) {
+				knownRe[index] = V::load(cRe.data() + index * V::Width);
+				knownIm[index] = V::load(cIm.data() + index * V::Width);
+			}
+
+		vec xRe[Known ? H * P : MaxSplitVectorDimension], xIm[Known ? H * P : MaxSplitVectorDimension];
+		for (size_t v = 0; v < numStates / highDimension; v += V::Width) {
+			size_t state = v;
+			for (size_t position: highPositions) {
+				size_t mask = (1ULL << position) - 1;
+				state = ((state & ~mask) << 1) | (state & mask);
+			}
+
+			for (size_t in = 0; in < highDimension; ++in) {
+				vec loadedRe = V::load(re + state + offsets[in]);
+				vec loadedIm = V::load(im + state + offsets[in]);
+				for (size_t p = 0; p < patterns; ++p) {
+					xRe[in * patterns + p] = V::permute(loadedRe, permutations[p]);
+					xIm[in * patterns + p] = V::permute(loadedIm, permutations[p]);
+				}
+			}
+
+			for (size_t out = 0; out < highDimension; ++out) {
+				vec yRe = V::zero(), yIm = V::zero();
+				for (size_t j = 0; j < highDimension * patterns; ++j) {
+					size_t index = out * highDimension * patterns + j;
+					if constexpr (Known)
+						complexMultiplyAdd<V>(knownRe[index], knownIm[index], xRe[j], xIm[j], yRe, yIm);
+					else
+						complexMultiplyAdd<V>(V::load(cRe.data() + index * V::Width),
+											  V::load(cIm.data() + index * V::Width), xRe[j], xIm[j], yRe, yIm);
+				}
+
+				V::store(re + state + offsets[out], yRe);
+				V::store(im + state + offsets[out], yIm);
+			}
+		}
+	}
+
+	/// Register ///
+
+	template<typename T>
+	SplitQuantumRegister<T>::SplitQuantumRegister(size_t numberOfQubits)
+			: QuantumRegister<T>(numberOfQubits), fReal(fNumStates), fImag(fNumStates) {
+		fReal[0] = 1;
+	}
+
+	template<typename T>
+	void SplitQuantumRegister<T>::setPhysicalStateVector(const std::vector<complex_t> &stateVector) {
+		if (stateVector.size() != fNumStates)
+			throw std::runtime_error(std::format("State vector of size {} cannot be set to {}-qubit register",
+												 stateVector.size(), fNumQubits));
+
+		for (size_t i = 0; i < fNumStates; ++i) {
+			fReal[i] = stateVector[i].real();
+			fImag[i] = stateVector[i].imag();
+		}
+	}
+
+	template<typename T>
+	std::vector<std::complex<T>> SplitQuantumRegister<T>::physicalStateVector() const {
+		std::vector<complex_t> result(fNumStates);
+		for (size_t i = 0; i < fNumStates; ++i)
+			result[i] = complex_t(fReal[i], fImag[i]);
+
+		return result;
+	}
+
+	template<typename T>
+	void SplitQuantumRegister<T>::readPhysicalStateVector(const StateChunkCallback &callback) const {
+		// interleaved in chunks, so that the complex copy of the whole state vector is never needed
+		std::vector<complex_t> chunk(std::min<size_t>(fNumStates, 1 << 16));
+
+		for (size_t offset = 0; offset < fNumStates; offset += chunk.size()) {
+			size_t size = std::min(chunk.size(), fNumStates - offset);
+			for (size_t i = 0; i < size; ++i)
+				chunk[i] = complex_t(fReal[offset + i], fImag[offset + i]);
+
+			callback(offset, std::span<const complex_t>(chunk.data(), size));
+		}
+	}
+
+	template<typename T>
+	std::vector<std::complex<double>> SplitQuantumRegister<T>::physicalReducedDensityMatrix(
+			const std::vector<size_t> &qubits) const {
+		return Kernels::reducedDensityMatrix(fNumStates, qubits, [this](size_t i) {
+			return complex_t(fReal[i], fImag[i]);
+		});
+	}
+
+	template<typename T>
+	T SplitQuantumRegister<T>::norm() const {
+		double sum = 0;
+		for (size_t i = 0; i < fNumStates; ++i)
+			sum += static_cast<double>(fReal[i]) * fReal[i] + static_cast<double>(fImag[i]) * fImag[i];
+
+		return static_cast<real_t>(sum);
+	}
+
+	template<typename T>
+	void SplitQuantumRegister<T>::applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) {
+		applyMatrix(matrix.data(), {targetQubit});
+	}
+
+	template<typename T>
+	void SplitQuantumRegister<T>::applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) {
+		applyMatrix(matrix.data(), {targetQubits[0], targetQubits[1]});
+	}
+
+	template<typename T>
+	void SplitQuantumRegister<T>::applyKQubitGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
+		if (gate.matrix().rows() != 1ULL << targetQubits.size())
+			throw std::runtime_error(std::format("Gate of dimension {} cannot be applied to {} qubits",
+												 gate.matrix().rows(), targetQubits.size()));
+
+		applyMatrix(gate.matrix().data(), targetQubits);
+	}
+
+	template<typename T>
+	void SplitQuantumRegister<T>::permutePhysicalQubits(const std::vector<size_t> &permutation) {
+		std::vector<real_t> permuted(fNumStates);
+		for (std::vector<real_t> *part: {&fReal, &fImag}) {
+			Kernels::permuteQubits<1>(part->data(), permuted.data(), fNumQubits, permutation);
+			part->swap(permuted);
+		}
+	}
+
+	/// Private methods ///
+
+	template<typename T>
+	void SplitQuantumRegister<T>::applyMatrix(std::span<const complex_t> matrix, const std::vector<size_t> &targetQubits) {
+		using V = SplitVector<T>;
+
+		for (size_t targetQubit: targetQubits)
+			if (targetQubit >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Cannot apply gate to qubit {} in {}-qubit register", targetQubit, fNumQubits));
+
+		size_t dimension = 1ULL << targetQubits.size();
+		size_t groups = fNumStates / dimension;
+		if (fNumStates < V::Width * dimension || dimension > MaxSplitVectorDimension) {
+			applyGateScalar(matrix, targetQubits);
+			return;
+		}
+
+		size_t lowTargets = std::ranges::count_if(targetQubits, [](size_t q) { return q < V::Qubits; });
+		if (lowTargets > 0) {
+			if (dimension == 2)
+				applyMixedSplit<V, 1, 2>(fReal.data(), fImag.data(), fNumStates, matrix, targetQubits);
+			else if (dimension == 4 && lowTargets == 1)
+				applyMixedSplit<V, 2, 2>(fReal.data(), fImag.data(), fNumStates, matrix, targetQubits);
+			else if (dimension == 4)
+				applyMixedSplit<V, 1, 4>(fReal.data(), fImag.data(), fNumStates, matrix, targetQubits);
+			else
+				applyMixedSplit<V, 0, 0>(fReal.data(), fImag.data(), fNumStates, matrix, targetQubits);
+			return;
+		}
+
+		std::vector<real_t> mRe(dimension * dimension), mIm(dimension * dimension);
+		for (size_t i = 0; i < dimension * dimension; ++i) {
+			mRe[i] = matrix[i].real();
+			mIm[i] = matrix[i].imag();
+		}
+
+		// offset of each state of a group from the first state of the group
+		std::vector<size_t> offsets(dimension, 0);
+		for (size_t j = 0; j < dimension; ++j)
+			for (size_t k = 0; k < targetQubits.size(); ++k)
+				offsets[j] |= ((j >> k) & 1) << targetQubits[k];
+
+		// zero bits inserted in ascending order end up exactly at the target positions
+		std::vector<size_t> sortedTargets = targetQubits;
+		std::ranges::sort(sortedTargets);
+		auto firstState = [&sortedTargets](size_t group) {
+			for (size_t position: sortedTargets) {
+				size_t mask = (1ULL << position) - 1;
+				group = ((group & ~mask) << 1) | (group & mask);
+			}
+			return group;
+		};
+
+		switch (dimension) {
+			case 2:
+				applyGroupsSplit<V, 2>(fReal.data(), fImag.data(), groups, dimension, offsets, mRe, mIm, firstState);
+				break;
+			case 4:
+				applyGroupsSplit<V, 4>(fReal.data(), fImag.data(), groups, dimension, offsets, mRe, mIm, firstState);
+				break;
+			default:
+				applyGroupsSplit<V, 0>(fReal.data(), fImag.data(), groups, dimension, offsets, mRe, mIm, firstState);
+				break;
+		}
+	}
+
+	template<typename T>
+	void SplitQuantumRegister<T>::applyGateScalar(std::span<const complex_t> matrix, const std::vector<size_t> &targetQubits) {
+		size_t dimension = 1ULL << targetQubits.size();
+		size_t groups = fNumStates / dimension;
+
+		std::vector<size_t> offsets(dimension, 0);
+		for (size_t j = 0; j < dimension; ++j)
+			for (size_t k = 0; k < targetQubits.size(); ++k)
+				offsets[j] |= ((j >> k) & 1) << targetQubits[k];
+
+		std::vector<size_t> sortedTargets = targetQubits;
+		std::ranges::sort(sortedTargets);
+
+		ComplexVector<T> group(dimension);
+		for (size_t g = 0; g < groups; ++g) {
+			size_t state = g;
+			for (size_t position: sortedTargets) {
+				size_t mask = (1ULL << position) - 1;
+				state = ((state & ~mask) << 1) | (state & mask);
+			}
+
+			for (size_t j = 0; j < dimension; ++j)
+				group[j] = complex_t(fReal[state + offsets[j]], fImag[state + offsets[j]]);
+
+			for (size_t r = 0; r < dimension; ++r) {
+				complex_t value = 0;
+				for (size_t c = 0; c < dimension; ++c)
+					value += matrix[r * dimension + c] * group[c];
+
+				fReal[state + offsets[r]] = value.real();
+				fImag[state + offsets[r]] = value.imag();
+			}
+		}
+	}
+
+	template class SplitQuantumRegister<float>;
+	template class SplitQuantumRegister<double>;
+}
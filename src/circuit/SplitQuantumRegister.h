@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include <array>
+#include "../types.h"
+#include "QuantumLogicGate.h"
+#include "QuantumRegister.h"
+
+namespace KQS::Circuit {
+
+	/**
+	 * Quantum register storing the real and imaginary parts of the amplitudes in two separate arrays
+	 * (structure of arrays). A SIMD register then holds the same part of consecutive amplitudes, so the complex
+	 * multiply-adds of the AVX kernels are plain vertical FMAs without permutations and sign masks.
+	 * @tparam T type of the real and imaginary parts of the amplitudes, float or double
+	 */
+	template<typename T>
+	class SplitQuantumRegister : public QuantumRegister<T> {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+		using typename QuantumRegister<T>::StateChunkCallback;
+
+	protected:
+		using QuantumRegister<T>::fNumQubits;
+		using QuantumRegister<T>::fNumStates;
+
+		std::vector<real_t> fReal;
+		std::vector<real_t> fImag;
+
+	public:
+		explicit SplitQuantumRegister(size_t numberOfQubits);
+
+		real_t norm() const override;
+
+	protected:
+		void setPhysicalStateVector(const std::vector<complex_t> &stateVector) override;
+		std::vector<complex_t> physicalStateVector() const override;
+		void readPhysicalStateVector(const StateChunkCallback &callback) const override;
+		std::vector<std::complex<double>> physicalReducedDensityMatrix(const std::vector<size_t> &qubits) const override;
+
+		void applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) override;
+		void applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) override;
+		void applyKQubitGate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) override;
+		void permutePhysicalQubits(const std::vector<size_t> &permutation) override;
+
+	private:
+		/** Applies a gate given by its elements in row-major order. */
+		void applyMatrix(std::span<const complex_t> matrix, const std::vector<size_t> &targetQubits);
+		void applyGateScalar(std::span<const complex_t> matrix, const std::vector<size_t> &targetQubits);
+	};
+}
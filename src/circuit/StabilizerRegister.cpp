@@ -0,0 +1,485 @@
+#include <bit>
+#include <cmath>
+#include <format>
+#include <algorithm>
+#include "StabilizerRegister.h"
+#include "../algebra/Constants.h"
+#include "../parallel.h"
+
+namespace KQS::Circuit {
+
+	namespace {
+		/**
+		 * Exponent of i in the product of the Pauli strings (x1, z1) * (x2, z2) of 64 qubits, i.e. the sum of the
+		 * function g of CHP over the qubits. Qubits contribute +1 for the products XY, YZ and ZX and -1 for the
+		 * reversed products.
+		 */
+		int productPhase(uint64_t x1, uint64_t z1, uint64_t x2, uint64_t z2) {
+			uint64_t plus = (x1 & z1 & z2 & ~x2) | (x1 & ~z1 & x2 & z2) | (~x1 & z1 & x2 & ~z2);
+			uint64_t minus = (x1 & z1 & x2 & ~z2) | (x1 & ~z1 & ~x2 & z2) | (~x1 & z1 & x2 & z2);
+			return std::popcount(plus) - std::popcount(minus);
+		}
+
+		/** Image of a Pauli operator under conjugation with a gate, a Pauli string on the qubits of the gate. */
+		struct PauliImage {
+			uint64_t x;
+			uint64_t z;
+			bool negative;
+		};
+
+		/** Element (c ^ x, c) of the Pauli string (x, z), the only non-zero element of column c. */
+		std::complex<double> pauliElement(uint64_t x, uint64_t z, uint64_t column) {
+			double sign = std::popcount(z & column) % 2 ? -1 : 1;
+			// Y = i X Z
+			constexpr std::array<std::complex<double>, 4> powers = {1.0, {0, 1}, -1.0, {0, -1}};
+			return sign * powers[std::popcount(x & z) % 4];
+		}
+
+		/**
+		 * Computes U P U^+ for the Pauli operators X and Z of every qubit of the gate (in this order), which must all
+		 * be Pauli strings up to a sign for Clifford gates.
+		 */
+		template<typename T>
+		std::vector<PauliImage> cliffordImages(const ComplexMatrix<T> &matrix, size_t qubits, double tolerance) {
+			size_t dimension = 1ULL << qubits;
+			std::vector<std::complex<double>> unitary(dimension * dimension);
+			for (size_t r = 0; r < dimension; ++r)
+				for (size_t c = 0; c < dimension; ++c)
+					unitary[r * dimension + c] = std::complex<double>(matrix[r, c]);
+
+			std::vector<PauliImage> images;
+			std::vector<std::complex<double>> product(dimension * dimension);
+			std::vector<std::complex<double>> image(dimension * dimension);
+			for (size_t generator = 0; generator < 2 * qubits; ++generator) {
+				uint64_t x = generator % 2 == 0 ? 1ULL << generator / 2 : 0;
+				uint64_t z = generator % 2 == 1 ? 1ULL << generator / 2 : 0;
+
+				// U P, then U P U^+
+				for (size_t r = 0; r < dimension; ++r)
+					for (size_t c = 0; c < dimension; ++c)
+						product[r * dimension + c] = unitary[r * dimension + (c ^ x)] * pauliElement(x, z, c);
+				for (size_t r = 0; r < dimension; ++r) {
+					for (size_t c = 0; c < dimension; ++c) {
+						std::complex<double> sum = 0;
+						for (size_t k = 0; k < dimension; ++k)
+							sum += product[r * dimension + k] * std::conj(unitary[c * dimension + k]);
+						image[r * dimension + c] = sum;
+					}
+				}
+
+				// the coefficient of Pauli string Q is tr(Q U P U^+) / 2^k, it is +-1 for the image
+				bool found = false;
+				for (uint64_t candidate = 0; candidate < dimension * dimension && !found; ++candidate) {
+					uint64_t cx = candidate % dimension, cz = candidate / dimension;
+					std::complex<double> trace = 0;
+					for (size_t c = 0; c < dimension; ++c)
+						trace += pauliElement(cx, cz, c) * image[c * dimension + (c ^ cx)];
+					trace /= static_cast<double>(dimension);
+
+					if (std::abs(trace - 1.0) < tolerance || std::abs(trace + 1.0) < tolerance) {
+						images.push_back({cx, cz, trace.real() < 0});
+						found = true;
+					}
+				}
+				if (!found)
+					throw std::runtime_error(
+							std::format("Gate on {} qubits is not a Clifford gate, it cannot be applied to a "
+										"stabilizer register", qubits));
+			}
+			return images;
+		}
+	}
+
+	template<typename T>
+	StabilizerRegister<T>::StabilizerRegister(size_t numberOfQubits)
+			: fNumQubits(numberOfQubits), fWords((numberOfQubits + 63) / 64), fX(2 * numberOfQubits * fWords),
+			  fZ(2 * numberOfQubits * fWords), fSigns(2 * numberOfQubits) {
+		// |0...0> is stabilized by Z on every qubit, the destabilizers are X
+		for (size_t q = 0; q < fNumQubits; ++q) {
+			xColumn(q)[q] |= 1ULL << q % 64;
+			zColumn(q)[fNumQubits + q] |= 1ULL << q % 64;
+		}
+	}
+
+	template<typename T>
+	size_t StabilizerRegister<T>::qubits() const {
+		return fNumQubits;
+	}
+
+	/// Gates ///
+
+	template<typename T>
+	void StabilizerRegister<T>::pauliX(size_t targetQubit) {
+		checkQubits({targetQubit});
+		const uint64_t *zs = zColumn(targetQubit);
+		size_t shift = targetQubit % 64;
+		for (size_t i = 0; i < 2 * fNumQubits; ++i)
+			fSigns[i] ^= zs[i] >> shift & 1;
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::pauliY(size_t targetQubit) {
+		checkQubits({targetQubit});
+		const uint64_t *xs = xColumn(targetQubit), *zs = zColumn(targetQubit);
+		size_t shift = targetQubit % 64;
+		for (size_t i = 0; i < 2 * fNumQubits; ++i)
+			fSigns[i] ^= (xs[i] ^ zs[i]) >> shift & 1;
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::pauliZ(size_t targetQubit) {
+		checkQubits({targetQubit});
+		const uint64_t *xs = xColumn(targetQubit);
+		size_t shift = targetQubit % 64;
+		for (size_t i = 0; i < 2 * fNumQubits; ++i)
+			fSigns[i] ^= xs[i] >> shift & 1;
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::controlledX(size_t controlQubit, size_t targetQubit) {
+		checkQubits({controlQubit, targetQubit});
+		applyCNOT(controlQubit, targetQubit);
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::controlledY(size_t controlQubit, size_t targetQubit) {
+		checkQubits({controlQubit, targetQubit});
+		// CY = S CX S^+ on the target, S^+ = S^3
+		for (size_t i = 0; i < 3; ++i)
+			applyS(targetQubit);
+		applyCNOT(controlQubit, targetQubit);
+		applyS(targetQubit);
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::controlledZ(size_t controlQubit, size_t targetQubit) {
+		checkQubits({controlQubit, targetQubit});
+		hadamard(targetQubit);
+		applyCNOT(controlQubit, targetQubit);
+		hadamard(targetQubit);
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::hadamard(size_t targetQubit) {
+		checkQubits({targetQubit});
+		uint64_t *xs = xColumn(targetQubit), *zs = zColumn(targetQubit);
+		size_t shift = targetQubit % 64;
+		for (size_t i = 0; i < 2 * fNumQubits; ++i) {
+			fSigns[i] ^= (xs[i] & zs[i]) >> shift & 1;
+			// swaps the bits
+			uint64_t difference = (xs[i] ^ zs[i]) & 1ULL << shift;
+			xs[i] ^= difference;
+			zs[i] ^= difference;
+		}
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::phase(size_t targetQubit, real_t phase) {
+		checkQubits({targetQubit});
+		real_t quarters = std::round(phase / (Algebra::PI<real_t> / 2));
+		if (std::abs(phase - quarters * Algebra::PI<real_t> / 2) > CliffordTolerance)
+			throw std::runtime_error(std::format("Phase {} is not a multiple of pi/2, it cannot be applied to a "
+												 "stabilizer register", phase));
+
+		auto count = static_cast<long long>(quarters);
+		for (long long i = 0; i < (count % 4 + 4) % 4; ++i)
+			applyS(targetQubit);
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::controlledPhase(size_t controlQubit, size_t targetQubit, real_t phase) {
+		checkQubits({controlQubit, targetQubit});
+		real_t halves = std::round(phase / Algebra::PI<real_t>);
+		if (std::abs(phase - halves * Algebra::PI<real_t>) > CliffordTolerance)
+			throw std::runtime_error(std::format("Controlled phase {} is not a multiple of pi, it cannot be applied to "
+												 "a stabilizer register", phase));
+
+		if (static_cast<long long>(halves) % 2 != 0)
+			controlledZ(controlQubit, targetQubit);
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::piOverEight(size_t targetQubit) {
+		throw std::runtime_error(std::format("Cannot apply T gate to qubit {}, it is not a Clifford gate", targetQubit));
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::swap(size_t targetQubit1, size_t targetQubit2) {
+		checkQubits({targetQubit1, targetQubit2});
+		size_t shift1 = targetQubit1 % 64, shift2 = targetQubit2 % 64;
+		for (auto [words1, words2]: {std::pair{xColumn(targetQubit1), xColumn(targetQubit2)},
+									 std::pair{zColumn(targetQubit1), zColumn(targetQubit2)}}) {
+			for (size_t i = 0; i < 2 * fNumQubits; ++i) {
+				// both bits are flipped if they differ
+				uint64_t difference = (words1[i] >> shift1 ^ words2[i] >> shift2) & 1;
+				words1[i] ^= difference << shift1;
+				words2[i] ^= difference << shift2;
+			}
+		}
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::toffoli(size_t controlQubit1, size_t controlQubit2, size_t targetQubit) {
+		throw std::runtime_error(std::format("Cannot apply Toffoli gate to qubits {}, {}, {}, it is not a Clifford gate",
+											 controlQubit1, controlQubit2, targetQubit));
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::gate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits) {
+		if (targetQubits.size() >= 32 || gate.matrix().rows() != 1ULL << targetQubits.size())
+			throw std::runtime_error(std::format("Gate of size {}x{} cannot be applied to {} qubits",
+												 gate.matrix().rows(), gate.matrix().columns(), targetQubits.size()));
+		checkQubits(targetQubits);
+
+		std::vector<PauliImage> images = cliffordImages(gate.matrix(), targetQubits.size(), CliffordTolerance);
+
+		// the Pauli string of a row on the qubits is i^(number of Ys) times the product of X_j^x_j Z_j^z_j, which is
+		// mapped to the product of the images
+		for (size_t i = 0; i < 2 * fNumQubits; ++i) {
+			int exponent = 2 * fSigns[i];
+			uint64_t productX = 0, productZ = 0;
+			for (size_t j = 0; j < targetQubits.size(); ++j) {
+				bool x = xBit(i, targetQubits[j]), z = zBit(i, targetQubits[j]);
+				exponent += x && z;
+
+				for (const PauliImage *image: {x ? &images[2 * j] : nullptr, z ? &images[2 * j + 1] : nullptr}) {
+					if (!image)
+						continue;
+					exponent += productPhase(productX, productZ, image->x, image->z) + 2 * image->negative;
+					productX ^= image->x;
+					productZ ^= image->z;
+				}
+			}
+
+			fSigns[i] = (exponent & 3) == 2;
+			for (size_t j = 0; j < targetQubits.size(); ++j) {
+				uint64_t mask = 1ULL << targetQubits[j] % 64;
+				uint64_t &xWord = xColumn(targetQubits[j])[i], &zWord = zColumn(targetQubits[j])[i];
+				xWord = productX >> j & 1 ? xWord | mask : xWord & ~mask;
+				zWord = productZ >> j & 1 ? zWord | mask : zWord & ~mask;
+			}
+		}
+	}
+
+	/// Measurement ///
+
+	template<typename T>
+	bool StabilizerRegister<T>::measure(size_t qubit, real_t randomNumber) {
+		checkQubits({qubit});
+		size_t p = anticommutingStabilizer(qubit);
+		if (p == 2 * fNumQubits)
+			return deterministicOutcome(qubit);
+
+		// all other rows with an X or Y on the qubit are multiplied by row p, which leaves p the only one not
+		// commuting with Z on the qubit
+		std::vector<size_t> rows;
+		for (size_t i = 0; i < 2 * fNumQubits; ++i)
+			if (i != p && xBit(i, qubit))
+				rows.push_back(i);
+		multiplyRows(rows, p);
+
+		// row p becomes the destabilizer of the new stabilizer, +-Z on the qubit
+		size_t destabilizer = p - fNumQubits;
+		size_t rowCount = 2 * fNumQubits;
+		for (size_t w = 0; w < fWords; ++w) {
+			fX[w * rowCount + destabilizer] = fX[w * rowCount + p];
+			fZ[w * rowCount + destabilizer] = fZ[w * rowCount + p];
+			fX[w * rowCount + p] = 0;
+			fZ[w * rowCount + p] = 0;
+		}
+		fSigns[destabilizer] = fSigns[p];
+
+		bool outcome = randomNumber >= real_t(0.5);
+		zColumn(qubit)[p] = 1ULL << qubit % 64;
+		fSigns[p] = outcome;
+		return outcome;
+	}
+
+	template<typename T>
+	std::vector<T> StabilizerRegister<T>::marginals() const {
+		std::vector<real_t> marginals(fNumQubits);
+		for (size_t q = 0; q < fNumQubits; ++q)
+			marginals[q] = anticommutingStabilizer(q) < 2 * fNumQubits ? real_t(0.5) : real_t(deterministicOutcome(q));
+		return marginals;
+	}
+
+	template<typename T>
+	std::vector<typename StabilizerRegister<T>::Outcome>
+	StabilizerRegister<T>::sample(size_t shots, std::mt19937_64 &random) const {
+		// one outcome, measured choosing zero for every random qubit
+		StabilizerRegister copy = *this;
+		Outcome reference(fWords);
+		for (size_t q = 0; q < fNumQubits; ++q)
+			if (copy.measure(q, 0))
+				reference[q / 64] |= 1ULL << q % 64;
+
+		// the outcomes are the reference plus the x bits of any product of stabilizers, a basis of which is found
+		// by gaussian elimination of the x bits, copied row by row
+		std::vector<uint64_t> rows(fNumQubits * fWords);
+		for (size_t r = 0; r < fNumQubits; ++r)
+			for (size_t w = 0; w < fWords; ++w)
+				rows[r * fWords + w] = fX[w * 2 * fNumQubits + fNumQubits + r];
+
+		auto rowBit = [&](size_t row, size_t qubit) { return rows[row * fWords + qubit / 64] >> qubit % 64 & 1; };
+		size_t rank = 0;
+		for (size_t q = 0; q < fNumQubits && rank < fNumQubits; ++q) {
+			size_t pivot = rank;
+			while (pivot < fNumQubits && !rowBit(pivot, q))
+				++pivot;
+			if (pivot == fNumQubits)
+				continue;
+
+			std::swap_ranges(rows.begin() + static_cast<ptrdiff_t>(pivot * fWords),
+							 rows.begin() + static_cast<ptrdiff_t>((pivot + 1) * fWords),
+							 rows.begin() + static_cast<ptrdiff_t>(rank * fWords));
+			for (size_t r = rank + 1; r < fNumQubits; ++r)
+				if (rowBit(r, q))
+					for (size_t w = 0; w < fWords; ++w)
+						rows[r * fWords + w] ^= rows[rank * fWords + w];
+			++rank;
+		}
+
+		std::vector<Outcome> outcomes(shots, reference);
+		for (auto &outcome: outcomes) {
+			uint64_t bits = 0;
+			for (size_t b = 0; b < rank; ++b) {
+				if (b % 64 == 0)
+					bits = random();
+				if (bits >> b % 64 & 1)
+					for (size_t w = 0; w < fWords; ++w)
+						outcome[w] ^= rows[b * fWords + w];
+			}
+		}
+		return outcomes;
+	}
+
+	template<typename T>
+	std::string StabilizerRegister<T>::toString() const {
+		std::string result;
+		for (size_t i = fNumQubits; i < 2 * fNumQubits; ++i) {
+			result += fSigns[i] ? '-' : '+';
+			for (size_t q = 0; q < fNumQubits; ++q)
+				result += "IZXY"[2 * xBit(i, q) + zBit(i, q)];
+			result += '\n';
+		}
+		return result;
+	}
+
+	/// Private methods ///
+
+	template<typename T>
+	uint64_t *StabilizerRegister<T>::xColumn(size_t qubit) {
+		return fX.data() + qubit / 64 * 2 * fNumQubits;
+	}
+
+	template<typename T>
+	uint64_t *StabilizerRegister<T>::zColumn(size_t qubit) {
+		return fZ.data() + qubit / 64 * 2 * fNumQubits;
+	}
+
+	template<typename T>
+	bool StabilizerRegister<T>::xBit(size_t row, size_t qubit) const {
+		return fX[qubit / 64 * 2 * fNumQubits + row] >> qubit % 64 & 1;
+	}
+
+	template<typename T>
+	bool StabilizerRegister<T>::zBit(size_t row, size_t qubit) const {
+		return fZ[qubit / 64 * 2 * fNumQubits + row] >> qubit % 64 & 1;
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::checkQubits(const std::vector<size_t> &qubits) const {
+		for (size_t i = 0; i < qubits.size(); ++i) {
+			if (qubits[i] >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Cannot apply gate to qubit {} in {}-qubit register", qubits[i], fNumQubits));
+			for (size_t j = 0; j < i; ++j)
+				if (qubits[j] == qubits[i])
+					throw std::runtime_error(std::format("Cannot apply gate twice to qubit {}", qubits[i]));
+		}
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::applyS(size_t qubit) {
+		uint64_t *xs = xColumn(qubit), *zs = zColumn(qubit);
+		size_t shift = qubit % 64;
+		for (size_t i = 0; i < 2 * fNumQubits; ++i) {
+			fSigns[i] ^= (xs[i] & zs[i]) >> shift & 1;
+			zs[i] ^= xs[i] & 1ULL << shift;
+		}
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::applyCNOT(size_t control, size_t target) {
+		uint64_t *xControl = xColumn(control), *zControl = zColumn(control);
+		uint64_t *xTarget = xColumn(target), *zTarget = zColumn(target);
+		size_t c = control % 64, t = target % 64;
+		for (size_t i = 0; i < 2 * fNumQubits; ++i) {
+			uint64_t xc = xControl[i] >> c & 1, zc = zControl[i] >> c & 1;
+			uint64_t xt = xTarget[i] >> t & 1, zt = zTarget[i] >> t & 1;
+
+			fSigns[i] ^= xc & zt & (xt ^ zc ^ 1);
+			xTarget[i] ^= xc << t;
+			zControl[i] ^= zt << c;
+		}
+	}
+
+	template<typename T>
+	void StabilizerRegister<T>::multiplyRows(const std::vector<size_t> &rows, size_t factor) {
+		size_t rowCount = 2 * fNumQubits;
+		// the product of commuting Pauli strings has a real phase, i.e. an even exponent of i
+		std::vector<int64_t> exponents(rows.size());
+		for (size_t k = 0; k < rows.size(); ++k)
+			exponents[k] = 2 * (fSigns[rows[k]] + fSigns[factor]);
+
+		// word by word, so that the words of all rows are read consecutively
+		size_t minChunk = std::max<size_t>(1, (1 << 16) / fWords);
+		parallelFor(rows.size(), minChunk, [&](size_t begin, size_t end) {
+			for (size_t w = 0; w < fWords; ++w) {
+				uint64_t *xs = fX.data() + w * rowCount, *zs = fZ.data() + w * rowCount;
+				uint64_t factorX = xs[factor], factorZ = zs[factor];
+				for (size_t k = begin; k < end; ++k) {
+					size_t i = rows[k];
+					exponents[k] += productPhase(factorX, factorZ, xs[i], zs[i]);
+					xs[i] ^= factorX;
+					zs[i] ^= factorZ;
+				}
+			}
+			for (size_t k = begin; k < end; ++k)
+				fSigns[rows[k]] = (exponents[k] & 3) == 2;
+		});
+	}
+
+	template<typename T>
+	bool StabilizerRegister<T>::deterministicOutcome(size_t qubit) const {
+		// Z on the qubit is the product of the stabilizers whose destabilizers anticommute with it
+		size_t rowCount = 2 * fNumQubits;
+		int64_t exponent = 0;
+		for (size_t w = 0; w < fWords; ++w) {
+			uint64_t productX = 0, productZ = 0;
+			for (size_t i = 0; i < fNumQubits; ++i) {
+				if (!xBit(i, qubit))
+					continue;
+				size_t stabilizer = w * rowCount + fNumQubits + i;
+				exponent += productPhase(fX[stabilizer], fZ[stabilizer], productX, productZ);
+				productX ^= fX[stabilizer];
+				productZ ^= fZ[stabilizer];
+			}
+		}
+		for (size_t i = 0; i < fNumQubits; ++i)
+			if (xBit(i, qubit))
+				exponent += 2 * fSigns[fNumQubits + i];
+		return (exponent & 3) == 2;
+	}
+
+	template<typename T>
+	size_t StabilizerRegister<T>::anticommutingStabilizer(size_t qubit) const {
+		for (size_t p = fNumQubits; p < 2 * fNumQubits; ++p)
+			if (xBit(p, qubit))
+				return p;
+		return 2 * fNumQubits;
+	}
+
+	template class StabilizerRegister<float>;
+	template class StabilizerRegister<double>;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "../types.h"
+#include "QuantumLogicGate.h"
+
+namespace KQS::Circuit {
+
+	/**
+	 * Register of a stabilizer state, simulated with the tableau of Aaronson and Gottesman (CHP) in polynomial
+	 * time and memory, so that Clifford circuits on thousands of qubits can be simulated. It provides the gate
+	 * methods of QuantumRegister, but accepts only Clifford gates: H, S (phases that are multiples of pi/2), the Pauli
+	 * gates, CNOT, CY, CZ (controlled phases of pi), swap and any gate() whose matrix maps Pauli operators to Pauli
+	 * operators. Other gates throw a std::runtime_error. It does not derive from QuantumRegister, which holds
+	 * 2^n states.
+	 *
+	 * The tableau holds n destabilizer and n stabilizer rows, every row is a Pauli string with the x and z bits of
+	 * all qubits packed into 64-bit words, so that multiplying rows (needed by measurements) processes 64 qubits per
+	 * instruction. The words are stored word-major, i.e. word w of all rows is contiguous, so gates update one or two
+	 * bits of consecutive words and measurements multiply many rows by one row in contiguous, vectorizable loops.
+	 * @tparam T type of the gate matrices, phases and probabilities
+	 */
+	template<typename T>
+	class StabilizerRegister {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+
+		/** Measured values of all qubits, bit q % 64 of word q / 64 holds qubit q. */
+		using Outcome = std::vector<uint64_t>;
+
+		/** Maximal deviation of gate matrix elements and phases from a Clifford gate. */
+		static constexpr real_t CliffordTolerance = 1024 * std::numeric_limits<real_t>::epsilon();
+
+	private:
+		size_t fNumQubits;
+		/** Words of the x or z bits of one row. */
+		size_t fWords;
+
+		/** Rows 0 to n-1 are the destabilizers, rows n to 2n-1 the stabilizers, word w of row i is at w * 2n + i. */
+		std::vector<uint64_t> fX;
+		std::vector<uint64_t> fZ;
+		/** Sign of every row, 1 for a factor of -1. */
+		std::vector<uint8_t> fSigns;
+
+	public:
+		/** Creates the register in state |0...0>. */
+		explicit StabilizerRegister(size_t numberOfQubits);
+
+		size_t qubits() const;
+
+		void pauliX(size_t targetQubit);
+		void pauliY(size_t targetQubit);
+		void pauliZ(size_t targetQubit);
+		void controlledX(size_t controlQubit, size_t targetQubit);
+		void controlledY(size_t controlQubit, size_t targetQubit);
+		void controlledZ(size_t controlQubit, size_t targetQubit);
+		void hadamard(size_t targetQubit);
+		/** Applies S^k for a phase of k * pi/2, other phases are not Clifford gates. */
+		void phase(size_t targetQubit, real_t phase);
+		/** Applies CZ for a phase of pi and nothing for a phase of 0, other phases are not Clifford gates. */
+		void controlledPhase(size_t controlQubit, size_t targetQubit, real_t phase);
+		/** Always throws, T is not a Clifford gate. */
+		void piOverEight(size_t targetQubit);
+		void swap(size_t targetQubit1, size_t targetQubit2);
+		/** Always throws, Toffoli is not a Clifford gate. */
+		void toffoli(size_t controlQubit1, size_t controlQubit2, size_t targetQubit);
+
+		/**
+		 * Applies a Clifford gate given by its matrix. The gate is applied by its action on the Pauli operators of its
+		 * qubits, which is computed from the matrix, so the cost is independent of the matrix afterwards.
+		 * @param gate gate with a Clifford matrix up to a global phase
+		 * @param targetQubits qubits of the bits of the matrix indices
+		 */
+		void gate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits);
+
+		/**
+		 * Measures the qubit in the computational basis and collapses the state.
+		 * @param randomNumber number uniformly distributed in [0, 1), the outcome is one if it is at least 0.5 and
+		 * the outcome is random
+		 * @return measured value
+		 */
+		bool measure(size_t qubit, real_t randomNumber);
+
+		/**
+		 * Computes the marginal probability of measuring each qubit in state one, which is 0, 1/2 or 1 for
+		 * stabilizer states.
+		 * @return vector with the probability for every qubit
+		 */
+		std::vector<real_t> marginals() const;
+
+		/**
+		 * Samples measurement outcomes of the whole register without collapsing the state. The outcomes of a
+		 * stabilizer state are uniformly distributed on an affine subspace, which is computed once with one
+		 * measurement of every qubit, then every shot only costs a random combination of its basis.
+		 * @param shots number of outcomes
+		 * @param random generator of the random bits
+		 * @return sampled outcomes, one per shot
+		 */
+		std::vector<Outcome> sample(size_t shots, std::mt19937_64 &random) const;
+
+		/** Returns the stabilizer generators as signed Pauli strings, e.g. "+XZI", qubit 0 first. */
+		std::string toString() const;
+
+	private:
+		/** Words of the qubit in all rows. */
+		uint64_t *xColumn(size_t qubit);
+		uint64_t *zColumn(size_t qubit);
+
+		bool xBit(size_t row, size_t qubit) const;
+		bool zBit(size_t row, size_t qubit) const;
+
+		/** Throws if a qubit is out of range or repeated. */
+		void checkQubits(const std::vector<size_t> &qubits) const;
+
+		void applyS(size_t qubit);
+		void applyCNOT(size_t control, size_t target);
+
+		/** Multiplies every given row by the factor row from the left (rowsum of CHP). */
+		void multiplyRows(const std::vector<size_t> &rows, size_t factor);
+
+		/** Value of a qubit not in superposition, i.e. no stabilizer has an X or Y on it. */
+		bool deterministicOutcome(size_t qubit) const;
+
+		/** First stabilizer row with an X or Y on the qubit, 2n if the outcome of the qubit is deterministic. */
+		size_t anticommutingStabilizer(size_t qubit) const;
+	};
+}
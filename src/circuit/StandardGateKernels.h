@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdlib>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include "../types.h"
+#include "../parallel.h"
+#include "../algebra/Constants.h"
+#include "../algebra/SmallMatrix.h"
+#include "StandardGates.h"
+
+/**
+ * Kernels of the standard gates on an interleaved state vector. Every gate is a separate instantiation, so it only
+ * touches the states it changes and does no complex multiplications it does not need: X and Swap are swaps, Y a swap
+ * with a phase, H a butterfly with one real multiplication per component and phases multiply a half or a quarter
+ * of the states. The pairs and quadruples of states are distributed over threads like the groups of the dense and
+ * structured kernels.
+ */
+namespace KQS::Circuit::Kernels {
+
+	/** Minimal number of pairs or quadruples of states per thread worth the cost of starting it. */
+	constexpr size_t StandardGateWorkPerThread = 1ULL << 18;
+
+	/**
+	 * Calls function(begin, end) for contiguous runs of states with zero at the qubit, at most 2^qubit states long.
+	 * The pairs are split between threads, so a run may also end at the boundary of a chunk of a thread.
+	 */
+	template<typename F>
+	inline void forEachPairRun(size_t numStates, size_t qubit, F &&function) {
+		size_t stride = 1ULL << qubit;
+		parallelFor(numStates / 2, StandardGateWorkPerThread, [&](size_t begin, size_t end) {
+			for (size_t pair = begin; pair < end;) {
+				size_t length = std::min(stride - (pair & (stride - 1)), end - pair);
+				size_t i = ((pair & ~(stride - 1)) << 1) | (pair & (stride - 1));
+				function(i, i + length);
+				pair += length;
+			}
+		});
+	}
+
+	/**
+	 * Calls function(begin, end) for contiguous runs of states with zeros at both qubits, at most 2^min(qubits)
+	 * states long.
+	 */
+	template<typename F>
+	inline void forEachQuadRun(size_t numStates, size_t qubit0, size_t qubit1, F &&function) {
+		size_t low = 1ULL << std::min(qubit0, qubit1);
+		size_t high = 1ULL << std::max(qubit0, qubit1);
+		parallelFor(numStates / 4, StandardGateWorkPerThread, [&](size_t begin, size_t end) {
+			for (size_t quad = begin; quad < end;) {
+				size_t length = std::min(low - (quad & (low - 1)), end - quad);
+				// inserts the zero bit of the lower qubit, then the one of the higher qubit
+				size_t i = ((quad & ~(low - 1)) << 1) | (quad & (low - 1));
+				i = ((i & ~(high - 1)) << 1) | (i & (high - 1));
+				function(i, i + length);
+				quad += length;
+			}
+		});
+	}
+
+	/**
+	 * Calls the function for every state with zero at the qubit. The states are visited in contiguous runs of
+	 * 2^qubit states, so the inner loop has no index arithmetic.
+	 */
+	template<typename F>
+	inline void forEachPair(size_t numStates, size_t qubit, F &&function) {
+		forEachPairRun(numStates, qubit, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+				function(i);
+		});
+	}
+
+	/** Calls the function for every state with zeros at both qubits. */
+	template<typename F>
+	inline void forEachQuad(size_t numStates, size_t qubit0, size_t qubit1, F &&function) {
+		forEachQuadRun(numStates, qubit0, qubit1, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+				function(i);
+		});
+	}
+
+	/**
+	 * Applies the standard gate to the state vector.
+	 * @param state interleaved amplitudes
+	 * @param numStates number of amplitudes
+	 * @param qubits target qubit, for controlled gates followed by the control qubit, for Swap both qubits
+	 * @param factor phase of Phase and ControlledPhase
+	 */
+	template<StandardGate G, typename T>
+	void applyStandardGate(std::complex<T> *state, size_t numStates, std::array<size_t, 2> qubits,
+						   std::complex<T> factor) {
+		size_t bit0 = 1ULL << qubits[0];
+		size_t bit1 = 1ULL << qubits[1];
+
+		if constexpr (G == StandardGate::PauliX) {
+			forEachPair(numStates, qubits[0], [=](size_t i) {
+				std::swap(state[i], state[i | bit0]);
+			});
+		} else if constexpr (G == StandardGate::PauliY) {
+			// Y|0> = i|1>, Y|1> = -i|0>
+			forEachPair(numStates, qubits[0], [=](size_t i) {
+				std::complex<T> a0 = state[i];
+				std::complex<T> a1 = state[i | bit0];
+				state[i] = std::complex<T>(a1.imag(), -a1.real());
+				state[i | bit0] = std::complex<T>(-a0.imag(), a0.real());
+			});
+		} else if constexpr (G == StandardGate::Hadamard) {
+			forEachPair(numStates, qubits[0], [=](size_t i) {
+				std::complex<T> a0 = state[i];
+				std::complex<T> a1 = state[i | bit0];
+				state[i] = (a0 + a1) * Algebra::RecSqrt2<T>;
+				state[i | bit0] = (a0 - a1) * Algebra::RecSqrt2<T>;
+			});
+		} else if constexpr (G == StandardGate::Phase) {
+			forEachPair(numStates, qubits[0], [=](size_t i) {
+				state[i | bit0] = Algebra::multiply(state[i | bit0], factor);
+			});
+		} else if constexpr (G == StandardGate::ControlledX) {
+			forEachQuad(numStates, qubits[0], qubits[1], [=](size_t i) {
+				std::swap(state[i | bit1], state[i | bit1 | bit0]);
+			});
+		} else if constexpr (G == StandardGate::ControlledPhase) {
+			forEachQuad(numStates, qubits[0], qubits[1], [=](size_t i) {
+				state[i | bit0 | bit1] = Algebra::multiply(state[i | bit0 | bit1], factor);
+			});
+		} else if constexpr (G == StandardGate::Swap) {
+			forEachQuad(numStates, qubits[0], qubits[1], [=](size_t i) {
+				std::swap(state[i | bit0], state[i | bit1]);
+			});
+		}
+	}
+}
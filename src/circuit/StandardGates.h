@@ -0,0 +1,129 @@
+#pragma once
+
+
+#include <cmath>
+#include "../algebra/SmallMatrix.h"
+#include "../algebra/Constants.h"
+
+namespace KQS::Circuit {
+
+	/**
+	 * Standard gates with dedicated kernels. Diagonal gates (Z, S, T and phases in general) are all Phase gates
+	 * multiplying the states with the target qubit set by a factor, controlled Z is a ControlledPhase with factor -1.
+	 */
+	enum class StandardGate {
+		PauliX,
+		PauliY,
+		Hadamard,
+		Phase,
+		ControlledX,
+		ControlledPhase,
+		Swap
+	};
+
+	/** Whether the standard gate acts on two qubits. */
+	constexpr bool isTwoQubitGate(StandardGate gate) {
+		return gate == StandardGate::ControlledX || gate == StandardGate::ControlledPhase || gate == StandardGate::Swap;
+	}
+}
+
+/**
+ * Matrices of the standard gates as compile-time constants, so that applying them neither allocates nor builds
+ * the matrix. Bit k of a row or column index corresponds to the k-th target qubit, the controls are the last targets.
+ */
+namespace KQS::Circuit::Gates {
+
+	template<typename T>
+	constexpr Algebra::SmallMatrix<T, 2> PauliX = {
+			{0, 1},
+			{1, 0}
+	};
+
+	template<typename T>
+	constexpr Algebra::SmallMatrix<T, 2> PauliY = {
+			{0, -Algebra::I<T>},
+			{Algebra::I<T>, 0}
+	};
+
+	template<typename T>
+	constexpr Algebra::SmallMatrix<T, 2> PauliZ = {
+			{1, 0},
+			{0, -1}
+	};
+
+	template<typename T>
+	constexpr Algebra::SmallMatrix<T, 2> Hadamard = {
+			{Algebra::RecSqrt2<T>, Algebra::RecSqrt2<T>},
+			{Algebra::RecSqrt2<T>, -Algebra::RecSqrt2<T>}
+	};
+
+	/** Phase gate with phase pi/4, i.e. exp(i pi/4) = (1 + i)/sqrt(2). */
+	template<typename T>
+	constexpr Algebra::SmallMatrix<T, 2> PiOverEight = {
+			{1, 0},
+			{0, std::complex<T>(Algebra::RecSqrt2<T>, Algebra::RecSqrt2<T>)}
+	};
+
+	template<typename T>
+	constexpr Algebra::SmallMatrix<T, 4> ControlledX = {
+			{1, 0, 0, 0},
+			{0, 1, 0, 0},
+			{0, 0, 0, 1},
+			{0, 0, 1, 0},
+	};
+
+	template<typename T>
+	constexpr Algebra::SmallMatrix<T, 4> ControlledY = {
+			{1, 0, 0, 0},
+			{0, 1, 0, 0},
+			{0, 0, 0, -Algebra::I<T>},
+			{0, 0, Algebra::I<T>, 0},
+	};
+
+	template<typename T>
+	constexpr Algebra::SmallMatrix<T, 4> ControlledZ = {
+			{1, 0, 0, 0},
+			{0, 1, 0, 0},
+			{0, 0, 1, 0},
+			{0, 0, 0, -1},
+	};
+
+	template<typename T>
+	constexpr Algebra::SmallMatrix<T, 4> Swap = {
+			{1, 0, 0, 0},
+			{0, 0, 1, 0},
+			{0, 1, 0, 0},
+			{0, 0, 0, 1},
+	};
+
+	template<typename T>
+	constexpr Algebra::SmallMatrix<T, 8> Toffoli = {
+			{1, 0, 0, 0, 0, 0, 0, 0},
+			{0, 1, 0, 0, 0, 0, 0, 0},
+			{0, 0, 1, 0, 0, 0, 0, 0},
+			{0, 0, 0, 1, 0, 0, 0, 0},
+			{0, 0, 0, 0, 1, 0, 0, 0},
+			{0, 0, 0, 0, 0, 1, 0, 0},
+			{0, 0, 0, 0, 0, 0, 0, 1},
+			{0, 0, 0, 0, 0, 0, 1, 0},
+	};
+
+	/** Phase gates depend on the runtime phase, they are built on the stack. */
+	template<typename T>
+	Algebra::SmallMatrix<T, 2> phase(T phase) {
+		return {
+				{1, 0},
+				{0, std::polar<T>(1, phase)}
+		};
+	}
+
+	template<typename T>
+	Algebra::SmallMatrix<T, 4> controlledPhase(T phase) {
+		return {
+				{1, 0, 0, 0},
+				{0, 1, 0, 0},
+				{0, 0, 1, 0},
+				{0, 0, 0, std::polar<T>(1, phase)},
+		};
+	}
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstdlib>
+#include <array>
+#include <vector>
+#include <utility>
+#include "../types.h"
+#include "../parallel.h"
+#include "../algebra/SmallMatrix.h"
+#include "DenseGateKernels.h"
+
+/**
+ * Kernels of diagonal, permutation and monomial gates on an interleaved state vector. They only read and write the
+ * states of a group the gate changes, and do one complex multiplication per changed state at most. Gates on one and
+ * two qubits, the common case, are instantiated for their size: the offsets and factors live in registers and the
+ * first state of a group is computed with masks, so they are never slower than the dense kernels.
+ */
+namespace KQS::Circuit::Kernels {
+
+	/**
+	 * Masks of the bits below the qubits in ascending order, for insertZeroBits of a gate of fixed size.
+	 * @param targetQubits the K qubits in any order
+	 */
+	template<size_t K>
+	std::array<size_t, K> lowBitMasks(const std::vector<size_t> &targetQubits) {
+		std::vector<size_t> sorted = sortedQubits(targetQubits);
+		std::array<size_t, K> masks{};
+		for (size_t k = 0; k < K; ++k)
+			masks[k] = (1ULL << sorted[k]) - 1;
+		return masks;
+	}
+
+	/** Inserts zero bits below the masks, in ascending order, like insertZeroBits. */
+	template<size_t K>
+	inline size_t insertZeroBits(size_t x, const std::array<size_t, K> &lowMasks) {
+		for (size_t mask: lowMasks)
+			x = ((x & ~mask) << 1) | (x & mask);
+		return x;
+	}
+
+	/**
+	 * Calls the function with the first state of every group in [begin, end) of a gate on K qubits. The next first
+	 * state is the next number with zeros at the qubits, which takes three operations instead of inserting bits.
+	 * @param qubitMask bits of the qubits of the gate
+	 */
+	template<size_t K, typename F>
+	inline void forEachGroup(size_t begin, size_t end, const std::array<size_t, K> &lowMasks, size_t qubitMask,
+							 F &&function) {
+		size_t base = insertZeroBits<K>(begin, lowMasks);
+		for (size_t g = begin; g < end; ++g) {
+			function(base);
+			base = ((base | qubitMask) + 1) & ~qubitMask;
+		}
+	}
+
+	/**
+	 * Calls function.template operator()<N>() with N = count, so loops over the changed states of a group have a
+	 * length known at compile time and keep the group in registers.
+	 * @param count number between 1 and Max
+	 */
+	template<size_t Max, typename F>
+	inline void withCount(size_t count, F &&function) {
+		if constexpr (Max > 0) {
+			if (count == Max)
+				function.template operator()<Max>();
+			else
+				withCount<Max - 1>(count, function);
+		}
+	}
+
+	/** Calls the function with the indices from 0 to N - 1, as an unrolled loop. */
+	template<size_t N, typename F>
+	inline void unrolled(F &&function) {
+		[&]<size_t... J>(std::index_sequence<J...>) {
+			(function(J), ...);
+		}(std::make_index_sequence<N>{});
+	}
+
+	/** Diagonal gate on K qubits, see applyDiagonalGate. */
+	template<size_t K, typename T>
+	void applyFixedDiagonalGate(std::complex<T> *state, size_t numStates, const std::vector<std::complex<T>> &diagonal,
+								const std::vector<size_t> &targetQubits) {
+		constexpr size_t GroupSize = 1ULL << K;
+		std::vector<size_t> groupOffsets = Kernels::groupOffsets(targetQubits);
+		std::array<size_t, K> lowMasks = lowBitMasks<K>(targetQubits);
+		size_t qubitMask = groupOffsets.back();
+
+		// elements equal to one leave the states untouched
+		std::array<size_t, GroupSize> offsets{};
+		std::array<std::complex<T>, GroupSize> factors{};
+		size_t changed = 0;
+		for (size_t j = 0; j < GroupSize; ++j) {
+			if (diagonal[j] == std::complex<T>(1))
+				continue;
+			offsets[changed] = groupOffsets[j];
+			factors[changed++] = diagonal[j];
+		}
+		if (changed == 0)
+			return;
+
+		size_t groups = numStates >> K;
+		size_t minGroupsPerThread = std::max<size_t>(1, DenseGateWorkPerThread / changed);
+		withCount<GroupSize>(changed, [=]<size_t Changed>() {
+			parallelFor(groups, minGroupsPerThread, [=](size_t begin, size_t end) {
+				forEachGroup<K>(begin, end, lowMasks, qubitMask, [=](size_t base) {
+					unrolled<Changed>([=](size_t j) {
+						state[base + offsets[j]] = Algebra::multiply(state[base + offsets[j]], factors[j]);
+					});
+				});
+			});
+		});
+	}
+
+	/** Permutation or monomial gate on K qubits, see applyMonomialGate. */
+	template<size_t K, typename T>
+	void applyFixedMonomialGate(std::complex<T> *state, size_t numStates, const std::vector<size_t> &sources,
+								const std::vector<std::complex<T>> &factors, const std::vector<size_t> &targetQubits) {
+		constexpr size_t GroupSize = 1ULL << K;
+		std::vector<size_t> groupOffsets = Kernels::groupOffsets(targetQubits);
+		std::array<size_t, K> lowMasks = lowBitMasks<K>(targetQubits);
+		size_t qubitMask = groupOffsets.back();
+
+		// states that stay in place with factor one are neither read nor written
+		std::array<size_t, GroupSize> offsets{};
+		std::array<size_t, GroupSize> sourceOffsets{};
+		std::array<std::complex<T>, GroupSize> groupFactors{};
+		size_t changed = 0;
+		bool permutation = true;
+		for (size_t j = 0; j < GroupSize; ++j) {
+			permutation &= factors[j] == std::complex<T>(1);
+			if (sources[j] == j && factors[j] == std::complex<T>(1))
+				continue;
+			offsets[changed] = groupOffsets[j];
+			sourceOffsets[changed] = groupOffsets[sources[j]];
+			groupFactors[changed++] = factors[j];
+		}
+		if (changed == 0)
+			return;
+
+		size_t groups = numStates >> K;
+		size_t minGroupsPerThread = std::max<size_t>(1, DenseGateWorkPerThread / changed);
+		auto run = [=]<bool Permutation, size_t Changed>() {
+			parallelFor(groups, minGroupsPerThread, [=](size_t begin, size_t end) {
+				forEachGroup<K>(begin, end, lowMasks, qubitMask, [=](size_t base) {
+					// all sources are read before any state is written, they are changed states themselves
+					std::array<std::complex<T>, Changed> group;
+					unrolled<Changed>([&](size_t j) { group[j] = state[base + sourceOffsets[j]]; });
+					unrolled<Changed>([&](size_t j) {
+						state[base + offsets[j]] = Permutation ? group[j] : Algebra::multiply(group[j], groupFactors[j]);
+					});
+				});
+			});
+		};
+		withCount<GroupSize>(changed, [=]<size_t Changed>() {
+			if (permutation)
+				run.template operator()<true, Changed>();
+			else
+				run.template operator()<false, Changed>();
+		});
+	}
+
+	/**
+	 * Multiplies every state by the element of the diagonal selected by the bits at the target qubits.
+	 * @param diagonal 2^k elements, bit q of the index corresponds to targetQubits[q]
+	 */
+	template<typename T>
+	void applyDiagonalGate(std::complex<T> *state, size_t numStates, const std::vector<std::complex<T>> &diagonal,
+						   const std::vector<size_t> &targetQubits) {
+		if (targetQubits.size() == 1)
+			return applyFixedDiagonalGate<1>(state, numStates, diagonal, targetQubits);
+		if (targetQubits.size() == 2)
+			return applyFixedDiagonalGate<2>(state, numStates, diagonal, targetQubits);
+
+		std::vector<size_t> offsets = groupOffsets(targetQubits);
+		std::vector<size_t> positions = sortedQubits(targetQubits);
+
+		// elements equal to one leave the states untouched
+		std::vector<size_t> changed;
+		for (size_t j = 0; j < diagonal.size(); ++j)
+			if (diagonal[j] != std::complex<T>(1))
+				changed.push_back(j);
+		if (changed.empty())
+			return;
+
+		size_t groups = numStates >> targetQubits.size();
+		size_t minGroupsPerThread = std::max<size_t>(1, DenseGateWorkPerThread / changed.size());
+		parallelFor(groups, minGroupsPerThread, [&](size_t begin, size_t end) {
+			for (size_t g = begin; g < end; ++g) {
+				size_t base = insertZeroBits(g, positions);
+				for (size_t j: changed) {
+					std::complex<T> &amplitude = state[base + offsets[j]];
+					amplitude = Algebra::multiply(amplitude, diagonal[j]);
+				}
+			}
+		});
+	}
+
+	/**
+	 * Applies a permutation or monomial gate, state i of every group becomes factors[i] times state sources[i].
+	 * @param sources 2^k indices of the source states, bit q of the indices corresponds to targetQubits[q]
+	 * @param factors 2^k factors, all ones for permutations
+	 */
+	template<typename T>
+	void applyMonomialGate(std::complex<T> *state, size_t numStates, const std::vector<size_t> &sources,
+						   const std::vector<std::complex<T>> &factors, const std::vector<size_t> &targetQubits) {
+		if (targetQubits.size() == 1)
+			return applyFixedMonomialGate<1>(state, numStates, sources, factors, targetQubits);
+		if (targetQubits.size() == 2)
+			return applyFixedMonomialGate<2>(state, numStates, sources, factors, targetQubits);
+
+		std::vector<size_t> offsets = groupOffsets(targetQubits);
+		std::vector<size_t> positions = sortedQubits(targetQubits);
+
+		// states that stay in place with factor one are neither read nor written
+		std::vector<size_t> changed;
+		bool permutation = true;
+		for (size_t j = 0; j < sources.size(); ++j) {
+			if (sources[j] != j || factors[j] != std::complex<T>(1))
+				changed.push_back(j);
+			permutation &= factors[j] == std::complex<T>(1);
+		}
+		if (changed.empty())
+			return;
+
+		size_t groupSize = sources.size();
+		size_t groups = numStates >> targetQubits.size();
+		size_t minGroupsPerThread = std::max<size_t>(1, DenseGateWorkPerThread / changed.size());
+		parallelFor(groups, minGroupsPerThread, [&](size_t begin, size_t end) {
+			ComplexVector<T> group(groupSize);
+			for (size_t g = begin; g < end; ++g) {
+				size_t base = insertZeroBits(g, positions);
+				for (size_t j: changed)
+					group[j] = state[base + offsets[j]];
+
+				// every changed state reads a changed state, the others are their own sources
+				for (size_t j: changed) {
+					std::complex<T> value = group[sources[j]];
+					state[base + offsets[j]] = permutation ? value : Algebra::multiply(value, factors[j]);
+				}
+			}
+		});
+	}
+}
@@ -3,15 +3,17 @@
 
 namespace KQS::Circuit {
 
-	VectorizedQuantumRegister::VectorizedQuantumRegister(size_t i)
-			: BasicQuantumRegister(i) {}
+	template<typename T>
+	VectorizedQuantumRegister<T>::VectorizedQuantumRegister(size_t i)
+			: BasicQuantumRegister<T>(i) {}
 
-	void VectorizedQuantumRegister::applyOneQubitGate(const QuantumLogicGate &gate, size_t targetQubit) {
+	/// Single precision ///
+
+	template<>
+	void VectorizedQuantumRegister<float>::applyOneQubitGate(const SmallMatrix<float, 2> &m, size_t targetQubit) {
 		size_t groups = fNumStates / 2;
 
 		// prepare registers for matrix-vector multiplication
-		const ComplexMatrix &m = gate.matrix();
-
 		// [m00_re, m00_im, m10_re, m10_im]
 		__m128 col0 = _mm_set_ps(m[0, 0].real(), m[0, 0].imag(), m[1, 0].real(), m[1, 0].imag());
 		// [m01_re, m01_im, m11_re, m11_im]
@@ -60,14 +62,15 @@ namespace KQS::Circuit {
 		}
 	}
 
-	void VectorizedQuantumRegister::applyTwoQubitGate(const QuantumLogicGate &gate, std::array<size_t, 2> targetQubits) {
+	template<>
+	void VectorizedQuantumRegister<float>::applyTwoQubitGate(const SmallMatrix<float, 4> &m,
+															 std::array<size_t, 2> targetQubits) {
 		size_t groups = fNumStates / 4;
 
 		if (targetQubits[0] > targetQubits[1])
 			targetQubits[0]--;
 
 		// prepare registers for matrix-vector multiplication
-		const ComplexMatrix &m = gate.matrix();
 		__m256 col0 = _mm256_set_ps(m[0, 0].real(), m[0, 0].imag(), m[1, 0].real(), m[1, 0].imag(),
 									m[2, 0].real(), m[2, 0].imag(), m[3, 0].real(), m[3, 0].imag());
 		__m256 col1 = _mm256_set_ps(m[0, 1].real(), m[0, 1].imag(), m[1, 1].real(), m[1, 1].imag(),
@@ -144,6 +147,101 @@ namespace KQS::Circuit {
 		}
 	}
 
-	void VectorizedQuantumRegister::applyKQubitGate(const QuantumLogicGate &gate, const std::vector<size_t> &targetQubits) {
+	/// Double precision ///
+
+	template<>
+	void VectorizedQuantumRegister<double>::applyOneQubitGate(const SmallMatrix<double, 2> &m, size_t targetQubit) {
+		size_t groups = fNumStates / 2;
+
+		// prepare registers for matrix-vector multiplication
+		// [m00_re, m00_im, m10_re, m10_im]
+		__m256d col0 = _mm256_set_pd(m[0, 0].real(), m[0, 0].imag(), m[1, 0].real(), m[1, 0].imag());
+		// [m01_re, m01_im, m11_re, m11_im]
+		__m256d col1 = _mm256_set_pd(m[0, 1].real(), m[0, 1].imag(), m[1, 1].real(), m[1, 1].imag());
+		__m256d mask = _mm256_set_pd(-1, 1, -1, 1);
+		// [-m00_im, m00_re, -m10_im, m10_re]
+		__m256d col2 = _mm256_mul_pd(_mm256_permute_pd(col0, 0b0101), mask);
+		// [-m01_im, m01_re, -m11_im, m11_re]
+		__m256d col3 = _mm256_mul_pd(_mm256_permute_pd(col1, 0b0101), mask);
+
+		size_t mask2 = (1ULL << targetQubit) - 1;
+
+		for (size_t i = 0; i < groups; ++i) {
+			size_t index0 = ((i >> targetQubit) << (targetQubit + 1)) | (i & mask2);
+			size_t index1 = index0 | (1ULL << targetQubit);
+
+			// complex matrix multiplication
+			__m256d x_re = _mm256_set1_pd(fStateVector[index0].real());
+			__m256d x_im = _mm256_set1_pd(fStateVector[index0].imag());
+			__m256d y_re = _mm256_set1_pd(fStateVector[index1].real());
+			__m256d y_im = _mm256_set1_pd(fStateVector[index1].imag());
+
+			__m256d z = _mm256_mul_pd(x_re, col0);
+			z = _mm256_fmadd_pd(x_im, col2, z);
+			z = _mm256_fmadd_pd(y_re, col1, z);
+			z = _mm256_fmadd_pd(y_im, col3, z);
+
+			alignas(32) double res[4];
+			_mm256_store_pd(res, z);
+
+			fStateVector[index0] = complex_t(res[3], res[2]);
+			fStateVector[index1] = complex_t(res[1], res[0]);
+		}
+	}
+
+	template<>
+	void VectorizedQuantumRegister<double>::applyTwoQubitGate(const SmallMatrix<double, 4> &m,
+															  std::array<size_t, 2> targetQubits) {
+		size_t groups = fNumStates / 4;
+
+		if (targetQubits[0] > targetQubits[1])
+			targetQubits[0]--;
+
+		// prepare registers for matrix-vector multiplication, every column is split into rows 0-1 and 2-3
+		__m256d mask = _mm256_set_pd(-1, 1, -1, 1);
+		__m256d colLow[4], colHigh[4], colLowSwapped[4], colHighSwapped[4];
+		for (size_t c = 0; c < 4; ++c) {
+			colLow[c] = _mm256_set_pd(m[0, c].real(), m[0, c].imag(), m[1, c].real(), m[1, c].imag());
+			colHigh[c] = _mm256_set_pd(m[2, c].real(), m[2, c].imag(), m[3, c].real(), m[3, c].imag());
+			colLowSwapped[c] = _mm256_mul_pd(_mm256_permute_pd(colLow[c], 0b0101), mask);
+			colHighSwapped[c] = _mm256_mul_pd(_mm256_permute_pd(colHigh[c], 0b0101), mask);
+		}
+
+		size_t mask0 = (1ULL << targetQubits[0]) - 1;
+		size_t mask1 = (1ULL << targetQubits[1]) - 1;
+
+		for (size_t i = 0; i < groups; ++i) {
+			size_t state = ((i >> targetQubits[0]) << (targetQubits[0] + 1)) | (i & mask0);
+			state = ((state >> targetQubits[1]) << (targetQubits[1] + 1)) | (state & mask1);
+
+			// the bit inserted first was moved by the second insertion, if it was not below the second target
+			size_t bit0 = 1ULL << (targetQubits[0] + (targetQubits[0] >= targetQubits[1]));
+			size_t bit1 = 1ULL << targetQubits[1];
+			size_t indices[4] = {state, state | bit0, state | bit1, state | bit0 | bit1};
+
+			__m256d low = _mm256_setzero_pd();
+			__m256d high = _mm256_setzero_pd();
+			for (size_t c = 0; c < 4; ++c) {
+				__m256d x_re = _mm256_set1_pd(fStateVector[indices[c]].real());
+				__m256d x_im = _mm256_set1_pd(fStateVector[indices[c]].imag());
+
+				low = _mm256_fmadd_pd(x_re, colLow[c], low);
+				low = _mm256_fmadd_pd(x_im, colLowSwapped[c], low);
+				high = _mm256_fmadd_pd(x_re, colHigh[c], high);
+				high = _mm256_fmadd_pd(x_im, colHighSwapped[c], high);
+			}
+
+			alignas(32) double resLow[4], resHigh[4];
+			_mm256_store_pd(resLow, low);
+			_mm256_store_pd(resHigh, high);
+
+			fStateVector[indices[0]] = complex_t(resLow[3], resLow[2]);
+			fStateVector[indices[1]] = complex_t(resLow[1], resLow[0]);
+			fStateVector[indices[2]] = complex_t(resHigh[3], resHigh[2]);
+			fStateVector[indices[3]] = complex_t(resHigh[1], resHigh[0]);
+		}
 	}
+
+	template class VectorizedQuantumRegister<float>;
+	template class VectorizedQuantumRegister<double>;
 }
\ No newline at end of file
@@ -3,14 +3,28 @@
 #include "BasicQuantumRegister.h"
 
 namespace KQS::Circuit {
-	class VectorizedQuantumRegister : public BasicQuantumRegister {
+
+	/**
+	 * Quantum register applying gates with AVX instructions. Single precision kernels process one group of states
+	 * in one register, double precision kernels split the group into 256-bit halves.
+	 * @tparam T type of the real and imaginary parts of the amplitudes, float or double
+	 */
+	template<typename T>
+	class VectorizedQuantumRegister : public BasicQuantumRegister<T> {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+
+	protected:
+		using QuantumRegister<T>::fNumQubits;
+		using QuantumRegister<T>::fNumStates;
+		using BasicQuantumRegister<T>::fStateVector;
 
 	public:
 		explicit VectorizedQuantumRegister(size_t i);
 
 	protected:
-		void applyOneQubitGate(const QuantumLogicGate &gate, size_t targetQubit) override;
-		void applyTwoQubitGate(const QuantumLogicGate &gate, std::array<size_t, 2> targetQubits) override;
-		void applyKQubitGate(const QuantumLogicGate &gate, const std::vector<size_t> &targetQubits) override;
+		void applyOneQubitGate(const SmallMatrix<T, 2> &matrix, size_t targetQubit) override;
+		void applyTwoQubitGate(const SmallMatrix<T, 4> &matrix, std::array<size_t, 2> targetQubits) override;
 	};
 }
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/** Upper limit on the number of threads used by parallelFor, 0 means one per hardware thread. */
+inline std::atomic<size_t> gMaxThreads = 0;
+
+/**
+ * Limits the number of threads used by the multithreaded kernels.
+ * @param threads maximal number of threads, 0 to use all hardware threads
+ */
+inline void setMaxThreads(size_t threads) {
+	gMaxThreads = threads;
+}
+
+/**
+ * Notified on every worker thread of a parallelFor right before and after its chunk, e.g. to attribute the hardware
+ * counters of the workers to the calling thread. The observer of the calling thread is passed to the workers.
+ */
+class WorkerObserver {
+public:
+	virtual ~WorkerObserver() = default;
+
+	virtual void workerStarted() = 0;
+	virtual void workerFinished() = 0;
+};
+
+/** Observer of the worker threads started by parallelFor calls of this thread, if any. */
+inline thread_local WorkerObserver *tWorkerObserver = nullptr;
+
+/** Set on the threads of a parallelFor, nested calls run on the calling thread instead of starting more threads. */
+inline thread_local bool tInParallelFor = false;
+
+/** The number of threads used by the multithreaded kernels. */
+inline size_t maxThreads() {
+	size_t threads = gMaxThreads;
+	if (threads == 0)
+		threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	return threads;
+}
+
+/**
+ * Splits the range [0, count) into contiguous chunks processed in parallel. Only as many threads are started as
+ * there are chunks of at least minChunk items, so small ranges run on the calling thread without any overhead.
+ * Nested calls, e.g. the kernels of registers used by parallel trajectories, run on the calling thread.
+ * @param count number of items
+ * @param minChunk minimal number of items worth a separate thread
+ * @param function callable with the signature void(size_t begin, size_t end), called once per chunk
+ */
+template<typename F>
+void parallelFor(size_t count, size_t minChunk, F &&function) {
+	size_t threads = std::min(maxThreads(), count / std::max<size_t>(minChunk, 1));
+	if (threads <= 1 || tInParallelFor) {
+		if (count > 0)
+			function(size_t(0), count);
+		return;
+	}
+
+	std::vector<std::jthread> workers;
+	workers.reserve(threads - 1);
+	size_t chunk = (count + threads - 1) / threads;
+	for (size_t begin = chunk; begin < count; begin += chunk)
+		workers.emplace_back([&function, begin, end = std::min(begin + chunk, count), observer = tWorkerObserver] {
+			tInParallelFor = true;
+			if (observer)
+				observer->workerStarted();
+			function(begin, end);
+			if (observer)
+				observer->workerFinished();
+		});
+
+	// reset even if the function throws
+	struct Scope {
+		Scope() { tInParallelFor = true; }
+		~Scope() { tInParallelFor = false; }
+	} scope;
+	function(size_t(0), std::min(chunk, count));
+}
@@ -0,0 +1,116 @@
+#include <format>
+#include "GateSequence.h"
+
+namespace KQS::Simulator {
+
+	template<typename T>
+	GateSequence<T>::GateSequence(size_t numberOfQubits) : fNumQubits(numberOfQubits) {}
+
+	template<typename T>
+	size_t GateSequence<T>::qubits() const {
+		return fNumQubits;
+	}
+
+	template<typename T>
+	const std::vector<typename GateSequence<T>::Gate> &GateSequence<T>::gates() const {
+		return fGates;
+	}
+
+	template<typename T>
+	void GateSequence<T>::apply(QuantumRegister<T> &qRegister) const {
+		for (const auto &gate: fGates)
+			gate.apply(qRegister);
+	}
+
+	template<typename T>
+	void GateSequence<T>::add(std::string kind, std::vector<size_t> qubits, Operation operation) {
+		for (size_t i = 0; i < qubits.size(); ++i) {
+			if (qubits[i] >= fNumQubits)
+				throw std::runtime_error(
+						std::format("Cannot apply gate to qubit {} in {}-qubit register", qubits[i], fNumQubits));
+			for (size_t j = 0; j < i; ++j)
+				if (qubits[j] == qubits[i])
+					throw std::runtime_error(std::format("Cannot apply gate twice to qubit {}", qubits[i]));
+		}
+		fGates.push_back({std::move(kind), std::move(qubits), std::move(operation)});
+	}
+
+	/// Gates ///
+
+	template<typename T>
+	void GateSequence<T>::pauliX(size_t targetQubit) {
+		add("PauliX", {targetQubit}, [=](QuantumRegister<T> &r) { r.pauliX(targetQubit); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::pauliY(size_t targetQubit) {
+		add("PauliY", {targetQubit}, [=](QuantumRegister<T> &r) { r.pauliY(targetQubit); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::pauliZ(size_t targetQubit) {
+		add("PauliZ", {targetQubit}, [=](QuantumRegister<T> &r) { r.pauliZ(targetQubit); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::controlledX(size_t controlQubit, size_t targetQubit) {
+		add("ControlledX", {controlQubit, targetQubit},
+			[=](QuantumRegister<T> &r) { r.controlledX(controlQubit, targetQubit); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::controlledY(size_t controlQubit, size_t targetQubit) {
+		add("ControlledY", {controlQubit, targetQubit},
+			[=](QuantumRegister<T> &r) { r.controlledY(controlQubit, targetQubit); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::controlledZ(size_t controlQubit, size_t targetQubit) {
+		add("ControlledZ", {controlQubit, targetQubit},
+			[=](QuantumRegister<T> &r) { r.controlledZ(controlQubit, targetQubit); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::hadamard(size_t targetQubit) {
+		add("Hadamard", {targetQubit}, [=](QuantumRegister<T> &r) { r.hadamard(targetQubit); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::phase(size_t targetQubit, real_t phase) {
+		add("Phase", {targetQubit}, [=](QuantumRegister<T> &r) { r.phase(targetQubit, phase); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::controlledPhase(size_t controlQubit, size_t targetQubit, real_t phase) {
+		add("ControlledPhase", {controlQubit, targetQubit},
+			[=](QuantumRegister<T> &r) { r.controlledPhase(controlQubit, targetQubit, phase); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::piOverEight(size_t targetQubit) {
+		add("PiOverEight", {targetQubit}, [=](QuantumRegister<T> &r) { r.piOverEight(targetQubit); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::swap(size_t targetQubit1, size_t targetQubit2) {
+		add("Swap", {targetQubit1, targetQubit2}, [=](QuantumRegister<T> &r) { r.swap(targetQubit1, targetQubit2); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::toffoli(size_t controlQubit1, size_t controlQubit2, size_t targetQubit) {
+		add("Toffoli", {controlQubit1, controlQubit2, targetQubit},
+			[=](QuantumRegister<T> &r) { r.toffoli(controlQubit1, controlQubit2, targetQubit); });
+	}
+
+	template<typename T>
+	void GateSequence<T>::gate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits,
+							   const std::string &kind) {
+		if (gate.matrix().rows() != 1ULL << targetQubits.size())
+			throw std::runtime_error(std::format("Gate of size {}x{} cannot be applied to {} qubits",
+												 gate.matrix().rows(), gate.matrix().columns(), targetQubits.size()));
+		add(kind, targetQubits, [gate, targetQubits](QuantumRegister<T> &r) { r.gate(gate, targetQubits); });
+	}
+
+	template class GateSequence<float>;
+	template class GateSequence<double>;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../circuit/QuantumRegister.h"
+
+using namespace KQS::Circuit;
+
+namespace KQS::Simulator {
+
+	/**
+	 * Sequence of gates that can be replayed on any number of registers, e.g. once per trajectory of a noisy
+	 * simulation. Every gate records its kind, named like the gate methods of the registers and their profiles
+	 * ("Hadamard", "ControlledX", ...), and its logical qubits, which select the noise applied after it.
+	 * @tparam T type of the real and imaginary parts of the amplitudes of the registers
+	 */
+	template<typename T>
+	class GateSequence {
+	public:
+		using real_t = T;
+		using Operation = std::function<void(QuantumRegister<T> &)>;
+
+		struct Gate {
+			std::string kind;
+			std::vector<size_t> qubits;
+			Operation apply;
+		};
+
+	private:
+		size_t fNumQubits;
+		std::vector<Gate> fGates;
+
+	public:
+		explicit GateSequence(size_t numberOfQubits);
+
+		size_t qubits() const;
+		const std::vector<Gate> &gates() const;
+
+		/** Applies all gates to the register, without noise. */
+		void apply(QuantumRegister<T> &qRegister) const;
+
+		void pauliX(size_t targetQubit);
+		void pauliY(size_t targetQubit);
+		void pauliZ(size_t targetQubit);
+		void controlledX(size_t controlQubit, size_t targetQubit);
+		void controlledY(size_t controlQubit, size_t targetQubit);
+		void controlledZ(size_t controlQubit, size_t targetQubit);
+		void hadamard(size_t targetQubit);
+		void phase(size_t targetQubit, real_t phase);
+		void controlledPhase(size_t controlQubit, size_t targetQubit, real_t phase);
+		void piOverEight(size_t targetQubit);
+		void swap(size_t targetQubit1, size_t targetQubit2);
+		void toffoli(size_t controlQubit1, size_t controlQubit2, size_t targetQubit);
+
+		/**
+		 * Appends a gate given by its matrix.
+		 * @param gate gate applied by QuantumRegister::gate()
+		 * @param targetQubits qubits of the gate, in the order of the bits of its matrix
+		 * @param kind kind of the gate for the noise model
+		 */
+		void gate(const QuantumLogicGate<T> &gate, const std::vector<size_t> &targetQubits,
+				  const std::string &kind = "Gate");
+
+		/**
+		 * Appends any operation on the register.
+		 * @param kind kind of the operation for the noise model
+		 * @param qubits logical qubits the operation acts on
+		 * @param operation function applying it to a register
+		 */
+		void add(std::string kind, std::vector<size_t> qubits, Operation operation);
+	};
+}
@@ -0,0 +1,93 @@
+#include <format>
+#include <algorithm>
+#include "NoiseModel.h"
+
+namespace KQS::Simulator {
+
+	namespace {
+		template<typename T>
+		void checkReadoutError(T flipZero, T flipOne) {
+			for (T probability: {flipZero, flipOne})
+				if (!(probability >= 0 && probability <= 1))
+					throw std::runtime_error(std::format("Readout error {} is not in [0, 1]", probability));
+		}
+	}
+
+	template<typename T>
+	void NoiseModel<T>::addGateNoise(const std::string &kind, KrausChannel<T> channel) {
+		fChannels.push_back(std::move(channel));
+		fGateNoise.emplace_back(kind, fChannels.size() - 1);
+	}
+
+	template<typename T>
+	void NoiseModel<T>::addQubitNoise(size_t qubit, KrausChannel<T> channel) {
+		if (channel.qubits() != 1)
+			throw std::runtime_error(std::format("Noise of qubit {} must be a one-qubit channel, not {} qubits", qubit,
+												 channel.qubits()));
+		fChannels.push_back(std::move(channel));
+		fQubitNoise.emplace_back(qubit, fChannels.size() - 1);
+	}
+
+	template<typename T>
+	void NoiseModel<T>::setReadoutError(real_t flipZero, real_t flipOne) {
+		checkReadoutError(flipZero, flipOne);
+		fDefaultReadoutError = {flipZero, flipOne};
+	}
+
+	template<typename T>
+	void NoiseModel<T>::setReadoutError(size_t qubit, real_t flipZero, real_t flipOne) {
+		checkReadoutError(flipZero, flipOne);
+		std::erase_if(fReadoutErrors, [qubit](const auto &entry) { return entry.first == qubit; });
+		fReadoutErrors.emplace_back(qubit, ReadoutError{flipZero, flipOne});
+	}
+
+	template<typename T>
+	const std::vector<KrausChannel<T>> &NoiseModel<T>::channels() const {
+		return fChannels;
+	}
+
+	template<typename T>
+	std::vector<typename NoiseModel<T>::AppliedChannel>
+	NoiseModel<T>::channelsAfter(const std::string &kind, const std::vector<size_t> &qubits) const {
+		std::vector<AppliedChannel> result;
+		for (const auto &[gateKind, channel]: fGateNoise) {
+			if (gateKind != kind)
+				continue;
+
+			size_t channelQubits = fChannels[channel].qubits();
+			if (channelQubits == 1) {
+				for (size_t qubit: qubits)
+					result.push_back({channel, {qubit}});
+			} else if (channelQubits == qubits.size()) {
+				result.push_back({channel, qubits});
+			} else {
+				throw std::runtime_error(std::format("Noise of {} qubits cannot be applied after {} gate on {} qubits",
+													 channelQubits, kind, qubits.size()));
+			}
+		}
+
+		for (size_t qubit: qubits)
+			for (const auto &[noisyQubit, channel]: fQubitNoise)
+				if (noisyQubit == qubit)
+					result.push_back({channel, {qubit}});
+		return result;
+	}
+
+	template<typename T>
+	typename NoiseModel<T>::ReadoutError NoiseModel<T>::readoutError(size_t qubit) const {
+		for (const auto &[noisyQubit, error]: fReadoutErrors)
+			if (noisyQubit == qubit)
+				return error;
+		return fDefaultReadoutError;
+	}
+
+	template<typename T>
+	bool NoiseModel<T>::hasReadoutErrors() const {
+		auto isError = [](const ReadoutError &error) { return error.flipZero > 0 || error.flipOne > 0; };
+		return isError(fDefaultReadoutError) ||
+			   std::ranges::any_of(fReadoutErrors, [&](const auto &entry) { return isError(entry.second); });
+	}
+
+	template class NoiseModel<float>;
+	template class NoiseModel<double>;
+}
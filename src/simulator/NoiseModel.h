@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../circuit/KrausChannel.h"
+
+using namespace KQS::Circuit;
+
+namespace KQS::Simulator {
+
+	/**
+	 * Noise of a circuit: channels applied after the gates of a kind or after every gate acting on a qubit, and
+	 * errors flipping the measured values of the qubits. The model only describes the noise, TrajectorySimulator
+	 * samples it on state vectors and DensityMatrixRegister::applyChannel() applies it exactly.
+	 * @tparam T type of the real and imaginary parts of the Kraus operators
+	 */
+	template<typename T>
+	class NoiseModel {
+	public:
+		using real_t = T;
+
+		/** Channel applied to qubits after a gate. */
+		struct AppliedChannel {
+			/** Index of the channel in channels(). */
+			size_t channel;
+			/** Logical qubits, in the order of the bits of the Kraus operators. */
+			std::vector<size_t> qubits;
+		};
+
+		/** Probabilities that a measured qubit is read wrongly. */
+		struct ReadoutError {
+			/** Probability of reading one when the qubit is zero. */
+			real_t flipZero = 0;
+			/** Probability of reading zero when the qubit is one. */
+			real_t flipOne = 0;
+		};
+
+	private:
+		std::vector<KrausChannel<T>> fChannels;
+		/** Kind of the gates and index of the channel applied after them. */
+		std::vector<std::pair<std::string, size_t>> fGateNoise;
+		/** Qubit and index of the channel applied after every gate on it. */
+		std::vector<std::pair<size_t, size_t>> fQubitNoise;
+
+		ReadoutError fDefaultReadoutError;
+		/** Readout errors of the qubits set individually, the others use the default. */
+		std::vector<std::pair<size_t, ReadoutError>> fReadoutErrors;
+
+	public:
+		/**
+		 * Applies the channel after every gate of the kind. One-qubit channels are applied to every qubit of the gate,
+		 * larger channels must act on as many qubits as the gate and are applied to all of them at once.
+		 * @param kind kind of the gates, see GateSequence
+		 * @param channel channel applied after them
+		 */
+		void addGateNoise(const std::string &kind, KrausChannel<T> channel);
+
+		/**
+		 * Applies the one-qubit channel to the qubit after every gate acting on it, after the noise of the gate kind.
+		 * @param qubit logical qubit
+		 * @param channel one-qubit channel
+		 */
+		void addQubitNoise(size_t qubit, KrausChannel<T> channel);
+
+		/** Sets the readout error of all qubits without an individual one. */
+		void setReadoutError(real_t flipZero, real_t flipOne);
+
+		/** Sets the readout error of the qubit. */
+		void setReadoutError(size_t qubit, real_t flipZero, real_t flipOne);
+
+		const std::vector<KrausChannel<T>> &channels() const;
+
+		/**
+		 * Returns the channels applied after a gate, in the order they are applied.
+		 * @param kind kind of the gate
+		 * @param qubits logical qubits of the gate
+		 */
+		std::vector<AppliedChannel> channelsAfter(const std::string &kind, const std::vector<size_t> &qubits) const;
+
+		ReadoutError readoutError(size_t qubit) const;
+
+		/** Whether any qubit has a readout error. */
+		bool hasReadoutErrors() const;
+	};
+}
@@ -5,40 +5,52 @@
 #include <random>
 #include "Simulator.h"
 
-std::uniform_real_distribution<real_t> uniform01(0, 1);
 std::random_device rng;
 
 namespace KQS::Simulator {
 
-	Simulator::Simulator(std::unique_ptr<QuantumRegister> qRegister)
-			: fRegister(std::move(qRegister)), fStatesCounts(1 << fRegister->qubits()) {}
+	template<typename T>
+	Simulator<T>::Simulator(std::unique_ptr<QuantumRegister<T>> qRegister)
+			: fNumQubits(qRegister->qubits()), fRegister(std::move(qRegister)), fStatesCounts(1ULL << fNumQubits) {}
 
-	bool measure(const std::vector<complex_t> &stateVector, size_t qubit) {
-		real_t prob = 0; // probability of one state
-		for (size_t i = 0; i < stateVector.size(); ++i)
-			if ((i >> qubit & 1) == 1)
-				prob += std::norm(stateVector[i]);
+	template<typename T>
+	Simulator<T>::Simulator(size_t numberOfQubits) : fNumQubits(numberOfQubits), fStatesCounts(1ULL << fNumQubits) {}
 
-		real_t R = uniform01(rng);
+	template<typename T>
+	void Simulator<T>::run(size_t numShots) {
+		if (!fRegister)
+			throw std::runtime_error("Simulator has no register to sample");
 
-		return R < prob;
-	}
+		std::uniform_real_distribution<T> uniform01(0, 1);
 
-	void Simulator::run(size_t numShots) {
+		std::vector<T> randomNumbers(numShots);
+		for (auto &r: randomNumbers)
+			r = uniform01(rng);
 
-		for (size_t n = 0; n < numShots; ++n) {
+		// all shots are sampled by the register at once, so GPU registers only return the sampled states
+		for (size_t state: fRegister->sample(randomNumbers))
+			++fStatesCounts[state];
+	}
 
-			size_t i = 0;
-			for (size_t b = 0; b < fRegister->qubits(); ++b) {
-				if (measure(fRegister->stateVector(), b))
-					i = i | (1 << b);
-			}
+	template<typename T>
+	void Simulator<T>::run(TrajectorySimulator<T> &trajectories, const GateSequence<T> &circuit,
+						   size_t numTrajectories, size_t shotsPerTrajectory) {
+		if (circuit.qubits() != fNumQubits)
+			throw std::runtime_error(std::format("Circuit on {} qubits cannot be run by {}-qubit simulator",
+												 circuit.qubits(), fNumQubits));
 
-			++fStatesCounts[i];
-		}
+		uint64_t seed = (uint64_t(rng()) << 32) | rng();
+		for (size_t state: trajectories.run(circuit, numTrajectories, shotsPerTrajectory, seed))
+			++fStatesCounts[state];
 	}
 
-	std::string Simulator::toString() {
+	template<typename T>
+	const std::vector<size_t> &Simulator<T>::counts() const {
+		return fStatesCounts;
+	}
+
+	template<typename T>
+	std::string Simulator<T>::toString() {
 		std::stringstream ss;
 		ss << std::fixed << std::setprecision(2);
 
@@ -47,11 +59,14 @@ namespace KQS::Simulator {
 			total += count;
 
 		for (size_t i = 0; i < fStatesCounts.size(); ++i) {
-			std::string ket = std::format("|{}>", std::bitset<64>(i).to_string().substr(64 - fRegister->qubits()));
-			real_t fraction = (real_t) fStatesCounts[i] / (real_t) total * 100;
+			std::string ket = std::format("|{}>", std::bitset<64>(i).to_string().substr(64 - fNumQubits));
+			double fraction = (double) fStatesCounts[i] / (double) total * 100;
 			ss << ket << ": " << fStatesCounts[i] << " (" << fraction << "%)\n";
 		}
 
 		return ss.str();
 	}
-}
\ No newline at end of file
+
+	template class Simulator<float>;
+	template class Simulator<double>;
+}
@@ -3,22 +3,46 @@
 
 #include <memory>
 #include "../circuit/QuantumRegister.h"
+#include "TrajectorySimulator.h"
 
 using namespace KQS::Circuit;
 
 namespace KQS::Simulator {
 
+	/**
+	 * Simulator sampling measurements of a quantum register, or of noisy trajectories of a circuit, into a histogram
+	 * of the measured states.
+	 * @tparam T type of the real and imaginary parts of the amplitudes of the register
+	 */
+	template<typename T>
 	class Simulator {
 	private:
-		std::unique_ptr<QuantumRegister> fRegister;
+		size_t fNumQubits;
+		std::unique_ptr<QuantumRegister<T>> fRegister;
 		std::vector<size_t> fStatesCounts;
 
 	public:
-		explicit Simulator(std::unique_ptr<QuantumRegister> qRegister);
+		explicit Simulator(std::unique_ptr<QuantumRegister<T>> qRegister);
+
+		/** Creates a simulator without a register, which only collects the shots of noisy trajectories. */
+		explicit Simulator(size_t numberOfQubits);
 
 		void run(size_t numShots);
+
+		/**
+		 * Simulates noisy trajectories of the circuit and adds their shots to the histogram.
+		 * @param trajectories simulator of the noise
+		 * @param circuit circuit on as many qubits as the simulator
+		 * @param numTrajectories number of trajectories
+		 * @param shotsPerTrajectory number of shots sampled from every trajectory
+		 */
+		void run(TrajectorySimulator<T> &trajectories, const GateSequence<T> &circuit, size_t numTrajectories,
+				 size_t shotsPerTrajectory);
+
+		/** Number of shots that measured every state. */
+		const std::vector<size_t> &counts() const;
+
 		std::string toString();
 	};
 
 }
-
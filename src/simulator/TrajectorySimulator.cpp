@@ -0,0 +1,265 @@
+#include <cmath>
+#include <format>
+#include <atomic>
+#include <numeric>
+#include <algorithm>
+#include "TrajectorySimulator.h"
+#include "../circuit/VectorizedQuantumRegister.h"
+#include "../parallel.h"
+
+namespace KQS::Simulator {
+
+	/// Random numbers ///
+
+	template<typename T>
+	TrajectorySimulator<T>::Random::Random(uint64_t seed, uint64_t stream) : fState(seed) {
+		// the streams start at well separated states of the sequence
+		fState += stream * 0x9E3779B97F4A7C15ULL;
+		fState = next();
+	}
+
+	template<typename T>
+	uint64_t TrajectorySimulator<T>::Random::next() {
+		uint64_t z = (fState += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	template<typename T>
+	double TrajectorySimulator<T>::Random::uniform() {
+		return static_cast<double>(next() >> 11) * 0x1.0p-53;
+	}
+
+	/// Setup ///
+
+	template<typename T>
+	TrajectorySimulator<T>::TrajectorySimulator(NoiseModel<T> noise, RegisterFactory factory)
+			: fNoise(std::move(noise)), fFactory(std::move(factory)) {
+		if (!fFactory)
+			fFactory = [](size_t numberOfQubits) {
+				return std::make_unique<VectorizedQuantumRegister<T>>(numberOfQubits);
+			};
+
+		for (const auto &channel: fNoise.channels())
+			fSamplers.push_back(prepare(channel));
+	}
+
+	template<typename T>
+	const NoiseModel<T> &TrajectorySimulator<T>::noiseModel() const {
+		return fNoise;
+	}
+
+	template<typename T>
+	size_t TrajectorySimulator<T>::branches() const {
+		return fBranches;
+	}
+
+	template<typename T>
+	typename TrajectorySimulator<T>::Sampler TrajectorySimulator<T>::prepare(const KrausChannel<T> &channel) {
+		Sampler sampler;
+		size_t dimension = 1ULL << channel.qubits();
+		auto tolerance = KrausChannel<T>::CompletenessTolerance;
+
+		// the channel is a mixture of unitaries if every K_i^+ K_i is p_i I, then p_i does not depend on the state
+		bool mixture = true;
+		for (const auto &op: channel.operators()) {
+			ComplexMatrix<T> effect = op.adjoint() * op;
+			double weight = effect[0, 0].real();
+			for (size_t i = 0; i < dimension; ++i)
+				for (size_t j = 0; j < dimension; ++j)
+					mixture &= std::abs(effect[i, j] - complex_t(i == j ? weight : 0)) <= tolerance;
+
+			bool identity = true;
+			for (size_t i = 0; i < dimension; ++i)
+				for (size_t j = 0; j < dimension; ++j)
+					identity &= std::abs(op[i, j] - (i == j ? op[0, 0] : complex_t(0))) <= tolerance;
+
+			sampler.effects.push_back(effect);
+			sampler.probabilities.push_back(weight);
+			sampler.identities.push_back(identity);
+		}
+
+		if (!mixture) {
+			sampler.probabilities.clear();
+			return sampler;
+		}
+
+		for (size_t k = 0; k < channel.operators().size(); ++k) {
+			ComplexMatrix<T> unitary = channel.operators()[k];
+			auto scale = static_cast<real_t>(sampler.probabilities[k] > 0 ? 1 / std::sqrt(sampler.probabilities[k]) : 0);
+			for (size_t i = 0; i < dimension; ++i)
+				for (size_t j = 0; j < dimension; ++j)
+					unitary[i, j, unitary[i, j] * scale];
+			sampler.unitaries.emplace_back(unitary);
+		}
+		return sampler;
+	}
+
+	/// Trajectories ///
+
+	template<typename T>
+	std::vector<size_t> TrajectorySimulator<T>::run(const GateSequence<T> &circuit, size_t trajectories,
+													size_t shotsPerTrajectory, uint64_t seed) {
+		Run run{{}, circuit.qubits(), shotsPerTrajectory, {}, {}};
+
+		// the noise is resolved before the threads start, so invalid models throw here
+		for (const auto &gate: circuit.gates()) {
+			run.steps.push_back({&gate, {}});
+			for (auto &channel: fNoise.channelsAfter(gate.kind, gate.qubits)) {
+				for (size_t qubit: channel.qubits)
+					if (qubit >= circuit.qubits())
+						throw std::runtime_error(std::format("Cannot apply noise to qubit {} in {}-qubit register",
+															 qubit, circuit.qubits()));
+				run.steps.push_back({nullptr, std::move(channel)});
+			}
+		}
+
+		run.randoms.reserve(trajectories);
+		for (size_t t = 0; t < trajectories; ++t)
+			run.randoms.emplace_back(seed, t);
+		run.outcomes.resize(trajectories * shotsPerTrajectory);
+
+		std::atomic<size_t> branches = 0;
+		parallelFor(trajectories, 1, [&](size_t begin, size_t end) {
+			std::vector<size_t> group(end - begin);
+			std::iota(group.begin(), group.end(), begin);
+
+			auto qRegister = fFactory(run.numQubits);
+			branches += 1 + runBranch(run, *qRegister, 0, std::move(group));
+		});
+
+		fBranches = branches;
+		return std::move(run.outcomes);
+	}
+
+	template<typename T>
+	size_t TrajectorySimulator<T>::runBranch(Run &run, QuantumRegister<T> &qRegister, size_t step,
+											 std::vector<size_t> trajectories) const {
+		size_t branches = 0;
+		for (; step < run.steps.size(); ++step) {
+			const Step &current = run.steps[step];
+			if (current.gate) {
+				current.gate->apply(qRegister);
+				continue;
+			}
+
+			const auto &qubits = current.channel.qubits;
+			const KrausChannel<T> &channel = fNoise.channels()[current.channel.channel];
+			const Sampler &sampler = fSamplers[current.channel.channel];
+			std::vector<double> probabilities = sampler.probabilities.empty()
+												? this->probabilities(qRegister, sampler, qubits)
+												: sampler.probabilities;
+
+			// every trajectory draws its operator from its own stream
+			std::vector<std::vector<size_t>> groups(probabilities.size());
+			double total = std::accumulate(probabilities.begin(), probabilities.end(), 0.0);
+			for (size_t trajectory: trajectories) {
+				double u = run.randoms[trajectory].uniform() * total;
+				// draws beyond the total due to rounding belong to the last operator with non-zero probability
+				size_t chosen = 0;
+				for (size_t k = 0; k < probabilities.size(); ++k) {
+					if (probabilities[k] == 0)
+						continue;
+					chosen = k;
+					if (u < probabilities[k])
+						break;
+					u -= probabilities[k];
+				}
+				groups[chosen].push_back(trajectory);
+			}
+
+			// the largest group continues on this register, the smaller ones are simulated first on copies
+			size_t largest = std::ranges::max_element(groups, {}, &std::vector<size_t>::size) - groups.begin();
+			for (size_t k = 0; k < groups.size(); ++k) {
+				if (k == largest || groups[k].empty())
+					continue;
+
+				auto copy = fFactory(run.numQubits);
+				copy->setStateVector(qRegister.stateVector());
+				applyOperator(*copy, channel, sampler, k, probabilities[k] / total, qubits);
+				branches += 1 + runBranch(run, *copy, step + 1, std::move(groups[k]));
+			}
+
+			applyOperator(qRegister, channel, sampler, largest, probabilities[largest] / total, qubits);
+			trajectories = std::move(groups[largest]);
+		}
+
+		measure(run, qRegister, trajectories);
+		return branches;
+	}
+
+	template<typename T>
+	std::vector<double> TrajectorySimulator<T>::probabilities(const QuantumRegister<T> &qRegister,
+															  const Sampler &sampler,
+															  const std::vector<size_t> &qubits) const {
+		size_t dimension = 1ULL << qubits.size();
+		std::vector<std::complex<double>> rho = qRegister.reducedDensityMatrix(qubits);
+
+		// p_k = Tr(K_k^+ K_k rho), rounding can make it slightly negative
+		std::vector<double> result;
+		for (const auto &effect: sampler.effects) {
+			double p = 0;
+			for (size_t a = 0; a < dimension; ++a)
+				for (size_t b = 0; b < dimension; ++b)
+					p += (std::complex<double>(effect[a, b]) * rho[b * dimension + a]).real();
+			result.push_back(std::max(p, 0.0));
+		}
+		return result;
+	}
+
+	template<typename T>
+	void TrajectorySimulator<T>::applyOperator(QuantumRegister<T> &qRegister, const KrausChannel<T> &channel,
+											   const Sampler &sampler, size_t index, double probability,
+											   const std::vector<size_t> &qubits) const {
+		if (sampler.identities[index])
+			return;
+		if (!sampler.unitaries.empty()) {
+			qRegister.gate(sampler.unitaries[index], qubits);
+			return;
+		}
+
+		ComplexMatrix<T> op = channel.operators()[index];
+		auto scale = static_cast<real_t>(1 / std::sqrt(probability));
+		for (size_t i = 0; i < op.rows(); ++i)
+			for (size_t j = 0; j < op.columns(); ++j)
+				op[i, j, op[i, j] * scale];
+		qRegister.gate(QuantumLogicGate<T>(op), qubits);
+	}
+
+	template<typename T>
+	void TrajectorySimulator<T>::measure(Run &run, QuantumRegister<T> &qRegister,
+										 const std::vector<size_t> &trajectories) const {
+		// branches split off copies with the qubit map applied, the physical order of the states, in which the
+		// shots are sampled, must not depend on where a trajectory was split off
+		qRegister.applyQubitMap();
+
+		// all shots of the branch are sampled at once, in one pass over the state
+		std::vector<real_t> randomNumbers;
+		randomNumbers.reserve(trajectories.size() * run.shots);
+		for (size_t trajectory: trajectories)
+			for (size_t shot = 0; shot < run.shots; ++shot)
+				randomNumbers.push_back(static_cast<real_t>(run.randoms[trajectory].uniform()));
+		std::vector<size_t> samples = qRegister.sample(randomNumbers);
+
+		std::vector<typename NoiseModel<T>::ReadoutError> readoutErrors;
+		if (fNoise.hasReadoutErrors())
+			for (size_t q = 0; q < run.numQubits; ++q)
+				readoutErrors.push_back(fNoise.readoutError(q));
+
+		for (size_t i = 0; i < samples.size(); ++i) {
+			size_t trajectory = trajectories[i / run.shots];
+			size_t outcome = samples[i];
+			for (size_t q = 0; q < readoutErrors.size(); ++q) {
+				bool one = (outcome >> q) & 1;
+				double flip = one ? readoutErrors[q].flipOne : readoutErrors[q].flipZero;
+				if (flip > 0 && run.randoms[trajectory].uniform() < flip)
+					outcome ^= 1ULL << q;
+			}
+			run.outcomes[trajectory * run.shots + i % run.shots] = outcome;
+		}
+	}
+
+	template class TrajectorySimulator<float>;
+	template class TrajectorySimulator<double>;
+}
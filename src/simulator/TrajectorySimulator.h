@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "../circuit/QuantumRegister.h"
+#include "GateSequence.h"
+#include "NoiseModel.h"
+
+using namespace KQS::Circuit;
+
+namespace KQS::Simulator {
+
+	/**
+	 * Simulates noisy circuits on state vectors by Monte-Carlo trajectories: after every gate, each channel of the
+	 * noise model applies one of its Kraus operators, chosen at random with the probability it has for the current
+	 * state, and the measured shots are flipped by the readout errors. Averaged over many trajectories this samples
+	 * the same distribution as the density matrix, with the memory of a state vector.
+	 *
+	 * Trajectories are simulated together as long as they drew the same Kraus operators: a branch holds one register
+	 * for a group of trajectories and only splits off a copy of its state for the trajectories drawing a different
+	 * operator, so with weak noise most gates are applied once for many trajectories. Channels that are mixtures of
+	 * unitaries (depolarizing, bit and phase flips) have probabilities independent of the state and apply nothing
+	 * for their identity term, the probabilities of other channels are computed from the reduced density matrix of
+	 * their qubits. Branches of fewer trajectories are simulated first, so at most log2 of the trajectories of a
+	 * thread plus one registers are alive per thread.
+	 *
+	 * The trajectories are split between threads, every thread simulates its own branches. Every trajectory has its
+	 * own random number stream derived from the seed and its index, so the outcomes do not depend on the number of
+	 * threads or on how the trajectories were grouped, up to rounding of the probabilities computed from the states.
+	 * The kernels of the registers run single-threaded inside the threads of the trajectories.
+	 * @tparam T type of the real and imaginary parts of the amplitudes
+	 */
+	template<typename T>
+	class TrajectorySimulator {
+	public:
+		using real_t = T;
+		using complex_t = std::complex<T>;
+
+		/** Creates a register of the given number of qubits in state |0...0>. */
+		using RegisterFactory = std::function<std::unique_ptr<QuantumRegister<T>>(size_t numberOfQubits)>;
+
+	private:
+		/** Random number stream of one trajectory (SplitMix64). */
+		class Random {
+		private:
+			uint64_t fState;
+
+		public:
+			Random(uint64_t seed, uint64_t stream);
+
+			uint64_t next();
+
+			/** Uniformly distributed number in [0, 1). */
+			double uniform();
+		};
+
+		/** Kraus operators of a channel prepared for sampling. */
+		struct Sampler {
+			/** Probabilities of the operators of a mixture of unitaries, empty if they depend on the state. */
+			std::vector<double> probabilities;
+			/** K_i^+ K_i of every operator, to compute the probabilities from the state. */
+			std::vector<ComplexMatrix<T>> effects;
+			/** For mixtures of unitaries, the unitary K_i / sqrt(p_i) of every operator. */
+			std::vector<QuantumLogicGate<T>> unitaries;
+			/** Whether the operator is proportional to the identity, so applying it changes nothing. */
+			std::vector<bool> identities;
+		};
+
+		/** Gate or channel of the noisy circuit. */
+		struct Step {
+			const typename GateSequence<T>::Gate *gate;
+			/** Channel if gate is null. */
+			typename NoiseModel<T>::AppliedChannel channel;
+		};
+
+		/** State shared by the branches of one run. */
+		struct Run {
+			std::vector<Step> steps;
+			size_t numQubits;
+			size_t shots;
+			std::vector<Random> randoms;
+			/** Outcomes of all shots, those of trajectory t start at t * shots. */
+			std::vector<size_t> outcomes;
+		};
+
+		NoiseModel<T> fNoise;
+		RegisterFactory fFactory;
+		std::vector<Sampler> fSamplers;
+		size_t fBranches = 0;
+
+	public:
+		/**
+		 * Creates the simulator of the noise model.
+		 * @param noise noise of the circuits
+		 * @param factory creates the registers of the branches, VectorizedQuantumRegister if empty
+		 */
+		explicit TrajectorySimulator(NoiseModel<T> noise, RegisterFactory factory = {});
+
+		const NoiseModel<T> &noiseModel() const;
+
+		/**
+		 * Simulates trajectories of the circuit and samples shots from each of them.
+		 * @param circuit gates of the circuit
+		 * @param trajectories number of trajectories
+		 * @param shotsPerTrajectory number of shots sampled from the final state of every trajectory
+		 * @param seed seed of the random number streams of the trajectories
+		 * @return measured states, the shots of trajectory t at t * shotsPerTrajectory
+		 */
+		std::vector<size_t> run(const GateSequence<T> &circuit, size_t trajectories, size_t shotsPerTrajectory,
+								uint64_t seed);
+
+		/**
+		 * Number of branches simulated by the last run, i.e. registers the gates were applied to. Trajectories share
+		 * a branch until they draw different Kraus operators.
+		 */
+		size_t branches() const;
+
+	private:
+		static Sampler prepare(const KrausChannel<T> &channel);
+
+		/**
+		 * Simulates the trajectories from the step on, applies their readout errors and stores their outcomes.
+		 * @return number of branches split off
+		 */
+		size_t runBranch(Run &run, QuantumRegister<T> &qRegister, size_t step, std::vector<size_t> trajectories) const;
+
+		/** Computes the probabilities of the Kraus operators of the channel for the state of the register. */
+		std::vector<double> probabilities(const QuantumRegister<T> &qRegister, const Sampler &sampler,
+										  const std::vector<size_t> &qubits) const;
+
+		/** Applies the Kraus operator, normalized by the square root of its probability. */
+		void applyOperator(QuantumRegister<T> &qRegister, const KrausChannel<T> &channel, const Sampler &sampler,
+						   size_t index, double probability, const std::vector<size_t> &qubits) const;
+
+		/**
+		 * Samples the shots of the trajectories from the final state, after applying its qubit map, and flips them by
+		 * the readout errors.
+		 */
+		void measure(Run &run, QuantumRegister<T> &qRegister, const std::vector<size_t> &trajectories) const;
+	};
+}
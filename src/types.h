@@ -1,13 +1,55 @@
 #pragma once
 
 #include <complex>
+#include <vector>
 #include <iostream>
+#include <utility>
+#include <type_traits>
+#include <string_view>
+#include <stdexcept>
+#include <format>
 
-/** The type representing real numbers throughout the project. */
-using real_t = float;
+/**
+ * Floating point precision of registers, gates and matrices. All of them are templates over the real type,
+ * instantiated for float and double, so the precision can be selected at runtime using dispatchPrecision.
+ */
+enum class Precision {
+	Single,
+	Double
+};
 
-/** The type representing complex numbers throughout the project. */
-using complex_t = std::complex<real_t>;
+/**
+ * Parses the name of a precision, e.g. given on the command line.
+ * @param name single (or float) or double
+ * @throws std::runtime_error for other names
+ */
+inline Precision parsePrecision(std::string_view name) {
+	if (name == "single" || name == "float")
+		return Precision::Single;
+	if (name == "double")
+		return Precision::Double;
+	throw std::runtime_error(std::format("Unknown precision {}, expected single or double", name));
+}
 
-/** The type representing vector of complex numbers. */
-using ComplexVector = std::vector<complex_t>;
+/** The precision corresponding to the real type T. */
+template<typename T>
+constexpr Precision precisionOf = std::is_same_v<T, float> ? Precision::Single : Precision::Double;
+
+/** The type representing vector of complex numbers with components of type T. */
+template<typename T>
+using ComplexVector = std::vector<std::complex<T>>;
+
+/**
+ * Calls the function with the real type matching the precision as its template argument, e.g.
+ * `dispatchPrecision(precision, [&]<typename T>() { BasicQuantumRegister<T> qRegister(n); ... });`.
+ * @param precision selected precision
+ * @param function generic lambda with a template parameter for the real type
+ * @return value returned by the function
+ */
+template<typename F>
+decltype(auto) dispatchPrecision(Precision precision, F &&function) {
+	if (precision == Precision::Double)
+		return std::forward<F>(function).template operator()<double>();
+
+	return std::forward<F>(function).template operator()<float>();
+}